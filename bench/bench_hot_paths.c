@@ -0,0 +1,332 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <axidev-io/c_api.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/thread.h"
+#include "keyboard/common/key_utils_internal.h"
+#include "keyboard/common/keymap_internal.h"
+#include "keyboard/listener/listener_internal.h"
+#include "keyboard/sender/typing_plan_internal.h"
+
+/* Each case repeats until it has run for at least this long. */
+#define BENCH_MIN_RUNTIME_NS 200000000ull
+#define BENCH_LISTENER_EVENTS 16384u
+/* Mixed-script plan inputs: a short and a long one. Planning is linear, so
+   both should report about the same ns/op. */
+#define BENCH_PLAN_SHORT_BYTES 4096u
+#define BENCH_PLAN_LONG_BYTES 65536u
+
+/* Allocation counting interposes the allocator, which glibc exposes through
+   its __libc_* entry points. Elsewhere allocations/op is not reported. */
+#if defined(__GLIBC__)
+#define BENCH_COUNTS_ALLOCATIONS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static atomic_ullong g_allocations;
+
+void *malloc(size_t size) {
+  atomic_fetch_add_explicit(&g_allocations, 1u, memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  atomic_fetch_add_explicit(&g_allocations, 1u, memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  atomic_fetch_add_explicit(&g_allocations, 1u, memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) { __libc_free(ptr); }
+
+static unsigned long long bench_allocations(void) {
+  return atomic_load_explicit(&g_allocations, memory_order_relaxed);
+}
+#else
+#define BENCH_COUNTS_ALLOCATIONS 0
+
+static unsigned long long bench_allocations(void) { return 0; }
+#endif
+
+/* Runs a case once; returns false when the platform cannot run it. */
+typedef bool (*bench_fn)(void *state);
+
+static void bench_run(const char *name, bench_fn fn, void *state,
+                      size_t ops_per_call) {
+  uint64_t iterations = 1;
+  uint64_t elapsed_ns = 0;
+  unsigned long long allocations = 0;
+
+  if (!fn(state)) {
+    printf("%-36s %12s %12s\n", name, "unsupported", "-");
+    return;
+  }
+  while (elapsed_ns < BENCH_MIN_RUNTIME_NS) {
+    unsigned long long allocations_before;
+    uint64_t start_ns;
+
+    iterations *= 2;
+    allocations_before = bench_allocations();
+    start_ns = axidev_io_monotonic_time_ns();
+    for (uint64_t i = 0; i < iterations; ++i) {
+      fn(state);
+    }
+    elapsed_ns = axidev_io_monotonic_time_ns() - start_ns;
+    allocations = bench_allocations() - allocations_before;
+  }
+
+  {
+    double ops = (double)iterations * (double)ops_per_call;
+
+    if (BENCH_COUNTS_ALLOCATIONS) {
+      printf("%-36s %12.1f %12.3f\n", name, (double)elapsed_ns / ops,
+             (double)allocations / ops);
+    } else {
+      printf("%-36s %12.1f %12s\n", name, (double)elapsed_ns / ops, "-");
+    }
+  }
+}
+
+static bool bench_type_text(void *state) {
+  return axidev_io_keyboard_type_text((const char *)state);
+}
+
+static size_t bench_codepoint_count(const char *text) {
+  size_t count = 0;
+
+  for (; *text != '\0'; ++text) {
+    if (((unsigned char)*text & 0xC0u) != 0x80u) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+/* Returns up to `bytes` of "ab" plus a Cyrillic letter, repeated, so the
+   planner's ASCII fast path restarts after every third character. */
+static char *bench_mixed_script_text(size_t bytes) {
+  static const char unit[] = "ab\xd0\x9f";
+  char *text = (char *)malloc(bytes + 1u);
+  size_t used = 0;
+
+  if (text == NULL) {
+    return NULL;
+  }
+  while (used + sizeof(unit) - 1u <= bytes) {
+    memcpy(text + used, unit, sizeof(unit) - 1u);
+    used += sizeof(unit) - 1u;
+  }
+  text[used] = '\0';
+  return text;
+}
+
+static bool bench_typing_plan_build(void *state) {
+  axidev_io_typing_step *steps = NULL;
+
+  if (state == NULL) {
+    return false;
+  }
+  if (axidev_io_typing_plan_build((const char *)state, &steps) !=
+      AXIDEV_IO_RESULT_OK) {
+    return false;
+  }
+  axidev_io_typing_plan_free(&steps);
+  return true;
+}
+
+static bool bench_lookup_character(void *state) {
+  axidev_io_keyboard_key_with_modifier_t key;
+  bool found = false;
+
+  (void)state;
+  for (uint32_t cp = 0x20; cp < 0x7F; ++cp) {
+    found |= axidev_io_keymap_lookup_character(cp, &key) ==
+             AXIDEV_IO_RESULT_OK;
+  }
+  return found;
+}
+
+static bool bench_resolve_key_request(void *state) {
+  int32_t keycode;
+  axidev_io_keyboard_modifier_t mods;
+  axidev_io_keyboard_key_t resolved;
+  bool found = false;
+
+  (void)state;
+  for (int key = AXIDEV_IO_KEY_A; key <= AXIDEV_IO_KEY_Z; ++key) {
+    axidev_io_keyboard_key_with_modifier_t request = {
+        (axidev_io_keyboard_key_t)key,
+        (key & 1) != 0 ? AXIDEV_IO_MOD_SHIFT : AXIDEV_IO_MOD_NONE};
+    found |= axidev_io_keymap_resolve_key_request(request, &keycode, &mods,
+                                                  &resolved) ==
+             AXIDEV_IO_RESULT_OK;
+  }
+  return found;
+}
+
+static const char *const g_key_names[] = {
+    "a",        "Enter",  "space",         "F12",
+    "Shift",    "KP_Add", "XF86AudioPlay", "BackSpace",
+    "PageDown", "Ctrl",   "Zenkaku",       "not-a-key",
+};
+#define BENCH_KEY_NAME_COUNT (sizeof(g_key_names) / sizeof(g_key_names[0]))
+
+static bool bench_string_to_key(void *state) {
+  bool found = false;
+
+  (void)state;
+  for (size_t i = 0; i < BENCH_KEY_NAME_COUNT; ++i) {
+    found |= axidev_io_string_to_key_internal(g_key_names[i]) !=
+             AXIDEV_IO_KEY_UNKNOWN;
+  }
+  return found;
+}
+
+static void bench_discard_events(const axidev_io_key_event_t *events,
+                                 size_t count, void *user_data) {
+  (void)events;
+  (void)count;
+  (void)user_data;
+}
+
+typedef struct bench_listener_state {
+  axidev_io_listener_synthetic_key keys[BENCH_LISTENER_EVENTS];
+} bench_listener_state;
+
+/* Letters typed with Shift held around every fourth one, as the platform
+   code of each key (evdev on Linux, virtual keys on Windows). */
+static bool bench_listener_prepare(bench_listener_state *state) {
+  int32_t shift_code;
+  size_t count = 0;
+  int key = AXIDEV_IO_KEY_A;
+
+  if (axidev_io_keymap_code_for_key(AXIDEV_IO_KEY_SHIFT_LEFT, &shift_code) !=
+      AXIDEV_IO_RESULT_OK) {
+    return false;
+  }
+  while (count + 4 <= BENCH_LISTENER_EVENTS) {
+    int32_t code;
+    bool shifted = ((key - AXIDEV_IO_KEY_A) % 4) == 0;
+
+    if (axidev_io_keymap_code_for_key((axidev_io_keyboard_key_t)key, &code) !=
+        AXIDEV_IO_RESULT_OK) {
+      return false;
+    }
+    if (shifted) {
+      state->keys[count++] =
+          (axidev_io_listener_synthetic_key){(uint32_t)shift_code, true};
+    }
+    state->keys[count++] =
+        (axidev_io_listener_synthetic_key){(uint32_t)code, true};
+    state->keys[count++] =
+        (axidev_io_listener_synthetic_key){(uint32_t)code, false};
+    if (shifted) {
+      state->keys[count++] =
+          (axidev_io_listener_synthetic_key){(uint32_t)shift_code, false};
+    }
+    key = key == AXIDEV_IO_KEY_Z ? AXIDEV_IO_KEY_A : key + 1;
+  }
+  while (count < BENCH_LISTENER_EVENTS) {
+    state->keys[count++] =
+        (axidev_io_listener_synthetic_key){(uint32_t)shift_code, false};
+  }
+  return true;
+}
+
+static bool bench_listener_translate(void *state) {
+  bench_listener_state *listener = (bench_listener_state *)state;
+
+  return axidev_io_keyboard_listener_replay_for_tests(
+             listener->keys, BENCH_LISTENER_EVENTS, bench_discard_events,
+             NULL) == AXIDEV_IO_RESULT_OK;
+}
+
+static void bench_quiet_log(axidev_io_log_level_t level, const char *file,
+                            int line, const char *message, void *user_data) {
+  (void)level;
+  (void)file;
+  (void)line;
+  (void)message;
+  (void)user_data;
+}
+
+int main(void) {
+  static const char ascii_text[] =
+      "the quick brown fox jumps over the lazy dog 0123456789";
+  static const char mixed_text[] =
+      "The Quick Brown Fox Jumps Over The Lazy Dog, Twice!";
+  static const char non_latin_text[] =
+      "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 "
+      "\xce\xba\xcf\x8c\xcf\x83\xce\xbc\xce\xb5 "
+      "\xe3\x81\x93\xe3\x82\x93\xe3\x81\xab\xe3\x81\xa1\xe3\x81\xaf";
+  static bench_listener_state listener;
+  char *plan_short_text;
+  char *plan_long_text;
+
+  /* Failures of unsupported cases are reported in the table instead. */
+  axidev_io_log_set_sink(bench_quiet_log, NULL);
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  if (!axidev_io_keyboard_initialize()) {
+    char *error_text = axidev_io_get_last_error();
+    fprintf(stderr, "capture sender failed to initialize: %s\n",
+            error_text != NULL ? error_text : "unknown error");
+    axidev_io_free_string(error_text);
+    return EXIT_FAILURE;
+  }
+  /* Pacing would dominate; only the library's own work is timed. */
+  axidev_io_keyboard_set_key_delay(0);
+
+  printf("axidev-io %s hot paths, capture backend\n",
+         axidev_io_library_version());
+  printf("%-36s %12s %12s\n", "case", "ns/op", "allocs/op");
+  bench_run("type_text ascii (per char)", bench_type_text,
+            (void *)ascii_text, bench_codepoint_count(ascii_text));
+  bench_run("type_text mixed case (per char)", bench_type_text,
+            (void *)mixed_text, bench_codepoint_count(mixed_text));
+  bench_run("type_text non-latin (per char)", bench_type_text,
+            (void *)non_latin_text, bench_codepoint_count(non_latin_text));
+  plan_short_text = bench_mixed_script_text(BENCH_PLAN_SHORT_BYTES);
+  plan_long_text = bench_mixed_script_text(BENCH_PLAN_LONG_BYTES);
+  bench_run("typing plan mixed 4K (per char)", bench_typing_plan_build,
+            plan_short_text,
+            plan_short_text != NULL ? bench_codepoint_count(plan_short_text)
+                                    : 1u);
+  bench_run("typing plan mixed 64K (per char)", bench_typing_plan_build,
+            plan_long_text,
+            plan_long_text != NULL ? bench_codepoint_count(plan_long_text)
+                                   : 1u);
+  free(plan_short_text);
+  free(plan_long_text);
+  bench_run("keymap_lookup_character", bench_lookup_character, NULL,
+            0x7F - 0x20);
+  bench_run("keymap_resolve_key_request", bench_resolve_key_request, NULL,
+            AXIDEV_IO_KEY_Z - AXIDEV_IO_KEY_A + 1);
+  bench_run("string_to_key", bench_string_to_key, NULL, BENCH_KEY_NAME_COUNT);
+  if (bench_listener_prepare(&listener)) {
+    bench_run("listener translate (per event)", bench_listener_translate,
+              &listener, BENCH_LISTENER_EVENTS);
+  } else {
+    printf("%-36s %12s %12s\n", "listener translate (per event)",
+           "unsupported", "-");
+  }
+
+  axidev_io_keyboard_free();
+  axidev_io_keyboard_set_sender_options(0);
+  axidev_io_log_set_sink(NULL, NULL);
+  return EXIT_SUCCESS;
+}
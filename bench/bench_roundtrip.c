@@ -0,0 +1,439 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <axidev-io/c_api.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* Round trip through the real sender and listener in one process: each
+   injected letter is timed from just before the send until the listener
+   callback sees it. Letters cycle a..z so the callback can check that every
+   transition arrives once and in order. */
+
+#define ROUNDTRIP_LETTERS 26u
+#define ROUNDTRIP_DEFAULT_SAMPLES 2000u
+#define ROUNDTRIP_BURST 500u
+#define ROUNDTRIP_DEFAULT_DELAY_US 1000u
+/* A transition not seen within this long counts as dropped. */
+#define ROUNDTRIP_TIMEOUT_NS 2000000000ull
+#define ROUNDTRIP_WARMUP_TRIES 50u
+
+typedef struct roundtrip_state {
+  /* Press receive times, written by the callback before it publishes
+     `presses`. */
+  uint64_t *press_ns;
+  size_t press_capacity;
+  atomic_uint_fast64_t presses;
+  atomic_uint_fast64_t releases;
+  atomic_uint_fast64_t out_of_order;
+} roundtrip_state;
+
+static roundtrip_state g_state;
+
+static uint64_t roundtrip_now_ns(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+
+  if (frequency.QuadPart == 0) {
+    QueryPerformanceFrequency(&frequency);
+  }
+  QueryPerformanceCounter(&counter);
+  return (uint64_t)((double)counter.QuadPart * 1e9 /
+                    (double)frequency.QuadPart);
+#else
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static void roundtrip_pause(void) {
+#ifdef _WIN32
+  Sleep(0);
+#else
+  struct timespec pause = {0, 20000L};
+  nanosleep(&pause, NULL);
+#endif
+}
+
+static void roundtrip_sleep_ms(unsigned int ms) {
+#ifdef _WIN32
+  Sleep(ms);
+#else
+  struct timespec pause;
+  pause.tv_sec = (time_t)(ms / 1000u);
+  pause.tv_nsec = (long)(ms % 1000u) * 1000000L;
+  nanosleep(&pause, NULL);
+#endif
+}
+
+static axidev_io_keyboard_key_t roundtrip_letter(uint64_t index) {
+  return (axidev_io_keyboard_key_t)(AXIDEV_IO_KEY_A +
+                                    (int)(index % ROUNDTRIP_LETTERS));
+}
+
+static void roundtrip_listener_cb(const axidev_io_key_event_t *events,
+                                  size_t count, void *user_data) {
+  roundtrip_state *state = (roundtrip_state *)user_data;
+  uint64_t now_ns = roundtrip_now_ns();
+
+  for (size_t i = 0; i < count; ++i) {
+    axidev_io_keyboard_key_t key = events[i].key_mod.key;
+    atomic_uint_fast64_t *counter;
+    uint64_t index;
+
+    if (key < AXIDEV_IO_KEY_A || key > AXIDEV_IO_KEY_Z) {
+      continue;
+    }
+    counter = events[i].pressed ? &state->presses : &state->releases;
+    index = atomic_load_explicit(counter, memory_order_relaxed);
+    if (key != roundtrip_letter(index)) {
+      atomic_fetch_add_explicit(&state->out_of_order, 1u,
+                                memory_order_relaxed);
+    }
+    if (events[i].pressed && index < state->press_capacity) {
+      state->press_ns[index] = now_ns;
+    }
+    atomic_store_explicit(counter, index + 1u, memory_order_release);
+  }
+}
+
+static void roundtrip_reset(void) {
+  atomic_store(&g_state.presses, 0);
+  atomic_store(&g_state.releases, 0);
+  atomic_store(&g_state.out_of_order, 0);
+}
+
+/* Waits until `counter` reaches `target`, giving up once it stops moving
+   for ROUNDTRIP_TIMEOUT_NS. Returns the final count. */
+static uint64_t roundtrip_wait(atomic_uint_fast64_t *counter,
+                               uint64_t target) {
+  uint64_t seen = atomic_load_explicit(counter, memory_order_acquire);
+  uint64_t progress_ns = roundtrip_now_ns();
+
+  while (seen < target) {
+    uint64_t now = atomic_load_explicit(counter, memory_order_acquire);
+    if (now != seen) {
+      seen = now;
+      progress_ns = roundtrip_now_ns();
+    } else if (roundtrip_now_ns() - progress_ns > ROUNDTRIP_TIMEOUT_NS) {
+      break;
+    }
+    roundtrip_pause();
+  }
+  return seen;
+}
+
+static bool roundtrip_tap(uint64_t index) {
+  if (!axidev_io_keyboard_tap((axidev_io_keyboard_key_with_modifier_t){
+          roundtrip_letter(index), AXIDEV_IO_MOD_NONE})) {
+    char *error_text = axidev_io_get_last_error();
+    fprintf(stderr, "tap failed: %s\n",
+            error_text != NULL ? error_text : "(no error)");
+    axidev_io_free_string(error_text);
+    return false;
+  }
+  return true;
+}
+
+/* Taps until the listener reports one, so device discovery is not timed. */
+static bool roundtrip_warm_up(void) {
+  for (unsigned int i = 0; i < ROUNDTRIP_WARMUP_TRIES; ++i) {
+    roundtrip_reset();
+    if (!roundtrip_tap(0)) {
+      return false;
+    }
+    roundtrip_sleep_ms(100);
+    if (atomic_load(&g_state.releases) > 0) {
+      roundtrip_sleep_ms(100);
+      roundtrip_reset();
+      return true;
+    }
+  }
+  fprintf(stderr, "listener never saw an injected key\n");
+  return false;
+}
+
+static int roundtrip_compare(const void *a, const void *b) {
+  uint64_t left = *(const uint64_t *)a;
+  uint64_t right = *(const uint64_t *)b;
+  return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+static double roundtrip_percentile_us(const uint64_t *sorted, size_t count,
+                                      double fraction) {
+  size_t rank = (size_t)(fraction * (double)count + 0.999999);
+
+  if (rank == 0) {
+    rank = 1;
+  }
+  if (rank > count) {
+    rank = count;
+  }
+  return (double)sorted[rank - 1] / 1000.0;
+}
+
+typedef struct roundtrip_totals {
+  uint64_t sent;
+  uint64_t dropped;
+  uint64_t out_of_order;
+} roundtrip_totals;
+
+static void roundtrip_account(roundtrip_totals *totals, uint64_t sent) {
+  uint64_t presses = roundtrip_wait(&g_state.presses, sent);
+  uint64_t releases = roundtrip_wait(&g_state.releases, sent);
+
+  totals->sent += sent;
+  totals->dropped += (sent - presses) + (sent - releases);
+  totals->out_of_order += atomic_load(&g_state.out_of_order);
+}
+
+/* One key in flight at a time; each press is timed from its send. */
+static bool roundtrip_measure_latency(size_t samples, uint64_t *latencies,
+                                      roundtrip_totals *totals) {
+  size_t measured = 0;
+
+  roundtrip_reset();
+  for (size_t i = 0; i < samples; ++i) {
+    uint64_t sent_ns = roundtrip_now_ns();
+
+    if (!roundtrip_tap(i)) {
+      return false;
+    }
+    if (roundtrip_wait(&g_state.presses, i + 1u) < i + 1u) {
+      break;
+    }
+    latencies[measured++] = g_state.press_ns[i] - sent_ns;
+  }
+  roundtrip_account(totals, samples);
+  qsort(latencies, measured, sizeof(latencies[0]), roundtrip_compare);
+  if (measured == 0) {
+    printf("  latency: no samples\n");
+    return true;
+  }
+  printf("  latency over %zu taps: p50 %.1f us, p99 %.1f us, "
+         "p999 %.1f us, max %.1f us\n",
+         measured, roundtrip_percentile_us(latencies, measured, 0.50),
+         roundtrip_percentile_us(latencies, measured, 0.99),
+         roundtrip_percentile_us(latencies, measured, 0.999),
+         (double)latencies[measured - 1] / 1000.0);
+  return true;
+}
+
+/* Back-to-back taps; throughput runs until the last release arrives. */
+static bool roundtrip_burst(size_t count, roundtrip_totals *totals,
+                            double *out_keys_per_second) {
+  uint64_t start_ns;
+  uint64_t elapsed_ns;
+
+  roundtrip_reset();
+  start_ns = roundtrip_now_ns();
+  for (size_t i = 0; i < count; ++i) {
+    if (!roundtrip_tap(i)) {
+      return false;
+    }
+  }
+  roundtrip_account(totals, count);
+  elapsed_ns = roundtrip_now_ns() - start_ns;
+  *out_keys_per_second =
+      elapsed_ns > 0 ? (double)count * 1e9 / (double)elapsed_ns : 0.0;
+  return true;
+}
+
+static void roundtrip_print_totals(const roundtrip_totals *totals) {
+  printf("  transitions: %llu taps, %llu dropped, %llu out of order\n",
+         (unsigned long long)totals->sent,
+         (unsigned long long)totals->dropped,
+         (unsigned long long)totals->out_of_order);
+}
+
+static bool roundtrip_run_pass(uint32_t delay_us, size_t samples,
+                               uint64_t *latencies,
+                               roundtrip_totals *totals) {
+  double keys_per_second = 0.0;
+
+  axidev_io_keyboard_set_key_delay(delay_us);
+  printf("key_delay_us=%u\n", (unsigned)delay_us);
+  if (!roundtrip_measure_latency(samples, latencies, totals) ||
+      !roundtrip_burst(ROUNDTRIP_BURST, totals, &keys_per_second)) {
+    return false;
+  }
+  printf("  throughput over %u taps: %.0f keys/s\n", ROUNDTRIP_BURST,
+         keys_per_second);
+  return true;
+}
+
+/* Repeats bursts for `seconds`, failing on any lost or reordered event. */
+static bool roundtrip_soak(unsigned int seconds, uint32_t delay_us,
+                           roundtrip_totals *totals) {
+  uint64_t end_ns = roundtrip_now_ns() + (uint64_t)seconds * 1000000000ull;
+  uint64_t bursts = 0;
+  double slowest = 0.0;
+
+  axidev_io_keyboard_set_key_delay(delay_us);
+  printf("soak: %u s with key_delay_us=%u\n", seconds, (unsigned)delay_us);
+  while (roundtrip_now_ns() < end_ns) {
+    double keys_per_second = 0.0;
+
+    if (!roundtrip_burst(ROUNDTRIP_BURST, totals, &keys_per_second)) {
+      return false;
+    }
+    if (bursts == 0 || keys_per_second < slowest) {
+      slowest = keys_per_second;
+    }
+    ++bursts;
+    if (totals->dropped != 0 || totals->out_of_order != 0) {
+      break;
+    }
+  }
+  printf("  %llu bursts, slowest %.0f keys/s\n", (unsigned long long)bursts,
+         slowest);
+  return true;
+}
+
+#ifdef _WIN32
+static HANDLE g_console;
+static DWORD g_console_mode;
+static bool g_console_saved;
+
+/* Injected letters land in this console; stop echoing them. */
+static void roundtrip_quiet_terminal(void) {
+  g_console = GetStdHandle(STD_INPUT_HANDLE);
+  if (g_console != INVALID_HANDLE_VALUE &&
+      GetConsoleMode(g_console, &g_console_mode)) {
+    g_console_saved = true;
+    SetConsoleMode(g_console, g_console_mode & ~(DWORD)(ENABLE_ECHO_INPUT |
+                                                        ENABLE_LINE_INPUT));
+  }
+}
+
+static void roundtrip_restore_terminal(void) {
+  if (g_console_saved) {
+    FlushConsoleInputBuffer(g_console);
+    SetConsoleMode(g_console, g_console_mode);
+  }
+}
+#else
+static struct termios g_termios;
+static bool g_termios_saved;
+
+/* Injected letters land in this terminal; stop echoing them. */
+static void roundtrip_quiet_terminal(void) {
+  struct termios quiet;
+
+  if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &g_termios) != 0) {
+    return;
+  }
+  g_termios_saved = true;
+  quiet = g_termios;
+  quiet.c_lflag &= (tcflag_t) ~(ECHO | ICANON);
+  tcsetattr(STDIN_FILENO, TCSANOW, &quiet);
+}
+
+static void roundtrip_restore_terminal(void) {
+  if (g_termios_saved) {
+    tcflush(STDIN_FILENO, TCIFLUSH);
+    tcsetattr(STDIN_FILENO, TCSANOW, &g_termios);
+  }
+}
+#endif
+
+static void roundtrip_usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [--samples N] [--soak SECONDS] [--delay-us US]\n"
+          "  --samples   latency taps per pass (default %u)\n"
+          "  --soak      repeat bursts for SECONDS and check every event\n"
+          "  --delay-us  key_delay_us for the soak (default 0)\n",
+          program, ROUNDTRIP_DEFAULT_SAMPLES);
+}
+
+int main(int argc, char **argv) {
+  size_t samples = ROUNDTRIP_DEFAULT_SAMPLES;
+  unsigned int soak_seconds = 0;
+  uint32_t soak_delay_us = 0;
+  roundtrip_totals totals;
+  uint64_t *latencies;
+  char line[64];
+  bool ok;
+
+  for (int i = 1; i < argc; ++i) {
+    if (i + 1 < argc && strcmp(argv[i], "--samples") == 0) {
+      samples = (size_t)strtoul(argv[++i], NULL, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "--soak") == 0) {
+      soak_seconds = (unsigned int)strtoul(argv[++i], NULL, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "--delay-us") == 0) {
+      soak_delay_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else {
+      roundtrip_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (samples == 0) {
+    roundtrip_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  memset(&g_state, 0, sizeof(g_state));
+  memset(&totals, 0, sizeof(totals));
+  g_state.press_capacity = samples;
+  g_state.press_ns = (uint64_t *)calloc(samples, sizeof(uint64_t));
+  latencies = (uint64_t *)calloc(samples, sizeof(uint64_t));
+  if (g_state.press_ns == NULL || latencies == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("Round-trip benchmark\n");
+  printf("Keep this terminal focused, then press ENTER. Letters a-z are "
+         "injected and discarded.\n");
+  fflush(stdout);
+  if (fgets(line, sizeof(line), stdin) == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  if (!axidev_io_keyboard_initialize() ||
+      !axidev_io_listener_start_batched(roundtrip_listener_cb, &g_state)) {
+    char *error_text = axidev_io_get_last_error();
+    fprintf(stderr, "setup failed: %s\n",
+            error_text != NULL ? error_text : "(no error)");
+    axidev_io_free_string(error_text);
+    axidev_io_keyboard_free();
+    return EXIT_FAILURE;
+  }
+
+  roundtrip_quiet_terminal();
+  ok = roundtrip_warm_up();
+  if (ok && soak_seconds > 0) {
+    ok = roundtrip_soak(soak_seconds, soak_delay_us, &totals);
+  } else if (ok) {
+    ok = roundtrip_run_pass(0, samples, latencies, &totals) &&
+         roundtrip_run_pass(ROUNDTRIP_DEFAULT_DELAY_US, samples, latencies,
+                            &totals);
+  }
+  roundtrip_print_totals(&totals);
+  roundtrip_restore_terminal();
+
+  axidev_io_listener_stop();
+  axidev_io_keyboard_free();
+  free(latencies);
+  free(g_state.press_ns);
+  return ok && totals.dropped == 0 && totals.out_of_order == 0
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
+}
@@ -30,10 +30,18 @@ COMMON_SOURCES = [
     Path("src/c_api.c"),
     Path("src/core/context.c"),
     Path("src/core/log.c"),
+    Path("src/core/stats.c"),
     Path("src/internal/utf.c"),
     Path("src/vendor/stb_ds_impl.c"),
     Path("src/keyboard/common/key_utils.c"),
     Path("src/keyboard/common/keymap.c"),
+    Path("src/keyboard/common/keymap_snapshot.c"),
+    Path("src/keyboard/sender/typing_plan.c"),
+    Path("src/keyboard/sender/sender_queue.c"),
+    Path("src/keyboard/sender/sender_repeat.c"),
+    Path("src/keyboard/sender/sender_capture.c"),
+    Path("src/keyboard/listener/listener_dispatch.c"),
+    Path("src/keyboard/macro/macro.c"),
 ]
 UNIT_TEST_SOURCES = [
     Path("tests/test_key_utils.c"),
@@ -44,6 +52,10 @@ INTEGRATION_TEST_SOURCES = [
     Path("tests/test_integration_listener.c"),
 ]
 EXAMPLE_SOURCE = Path("examples/example_c.c")
+BENCH_SOURCE = Path("bench/bench_hot_paths.c")
+BENCH_INTEGRATION_SOURCE = Path("bench/bench_roundtrip.c")
+BENCH_DIR_NAME = "bench"
+ASAN_DIR_NAME = "asan"
 LINUX_PERMISSION_HELPER = Path("scripts/setup_uinput_permissions.sh")
 COMPILE_COMMANDS_FILENAME = "compile_commands.json"
 
@@ -160,7 +172,7 @@ def make_config(build_dir: Path) -> BuildConfig:
                 Path("src/keyboard/listener/listener_windows.c"),
             ]
         )
-        platform_libs.extend(["-luser32", "-lkernel32"])
+        platform_libs.extend(["-luser32", "-lkernel32", "-ladvapi32"])
     else:
         pkg_config = os.environ.get("PKG_CONFIG", "pkg-config")
         cppflags.append("-DAXIDEV_IO_STATIC")
@@ -187,6 +199,7 @@ def make_config(build_dir: Path) -> BuildConfig:
                 Path("src/internal/thread_pthread.c"),
                 Path("src/keyboard/common/linux_layout.c"),
                 Path("src/keyboard/common/linux_keysym.c"),
+                Path("src/keyboard/common/linux_layout_cache.c"),
                 Path("src/keyboard/sender/sender_uinput.c"),
                 Path("src/keyboard/listener/listener_linux.c"),
             ]
@@ -212,6 +225,25 @@ def make_config(build_dir: Path) -> BuildConfig:
     )
 
 
+def make_bench_config(build_dir: Path) -> BuildConfig:
+    # Benchmarks build into their own tree so optimized objects never mix
+    # with the test build. An explicit CFLAGS is used as given.
+    config = make_config(build_dir / BENCH_DIR_NAME)
+    if not os.environ.get("CFLAGS"):
+        config.cflags.extend(["-O2", "-DNDEBUG"])
+    return config
+
+
+def make_asan_config(build_dir: Path) -> BuildConfig:
+    # AddressSanitizer builds use a separate tree as well; the sanitizer
+    # flags are added on top of CFLAGS/LDFLAGS so they cannot be dropped.
+    config = make_config(build_dir / ASAN_DIR_NAME)
+    sanitize = ["-fsanitize=address", "-fno-omit-frame-pointer", "-g"]
+    config.cflags.extend(sanitize)
+    config.ldflags.extend(sanitize)
+    return config
+
+
 def ensure_parent(path: Path) -> None:
     path.parent.mkdir(parents=True, exist_ok=True)
 
@@ -253,6 +285,8 @@ def all_compilation_sources(config: BuildConfig) -> list[Path]:
         *UNIT_TEST_SOURCES,
         *INTEGRATION_TEST_SOURCES,
         EXAMPLE_SOURCE,
+        BENCH_SOURCE,
+        BENCH_INTEGRATION_SOURCE,
     ]
     unique_sources: list[Path] = []
     seen: set[Path] = set()
@@ -419,11 +453,14 @@ def parse_args() -> argparse.Namespace:
             "compile-commands",
             "test",
             "test-unit",
+            "test-asan",
             "test-integration",
             "unit-binaries",
             "integration-binaries",
             "package-integration-tests",
             "example",
+            "bench",
+            "bench-integration",
             "clean",
             "package",
         ],
@@ -481,6 +518,13 @@ def main() -> int:
             run_binary(binary)
         return 0
 
+    if args.command == "test-asan":
+        asan_config = make_asan_config(Path(args.build_dir))
+        binaries = [build_binary(asan_config, source) for source in UNIT_TEST_SOURCES]
+        for binary in binaries:
+            run_binary(binary)
+        return 0
+
     if args.command == "test-integration":
         binaries = [build_binary(config, source) for source in INTEGRATION_TEST_SOURCES]
         for binary in binaries:
@@ -491,6 +535,15 @@ def main() -> int:
         build_binary(config, EXAMPLE_SOURCE)
         return 0
 
+    if args.command == "bench":
+        run_binary(build_binary(make_bench_config(Path(args.build_dir)), BENCH_SOURCE))
+        return 0
+
+    if args.command == "bench-integration":
+        bench_config = make_bench_config(Path(args.build_dir))
+        run_binary(build_binary(bench_config, BENCH_INTEGRATION_SOURCE))
+        return 0
+
     if args.command == "package":
         package_output(config, args.version, args.arch)
         return 0
@@ -39,6 +39,43 @@ extern "C" {
 #define AXIDEV_IO_KEYBOARD_LISTENER_STORAGE_SIZE 16384u
 #define AXIDEV_IO_KEYBOARD_KEYMAP_STORAGE_SIZE 8192u
 #define AXIDEV_IO_GLOBAL_PRIVATE_STORAGE_SIZE 2048u
+#define AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY 256u
+#define AXIDEV_IO_ASYNC_WAIT_INFINITE UINT32_MAX
+/* Sender options, applied by the next axidev_io_keyboard_initialize().
+   FAST_INIT registers only the keys the active layout can produce and waits
+   for the device to be announced instead of a fixed settle delay.
+   KEEP_DEVICE keeps the virtual device open across free/initialize cycles.
+   Backends without a virtual device ignore both. CAPTURE records key
+   transitions into an in-memory buffer read with
+   axidev_io_keyboard_capture_read() instead of sending them to the OS, so
+   the library's own overhead can be measured and tested without a device;
+   it takes precedence over the other two. */
+#define AXIDEV_IO_SENDER_OPTION_FAST_INIT (1u << 0)
+#define AXIDEV_IO_SENDER_OPTION_KEEP_DEVICE (1u << 1)
+#define AXIDEV_IO_SENDER_OPTION_CAPTURE (1u << 2)
+/* Transitions the capture buffer holds before overwriting the oldest. */
+#define AXIDEV_IO_SENDER_CAPTURE_CAPACITY 4096u
+/* Flags for axidev_io_sender_open(). OWN_DEVICE gives the handle its own
+   uinput device instead of sharing the global sender's; it honours
+   SENDER_OPTION_FAST_INIT. Backends without a virtual device ignore it. */
+#define AXIDEV_IO_SENDER_HANDLE_OWN_DEVICE (1u << 0)
+/* Listener options, applied by the next axidev_io_listener_start().
+   DEFERRED_DISPATCH makes the Windows keyboard hook only queue raw events;
+   a dispatcher thread translates them and runs the callback, so a slow
+   callback cannot stall system input. Events arriving while the queue is
+   full are dropped and counted. Linux already runs callbacks off the input
+   path and ignores it.
+   EVDEV makes the Linux listener read keyboards from /dev/input directly
+   instead of through libinput. Only devices with a keyboard's keys are
+   opened and hotplug follows an inotify watch; it needs read access to the
+   event nodes, as libinput does. Windows ignores it.
+   RAW_INPUT makes the Windows listener register for Raw Input on a
+   message-only window instead of installing a low-level hook, so it adds
+   no latency to other applications' input. It reads events in bulk and
+   takes precedence over DEFERRED_DISPATCH. Linux ignores it. */
+#define AXIDEV_IO_LISTENER_OPTION_DEFERRED_DISPATCH (1u << 0)
+#define AXIDEV_IO_LISTENER_OPTION_EVDEV (1u << 1)
+#define AXIDEV_IO_LISTENER_OPTION_RAW_INPUT (1u << 2)
 
 typedef union axidev_io_keyboard_sender_storage_t {
   max_align_t _align;
@@ -334,7 +371,10 @@ typedef enum axidev_io_keyboard_backend_type_t {
   AXIDEV_IO_BACKEND_WINDOWS = 1,
   AXIDEV_IO_BACKEND_MACOS = 2,
   AXIDEV_IO_BACKEND_LINUX_LIBINPUT = 3,
-  AXIDEV_IO_BACKEND_LINUX_UINPUT = 4
+  AXIDEV_IO_BACKEND_LINUX_UINPUT = 4,
+  AXIDEV_IO_BACKEND_LINUX_EVDEV = 5,
+  AXIDEV_IO_BACKEND_WINDOWS_RAW_INPUT = 6,
+  AXIDEV_IO_BACKEND_CAPTURE = 7
 } axidev_io_keyboard_backend_type_t;
 
 typedef struct axidev_io_keyboard_key_with_modifier_t {
@@ -352,21 +392,124 @@ typedef struct axidev_io_keyboard_capabilities_t {
   bool needs_uinput_access;
 } axidev_io_keyboard_capabilities_t;
 
+typedef struct axidev_io_keyboard_plan axidev_io_keyboard_plan_t;
+
+/* Independent sender opened with axidev_io_sender_open(). */
+typedef struct axidev_io_sender axidev_io_sender_t;
+
+/* Recorder created with axidev_io_macro_recorder_create(). */
+typedef struct axidev_io_macro_recorder axidev_io_macro_recorder_t;
+
+/* Identity of a virtual keyboard created by axidev_io_sender_open_device().
+   A NULL name or zero id keeps the library default for that field. */
+typedef struct axidev_io_virtual_device_t {
+  const char *name;
+  uint16_t vendor_id;
+  uint16_t product_id;
+} axidev_io_virtual_device_t;
+
+/* One transition recorded by AXIDEV_IO_SENDER_OPTION_CAPTURE. `code` is the
+   platform keycode the backend would have sent (an evdev code on Linux, a
+   virtual key on Windows) or, when `unicode` is set, a UTF-16 code unit.
+   `value` is 0 for release, 1 for press and 2 for an emulated repeat. */
+typedef struct axidev_io_captured_transition_t {
+  int32_t code;
+  uint8_t value;
+  bool unicode;
+} axidev_io_captured_transition_t;
+
 typedef void (*axidev_io_keyboard_listener_cb)(
     uint32_t codepoint, axidev_io_keyboard_key_with_modifier_t key_mod,
     bool pressed, void *user_data);
 
+/* One translated listener event. Both times are microseconds on the clock
+   of axidev_io_monotonic_time_us(). `timestamp_us` is the kernel/OS input
+   timestamp (libinput's event time on Linux, with millisecond resolution
+   from the hook message time on Windows); `dispatch_time_us` is when the
+   library handed the event to the callback or the pull queue. `code` is the
+   platform keycode the event was read as: an evdev code on Linux, a virtual
+   key on Windows. */
+typedef struct axidev_io_key_event_t {
+  uint64_t timestamp_us;
+  uint64_t dispatch_time_us;
+  uint32_t codepoint;
+  uint32_t code;
+  axidev_io_keyboard_key_with_modifier_t key_mod;
+  bool pressed;
+} axidev_io_key_event_t;
+
+/* Receives events in arrival order. `events` is only valid for the duration
+   of the call. */
+typedef void (*axidev_io_keyboard_listener_batch_cb)(
+    const axidev_io_key_event_t *events, size_t count, void *user_data);
+
+/* Readiness handle of the pull-mode listener queue: an eventfd on Linux, a
+   manual-reset event HANDLE on Windows. It is signalled while events may be
+   pending. Wait on it only; the library resets and closes it. */
+#ifdef _WIN32
+typedef void *axidev_io_listener_wait_handle_t;
+#else
+typedef int axidev_io_listener_wait_handle_t;
+#endif
+
+/* Runs on the injection worker once a job ends, including jobs dropped by
+   axidev_io_keyboard_async_cancel(), axidev_io_keyboard_free() or
+   axidev_io_keyboard_initialize(). When `success` is false,
+   axidev_io_get_last_error_code() inside the callback says why, e.g.
+   AXIDEV_IO_ERROR_CANCELLED. From the callback, initialize and free fail
+   with AXIDEV_IO_ERROR_NOT_SUPPORTED and axidev_io_keyboard_async_wait()
+   returns false. */
+typedef void (*axidev_io_keyboard_async_cb)(uint64_t job_id, bool success,
+                                            void *user_data);
+
 typedef struct axidev_io_keyboard_sender_context {
   bool initialized;
   bool ready;
   axidev_io_keyboard_modifier_t active_modifiers;
   uint32_t key_delay_us;
+  /* Set by axidev_io_keyboard_set_typing_rate(); 0 when the key delay was
+     set directly. Typed text is paced per character at this rate. */
+  uint32_t typing_rate_cps;
   uint64_t repeat_delay_ns;
   uint64_t repeat_interval_ns;
   axidev_io_keyboard_capabilities_t capabilities;
   axidev_io_keyboard_sender_storage_t storage;
 } axidev_io_keyboard_sender_context;
 
+typedef struct axidev_io_listener_stats_t {
+  uint64_t events_delivered;
+  uint64_t events_dropped;
+  uint32_t queue_capacity;
+  uint32_t queue_high_water;
+} axidev_io_listener_stats_t;
+
+/* Input-to-dispatch latency of the current listener session. Bucket 0
+   counts latencies under 1 us and bucket i counts [2^(i-1), 2^i) us; the
+   last bucket also takes everything slower. */
+#define AXIDEV_IO_LISTENER_LATENCY_BUCKETS 24u
+
+typedef struct axidev_io_listener_latency_t {
+  uint64_t samples;
+  uint64_t max_us;
+  uint64_t buckets[AXIDEV_IO_LISTENER_LATENCY_BUCKETS];
+} axidev_io_listener_latency_t;
+
+/* Listener key filter, applied by the next axidev_io_listener_start().
+   Bit k of `keys` (word k / 64, bit k % 64) selects axidev_io_keyboard_key_t
+   k; presses of other keys are dropped before any translation, and an
+   all-zero set selects every key. A press is also dropped unless all of
+   `required_mods` are active. The release of a reported press is always
+   reported. `keys_only` skips codepoint translation; events then carry
+   codepoint 0. */
+#define AXIDEV_IO_LISTENER_FILTER_WORDS                                        \
+  (((uint32_t)AXIDEV_IO_KEY_RF_KILL + 64u) / 64u)
+
+typedef struct axidev_io_listener_filter_t {
+  uint64_t keys[AXIDEV_IO_LISTENER_FILTER_WORDS];
+  axidev_io_keyboard_modifier_t required_mods;
+  bool keys_only;
+} axidev_io_listener_filter_t;
+
 typedef struct axidev_io_keyboard_listener_context {
   bool initialized;
   bool is_listening;
@@ -395,8 +538,26 @@ enum {
   AXIDEV_IO_LOG_LEVEL_ERROR = 3
 };
 
+typedef uint8_t axidev_io_error_code_t;
+
+enum {
+  AXIDEV_IO_ERROR_NONE = 0,
+  AXIDEV_IO_ERROR_INVALID_ARGUMENT = 1,
+  AXIDEV_IO_ERROR_NOT_INITIALIZED = 2,
+  AXIDEV_IO_ERROR_ALREADY_INITIALIZED = 3,
+  AXIDEV_IO_ERROR_NOT_SUPPORTED = 4,
+  AXIDEV_IO_ERROR_PERMISSION_DENIED = 5,
+  AXIDEV_IO_ERROR_NOT_FOUND = 6,
+  AXIDEV_IO_ERROR_BUFFER_TOO_SMALL = 7,
+  AXIDEV_IO_ERROR_PLATFORM = 8,
+  AXIDEV_IO_ERROR_INTERNAL = 9,
+  AXIDEV_IO_ERROR_QUEUE_FULL = 10,
+  AXIDEV_IO_ERROR_CANCELLED = 11
+};
+
 typedef struct axidev_io_global_context {
   axidev_io_log_level_t log_level;
+  /* Unused: last errors are kept per thread. Kept for layout. */
   char *last_error;
   axidev_io_keyboard_context keyboard;
   axidev_io_global_private_storage_t private_storage;
@@ -406,6 +567,13 @@ AXIDEV_IO_API extern axidev_io_global_context *axidev_io_global;
 
 AXIDEV_IO_API bool axidev_io_keyboard_initialize(void);
 AXIDEV_IO_API void axidev_io_keyboard_free(void);
+/* Picks up a keyboard layout switch without reinitializing: re-detects the
+   active layout and swaps in its lookup tables, keeping the sender device.
+   The tables of the last few layouts stay cached, so switching back is
+   free. `out_changed` (may be NULL) reports whether the layout differed.
+   Like axidev_io_keyboard_initialize(), fails while sender handles are
+   open. A running listener follows layout switches on its own. */
+AXIDEV_IO_API bool axidev_io_keyboard_refresh_layout(bool *out_changed);
 AXIDEV_IO_API bool axidev_io_keyboard_is_ready(void);
 AXIDEV_IO_API axidev_io_keyboard_backend_type_t axidev_io_keyboard_type(void);
 AXIDEV_IO_API void axidev_io_keyboard_get_capabilities(
@@ -427,25 +595,229 @@ axidev_io_keyboard_release_modifier(axidev_io_keyboard_modifier_t mods);
 AXIDEV_IO_API bool axidev_io_keyboard_release_all_modifiers(void);
 AXIDEV_IO_API bool axidev_io_keyboard_type_text(const char *text);
 AXIDEV_IO_API bool axidev_io_keyboard_type_character(uint32_t codepoint);
+AXIDEV_IO_API axidev_io_keyboard_plan_t *
+axidev_io_keyboard_plan_compile(const char *text);
+AXIDEV_IO_API bool
+axidev_io_keyboard_plan_play(axidev_io_keyboard_plan_t *plan);
+AXIDEV_IO_API void
+axidev_io_keyboard_plan_free(axidev_io_keyboard_plan_t *plan);
+AXIDEV_IO_API uint64_t axidev_io_keyboard_type_text_async(
+    const char *text, axidev_io_keyboard_async_cb cb, void *user_data);
+AXIDEV_IO_API uint64_t
+axidev_io_keyboard_tap_async(axidev_io_keyboard_key_with_modifier_t key_mod,
+                             axidev_io_keyboard_async_cb cb, void *user_data);
+AXIDEV_IO_API bool axidev_io_keyboard_async_wait(uint64_t job_id,
+                                                 uint32_t timeout_ms);
+AXIDEV_IO_API bool axidev_io_keyboard_async_cancel(uint64_t job_id);
+AXIDEV_IO_API size_t axidev_io_keyboard_async_pending(void);
 AXIDEV_IO_API void axidev_io_keyboard_flush(void);
 AXIDEV_IO_API void axidev_io_keyboard_set_key_delay(uint32_t delay_us);
+AXIDEV_IO_API void
+axidev_io_keyboard_set_typing_rate(uint32_t chars_per_second);
+AXIDEV_IO_API void axidev_io_keyboard_set_pacing_spin(uint32_t spin_us);
+AXIDEV_IO_API void axidev_io_keyboard_set_sender_options(uint32_t options);
+AXIDEV_IO_API uint32_t axidev_io_keyboard_get_sender_options(void);
+/* Moves up to `max_count` captured transitions, oldest first, into `out`
+   and returns how many were moved. Returns 0 unless the global sender was
+   initialized with AXIDEV_IO_SENDER_OPTION_CAPTURE. Handles sharing the
+   global sender record into the same buffer. */
+AXIDEV_IO_API size_t
+axidev_io_keyboard_capture_read(axidev_io_captured_transition_t *out,
+                                size_t max_count);
+AXIDEV_IO_API bool axidev_io_keyboard_set_keymap_cache_dir(const char *path);
+AXIDEV_IO_API bool axidev_io_keyboard_invalidate_keymap_cache(void);
+
+/* Sender handles own their modifier state, event buffer, key delay and
+   pacing, and share the keymap of axidev_io_keyboard_initialize() without
+   locking. Calls on a handle never take the global lock, so handles driven
+   from different threads do not contend; a single handle must not be used
+   from two threads at once. Close every handle before
+   axidev_io_keyboard_free() or re-initializing. The axidev_io_keyboard_*
+   functions keep driving the global sender. */
+AXIDEV_IO_API axidev_io_sender_t *axidev_io_sender_open(uint32_t flags);
+/* Opens a handle with its own virtual device named by `device`, as with
+   AXIDEV_IO_SENDER_HANDLE_OWN_DEVICE. Each such handle is a separate kernel
+   input device with its own event queue. */
+AXIDEV_IO_API axidev_io_sender_t *
+axidev_io_sender_open_device(const axidev_io_virtual_device_t *device);
+AXIDEV_IO_API void axidev_io_sender_close(axidev_io_sender_t *sender);
+AXIDEV_IO_API bool
+axidev_io_sender_key_down(axidev_io_sender_t *sender,
+                          axidev_io_keyboard_key_with_modifier_t key_mod,
+                          bool repeat);
+AXIDEV_IO_API bool
+axidev_io_sender_key_up(axidev_io_sender_t *sender,
+                        axidev_io_keyboard_key_with_modifier_t key_mod);
+AXIDEV_IO_API bool
+axidev_io_sender_tap(axidev_io_sender_t *sender,
+                     axidev_io_keyboard_key_with_modifier_t key_mod);
+AXIDEV_IO_API axidev_io_keyboard_modifier_t
+axidev_io_sender_active_modifiers(const axidev_io_sender_t *sender);
+AXIDEV_IO_API bool
+axidev_io_sender_hold_modifier(axidev_io_sender_t *sender,
+                               axidev_io_keyboard_modifier_t mods);
+AXIDEV_IO_API bool
+axidev_io_sender_release_modifier(axidev_io_sender_t *sender,
+                                  axidev_io_keyboard_modifier_t mods);
+AXIDEV_IO_API bool
+axidev_io_sender_release_all_modifiers(axidev_io_sender_t *sender);
+AXIDEV_IO_API bool axidev_io_sender_type_text(axidev_io_sender_t *sender,
+                                              const char *text);
+AXIDEV_IO_API bool axidev_io_sender_type_character(axidev_io_sender_t *sender,
+                                                   uint32_t codepoint);
+AXIDEV_IO_API void axidev_io_sender_flush(axidev_io_sender_t *sender);
+AXIDEV_IO_API void axidev_io_sender_set_key_delay(axidev_io_sender_t *sender,
+                                                  uint32_t delay_us);
 
 AXIDEV_IO_API bool axidev_io_listener_start(axidev_io_keyboard_listener_cb cb,
                                             void *user_data);
+AXIDEV_IO_API bool
+axidev_io_listener_start_batched(axidev_io_keyboard_listener_batch_cb cb,
+                                 void *user_data);
+AXIDEV_IO_API bool axidev_io_listener_open_queue(
+    axidev_io_listener_wait_handle_t *out_handle);
+AXIDEV_IO_API size_t axidev_io_listener_read_events(
+    axidev_io_key_event_t *events, size_t max_events);
 AXIDEV_IO_API void axidev_io_listener_stop(void);
+/* Adds `cb` to the listener fan-out. Subscribers receive every batch of any
+   running session after its own callback, and stay subscribed across
+   sessions. Returns a nonzero token, or 0 on failure. A batch already in
+   flight may still reach `cb` after axidev_io_listener_unsubscribe(), so keep
+   `user_data` alive until axidev_io_listener_stop() returns. */
+AXIDEV_IO_API uint64_t axidev_io_listener_subscribe(
+    axidev_io_keyboard_listener_batch_cb cb, void *user_data);
+AXIDEV_IO_API bool axidev_io_listener_unsubscribe(uint64_t token);
 AXIDEV_IO_API bool axidev_io_listener_is_listening(void);
+AXIDEV_IO_API axidev_io_keyboard_backend_type_t
+axidev_io_listener_backend_type(void);
+AXIDEV_IO_API void axidev_io_listener_set_options(uint32_t options);
+AXIDEV_IO_API uint32_t axidev_io_listener_get_options(void);
+AXIDEV_IO_API void
+axidev_io_listener_get_stats(axidev_io_listener_stats_t *out_stats);
+AXIDEV_IO_API void
+axidev_io_listener_set_filter(const axidev_io_listener_filter_t *filter);
+AXIDEV_IO_API void
+axidev_io_listener_filter_add_key(axidev_io_listener_filter_t *filter,
+                                  axidev_io_keyboard_key_t key);
+AXIDEV_IO_API void
+axidev_io_listener_get_latency(axidev_io_listener_latency_t *out_latency);
+
+/* Macro recording. A recorder encodes listener events into a compact
+   stream: per event a varint delay, the platform keycode from
+   axidev_io_key_event_t.code, the key, the modifiers and the direction.
+   Streams only replay on the platform that recorded them. */
+AXIDEV_IO_API axidev_io_macro_recorder_t *axidev_io_macro_recorder_create(void);
+AXIDEV_IO_API void
+axidev_io_macro_recorder_destroy(axidev_io_macro_recorder_t *recorder);
+/* Batch callback that appends `events` to `recorder`. Pass it to
+   axidev_io_listener_start_batched() or axidev_io_listener_subscribe() with
+   the recorder as `user_data`, and keep the recorder alive as any callback
+   user_data. Delays come from the events' input timestamps. */
+AXIDEV_IO_API void axidev_io_macro_recorder_append(
+    const axidev_io_key_event_t *events, size_t count, void *recorder);
+AXIDEV_IO_API size_t
+axidev_io_macro_recorder_event_count(axidev_io_macro_recorder_t *recorder);
+/* Copies up to `len` bytes of the stream into `buf` and returns the full
+   size, so a result > `len` means `buf` was too small. */
+AXIDEV_IO_API size_t axidev_io_macro_recorder_copy(
+    axidev_io_macro_recorder_t *recorder, uint8_t *buf, size_t len);
+AXIDEV_IO_API void
+axidev_io_macro_recorder_clear(axidev_io_macro_recorder_t *recorder);
+AXIDEV_IO_API bool
+axidev_io_macro_recorder_save(axidev_io_macro_recorder_t *recorder,
+                              const char *path);
+/* Replays a stream through the global sender. Each event is sent at its
+   recorded offset from the start divided by `speed`, against absolute
+   deadlines so late events do not accumulate drift; 0 sends everything
+   without waiting. Keycodes are sent as recorded, without keymap lookups,
+   and events that are due together go out as one batch. Keys still held
+   at the end are released. The library lock is only held while events are
+   sent, so other calls can inject between them; freeing the keyboard
+   mid-replay ends it with AXIDEV_IO_ERROR_NOT_INITIALIZED. */
+AXIDEV_IO_API bool axidev_io_macro_replay(const uint8_t *data, size_t size,
+                                          double speed);
+/* Queues a replay of a copy of `data` on the injection worker and returns
+   its job id, or 0 on failure. axidev_io_keyboard_async_cancel() stops it
+   between events and releases the keys it holds; `cb` then reports
+   AXIDEV_IO_ERROR_CANCELLED. */
+AXIDEV_IO_API uint64_t axidev_io_macro_replay_async(
+    const uint8_t *data, size_t size, double speed,
+    axidev_io_keyboard_async_cb cb, void *user_data);
+/* Same, reading a file written by axidev_io_macro_recorder_save() through a
+   memory mapping instead of loading it. */
+AXIDEV_IO_API bool axidev_io_macro_replay_file(const char *path, double speed);
 
 AXIDEV_IO_API char *
 axidev_io_keyboard_key_to_string(axidev_io_keyboard_key_t key);
+/* Static canonical name of `key` ("Unknown" if it has none); never freed. */
+AXIDEV_IO_API const char *
+axidev_io_keyboard_key_name(axidev_io_keyboard_key_t key);
+/* The _buf variants write into `buf` snprintf-style: the text is truncated
+   to fit and NUL-terminated when `len` > 0, and the return value is the full
+   length, so a result >= `len` means `buf` was too small. */
+AXIDEV_IO_API size_t axidev_io_keyboard_key_to_string_buf(
+    axidev_io_keyboard_key_t key, char *buf, size_t len);
 AXIDEV_IO_API axidev_io_keyboard_key_t
 axidev_io_keyboard_string_to_key(const char *name);
 AXIDEV_IO_API char *axidev_io_keyboard_key_to_string_with_modifier(
     axidev_io_keyboard_key_with_modifier_t key_mod);
+AXIDEV_IO_API size_t axidev_io_keyboard_key_to_string_with_modifier_buf(
+    axidev_io_keyboard_key_with_modifier_t key_mod, char *buf, size_t len);
 AXIDEV_IO_API bool axidev_io_keyboard_string_to_key_with_modifier(
     const char *combo, axidev_io_keyboard_key_with_modifier_t *out_key_mod);
 
 AXIDEV_IO_API const char *axidev_io_library_version(void);
+AXIDEV_IO_API uint64_t axidev_io_monotonic_time_us(void);
+
+/* Process-wide counters for every sender handle and listener session
+   together, kept since load or the last axidev_io_reset_stats(). They use
+   relaxed atomics, cheap enough to stay on in release builds. Histogram
+   bucket 0 counts values of 0 and bucket i counts [2^(i-1), 2^i); the last
+   bucket also takes everything larger. */
+#define AXIDEV_IO_STATS_HISTOGRAM_BUCKETS 32u
+
+typedef struct axidev_io_stats_histogram_t {
+  uint64_t samples;
+  uint64_t max;
+  uint64_t buckets[AXIDEV_IO_STATS_HISTOGRAM_BUCKETS];
+} axidev_io_stats_histogram_t;
+
+typedef struct axidev_io_stats_t {
+  /* Key transitions handed to the device, SendInput or the capture ring,
+     repeats included. */
+  uint64_t sender_events_sent;
+  /* write() or SendInput calls, and those that failed. */
+  uint64_t sender_writes;
+  uint64_t sender_write_failures;
+  /* Key transitions read from the OS, before filtering. */
+  uint64_t listener_events_received;
+  /* Events handed to a callback, a subscriber or the pull queue. */
+  uint64_t listener_events_delivered;
+  /* Windows releases dropped as repeats of one within 50 ms. */
+  uint64_t listener_events_deduplicated;
+  /* Events lost to a full hook ring or pull queue. */
+  uint64_t listener_events_dropped;
+  /* Time of each synchronous or queued tap, delays included. */
+  axidev_io_stats_histogram_t tap_duration_us;
+  /* Time spent in callbacks and subscribers per delivered batch. */
+  axidev_io_stats_histogram_t callback_duration_ns;
+  /* Events waiting in the pull queue after each push. */
+  axidev_io_stats_histogram_t listener_queue_depth;
+} axidev_io_stats_t;
+
+AXIDEV_IO_API void axidev_io_get_stats(axidev_io_stats_t *out_stats);
+AXIDEV_IO_API void axidev_io_reset_stats(void);
+/* The last error is kept per thread. Errors from library worker threads,
+   such as a listener that fails to start, are reported on the thread whose
+   call failed. axidev_io_get_last_error() returns a copy to free with
+   axidev_io_free_string(), or NULL when none is set. */
 AXIDEV_IO_API char *axidev_io_get_last_error(void);
+/* Same message without allocating: "" when none is set, and valid until the
+   calling thread's next library call. */
+AXIDEV_IO_API const char *axidev_io_get_last_error_message(void);
+/* Kind of the calling thread's last failure; AXIDEV_IO_ERROR_NONE once
+   cleared. */
+AXIDEV_IO_API axidev_io_error_code_t axidev_io_get_last_error_code(void);
 AXIDEV_IO_API void axidev_io_clear_last_error(void);
 AXIDEV_IO_API void axidev_io_free_string(char *s);
 
@@ -455,19 +827,78 @@ AXIDEV_IO_API bool axidev_io_log_is_enabled(axidev_io_log_level_t level);
 AXIDEV_IO_API void axidev_io_log_message(axidev_io_log_level_t level,
                                          const char *file, int line,
                                          const char *fmt, ...);
+/* Receives each formatted message, without timestamp or newline, in place
+   of the stderr output. It runs on the logging thread in async mode and on
+   the logging caller otherwise. Messages it logs itself are dropped and
+   counted, and logging calls from it (flush, set_sink, set_async) return
+   without effect. NULL restores stderr. */
+typedef void (*axidev_io_log_sink_fn)(axidev_io_log_level_t level,
+                                      const char *file, int line,
+                                      const char *message, void *user_data);
+AXIDEV_IO_API void axidev_io_log_set_sink(axidev_io_log_sink_fn sink,
+                                          void *user_data);
+/* In async mode a message is timestamped and formatted into a lock-free
+   ring, and a background thread writes it in batches. Async messages are
+   cut to 511 bytes; synchronous ones are not. A message that finds the
+   ring full is dropped and counted. Disabling drains the ring
+   first, and so does process exit, for at most 200 ms. Returns false if
+   the logging thread could not be started. */
+AXIDEV_IO_API bool axidev_io_log_set_async(bool enabled);
+/* Waits until every message queued before the call has been written. */
+AXIDEV_IO_API void axidev_io_log_flush(void);
+AXIDEV_IO_API uint64_t axidev_io_log_dropped_count(void);
+
+/* Call sites below this level compile to nothing. Use the numeric values
+   of AXIDEV_IO_LOG_LEVEL_*, e.g. -DAXIDEV_IO_LOG_MIN_LEVEL=1 to strip
+   DEBUG. */
+#ifndef AXIDEV_IO_LOG_MIN_LEVEL
+#define AXIDEV_IO_LOG_MIN_LEVEL 0
+#endif
 
+/* Compares against the runtime level inline, so a filtered message costs
+   no call and its arguments are not evaluated. */
+#define AXIDEV_IO_LOG_AT_LEVEL(level, fmt, ...)                                \
+  do {                                                                         \
+    if ((int)(level) >= (int)axidev_io_global->log_level) {                    \
+      axidev_io_log_message((level), __FILE__, __LINE__, fmt, ##__VA_ARGS__);  \
+    }                                                                          \
+  } while (0)
+/* Keeps a stripped call site type-checked and its arguments referenced. */
+#define AXIDEV_IO_LOG_STRIPPED(level, fmt, ...)                                \
+  do {                                                                         \
+    if (0) {                                                                   \
+      axidev_io_log_message((level), __FILE__, __LINE__, fmt, ##__VA_ARGS__);  \
+    }                                                                          \
+  } while (0)
+
+#if AXIDEV_IO_LOG_MIN_LEVEL <= 0
 #define AXIDEV_IO_LOG_DEBUG(fmt, ...)                                          \
-  axidev_io_log_message(AXIDEV_IO_LOG_LEVEL_DEBUG, __FILE__, __LINE__, fmt,    \
-                        ##__VA_ARGS__)
+  AXIDEV_IO_LOG_AT_LEVEL(AXIDEV_IO_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define AXIDEV_IO_LOG_DEBUG(fmt, ...)                                          \
+  AXIDEV_IO_LOG_STRIPPED(AXIDEV_IO_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#endif
+#if AXIDEV_IO_LOG_MIN_LEVEL <= 1
 #define AXIDEV_IO_LOG_INFO(fmt, ...)                                           \
-  axidev_io_log_message(AXIDEV_IO_LOG_LEVEL_INFO, __FILE__, __LINE__, fmt,     \
-                        ##__VA_ARGS__)
+  AXIDEV_IO_LOG_AT_LEVEL(AXIDEV_IO_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define AXIDEV_IO_LOG_INFO(fmt, ...)                                           \
+  AXIDEV_IO_LOG_STRIPPED(AXIDEV_IO_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#endif
+#if AXIDEV_IO_LOG_MIN_LEVEL <= 2
+#define AXIDEV_IO_LOG_WARN(fmt, ...)                                           \
+  AXIDEV_IO_LOG_AT_LEVEL(AXIDEV_IO_LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
 #define AXIDEV_IO_LOG_WARN(fmt, ...)                                           \
-  axidev_io_log_message(AXIDEV_IO_LOG_LEVEL_WARN, __FILE__, __LINE__, fmt,     \
-                        ##__VA_ARGS__)
+  AXIDEV_IO_LOG_STRIPPED(AXIDEV_IO_LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#endif
+#if AXIDEV_IO_LOG_MIN_LEVEL <= 3
+#define AXIDEV_IO_LOG_ERROR(fmt, ...)                                          \
+  AXIDEV_IO_LOG_AT_LEVEL(AXIDEV_IO_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
 #define AXIDEV_IO_LOG_ERROR(fmt, ...)                                          \
-  axidev_io_log_message(AXIDEV_IO_LOG_LEVEL_ERROR, __FILE__, __LINE__, fmt,    \
-                        ##__VA_ARGS__)
+  AXIDEV_IO_LOG_STRIPPED(AXIDEV_IO_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#endif
 
 #ifdef __cplusplus
 }
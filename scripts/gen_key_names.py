@@ -0,0 +1,712 @@
+#!/usr/bin/env python3
+"""Generate src/keyboard/common/key_names_table.h.
+
+The key name tables used by key_utils.c live here. Running this script
+rewrites the header with the canonical name of every key, indexed by key
+value, and a minimal perfect hash over every lowercased name and alias so the
+reverse lookup needs no runtime-built map and no allocation.
+
+    python scripts/gen_key_names.py          # rewrite the header
+    python scripts/gen_key_names.py --check  # fail if it is out of date
+"""
+from __future__ import annotations
+
+import argparse
+import re
+import sys
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parent.parent
+OUTPUT = ROOT / "src" / "keyboard" / "common" / "key_names_table.h"
+PUBLIC_HEADER = ROOT / "include" / "axidev-io" / "c_api.h"
+KEY_PREFIX = "AXIDEV_IO_KEY_"
+
+# Canonical names. The first entry for a key is what
+# axidev_io_keyboard_key_to_string() returns; the lowercased name is also
+# accepted by axidev_io_keyboard_string_to_key() unless an alias claims it.
+PAIRS: list[tuple[str, str]] = [
+    ("UNKNOWN", "Unknown"),
+    ("A", "A"),
+    ("B", "B"),
+    ("C", "C"),
+    ("D", "D"),
+    ("E", "E"),
+    ("F", "F"),
+    ("G", "G"),
+    ("H", "H"),
+    ("I", "I"),
+    ("J", "J"),
+    ("K", "K"),
+    ("L", "L"),
+    ("M", "M"),
+    ("N", "N"),
+    ("O", "O"),
+    ("P", "P"),
+    ("Q", "Q"),
+    ("R", "R"),
+    ("S", "S"),
+    ("T", "T"),
+    ("U", "U"),
+    ("V", "V"),
+    ("W", "W"),
+    ("X", "X"),
+    ("Y", "Y"),
+    ("Z", "Z"),
+    ("NUM0", "0"),
+    ("NUM1", "1"),
+    ("NUM2", "2"),
+    ("NUM3", "3"),
+    ("NUM4", "4"),
+    ("NUM5", "5"),
+    ("NUM6", "6"),
+    ("NUM7", "7"),
+    ("NUM8", "8"),
+    ("NUM9", "9"),
+    ("F1", "F1"),
+    ("F2", "F2"),
+    ("F3", "F3"),
+    ("F4", "F4"),
+    ("F5", "F5"),
+    ("F6", "F6"),
+    ("F7", "F7"),
+    ("F8", "F8"),
+    ("F9", "F9"),
+    ("F10", "F10"),
+    ("F11", "F11"),
+    ("F12", "F12"),
+    ("F13", "F13"),
+    ("F14", "F14"),
+    ("F15", "F15"),
+    ("F16", "F16"),
+    ("F17", "F17"),
+    ("F18", "F18"),
+    ("F19", "F19"),
+    ("F20", "F20"),
+    ("ENTER", "Enter"),
+    ("ESCAPE", "Escape"),
+    ("BACKSPACE", "Backspace"),
+    ("TAB", "Tab"),
+    ("SPACE", "Space"),
+    ("LEFT", "Left"),
+    ("RIGHT", "Right"),
+    ("UP", "Up"),
+    ("DOWN", "Down"),
+    ("HOME", "Home"),
+    ("END", "End"),
+    ("PAGE_UP", "PageUp"),
+    ("PAGE_DOWN", "PageDown"),
+    ("DELETE", "Delete"),
+    ("INSERT", "Insert"),
+    ("PRINT_SCREEN", "PrintScreen"),
+    ("SCROLL_LOCK", "ScrollLock"),
+    ("PAUSE", "Pause"),
+    ("NUMPAD_DIVIDE", "NumpadDivide"),
+    ("NUMPAD_MULTIPLY", "NumpadMultiply"),
+    ("NUMPAD_MINUS", "NumpadMinus"),
+    ("NUMPAD_PLUS", "NumpadPlus"),
+    ("NUMPAD_ENTER", "NumpadEnter"),
+    ("NUMPAD_DECIMAL", "NumpadDecimal"),
+    ("NUMPAD0", "Numpad0"),
+    ("NUMPAD1", "Numpad1"),
+    ("NUMPAD2", "Numpad2"),
+    ("NUMPAD3", "Numpad3"),
+    ("NUMPAD4", "Numpad4"),
+    ("NUMPAD5", "Numpad5"),
+    ("NUMPAD6", "Numpad6"),
+    ("NUMPAD7", "Numpad7"),
+    ("NUMPAD8", "Numpad8"),
+    ("NUMPAD9", "Numpad9"),
+    ("SHIFT_LEFT", "ShiftLeft"),
+    ("SHIFT_RIGHT", "ShiftRight"),
+    ("CTRL_LEFT", "CtrlLeft"),
+    ("CTRL_RIGHT", "CtrlRight"),
+    ("ALT_LEFT", "AltLeft"),
+    ("ALT_RIGHT", "AltRight"),
+    ("SUPER_LEFT", "SuperLeft"),
+    ("SUPER_RIGHT", "SuperRight"),
+    ("CAPS_LOCK", "CapsLock"),
+    ("NUM_LOCK", "NumLock"),
+    ("HELP", "Help"),
+    ("MENU", "Menu"),
+    ("POWER", "Power"),
+    ("SLEEP", "Sleep"),
+    ("WAKE", "Wake"),
+    ("MUTE", "Mute"),
+    ("VOLUME_DOWN", "VolumeDown"),
+    ("VOLUME_UP", "VolumeUp"),
+    ("MEDIA_PLAY_PAUSE", "MediaPlayPause"),
+    ("MEDIA_STOP", "MediaStop"),
+    ("MEDIA_NEXT", "MediaNext"),
+    ("MEDIA_PREVIOUS", "MediaPrevious"),
+    ("BRIGHTNESS_DOWN", "BrightnessDown"),
+    ("BRIGHTNESS_UP", "BrightnessUp"),
+    ("EJECT", "Eject"),
+    ("GRAVE", "`"),
+    ("MINUS", "-"),
+    ("EQUAL", "="),
+    ("LEFT_BRACKET", "["),
+    ("RIGHT_BRACKET", "]"),
+    ("BACKSLASH", "\\"),
+    ("SEMICOLON", ";"),
+    ("APOSTROPHE", "'"),
+    ("COMMA", ","),
+    ("PERIOD", "."),
+    ("SLASH", "/"),
+    ("AT", "At"),
+    ("HASHTAG", "Hashtag"),
+    ("EXCLAMATION", "Exclamation"),
+    ("DOLLAR", "Dollar"),
+    ("PERCENT", "Percent"),
+    ("CARET", "Caret"),
+    ("AMPERSAND", "Ampersand"),
+    ("ASTERISK", "Asterisk"),
+    ("LEFT_PAREN", "LeftParen"),
+    ("RIGHT_PAREN", "RightParen"),
+    ("UNDERSCORE", "Underscore"),
+    ("PLUS", "Plus"),
+    ("COLON", "Colon"),
+    ("QUOTE", "Quote"),
+    ("QUESTION_MARK", "QuestionMark"),
+    ("BAR", "Bar"),
+    ("LESS_THAN", "LessThan"),
+    ("GREATER_THAN", "GreaterThan"),
+    ("ASCII_NUL", "NUL"),
+    ("ASCII_SOH", "SOH"),
+    ("ASCII_STX", "STX"),
+    ("ASCII_ETX", "ETX"),
+    ("ASCII_EOT", "EOT"),
+    ("ASCII_ENQ", "ENQ"),
+    ("ASCII_ACK", "ACK"),
+    ("ASCII_BELL", "Bell"),
+    ("ASCII_VT", "VT"),
+    ("ASCII_FF", "FF"),
+    ("ASCII_SO", "SO"),
+    ("ASCII_SI", "SI"),
+    ("ASCII_DLE", "DLE"),
+    ("ASCII_DC1", "DC1"),
+    ("ASCII_DC2", "DC2"),
+    ("ASCII_DC3", "DC3"),
+    ("ASCII_DC4", "DC4"),
+    ("ASCII_NAK", "NAK"),
+    ("ASCII_SYN", "SYN"),
+    ("ASCII_ETB", "ETB"),
+    ("ASCII_CAN", "CAN"),
+    ("ASCII_EM", "EM"),
+    ("ASCII_SUB", "SUB"),
+    ("ASCII_FS", "FS"),
+    ("ASCII_GS", "GS"),
+    ("ASCII_RS", "RS"),
+    ("ASCII_US", "US"),
+    ("ASCII_DEL", "DEL"),
+    ("NUMPAD_EQUAL", "NumpadEqual"),
+    ("DEGREE", "Degree"),
+    ("STERLING", "Sterling"),
+    ("MU", "Mu"),
+    ("PLUS_MINUS", "PlusMinus"),
+    ("DEAD_CIRCUMFLEX", "DeadCircumflex"),
+    ("DEAD_DIAERESIS", "DeadDiaeresis"),
+    ("SECTION", "Section"),
+    ("CANCEL", "Cancel"),
+    ("REDO", "Redo"),
+    ("UNDO", "Undo"),
+    ("FIND", "Find"),
+    ("HANGUL", "Hangul"),
+    ("HANGUL_HANJA", "HangulHanja"),
+    ("KATAKANA", "Katakana"),
+    ("HIRAGANA", "Hiragana"),
+    ("HENKAN", "Henkan"),
+    ("MUHENKAN", "Muhenkan"),
+    ("OE", "OE"),
+    ("oe", "oe"),
+    ("SUN_PROPS", "SunProps"),
+    ("SUN_FRONT", "SunFront"),
+    ("COPY", "Copy"),
+    ("OPEN", "Open"),
+    ("PASTE", "Paste"),
+    ("CUT", "Cut"),
+    ("CALCULATOR", "Calculator"),
+    ("EXPLORER", "Explorer"),
+    ("PHONE", "Phone"),
+    ("WEB_CAM", "WebCam"),
+    ("AUDIO_RECORD", "AudioRecord"),
+    ("AUDIO_REWIND", "AudioRewind"),
+    ("AUDIO_PRESET", "AudioPreset"),
+    ("MESSENGER", "Messenger"),
+    ("SEARCH", "Search"),
+    ("GO", "Go"),
+    ("FINANCE", "Finance"),
+    ("GAME", "Game"),
+    ("SHOP", "Shop"),
+    ("HOME_PAGE", "HomePage"),
+    ("RELOAD", "Reload"),
+    ("CLOSE", "Close"),
+    ("SEND", "Send"),
+    ("XFER", "Xfer"),
+    ("LAUNCH_A", "LaunchA"),
+    ("LAUNCH_B", "LaunchB"),
+    ("LAUNCH1", "Launch1"),
+    ("LAUNCH2", "Launch2"),
+    ("LAUNCH3", "Launch3"),
+    ("LAUNCH4", "Launch4"),
+    ("LAUNCH5", "Launch5"),
+    ("LAUNCH6", "Launch6"),
+    ("LAUNCH7", "Launch7"),
+    ("LAUNCH8", "Launch8"),
+    ("LAUNCH9", "Launch9"),
+    ("TOUCHPAD_TOGGLE", "TouchpadToggle"),
+    ("TOUCHPAD_ON", "TouchpadOn"),
+    ("TOUCHPAD_OFF", "TouchpadOff"),
+    ("KBD_LIGHT_ON_OFF", "KbdLightOnOff"),
+    ("KBD_BRIGHTNESS_DOWN", "KbdBrightnessDown"),
+    ("KBD_BRIGHTNESS_UP", "KbdBrightnessUp"),
+    ("MAIL", "Mail"),
+    ("MAIL_FORWARD", "MailForward"),
+    ("SAVE", "Save"),
+    ("DOCUMENTS", "Documents"),
+    ("BATTERY", "Battery"),
+    ("BLUETOOTH", "Bluetooth"),
+    ("WLAN", "WLAN"),
+    ("UWB", "UWB"),
+    ("NEXT_VMODE", "Next_VMode"),
+    ("PREV_VMODE", "Prev_VMode"),
+    ("MON_BRIGHTNESS_CYCLE", "MonBrightnessCycle"),
+    ("BRIGHTNESS_AUTO", "BrightnessAuto"),
+    ("DISPLAY_OFF", "DisplayOff"),
+    ("WWAN", "WWAN"),
+    ("RF_KILL", "RFKill"),
+]
+
+# Extra spellings: symbols, control characters, X11 keysym names and common
+# abbreviations. They take precedence over canonical names; spellings with
+# uppercase letters only match exactly.
+ALIASES: list[tuple[str, str]] = [
+    ("esc", "ESCAPE"),
+    ("return", "ENTER"),
+    ("spacebar", "SPACE"),
+    ("space", "SPACE"),
+    ("ctrl", "CTRL_LEFT"),
+    ("control", "CTRL_LEFT"),
+    ("shift", "SHIFT_LEFT"),
+    ("alt", "ALT_LEFT"),
+    ("super", "SUPER_LEFT"),
+    ("meta", "SUPER_LEFT"),
+    ("win", "SUPER_LEFT"),
+    ("num0", "NUM0"),
+    ("num1", "NUM1"),
+    ("num2", "NUM2"),
+    ("num3", "NUM3"),
+    ("num4", "NUM4"),
+    ("num5", "NUM5"),
+    ("num6", "NUM6"),
+    ("num7", "NUM7"),
+    ("num8", "NUM8"),
+    ("num9", "NUM9"),
+    ("dash", "MINUS"),
+    ("hyphen", "MINUS"),
+    ("minus", "MINUS"),
+    ("grave", "GRAVE"),
+    ("backslash", "BACKSLASH"),
+    ("semicolon", "SEMICOLON"),
+    ("apostrophe", "APOSTROPHE"),
+    ("comma", "COMMA"),
+    ("period", "PERIOD"),
+    ("dot", "PERIOD"),
+    ("slash", "SLASH"),
+    ("bracketleft", "LEFT_BRACKET"),
+    ("bracketright", "RIGHT_BRACKET"),
+    ("@", "AT"),
+    ("#", "HASHTAG"),
+    ("&", "AMPERSAND"),
+    ("(", "LEFT_PAREN"),
+    (")", "RIGHT_PAREN"),
+    ("!", "EXCLAMATION"),
+    ("$", "DOLLAR"),
+    ("%", "PERCENT"),
+    ("^", "CARET"),
+    ("*", "ASTERISK"),
+    (" ", "SPACE"),
+    ("\t", "TAB"),
+    ("\x01", "ASCII_SOH"),
+    ("\x02", "ASCII_STX"),
+    ("\x03", "ASCII_ETX"),
+    ("\x04", "ASCII_EOT"),
+    ("\x05", "ASCII_ENQ"),
+    ("\x06", "ASCII_ACK"),
+    ("\x07", "ASCII_BELL"),
+    ("\x08", "BACKSPACE"),
+    ("\t", "TAB"),
+    ("\n", "ENTER"),
+    ("\x0b", "ASCII_VT"),
+    ("\x0c", "ASCII_FF"),
+    ("\r", "ENTER"),
+    ("\x0e", "ASCII_SO"),
+    ("\x0f", "ASCII_SI"),
+    ("\x10", "ASCII_DLE"),
+    ("\x11", "ASCII_DC1"),
+    ("\x12", "ASCII_DC2"),
+    ("\x13", "ASCII_DC3"),
+    ("\x14", "ASCII_DC4"),
+    ("\x15", "ASCII_NAK"),
+    ("\x16", "ASCII_SYN"),
+    ("\x17", "ASCII_ETB"),
+    ("\x18", "ASCII_CAN"),
+    ("\x19", "ASCII_EM"),
+    ("\x1a", "ASCII_SUB"),
+    ("\x1b", "ESCAPE"),
+    ("\x1c", "ASCII_FS"),
+    ("\x1d", "ASCII_GS"),
+    ("\x1e", "ASCII_RS"),
+    ("\x1f", "ASCII_US"),
+    ("\x7f", "DELETE"),
+    ("_", "MINUS"),
+    ("+", "EQUAL"),
+    (":", "SEMICOLON"),
+    ('"', "APOSTROPHE"),
+    ("?", "SLASH"),
+    ("|", "BACKSLASH"),
+    ("<", "COMMA"),
+    (">", "PERIOD"),
+    ("{", "LEFT_BRACKET"),
+    ("}", "RIGHT_BRACKET"),
+    ("~", "GRAVE"),
+    ("at", "AT"),
+    ("hash", "HASHTAG"),
+    ("hashtag", "HASHTAG"),
+    ("pound", "HASHTAG"),
+    ("bang", "EXCLAMATION"),
+    ("exclamation", "EXCLAMATION"),
+    ("dollar", "DOLLAR"),
+    ("percent", "PERCENT"),
+    ("caret", "CARET"),
+    ("ampersand", "AMPERSAND"),
+    ("star", "ASTERISK"),
+    ("asterisk", "ASTERISK"),
+    ("lparen", "LEFT_PAREN"),
+    ("rparen", "RIGHT_PAREN"),
+    ("underscore", "UNDERSCORE"),
+    ("plus", "PLUS"),
+    ("colon", "COLON"),
+    ("quote", "QUOTE"),
+    ("pipe", "BAR"),
+    ("bar", "BAR"),
+    ("lt", "LESS_THAN"),
+    ("gt", "GREATER_THAN"),
+    ("less", "LESS_THAN"),
+    ("greater", "GREATER_THAN"),
+    ("nul", "ASCII_NUL"),
+    ("bell", "ASCII_BELL"),
+    ("vt", "ASCII_VT"),
+    ("ff", "ASCII_FF"),
+    ("dle", "ASCII_DLE"),
+    ("sub", "ASCII_SUB"),
+    ("can", "ASCII_CAN"),
+    ("fs", "ASCII_FS"),
+    ("gs", "ASCII_GS"),
+    ("rs", "ASCII_RS"),
+    ("us", "ASCII_US"),
+    ("del", "ASCII_DEL"),
+    ("kp0", "NUMPAD0"),
+    ("kp1", "NUMPAD1"),
+    ("kp2", "NUMPAD2"),
+    ("kp3", "NUMPAD3"),
+    ("kp4", "NUMPAD4"),
+    ("kp5", "NUMPAD5"),
+    ("kp6", "NUMPAD6"),
+    ("kp7", "NUMPAD7"),
+    ("kp8", "NUMPAD8"),
+    ("kp9", "NUMPAD9"),
+    ("control_l", "CTRL_LEFT"),
+    ("control_r", "CTRL_RIGHT"),
+    ("shift_l", "SHIFT_LEFT"),
+    ("shift_r", "SHIFT_RIGHT"),
+    ("alt_l", "ALT_LEFT"),
+    ("alt_r", "ALT_RIGHT"),
+    ("meta_l", "SUPER_LEFT"),
+    ("super_l", "SUPER_LEFT"),
+    ("super_r", "SUPER_RIGHT"),
+    ("hyper_l", "SUPER_LEFT"),
+    ("caps_lock", "CAPS_LOCK"),
+    ("num_lock", "NUM_LOCK"),
+    ("scroll_lock", "SCROLL_LOCK"),
+    ("iso_left_tab", "TAB"),
+    ("iso_level3_shift", "ALT_RIGHT"),
+    ("iso_level5_shift", "ALT_RIGHT"),
+    ("quotedbl", "QUOTE"),
+    ("parenleft", "LEFT_PAREN"),
+    ("parenright", "RIGHT_PAREN"),
+    ("equal", "EQUAL"),
+    ("question", "QUESTION_MARK"),
+    ("exclam", "EXCLAMATION"),
+    ("section", "SECTION"),
+    ("degree", "DEGREE"),
+    ("sterling", "STERLING"),
+    ("plusminus", "PLUS_MINUS"),
+    ("dead_circumflex", "DEAD_CIRCUMFLEX"),
+    ("dead_diaeresis", "DEAD_DIAERESIS"),
+    ("eacute", "E"),
+    ("egrave", "E"),
+    ("agrave", "A"),
+    ("ugrave", "U"),
+    ("ccedilla", "C"),
+    ("oe", "oe"),
+    ("OE", "OE"),
+    ("mu", "MU"),
+    ("linefeed", "ENTER"),
+    ("prior", "PAGE_UP"),
+    ("next", "PAGE_DOWN"),
+    ("print", "PRINT_SCREEN"),
+    ("sys_req", "PRINT_SCREEN"),
+    ("break", "PAUSE"),
+    ("cancel", "CANCEL"),
+    ("redo", "REDO"),
+    ("undo", "UNDO"),
+    ("find", "FIND"),
+    ("sunprops", "SUN_PROPS"),
+    ("sunfront", "SUN_FRONT"),
+    ("menu", "MENU"),
+    ("copy", "COPY"),
+    ("open", "OPEN"),
+    ("paste", "PASTE"),
+    ("cut", "CUT"),
+    ("calculator", "CALCULATOR"),
+    ("explorer", "EXPLORER"),
+    ("phone", "PHONE"),
+    ("webcam", "WEB_CAM"),
+    ("mail", "MAIL"),
+    ("mailforward", "MAIL_FORWARD"),
+    ("save", "SAVE"),
+    ("documents", "DOCUMENTS"),
+]
+
+# Numpad spellings accepted after "kp" or "kp_" (X11 keysym names and common
+# abbreviations), unless a name or alias above already claims the spelling.
+KEYPAD_SUFFIXES: list[tuple[tuple[str, ...], str]] = [
+    (("multiply", "mul"), "NUMPAD_MULTIPLY"),
+    (("divide", "div"), "NUMPAD_DIVIDE"),
+    (("add", "plus"), "NUMPAD_PLUS"),
+    (("subtract", "minus"), "NUMPAD_MINUS"),
+    (("enter",), "NUMPAD_ENTER"),
+    (("decimal", "delete", "del"), "NUMPAD_DECIMAL"),
+    (("equal",), "NUMPAD_EQUAL"),
+    (("home", "7"), "NUMPAD7"),
+    (("up", "8"), "NUMPAD8"),
+    (("prior", "9"), "NUMPAD9"),
+    (("left", "4"), "NUMPAD4"),
+    (("begin", "5"), "NUMPAD5"),
+    (("right", "6"), "NUMPAD6"),
+    (("end", "1"), "NUMPAD1"),
+    (("down", "2"), "NUMPAD2"),
+    (("next", "3"), "NUMPAD3"),
+    (("insert", "0"), "NUMPAD0"),
+]
+
+FNV_OFFSET = 0xCBF29CE484222325
+FNV_PRIME = 0x100000001B3
+MASK64 = (1 << 64) - 1
+MASK32 = (1 << 32) - 1
+# Average keys per displacement bucket.
+BUCKET_LOAD = 4
+
+
+def ascii_lower(text: str) -> str:
+    return "".join(chr(ord(c) + 32) if "A" <= c <= "Z" else c for c in text)
+
+
+def name_hash(text: str) -> int:
+    """64-bit FNV-1a over the ASCII-lowercased bytes; mirrors key_utils.c."""
+    value = FNV_OFFSET
+    for byte in ascii_lower(text).encode("latin-1"):
+        value ^= byte
+        value = (value * FNV_PRIME) & MASK64
+    return value
+
+
+def mix32(value: int) -> int:
+    value ^= value >> 16
+    value = (value * 0x85EBCA6B) & MASK32
+    value ^= value >> 13
+    value = (value * 0xC2B2AE35) & MASK32
+    value ^= value >> 16
+    return value
+
+
+def slot_of(hash_value: int, displacement: int, slot_count: int) -> int:
+    return mix32((hash_value & MASK32) ^ displacement) % slot_count
+
+
+def key_values() -> dict[str, int]:
+    """Reads the key enum, resolving entries that alias another key."""
+    pattern = re.compile(r"^\s*" + KEY_PREFIX + r"(\w+) = (\w+),?\s*$")
+    values: dict[str, int] = {}
+    for line in PUBLIC_HEADER.read_text().splitlines():
+        match = pattern.match(line)
+        if match is None:
+            continue
+        name, value = match.groups()
+        if value.startswith(KEY_PREFIX):
+            values[name] = values[value[len(KEY_PREFIX):]]
+        else:
+            values[name] = int(value)
+    return values
+
+
+def reverse_entries() -> tuple[dict[str, str], dict[str, str]]:
+    """Returns (case-insensitive map, exact-case overrides).
+
+    Aliases win over canonical names, a later alias replaces an earlier one,
+    and the first canonical name for a lowercased spelling wins. Spellings
+    with uppercase letters only match exactly, which keeps "OE" and "oe"
+    apart.
+    """
+    names: dict[str, str] = {}
+    for alias, key in ALIASES:
+        names[alias] = key
+    for key, name in PAIRS:
+        names.setdefault(ascii_lower(name), key)
+    folded = {n: k for n, k in names.items() if n == ascii_lower(n)}
+    exact = {n: k for n, k in names.items() if n != ascii_lower(n)}
+    for suffixes, key in KEYPAD_SUFFIXES:
+        for suffix in suffixes:
+            for prefix in ("kp", "kp_"):
+                folded.setdefault(prefix + suffix, key)
+    return folded, exact
+
+
+def build_perfect_hash(names: list[str]) -> tuple[list[int], list[str]]:
+    slot_count = len(names)
+    bucket_count = (slot_count + BUCKET_LOAD - 1) // BUCKET_LOAD
+    buckets: list[list[str]] = [[] for _ in range(bucket_count)]
+    for name in names:
+        buckets[(name_hash(name) >> 32) % bucket_count].append(name)
+
+    displacements = [0] * bucket_count
+    slots: list[str | None] = [None] * slot_count
+    order = sorted(range(bucket_count), key=lambda b: -len(buckets[b]))
+    for bucket in order:
+        members = buckets[bucket]
+        if not members:
+            continue
+        for displacement in range(1 << 16):
+            chosen = {
+                slot_of(name_hash(n), displacement, slot_count)
+                for n in members
+            }
+            if len(chosen) == len(members) and all(
+                slots[s] is None for s in chosen
+            ):
+                break
+        else:
+            raise SystemExit(f"no displacement found for bucket {bucket}")
+        displacements[bucket] = displacement
+        for name in members:
+            slots[slot_of(name_hash(name), displacement, slot_count)] = name
+    return displacements, [s for s in slots if s is not None]
+
+
+def c_string(text: str) -> str:
+    out = []
+    for c in text:
+        if c in '"\\':
+            out.append("\\" + c)
+        elif not (" " <= c <= "~"):
+            out.append(f"\\{ord(c):03o}")
+        else:
+            out.append(c)
+    return '"' + "".join(out) + '"'
+
+
+def render() -> str:
+    folded, exact = reverse_entries()
+    displacements, slots = build_perfect_hash(sorted(folded))
+    values = key_values()
+    for key in [k for k, _ in PAIRS] + [k for _, k in ALIASES]:
+        if key not in values:
+            raise SystemExit(f"{KEY_PREFIX}{key} is not in {PUBLIC_HEADER}")
+    # Keys that alias another key's value keep the first name listed.
+    canonical: dict[int, tuple[str, str]] = {}
+    for key, name in PAIRS:
+        canonical.setdefault(values[key], (key, name))
+
+    lines = [
+        "/* Generated by scripts/gen_key_names.py; do not edit. */",
+        "#pragma once",
+        "#ifndef AXIDEV_IO_KEYBOARD_KEY_NAMES_TABLE_H",
+        "#define AXIDEV_IO_KEYBOARD_KEY_NAMES_TABLE_H",
+        "",
+        "#include <axidev-io/c_api.h>",
+        "",
+        "#include <stdint.h>",
+        "",
+        "typedef struct axidev_io_key_name_entry {",
+        "  const char *name;",
+        "  axidev_io_keyboard_key_t key;",
+        "} axidev_io_key_name_entry;",
+        "",
+        f"#define AXIDEV_IO_KEY_NAME_SLOTS {len(slots)}u",
+        f"#define AXIDEV_IO_KEY_NAME_BUCKETS {len(displacements)}u",
+        "#define AXIDEV_IO_KEY_NAME_MAX_LENGTH "
+        f"{max(len(n) for n in folded)}u",
+        "",
+        "static const char *const axidev_io_key_canonical_names[] = {",
+    ]
+    for key, name in canonical.values():
+        lines.append(f"    [{KEY_PREFIX}{key}] = {c_string(name)},")
+    lines += [
+        "};",
+        "",
+        "static const uint16_t",
+        "    axidev_io_key_name_displacements[AXIDEV_IO_KEY_NAME_BUCKETS] = {",
+    ]
+    row: list[str] = []
+    for value in displacements:
+        if row and len(" ".join(row)) + len(f" {value}u,") > 72:
+            lines.append("        " + " ".join(row))
+            row = []
+        row.append(f"{value}u,")
+    if row:
+        lines.append("        " + " ".join(row))
+    lines += [
+        "};",
+        "",
+        "/* Lowercased spellings, each at its perfect-hash slot. */",
+        "static const axidev_io_key_name_entry",
+        "    axidev_io_key_name_slots[AXIDEV_IO_KEY_NAME_SLOTS] = {",
+    ]
+    for name in slots:
+        key = KEY_PREFIX + folded[name]
+        lines.append(f"        {{{c_string(name)}, {key}}},")
+    lines += [
+        "};",
+        "",
+        "/* Spellings matched case-sensitively before the hash lookup. */",
+        "static const axidev_io_key_name_entry axidev_io_key_exact_names[] = {",
+    ]
+    for name, key in exact.items():
+        lines.append(f"    {{{c_string(name)}, {KEY_PREFIX}{key}}},")
+    lines += ["};", "", "#endif", ""]
+    return "\n".join(lines)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "--check",
+        action="store_true",
+        help="exit non-zero if the generated header is out of date",
+    )
+    args = parser.parse_args()
+
+    text = render()
+    if args.check:
+        current = OUTPUT.read_text() if OUTPUT.exists() else ""
+        if current != text:
+            print(f"{OUTPUT.relative_to(ROOT)} is out of date", file=sys.stderr)
+            return 1
+        return 0
+    OUTPUT.write_text(text, newline="\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,34 +1,45 @@
 #include <axidev-io/c_api.h>
 
-#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "internal/context.h"
-#include "internal/utf.h"
+#include "internal/stats.h"
 #include "keyboard/common/key_utils_internal.h"
 #include "keyboard/common/keymap_internal.h"
+#include "keyboard/common/keymap_snapshot_internal.h"
 #include "keyboard/listener/listener_internal.h"
+#include "keyboard/macro/macro_internal.h"
 #include "keyboard/sender/sender_internal.h"
+#include "keyboard/sender/sender_queue_internal.h"
+#include "keyboard/sender/typing_plan_internal.h"
+
+/* axidev_io_get_last_error_code() hands out results unchanged. */
+_Static_assert((int)AXIDEV_IO_ERROR_INVALID_ARGUMENT ==
+                   (int)AXIDEV_IO_RESULT_INVALID_ARGUMENT,
+               "error codes must mirror axidev_io_result");
+_Static_assert((int)AXIDEV_IO_ERROR_CANCELLED ==
+                   (int)AXIDEV_IO_RESULT_CANCELLED,
+               "error codes must mirror axidev_io_result");
 
 static void axidev_io_report_result(const char *function_name,
                                     axidev_io_result result) {
-  char *existing_error;
+  const char *existing_error;
 
   if (result == AXIDEV_IO_RESULT_OK) {
     return;
   }
 
-  existing_error = axidev_io_get_last_error();
-  if (existing_error == NULL || existing_error[0] == '\0') {
+  existing_error = axidev_io_get_last_error_message_internal();
+  if (existing_error[0] == '\0') {
     axidev_io_set_last_error_result(function_name, result);
     AXIDEV_IO_LOG_ERROR("%s failed: %s", function_name,
                         axidev_io_result_to_string(result));
   } else {
+    axidev_io_set_last_error_code(result);
     AXIDEV_IO_LOG_ERROR("%s failed: %s", function_name, existing_error);
   }
-  axidev_io_free_string(existing_error);
 }
 
 static const char *axidev_io_log_level_name(axidev_io_log_level_t level) {
@@ -68,98 +79,47 @@ static axidev_io_result axidev_io_require_keyboard_initialized(void) {
   return AXIDEV_IO_RESULT_OK;
 }
 
-static bool
-axidev_io_try_consume_modifier_prefix(const char **cursor,
-                                      axidev_io_keyboard_modifier_t *mods) {
-  static const struct {
-    const char *prefix;
-    axidev_io_keyboard_modifier_t flag;
-  } prefixes[] = {
-      {"super+", AXIDEV_IO_MOD_SUPER},  {"super-", AXIDEV_IO_MOD_SUPER},
-      {"cmd+", AXIDEV_IO_MOD_SUPER},    {"cmd-", AXIDEV_IO_MOD_SUPER},
-      {"win+", AXIDEV_IO_MOD_SUPER},    {"win-", AXIDEV_IO_MOD_SUPER},
-      {"meta+", AXIDEV_IO_MOD_SUPER},   {"meta-", AXIDEV_IO_MOD_SUPER},
-      {"ctrl+", AXIDEV_IO_MOD_CTRL},    {"ctrl-", AXIDEV_IO_MOD_CTRL},
-      {"control+", AXIDEV_IO_MOD_CTRL}, {"control-", AXIDEV_IO_MOD_CTRL},
-      {"alt+", AXIDEV_IO_MOD_ALT},      {"alt-", AXIDEV_IO_MOD_ALT},
-      {"opt+", AXIDEV_IO_MOD_ALT},      {"opt-", AXIDEV_IO_MOD_ALT},
-      {"option+", AXIDEV_IO_MOD_ALT},   {"option-", AXIDEV_IO_MOD_ALT},
-      {"shift+", AXIDEV_IO_MOD_SHIFT},  {"shift-", AXIDEV_IO_MOD_SHIFT}};
-  size_t i;
-
-  if (cursor == NULL || *cursor == NULL || mods == NULL) {
-    return false;
-  }
+/* Open axidev_io_sender_t handles; only touched under the context lock. */
+static size_t g_open_sender_handles = 0;
 
-  for (i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
-    size_t length = strlen(prefixes[i].prefix);
-    size_t j;
-    bool matched = true;
-    for (j = 0; j < length; ++j) {
-      char actual = (*cursor)[j];
-      if (actual == '\0') {
-        matched = false;
-        break;
-      }
-      if ((char)tolower((unsigned char)actual) != prefixes[i].prefix[j]) {
-        matched = false;
-        break;
-      }
-    }
-    if (matched) {
-      *mods = (axidev_io_keyboard_modifier_t)(*mods | prefixes[i].flag);
-      *cursor += length;
-      return true;
-    }
+/* Handles read the global keymap and may share the global device, so both
+   must outlive them. */
+static axidev_io_result axidev_io_require_no_sender_handles(void) {
+  if (g_open_sender_handles != 0) {
+    axidev_io_set_last_errorf("%zu sender handle(s) still open",
+                              g_open_sender_handles);
+    return AXIDEV_IO_RESULT_ALREADY_INITIALIZED;
   }
+  return AXIDEV_IO_RESULT_OK;
+}
 
-  return false;
+/* Handle calls skip the context lock and bind the handle's sender to the
+   calling thread until axidev_io_sender_unbind(). */
+static axidev_io_result axidev_io_sender_bind(axidev_io_sender_t *sender) {
+  if (sender == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if (!sender->context.initialized) {
+    return AXIDEV_IO_RESULT_NOT_INITIALIZED;
+  }
+  axidev_io_sender_binding = &sender->context;
+  return AXIDEV_IO_RESULT_OK;
 }
 
+static void axidev_io_sender_unbind(void) { axidev_io_sender_binding = NULL; }
+
 static axidev_io_result
 axidev_io_keyboard_type_text_internal(const char *text) {
-  const char *cursor = text;
-
-  while (cursor != NULL && *cursor != '\0') {
-    axidev_io_keyboard_modifier_t latched_mods = AXIDEV_IO_MOD_NONE;
-
-    while (axidev_io_try_consume_modifier_prefix(&cursor, &latched_mods)) {
-    }
-
-    while (*cursor != '\0' && *cursor != ',') {
-      const char *previous = cursor;
-      uint32_t codepoint = 0;
-      axidev_io_result result;
-
-      axidev_io_utf8_decode_one(&cursor, &codepoint);
-      if (cursor == previous) {
-        return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
-      }
-
-      if (latched_mods != AXIDEV_IO_MOD_NONE) {
-        axidev_io_keyboard_key_with_modifier_t key_mod;
-        result = axidev_io_keymap_lookup_character(codepoint, &key_mod);
-        if (result != AXIDEV_IO_RESULT_OK) {
-          return result;
-        }
-        key_mod.mods =
-            (axidev_io_keyboard_modifier_t)(key_mod.mods | latched_mods);
-        result = axidev_io_keyboard_sender_tap_internal(key_mod);
-      } else {
-        result = axidev_io_keyboard_sender_type_character_internal(codepoint);
-      }
-
-      if (result != AXIDEV_IO_RESULT_OK) {
-        return result;
-      }
-    }
+  axidev_io_typing_step *steps = NULL;
+  axidev_io_result result;
 
-    if (*cursor == ',') {
-      ++cursor;
-    }
+  result = axidev_io_typing_plan_build(text, &steps);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
   }
-
-  return AXIDEV_IO_RESULT_OK;
+  result = axidev_io_typing_plan_play(steps, (size_t)arrlen(steps), NULL);
+  axidev_io_typing_plan_free(&steps);
+  return result;
 }
 
 AXIDEV_IO_API bool axidev_io_keyboard_initialize(void) {
@@ -167,8 +127,19 @@ AXIDEV_IO_API bool axidev_io_keyboard_initialize(void) {
 
   axidev_io_context_ensure_runtime();
   axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_queue_shutdown();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_initialize", result);
+    return false;
+  }
 
   axidev_io_context_lock();
+  result = axidev_io_require_no_sender_handles();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_initialize", result);
+    axidev_io_context_unlock();
+    return false;
+  }
   axidev_io_keyboard_sender_free();
   axidev_io_keyboard_keymap_free();
 
@@ -191,8 +162,22 @@ AXIDEV_IO_API bool axidev_io_keyboard_initialize(void) {
 }
 
 AXIDEV_IO_API void axidev_io_keyboard_free(void) {
+  axidev_io_result result;
+
   axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_queue_shutdown();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_free", result);
+    return;
+  }
   axidev_io_context_lock();
+  result = axidev_io_require_no_sender_handles();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_free", result);
+    axidev_io_context_unlock();
+    return;
+  }
   axidev_io_keyboard_sender_free();
   axidev_io_keyboard_keymap_free();
   axidev_io_global->keyboard.initialized = false;
@@ -202,6 +187,33 @@ AXIDEV_IO_API void axidev_io_keyboard_free(void) {
   axidev_io_context_unlock();
 }
 
+AXIDEV_IO_API bool axidev_io_keyboard_refresh_layout(bool *out_changed) {
+  axidev_io_result result;
+  bool changed = false;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_require_no_sender_handles();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keymap_refresh(&changed);
+  }
+  if (result == AXIDEV_IO_RESULT_OK && changed) {
+    result = axidev_io_keyboard_sender_keymap_changed_internal();
+    if (!axidev_io_global->keyboard.sender.initialized) {
+      axidev_io_global->keyboard.initialized = false;
+    }
+  }
+  if (out_changed != NULL) {
+    *out_changed = changed;
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_refresh_layout", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
 AXIDEV_IO_API bool axidev_io_keyboard_is_ready(void) {
   axidev_io_context_ensure_runtime();
   return axidev_io_global->keyboard.initialized &&
@@ -287,7 +299,7 @@ axidev_io_keyboard_tap(axidev_io_keyboard_key_with_modifier_t key_mod) {
   axidev_io_context_lock();
   result = axidev_io_require_keyboard_initialized();
   if (result == AXIDEV_IO_RESULT_OK) {
-    result = axidev_io_keyboard_sender_tap_internal(key_mod);
+    result = axidev_io_keyboard_sender_tap_timed(key_mod);
   }
   if (result != AXIDEV_IO_RESULT_OK) {
     axidev_io_report_result("axidev_io_keyboard_tap", result);
@@ -395,6 +407,111 @@ AXIDEV_IO_API bool axidev_io_keyboard_type_character(uint32_t codepoint) {
   return result == AXIDEV_IO_RESULT_OK;
 }
 
+AXIDEV_IO_API axidev_io_keyboard_plan_t *
+axidev_io_keyboard_plan_compile(const char *text) {
+  axidev_io_keyboard_plan_t *plan = NULL;
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (text == NULL) {
+    axidev_io_report_result("axidev_io_keyboard_plan_compile",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return NULL;
+  }
+
+  axidev_io_context_lock();
+  result = axidev_io_require_keyboard_initialized();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_plan_compile_internal(text, &plan);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_plan_compile", result);
+  }
+  axidev_io_context_unlock();
+  return plan;
+}
+
+AXIDEV_IO_API bool
+axidev_io_keyboard_plan_play(axidev_io_keyboard_plan_t *plan) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (plan == NULL) {
+    axidev_io_report_result("axidev_io_keyboard_plan_play",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return false;
+  }
+
+  axidev_io_context_lock();
+  result = axidev_io_require_keyboard_initialized();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_plan_refresh_internal(plan);
+  }
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_typing_plan_play(plan->steps,
+                                        (size_t)arrlen(plan->steps), NULL);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_plan_play", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API void
+axidev_io_keyboard_plan_free(axidev_io_keyboard_plan_t *plan) {
+  axidev_io_keyboard_plan_free_internal(plan);
+}
+
+AXIDEV_IO_API uint64_t axidev_io_keyboard_type_text_async(
+    const char *text, axidev_io_keyboard_async_cb cb, void *user_data) {
+  uint64_t job_id = 0;
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_queue_push_text(text, cb, user_data, &job_id);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_type_text_async", result);
+    return 0;
+  }
+  return job_id;
+}
+
+AXIDEV_IO_API uint64_t
+axidev_io_keyboard_tap_async(axidev_io_keyboard_key_with_modifier_t key_mod,
+                             axidev_io_keyboard_async_cb cb, void *user_data) {
+  uint64_t job_id = 0;
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_queue_push_tap(key_mod, cb, user_data, &job_id);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_tap_async", result);
+    return 0;
+  }
+  return job_id;
+}
+
+AXIDEV_IO_API bool axidev_io_keyboard_async_wait(uint64_t job_id,
+                                                 uint32_t timeout_ms) {
+  axidev_io_context_ensure_runtime();
+  return axidev_io_sender_queue_wait(job_id, timeout_ms);
+}
+
+AXIDEV_IO_API bool axidev_io_keyboard_async_cancel(uint64_t job_id) {
+  axidev_io_context_ensure_runtime();
+  return axidev_io_sender_queue_cancel(job_id) > 0;
+}
+
+AXIDEV_IO_API size_t axidev_io_keyboard_async_pending(void) {
+  axidev_io_context_ensure_runtime();
+  return axidev_io_sender_queue_pending();
+}
+
 AXIDEV_IO_API void axidev_io_keyboard_flush(void) {
   axidev_io_context_ensure_runtime();
   axidev_io_context_lock();
@@ -404,94 +521,779 @@ AXIDEV_IO_API void axidev_io_keyboard_flush(void) {
   axidev_io_context_unlock();
 }
 
+/* Sets the bound sender's key delay and the typing rate it came from. */
+static void axidev_io_apply_key_delay(uint32_t delay_us,
+                                      uint32_t chars_per_second) {
+  axidev_io_keyboard_sender_set_key_delay_internal(delay_us);
+  axidev_io_sender_public_context()->typing_rate_cps = chars_per_second;
+}
+
 AXIDEV_IO_API void axidev_io_keyboard_set_key_delay(uint32_t delay_us) {
   axidev_io_context_ensure_runtime();
   axidev_io_context_lock();
   if (axidev_io_require_keyboard_initialized() == AXIDEV_IO_RESULT_OK) {
-    axidev_io_keyboard_sender_set_key_delay_internal(delay_us);
+    axidev_io_apply_key_delay(delay_us, 0);
   }
   axidev_io_context_unlock();
 }
 
-AXIDEV_IO_API bool axidev_io_listener_start(axidev_io_keyboard_listener_cb cb,
-                                            void *user_data) {
-  axidev_io_result result;
+/* A tap without modifiers is a down/up pair with one key delay after each
+   transition, so the delay is half of the per-character budget. A tap that
+   presses modifiers adds one more delay after them, so it runs below the
+   rate. Typed text re-derives the delay from each plan's transitions per
+   character and keeps the rate either way. */
+AXIDEV_IO_API void
+axidev_io_keyboard_set_typing_rate(uint32_t chars_per_second) {
+  uint32_t delay_us = 0;
+
+  if (chars_per_second != 0) {
+    delay_us = (500000u + chars_per_second / 2u) / chars_per_second;
+    if (delay_us == 0) {
+      delay_us = 1;
+    }
+  }
+  axidev_io_context_ensure_runtime();
+  axidev_io_context_lock();
+  if (axidev_io_require_keyboard_initialized() == AXIDEV_IO_RESULT_OK) {
+    axidev_io_apply_key_delay(delay_us, chars_per_second);
+  }
+  axidev_io_context_unlock();
+}
 
+AXIDEV_IO_API void axidev_io_keyboard_set_pacing_spin(uint32_t spin_us) {
   axidev_io_context_ensure_runtime();
-  axidev_io_clear_last_error_internal();
   axidev_io_context_lock();
-  result = axidev_io_keyboard_listener_start_internal(cb, user_data);
-  if (result != AXIDEV_IO_RESULT_OK) {
-    axidev_io_report_result("axidev_io_listener_start", result);
+  if (axidev_io_require_keyboard_initialized() == AXIDEV_IO_RESULT_OK) {
+    axidev_io_keyboard_sender_set_pacing_spin_internal(spin_us);
   }
   axidev_io_context_unlock();
-  return result == AXIDEV_IO_RESULT_OK;
 }
 
-AXIDEV_IO_API void axidev_io_listener_stop(void) {
+AXIDEV_IO_API void axidev_io_keyboard_set_sender_options(uint32_t options) {
   axidev_io_context_ensure_runtime();
   axidev_io_context_lock();
-  axidev_io_keyboard_listener_stop_internal();
+  axidev_io_keyboard_sender_set_options_internal(options);
   axidev_io_context_unlock();
 }
 
-AXIDEV_IO_API bool axidev_io_listener_is_listening(void) {
+AXIDEV_IO_API uint32_t axidev_io_keyboard_get_sender_options(void) {
+  uint32_t options;
+
   axidev_io_context_ensure_runtime();
-  return axidev_io_global->keyboard.listener.is_listening;
+  axidev_io_context_lock();
+  options = axidev_io_keyboard_sender_get_options_internal();
+  axidev_io_context_unlock();
+  return options;
 }
 
-AXIDEV_IO_API char *
-axidev_io_keyboard_key_to_string(axidev_io_keyboard_key_t key) {
+AXIDEV_IO_API size_t
+axidev_io_keyboard_capture_read(axidev_io_captured_transition_t *out,
+                                size_t max_count) {
+  size_t count;
+
   axidev_io_context_ensure_runtime();
   axidev_io_clear_last_error_internal();
-  return axidev_io_key_to_string_alloc(key);
+  if (out == NULL && max_count != 0) {
+    axidev_io_report_result("axidev_io_keyboard_capture_read",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return 0;
+  }
+  axidev_io_context_lock();
+  count = axidev_io_keyboard_sender_capture_read_internal(out, max_count);
+  axidev_io_context_unlock();
+  return count;
 }
 
-AXIDEV_IO_API axidev_io_keyboard_key_t
-axidev_io_keyboard_string_to_key(const char *name) {
+AXIDEV_IO_API bool axidev_io_keyboard_set_keymap_cache_dir(const char *path) {
+  axidev_io_result result;
+
   axidev_io_context_ensure_runtime();
   axidev_io_clear_last_error_internal();
-  if (name == NULL) {
-    axidev_io_report_result("axidev_io_keyboard_string_to_key",
-                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
-    return AXIDEV_IO_KEY_UNKNOWN;
+  result = axidev_io_keymap_snapshot_set_directory(path);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_set_keymap_cache_dir", result);
   }
-  return axidev_io_string_to_key_internal(name);
+  return result == AXIDEV_IO_RESULT_OK;
 }
 
-AXIDEV_IO_API char *axidev_io_keyboard_key_to_string_with_modifier(
-    axidev_io_keyboard_key_with_modifier_t key_mod) {
+AXIDEV_IO_API bool axidev_io_keyboard_invalidate_keymap_cache(void) {
+  axidev_io_result result;
+
   axidev_io_context_ensure_runtime();
   axidev_io_clear_last_error_internal();
-  return axidev_io_key_to_string_with_modifier_alloc(key_mod.key, key_mod.mods);
+  result = axidev_io_keymap_snapshot_invalidate();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_keyboard_invalidate_keymap_cache",
+                            result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
 }
 
-AXIDEV_IO_API bool axidev_io_keyboard_string_to_key_with_modifier(
-    const char *combo, axidev_io_keyboard_key_with_modifier_t *out_key_mod) {
+static axidev_io_sender_t *
+axidev_io_sender_open_internal(const char *function_name, uint32_t flags,
+                               const axidev_io_virtual_device_t *device) {
+  axidev_io_sender_t *sender;
+  axidev_io_result result;
+
   axidev_io_context_ensure_runtime();
   axidev_io_clear_last_error_internal();
-  if (combo == NULL || out_key_mod == NULL) {
-    axidev_io_report_result("axidev_io_keyboard_string_to_key_with_modifier",
-                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
-    return false;
+  sender = (axidev_io_sender_t *)calloc(1, sizeof(*sender));
+  if (sender == NULL) {
+    axidev_io_report_result(function_name, AXIDEV_IO_RESULT_INTERNAL_ERROR);
+    return NULL;
   }
-  return axidev_io_string_to_key_with_modifier_internal(combo, out_key_mod);
+  sender->flags = flags;
+
+  axidev_io_context_lock();
+  result = axidev_io_require_keyboard_initialized();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    axidev_io_sender_binding = &sender->context;
+    result = axidev_io_keyboard_sender_initialize_handle(flags, device);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      axidev_io_keyboard_sender_free();
+    }
+    axidev_io_sender_unbind();
+  }
+  if (result == AXIDEV_IO_RESULT_OK) {
+    ++g_open_sender_handles;
+  } else {
+    axidev_io_report_result(function_name, result);
+    free(sender);
+    sender = NULL;
+  }
+  axidev_io_context_unlock();
+  return sender;
 }
 
-AXIDEV_IO_API const char *axidev_io_library_version(void) {
-  return AXIDEV_IO_VERSION;
+AXIDEV_IO_API axidev_io_sender_t *axidev_io_sender_open(uint32_t flags) {
+  return axidev_io_sender_open_internal("axidev_io_sender_open", flags, NULL);
 }
 
-AXIDEV_IO_API char *axidev_io_get_last_error(void) {
-  axidev_io_private_runtime *runtime;
-  char *copy;
+AXIDEV_IO_API axidev_io_sender_t *
+axidev_io_sender_open_device(const axidev_io_virtual_device_t *device) {
+  return axidev_io_sender_open_internal("axidev_io_sender_open_device",
+                                        AXIDEV_IO_SENDER_HANDLE_OWN_DEVICE,
+                                        device);
+}
+
+AXIDEV_IO_API void axidev_io_sender_close(axidev_io_sender_t *sender) {
+  if (sender == NULL) {
+    return;
+  }
+  axidev_io_context_ensure_runtime();
+  axidev_io_context_lock();
+  axidev_io_sender_binding = &sender->context;
+  axidev_io_keyboard_sender_free();
+  axidev_io_sender_unbind();
+  --g_open_sender_handles;
+  axidev_io_context_unlock();
+  free(sender);
+}
+
+AXIDEV_IO_API bool
+axidev_io_sender_key_down(axidev_io_sender_t *sender,
+                          axidev_io_keyboard_key_with_modifier_t key_mod,
+                          bool repeat) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_sender_key_down_internal(key_mod, repeat);
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_key_down", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool
+axidev_io_sender_key_up(axidev_io_sender_t *sender,
+                        axidev_io_keyboard_key_with_modifier_t key_mod) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_sender_key_up_internal(key_mod);
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_key_up", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool
+axidev_io_sender_tap(axidev_io_sender_t *sender,
+                     axidev_io_keyboard_key_with_modifier_t key_mod) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_sender_tap_timed(key_mod);
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_tap", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API axidev_io_keyboard_modifier_t
+axidev_io_sender_active_modifiers(const axidev_io_sender_t *sender) {
+  return sender != NULL ? sender->context.active_modifiers
+                        : AXIDEV_IO_MOD_NONE;
+}
+
+AXIDEV_IO_API bool
+axidev_io_sender_hold_modifier(axidev_io_sender_t *sender,
+                               axidev_io_keyboard_modifier_t mods) {
+  axidev_io_result result;
 
   axidev_io_context_ensure_runtime();
-  runtime = axidev_io_private_runtime_get();
-  axidev_io_mutex_lock(&runtime->error_lock);
-  copy = axidev_io_duplicate_string(axidev_io_global->last_error);
-  axidev_io_mutex_unlock(&runtime->error_lock);
-  return copy;
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_sender_hold_modifier_internal(mods);
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_hold_modifier", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool
+axidev_io_sender_release_modifier(axidev_io_sender_t *sender,
+                                  axidev_io_keyboard_modifier_t mods) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_sender_release_modifier_internal(mods);
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_release_modifier", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool
+axidev_io_sender_release_all_modifiers(axidev_io_sender_t *sender) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_sender_release_all_modifiers_internal();
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_release_all_modifiers", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool axidev_io_sender_type_text(axidev_io_sender_t *sender,
+                                              const char *text) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (text == NULL) {
+    axidev_io_report_result("axidev_io_sender_type_text",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return false;
+  }
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_type_text_internal(text);
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_type_text", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool axidev_io_sender_type_character(axidev_io_sender_t *sender,
+                                                   uint32_t codepoint) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_bind(sender);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_keyboard_sender_type_character_internal(codepoint);
+    axidev_io_sender_unbind();
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_sender_type_character", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API void axidev_io_sender_flush(axidev_io_sender_t *sender) {
+  axidev_io_context_ensure_runtime();
+  if (axidev_io_sender_bind(sender) == AXIDEV_IO_RESULT_OK) {
+    axidev_io_keyboard_sender_flush_internal();
+    axidev_io_sender_unbind();
+  }
+}
+
+AXIDEV_IO_API void axidev_io_sender_set_key_delay(axidev_io_sender_t *sender,
+                                                  uint32_t delay_us) {
+  axidev_io_context_ensure_runtime();
+  if (axidev_io_sender_bind(sender) == AXIDEV_IO_RESULT_OK) {
+    axidev_io_apply_key_delay(delay_us, 0);
+    axidev_io_sender_unbind();
+  }
+}
+
+AXIDEV_IO_API bool axidev_io_listener_start(axidev_io_keyboard_listener_cb cb,
+                                            void *user_data) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_keyboard_listener_start_internal(cb, NULL, user_data);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_listener_start", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool
+axidev_io_listener_start_batched(axidev_io_keyboard_listener_batch_cb cb,
+                                 void *user_data) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_keyboard_listener_start_internal(NULL, cb, user_data);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_listener_start_batched", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API void axidev_io_listener_stop(void) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_context_lock();
+  axidev_io_keyboard_listener_stop_internal();
+  axidev_io_keyboard_listener_close_queue_internal();
+  axidev_io_keyboard_listener_reclaim(axidev_io_listener_impl_get());
+  axidev_io_context_unlock();
+}
+
+AXIDEV_IO_API uint64_t axidev_io_listener_subscribe(
+    axidev_io_keyboard_listener_batch_cb cb, void *user_data) {
+  axidev_io_result result;
+  uint64_t token = 0;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_keyboard_listener_subscribe_internal(
+      axidev_io_listener_impl_get(), cb, user_data, &token);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_listener_subscribe", result);
+  }
+  axidev_io_context_unlock();
+  return token;
+}
+
+AXIDEV_IO_API bool axidev_io_listener_unsubscribe(uint64_t token) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_keyboard_listener_unsubscribe_internal(
+      axidev_io_listener_impl_get(), token);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_listener_unsubscribe", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool
+axidev_io_listener_open_queue(axidev_io_listener_wait_handle_t *out_handle) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_keyboard_listener_open_queue_internal(out_handle);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_listener_open_queue", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API size_t axidev_io_listener_read_events(
+    axidev_io_key_event_t *events, size_t max_events) {
+  axidev_io_result result;
+  size_t count = 0;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_keyboard_listener_read_events_internal(events, max_events,
+                                                            &count);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_listener_read_events", result);
+  }
+  axidev_io_context_unlock();
+  return count;
+}
+
+AXIDEV_IO_API bool axidev_io_listener_is_listening(void) {
+  axidev_io_context_ensure_runtime();
+  return axidev_io_global->keyboard.listener.is_listening;
+}
+
+AXIDEV_IO_API axidev_io_keyboard_backend_type_t
+axidev_io_listener_backend_type(void) {
+  axidev_io_keyboard_backend_type_t backend_type;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_context_lock();
+  backend_type = axidev_io_listener_impl_get()->backend_type;
+  axidev_io_context_unlock();
+  return backend_type;
+}
+
+AXIDEV_IO_API void axidev_io_listener_set_options(uint32_t options) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_context_lock();
+  axidev_io_listener_impl_get()->options = options;
+  axidev_io_context_unlock();
+}
+
+AXIDEV_IO_API uint32_t axidev_io_listener_get_options(void) {
+  uint32_t options;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_context_lock();
+  options = axidev_io_listener_impl_get()->options;
+  axidev_io_context_unlock();
+  return options;
+}
+
+AXIDEV_IO_API void
+axidev_io_listener_get_stats(axidev_io_listener_stats_t *out_stats) {
+  axidev_io_keyboard_listener_impl *impl;
+
+  axidev_io_context_ensure_runtime();
+  if (out_stats == NULL) {
+    axidev_io_report_result("axidev_io_listener_get_stats",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return;
+  }
+  axidev_io_context_lock();
+  impl = axidev_io_listener_impl_get();
+  out_stats->events_delivered = atomic_load(&impl->events_delivered);
+  out_stats->events_dropped = atomic_load(&impl->events_dropped);
+  out_stats->queue_capacity = impl->queue_capacity;
+  out_stats->queue_high_water = atomic_load(&impl->queue_high_water);
+  axidev_io_context_unlock();
+}
+
+AXIDEV_IO_API void
+axidev_io_listener_set_filter(const axidev_io_listener_filter_t *filter) {
+  axidev_io_keyboard_listener_impl *impl;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_context_lock();
+  impl = axidev_io_listener_impl_get();
+  if (filter != NULL) {
+    impl->filter = *filter;
+  } else {
+    memset(&impl->filter, 0, sizeof(impl->filter));
+  }
+  axidev_io_context_unlock();
+}
+
+AXIDEV_IO_API void
+axidev_io_listener_filter_add_key(axidev_io_listener_filter_t *filter,
+                                  axidev_io_keyboard_key_t key) {
+  if (filter == NULL ||
+      (uint32_t)key >= AXIDEV_IO_LISTENER_FILTER_WORDS * 64u) {
+    return;
+  }
+  filter->keys[key / 64u] |= (uint64_t)1u << (key % 64u);
+}
+
+AXIDEV_IO_API void
+axidev_io_listener_get_latency(axidev_io_listener_latency_t *out_latency) {
+  axidev_io_keyboard_listener_impl *impl;
+
+  axidev_io_context_ensure_runtime();
+  if (out_latency == NULL) {
+    axidev_io_report_result("axidev_io_listener_get_latency",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return;
+  }
+  axidev_io_context_lock();
+  impl = axidev_io_listener_impl_get();
+  out_latency->samples = 0;
+  for (size_t i = 0; i < AXIDEV_IO_LISTENER_LATENCY_BUCKETS; ++i) {
+    out_latency->buckets[i] = atomic_load(&impl->latency_buckets[i]);
+    out_latency->samples += out_latency->buckets[i];
+  }
+  out_latency->max_us = atomic_load(&impl->latency_max_us);
+  axidev_io_context_unlock();
+}
+
+AXIDEV_IO_API axidev_io_macro_recorder_t *
+axidev_io_macro_recorder_create(void) {
+  axidev_io_macro_recorder_t *recorder = NULL;
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_macro_recorder_create_internal(&recorder);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_macro_recorder_create", result);
+    return NULL;
+  }
+  return recorder;
+}
+
+AXIDEV_IO_API void
+axidev_io_macro_recorder_destroy(axidev_io_macro_recorder_t *recorder) {
+  if (recorder != NULL) {
+    axidev_io_macro_recorder_destroy_internal(recorder);
+  }
+}
+
+AXIDEV_IO_API void axidev_io_macro_recorder_append(
+    const axidev_io_key_event_t *events, size_t count, void *recorder) {
+  if (recorder == NULL || (events == NULL && count > 0)) {
+    return;
+  }
+  axidev_io_macro_recorder_append_internal(
+      (axidev_io_macro_recorder_t *)recorder, events, count);
+}
+
+AXIDEV_IO_API size_t
+axidev_io_macro_recorder_event_count(axidev_io_macro_recorder_t *recorder) {
+  return recorder != NULL
+             ? axidev_io_macro_recorder_event_count_internal(recorder)
+             : 0;
+}
+
+AXIDEV_IO_API size_t axidev_io_macro_recorder_copy(
+    axidev_io_macro_recorder_t *recorder, uint8_t *buf, size_t len) {
+  if (recorder == NULL) {
+    return 0;
+  }
+  return axidev_io_macro_recorder_copy_internal(recorder, buf, len);
+}
+
+AXIDEV_IO_API void
+axidev_io_macro_recorder_clear(axidev_io_macro_recorder_t *recorder) {
+  if (recorder != NULL) {
+    axidev_io_macro_recorder_clear_internal(recorder);
+  }
+}
+
+AXIDEV_IO_API bool
+axidev_io_macro_recorder_save(axidev_io_macro_recorder_t *recorder,
+                              const char *path) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (recorder == NULL || path == NULL) {
+    result = AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  } else {
+    result = axidev_io_macro_recorder_save_internal(recorder, path);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_macro_recorder_save", result);
+  }
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API bool axidev_io_macro_replay(const uint8_t *data, size_t size,
+                                          double speed) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  axidev_io_context_lock();
+  result = axidev_io_require_keyboard_initialized();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_macro_replay_internal(data, size, speed, NULL);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_macro_replay", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API uint64_t axidev_io_macro_replay_async(
+    const uint8_t *data, size_t size, double speed,
+    axidev_io_keyboard_async_cb cb, void *user_data) {
+  uint64_t job_id = 0;
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  result = axidev_io_sender_queue_push_macro(data, size, speed, cb, user_data,
+                                             &job_id);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_macro_replay_async", result);
+    return 0;
+  }
+  return job_id;
+}
+
+AXIDEV_IO_API bool axidev_io_macro_replay_file(const char *path,
+                                               double speed) {
+  axidev_io_result result;
+
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (path == NULL) {
+    axidev_io_report_result("axidev_io_macro_replay_file",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return false;
+  }
+  axidev_io_context_lock();
+  result = axidev_io_require_keyboard_initialized();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_macro_replay_file_internal(path, speed);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_report_result("axidev_io_macro_replay_file", result);
+  }
+  axidev_io_context_unlock();
+  return result == AXIDEV_IO_RESULT_OK;
+}
+
+AXIDEV_IO_API char *
+axidev_io_keyboard_key_to_string(axidev_io_keyboard_key_t key) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  return axidev_io_key_to_string_alloc(key);
+}
+
+AXIDEV_IO_API const char *
+axidev_io_keyboard_key_name(axidev_io_keyboard_key_t key) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  return axidev_io_key_to_string_const(key);
+}
+
+AXIDEV_IO_API size_t axidev_io_keyboard_key_to_string_buf(
+    axidev_io_keyboard_key_t key, char *buf, size_t len) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (buf == NULL && len > 0u) {
+    axidev_io_report_result("axidev_io_keyboard_key_to_string_buf",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return 0;
+  }
+  return axidev_io_key_to_string_buf(key, buf, len);
+}
+
+AXIDEV_IO_API axidev_io_keyboard_key_t
+axidev_io_keyboard_string_to_key(const char *name) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (name == NULL) {
+    axidev_io_report_result("axidev_io_keyboard_string_to_key",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return AXIDEV_IO_KEY_UNKNOWN;
+  }
+  return axidev_io_string_to_key_internal(name);
+}
+
+AXIDEV_IO_API char *axidev_io_keyboard_key_to_string_with_modifier(
+    axidev_io_keyboard_key_with_modifier_t key_mod) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  return axidev_io_key_to_string_with_modifier_alloc(key_mod.key, key_mod.mods);
+}
+
+AXIDEV_IO_API size_t axidev_io_keyboard_key_to_string_with_modifier_buf(
+    axidev_io_keyboard_key_with_modifier_t key_mod, char *buf, size_t len) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (buf == NULL && len > 0u) {
+    axidev_io_report_result(
+        "axidev_io_keyboard_key_to_string_with_modifier_buf",
+        AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return 0;
+  }
+  return axidev_io_key_to_string_with_modifier_buf(key_mod.key, key_mod.mods,
+                                                   buf, len);
+}
+
+AXIDEV_IO_API bool axidev_io_keyboard_string_to_key_with_modifier(
+    const char *combo, axidev_io_keyboard_key_with_modifier_t *out_key_mod) {
+  axidev_io_context_ensure_runtime();
+  axidev_io_clear_last_error_internal();
+  if (combo == NULL || out_key_mod == NULL) {
+    axidev_io_report_result("axidev_io_keyboard_string_to_key_with_modifier",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return false;
+  }
+  return axidev_io_string_to_key_with_modifier_internal(combo, out_key_mod);
+}
+
+AXIDEV_IO_API const char *axidev_io_library_version(void) {
+  return AXIDEV_IO_VERSION;
+}
+
+AXIDEV_IO_API uint64_t axidev_io_monotonic_time_us(void) {
+  return axidev_io_monotonic_time_ns() / 1000u;
+}
+
+AXIDEV_IO_API void axidev_io_get_stats(axidev_io_stats_t *out_stats) {
+  axidev_io_context_ensure_runtime();
+  if (out_stats == NULL) {
+    axidev_io_report_result("axidev_io_get_stats",
+                            AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+    return;
+  }
+  axidev_io_stats_snapshot(out_stats);
+}
+
+AXIDEV_IO_API void axidev_io_reset_stats(void) { axidev_io_stats_reset(); }
+
+AXIDEV_IO_API char *axidev_io_get_last_error(void) {
+  const char *message = axidev_io_get_last_error_message_internal();
+
+  return message[0] != '\0' ? axidev_io_duplicate_string(message) : NULL;
+}
+
+AXIDEV_IO_API const char *axidev_io_get_last_error_message(void) {
+  return axidev_io_get_last_error_message_internal();
+}
+
+AXIDEV_IO_API axidev_io_error_code_t axidev_io_get_last_error_code(void) {
+  return (axidev_io_error_code_t)axidev_io_get_last_error_code_internal();
 }
 
 AXIDEV_IO_API void axidev_io_clear_last_error(void) {
@@ -12,13 +12,19 @@ static axidev_io_global_context g_axidev_io_storage = {
 
 AXIDEV_IO_API axidev_io_global_context *axidev_io_global = &g_axidev_io_storage;
 
+AXIDEV_IO_THREAD_LOCAL axidev_io_keyboard_sender_context
+    *axidev_io_sender_binding = NULL;
+
+/* Each thread keeps its own last error, so recording one needs no lock and
+   no allocation. Messages longer than the buffer are cut. */
+static AXIDEV_IO_THREAD_LOCAL axidev_io_error_record g_last_error;
+
 static void axidev_io_context_init_once(void) {
   axidev_io_private_runtime *runtime =
       (axidev_io_private_runtime *)axidev_io_global->private_storage.bytes;
 
   memset(runtime, 0, sizeof(*runtime));
   axidev_io_mutex_init(&runtime->state_lock);
-  axidev_io_mutex_init(&runtime->error_lock);
   axidev_io_global->log_level = AXIDEV_IO_LOG_LEVEL_INFO;
   axidev_io_keyboard_reset_public_state();
 }
@@ -42,16 +48,6 @@ void axidev_io_context_unlock(void) {
   axidev_io_mutex_unlock(&runtime->state_lock);
 }
 
-static void axidev_io_error_lock(void) {
-  axidev_io_private_runtime *runtime = axidev_io_private_runtime_get();
-  axidev_io_mutex_lock(&runtime->error_lock);
-}
-
-static void axidev_io_error_unlock(void) {
-  axidev_io_private_runtime *runtime = axidev_io_private_runtime_get();
-  axidev_io_mutex_unlock(&runtime->error_lock);
-}
-
 char *axidev_io_duplicate_string(const char *text) {
   size_t length;
   char *copy;
@@ -71,53 +67,38 @@ char *axidev_io_duplicate_string(const char *text) {
 }
 
 void axidev_io_clear_last_error_internal(void) {
-  axidev_io_error_lock();
-  free(axidev_io_global->last_error);
-  axidev_io_global->last_error = NULL;
-  axidev_io_error_unlock();
+  g_last_error.code = AXIDEV_IO_RESULT_OK;
+  g_last_error.message[0] = '\0';
 }
 
 void axidev_io_set_last_error_message(const char *message) {
-  char *copy = axidev_io_duplicate_string(message != NULL ? message : "");
+  size_t length;
 
-  axidev_io_error_lock();
-  free(axidev_io_global->last_error);
-  axidev_io_global->last_error = copy;
-  axidev_io_error_unlock();
+  if (message == NULL) {
+    message = "";
+  }
+  length = strlen(message);
+  if (length >= sizeof(g_last_error.message)) {
+    length = sizeof(g_last_error.message) - 1u;
+  }
+  memmove(g_last_error.message, message, length);
+  g_last_error.message[length] = '\0';
 }
 
 void axidev_io_set_last_errorfv(const char *fmt, va_list args) {
-  va_list copy_args;
-  int needed;
-  char *buffer;
+  /* Formatted aside first: the arguments may point into the current
+     message. */
+  char buffer[AXIDEV_IO_LAST_ERROR_MAX];
 
   if (fmt == NULL) {
     axidev_io_set_last_error_message("");
     return;
   }
-
-  va_copy(copy_args, args);
-#ifdef _WIN32
-  needed = _vscprintf(fmt, copy_args);
-#else
-  needed = vsnprintf(NULL, 0, fmt, copy_args);
-#endif
-  va_end(copy_args);
-  if (needed < 0) {
+  if (vsnprintf(buffer, sizeof(buffer), fmt, args) < 0) {
     axidev_io_set_last_error_message("formatting error");
     return;
   }
-
-  buffer = (char *)malloc((size_t)needed + 1u);
-  if (buffer == NULL) {
-    return;
-  }
-
-  vsnprintf(buffer, (size_t)needed + 1u, fmt, args);
-  axidev_io_error_lock();
-  free(axidev_io_global->last_error);
-  axidev_io_global->last_error = buffer;
-  axidev_io_error_unlock();
+  memcpy(g_last_error.message, buffer, sizeof(buffer));
 }
 
 void axidev_io_set_last_errorf(const char *fmt, ...) {
@@ -128,8 +109,29 @@ void axidev_io_set_last_errorf(const char *fmt, ...) {
   va_end(args);
 }
 
+void axidev_io_set_last_error_code(axidev_io_result result) {
+  g_last_error.code = result;
+}
+
+void axidev_io_last_error_save(axidev_io_error_record *out) {
+  memcpy(out, &g_last_error, sizeof(*out));
+}
+
+void axidev_io_last_error_restore(const axidev_io_error_record *record) {
+  memcpy(&g_last_error, record, sizeof(g_last_error));
+}
+
+axidev_io_result axidev_io_get_last_error_code_internal(void) {
+  return g_last_error.code;
+}
+
+const char *axidev_io_get_last_error_message_internal(void) {
+  return g_last_error.message;
+}
+
 void axidev_io_set_last_error_result(const char *function_name,
                                      axidev_io_result result) {
+  g_last_error.code = result;
   if (function_name == NULL) {
     axidev_io_set_last_error_message(axidev_io_result_to_string(result));
     return;
@@ -139,9 +141,10 @@ void axidev_io_set_last_error_result(const char *function_name,
 }
 
 void axidev_io_keyboard_reset_public_sender_state(void) {
-  memset(&axidev_io_global->keyboard.sender, 0,
-         sizeof(axidev_io_global->keyboard.sender));
-  axidev_io_global->keyboard.sender.key_delay_us = 1000u;
+  axidev_io_keyboard_sender_context *sender = axidev_io_sender_public_context();
+
+  memset(sender, 0, sizeof(*sender));
+  sender->key_delay_us = 1000u;
 }
 
 void axidev_io_keyboard_reset_public_listener_state(void) {
@@ -7,16 +7,72 @@
 #include <axidev-io/c_api.h>
 
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+/* Longest async message kept, including its terminator; longer ones are
+   cut. Synchronous messages are never truncated. */
+#define AXIDEV_IO_LOG_MESSAGE_MAX 512
+/* Slots in the async ring; a power of two. */
+#define AXIDEV_IO_LOG_RING_CAPACITY 1024u
+/* Records the async worker writes per stderr flush. */
+#define AXIDEV_IO_LOG_BATCH_MAX 64u
+/* How long process exit waits for the async worker to drain the ring. */
+#define AXIDEV_IO_LOG_EXIT_DRAIN_MS 200u
+
+typedef struct axidev_io_log_record {
+  axidev_io_log_level_t level;
+  int line;
+  /* Taken when the message is logged, not when it is written. */
+  time_t timestamp;
+  const char *file;
+  char message[AXIDEV_IO_LOG_MESSAGE_MAX];
+} axidev_io_log_record;
+
+/* Bounded multi-producer ring with per-slot sequence numbers: a slot whose
+   sequence equals the claim position is free, one past it is published. */
+typedef struct axidev_io_log_cell {
+  atomic_size_t sequence;
+  axidev_io_log_record record;
+} axidev_io_log_cell;
+
+typedef struct axidev_io_log_ring {
+  axidev_io_log_cell *cells;
+  atomic_size_t enqueue_pos;
+  size_t dequeue_pos;
+  /* Records delivered so far; axidev_io_log_flush() waits on it. */
+  atomic_size_t written;
+  atomic_bool stop;
+  atomic_bool idle;
+  axidev_io_thread worker;
+} axidev_io_log_ring;
+
 static axidev_io_once g_log_once = AXIDEV_IO_ONCE_INIT;
+/* Serializes output and guards the sink and the async on/off switch. */
 static axidev_io_mutex g_log_output_lock;
+static axidev_io_mutex g_log_wake_lock;
+static axidev_io_cond g_log_wake;
+static axidev_io_log_sink_fn g_log_sink = NULL;
+static void *g_log_sink_user_data = NULL;
+static _Atomic(axidev_io_log_ring *) g_log_ring = NULL;
+/* Producers inside the ring; disabling waits for it to reach zero before
+   the ring is freed. */
+static atomic_uint g_log_ring_users;
+static _Atomic uint64_t g_log_dropped;
+/* Set while this thread runs the user sink, whose own logging is dropped
+   rather than re-entering the output lock. */
+static AXIDEV_IO_THREAD_LOCAL bool g_log_in_sink;
+
+static void axidev_io_log_drain_at_exit(void);
 
 static void axidev_io_log_init_once(void) {
   axidev_io_mutex_init(&g_log_output_lock);
+  axidev_io_mutex_init(&g_log_wake_lock);
+  axidev_io_cond_init(&g_log_wake);
+  atexit(axidev_io_log_drain_at_exit);
 }
 
 static const char *axidev_io_log_level_string(axidev_io_log_level_t level) {
@@ -96,43 +152,406 @@ AXIDEV_IO_API bool axidev_io_log_is_enabled(axidev_io_log_level_t level) {
   return (int)level >= (int)axidev_io_log_get_level();
 }
 
+static void axidev_io_log_format_time(time_t when, char *buffer,
+                                      size_t size) {
+  struct tm local_time;
+
+#ifdef _WIN32
+  localtime_s(&local_time, &when);
+#else
+  localtime_r(&when, &local_time);
+#endif
+  strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &local_time);
+}
+
+/* Appends the stderr line for `record` to `out` and returns its length, or 0
+   when it does not fit in `size`. */
+static size_t axidev_io_log_format_line(char *out, size_t size,
+                                        const char *time_text, bool colors,
+                                        const axidev_io_log_record *record) {
+  int length = snprintf(
+      out, size, "[axidev-io] %s [%s%s%s] %s:%d: %s\n", time_text,
+      colors ? axidev_io_log_level_color(record->level) : "",
+      axidev_io_log_level_string(record->level), colors ? "\x1b[0m" : "",
+      axidev_io_trim_path(record->file), record->line, record->message);
+
+  if (length < 0 || (size_t)length >= size) {
+    return 0;
+  }
+  return (size_t)length;
+}
+
+/* Hands queued `records` to the sink, or writes them to stderr with one
+   flush. Called with the output lock held. */
+static void axidev_io_log_deliver(const axidev_io_log_record *const *records,
+                                  size_t count) {
+  char batch[8192];
+  char time_text[64];
+  time_t time_formatted = 0;
+  size_t used = 0;
+  bool colors;
+  size_t i;
+
+  if (g_log_sink != NULL) {
+    g_log_in_sink = true;
+    for (i = 0; i < count; ++i) {
+      g_log_sink(records[i]->level, axidev_io_trim_path(records[i]->file),
+                 records[i]->line, records[i]->message, g_log_sink_user_data);
+    }
+    g_log_in_sink = false;
+    return;
+  }
+
+  colors = axidev_io_log_colors_enabled();
+  for (i = 0; i < count; ++i) {
+    size_t length;
+
+    /* Records logged in the same second share one formatted timestamp. */
+    if (i == 0 || records[i]->timestamp != time_formatted) {
+      time_formatted = records[i]->timestamp;
+      axidev_io_log_format_time(time_formatted, time_text, sizeof(time_text));
+    }
+    length = axidev_io_log_format_line(
+        batch + used, sizeof(batch) - used, time_text, colors, records[i]);
+    if (length == 0 && used > 0) {
+      fwrite(batch, 1, used, stderr);
+      used = 0;
+      length = axidev_io_log_format_line(batch, sizeof(batch), time_text,
+                                         colors, records[i]);
+    }
+    used += length;
+  }
+  fwrite(batch, 1, used, stderr);
+  fflush(stderr);
+}
+
+static bool axidev_io_log_ring_has_next(axidev_io_log_ring *ring) {
+  const size_t mask = AXIDEV_IO_LOG_RING_CAPACITY - 1u;
+  axidev_io_log_cell *cell = &ring->cells[ring->dequeue_pos & mask];
+
+  return atomic_load(&cell->sequence) == ring->dequeue_pos + 1u;
+}
+
+/* Wakes the worker if it is parked. Taking the wake lock orders the signal
+   after the worker's last check of the ring, so no wakeup is lost. */
+static void axidev_io_log_wake_worker(axidev_io_log_ring *ring) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load(&ring->idle)) {
+    axidev_io_mutex_lock(&g_log_wake_lock);
+    axidev_io_cond_signal(&g_log_wake);
+    axidev_io_mutex_unlock(&g_log_wake_lock);
+  }
+}
+
+static int axidev_io_log_worker_main(void *user_data) {
+  axidev_io_log_ring *ring = (axidev_io_log_ring *)user_data;
+  const size_t mask = AXIDEV_IO_LOG_RING_CAPACITY - 1u;
+
+  for (;;) {
+    const axidev_io_log_record *records[AXIDEV_IO_LOG_BATCH_MAX];
+    size_t pos = ring->dequeue_pos;
+    size_t count = 0;
+    size_t i;
+
+    while (count < AXIDEV_IO_LOG_BATCH_MAX) {
+      axidev_io_log_cell *cell = &ring->cells[(pos + count) & mask];
+      if (atomic_load_explicit(&cell->sequence, memory_order_acquire) !=
+          pos + count + 1u) {
+        break;
+      }
+      records[count++] = &cell->record;
+    }
+
+    if (count == 0) {
+      if (atomic_load(&ring->stop)) {
+        break;
+      }
+      /* Publishing records and then reading `idle` pairs with setting
+         `idle` and then re-checking the ring: one side always sees the
+         other, and the signal is sent under the wake lock. */
+      axidev_io_mutex_lock(&g_log_wake_lock);
+      atomic_store(&ring->idle, true);
+      atomic_thread_fence(memory_order_seq_cst);
+      if (!axidev_io_log_ring_has_next(ring) && !atomic_load(&ring->stop)) {
+        axidev_io_cond_wait(&g_log_wake, &g_log_wake_lock);
+      }
+      atomic_store(&ring->idle, false);
+      axidev_io_mutex_unlock(&g_log_wake_lock);
+      continue;
+    }
+
+    axidev_io_mutex_lock(&g_log_output_lock);
+    axidev_io_log_deliver(records, count);
+    axidev_io_mutex_unlock(&g_log_output_lock);
+
+    for (i = 0; i < count; ++i) {
+      atomic_store_explicit(&ring->cells[(pos + i) & mask].sequence,
+                            pos + i + AXIDEV_IO_LOG_RING_CAPACITY,
+                            memory_order_release);
+    }
+    ring->dequeue_pos = pos + count;
+    atomic_store(&ring->written, pos + count);
+  }
+  return 0;
+}
+
+/* Claims a slot, formats into it and publishes it. Returns false only when
+   async logging is off; a full ring drops the message and counts it. */
+static bool axidev_io_log_enqueue(axidev_io_log_level_t level,
+                                  const char *file, int line, const char *fmt,
+                                  va_list args) {
+  const size_t mask = AXIDEV_IO_LOG_RING_CAPACITY - 1u;
+  axidev_io_log_ring *ring;
+  axidev_io_log_cell *cell = NULL;
+  size_t pos;
+
+  atomic_fetch_add(&g_log_ring_users, 1u);
+  ring = atomic_load(&g_log_ring);
+  if (ring == NULL) {
+    atomic_fetch_sub(&g_log_ring_users, 1u);
+    return false;
+  }
+
+  pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+  for (;;) {
+    size_t sequence;
+    intptr_t diff;
+
+    cell = &ring->cells[pos & mask];
+    sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos,
+                                                pos + 1u, memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      atomic_fetch_add(&g_log_dropped, 1u);
+      atomic_fetch_sub(&g_log_ring_users, 1u);
+      return true;
+    } else {
+      pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  cell->record.level = level;
+  cell->record.file = file;
+  cell->record.line = line;
+  cell->record.timestamp = time(NULL);
+  vsnprintf(cell->record.message, sizeof(cell->record.message), fmt, args);
+  atomic_store_explicit(&cell->sequence, pos + 1u, memory_order_release);
+  axidev_io_log_wake_worker(ring);
+  atomic_fetch_sub(&g_log_ring_users, 1u);
+  return true;
+}
+
+/* Writes one message on the calling thread without a length limit: it is
+   formatted straight to stderr, or into a buffer sized for the sink. */
+static void axidev_io_log_write_sync(axidev_io_log_level_t level,
+                                     const char *file, int line,
+                                     const char *fmt, va_list args) {
+  char time_text[64];
+  char stack_message[AXIDEV_IO_LOG_MESSAGE_MAX];
+  char *message = stack_message;
+  va_list copy;
+  bool colors;
+  int length;
+
+  axidev_io_mutex_lock(&g_log_output_lock);
+  if (g_log_sink != NULL) {
+    va_copy(copy, args);
+    length = vsnprintf(stack_message, sizeof(stack_message), fmt, copy);
+    va_end(copy);
+    if (length >= (int)sizeof(stack_message)) {
+      message = (char *)malloc((size_t)length + 1u);
+      if (message != NULL) {
+        vsnprintf(message, (size_t)length + 1u, fmt, args);
+      } else {
+        message = stack_message;
+      }
+    }
+    g_log_in_sink = true;
+    g_log_sink(level, axidev_io_trim_path(file), line,
+               length < 0 ? "" : message, g_log_sink_user_data);
+    g_log_in_sink = false;
+    if (message != stack_message) {
+      free(message);
+    }
+    axidev_io_mutex_unlock(&g_log_output_lock);
+    return;
+  }
+
+  colors = axidev_io_log_colors_enabled();
+  axidev_io_log_format_time(time(NULL), time_text, sizeof(time_text));
+  fprintf(stderr, "[axidev-io] %s [%s%s%s] %s:%d: ", time_text,
+          colors ? axidev_io_log_level_color(level) : "",
+          axidev_io_log_level_string(level), colors ? "\x1b[0m" : "",
+          axidev_io_trim_path(file), line);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  fflush(stderr);
+  axidev_io_mutex_unlock(&g_log_output_lock);
+}
+
 AXIDEV_IO_API void axidev_io_log_message(axidev_io_log_level_t level,
                                          const char *file, int line,
                                          const char *fmt, ...) {
   va_list args;
-  char time_buffer[64];
-  time_t now;
-  struct tm local_time;
-  const bool colors = axidev_io_log_colors_enabled();
+  bool queued;
 
   if (!axidev_io_log_is_enabled(level) || fmt == NULL) {
     return;
   }
+  if (g_log_in_sink) {
+    atomic_fetch_add(&g_log_dropped, 1u);
+    return;
+  }
 
   axidev_io_call_once(&g_log_once, axidev_io_log_init_once);
-  now = time(NULL);
-#ifdef _WIN32
-  localtime_s(&local_time, &now);
-#else
-  localtime_r(&now, &local_time);
-#endif
-  strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &local_time);
-
-  axidev_io_mutex_lock(&g_log_output_lock);
-  fprintf(stderr, "[axidev-io] %s [", time_buffer);
-  if (colors) {
-    fputs(axidev_io_log_level_color(level), stderr);
-  }
-  fputs(axidev_io_log_level_string(level), stderr);
-  if (colors) {
-    fputs("\x1b[0m", stderr);
+  va_start(args, fmt);
+  queued = axidev_io_log_enqueue(level, file, line, fmt, args);
+  va_end(args);
+  if (queued) {
+    return;
   }
-  fprintf(stderr, "] %s:%d: ", axidev_io_trim_path(file), line);
 
   va_start(args, fmt);
-  vfprintf(stderr, fmt, args);
+  axidev_io_log_write_sync(level, file, line, fmt, args);
   va_end(args);
-  fputc('\n', stderr);
-  fflush(stderr);
+}
+
+AXIDEV_IO_API void axidev_io_log_set_sink(axidev_io_log_sink_fn sink,
+                                          void *user_data) {
+  axidev_io_call_once(&g_log_once, axidev_io_log_init_once);
+  if (g_log_in_sink) {
+    return;
+  }
+  axidev_io_mutex_lock(&g_log_output_lock);
+  g_log_sink = sink;
+  g_log_sink_user_data = user_data;
   axidev_io_mutex_unlock(&g_log_output_lock);
 }
+
+static axidev_io_log_ring *axidev_io_log_ring_create(void) {
+  axidev_io_log_ring *ring =
+      (axidev_io_log_ring *)calloc(1, sizeof(axidev_io_log_ring));
+  size_t i;
+
+  if (ring == NULL) {
+    return NULL;
+  }
+  ring->cells = (axidev_io_log_cell *)malloc(AXIDEV_IO_LOG_RING_CAPACITY *
+                                             sizeof(axidev_io_log_cell));
+  if (ring->cells == NULL) {
+    free(ring);
+    return NULL;
+  }
+  for (i = 0; i < AXIDEV_IO_LOG_RING_CAPACITY; ++i) {
+    atomic_init(&ring->cells[i].sequence, i);
+  }
+  atomic_init(&ring->enqueue_pos, 0);
+  atomic_init(&ring->written, 0);
+  atomic_init(&ring->stop, false);
+  atomic_init(&ring->idle, false);
+  if (!axidev_io_thread_create(&ring->worker, axidev_io_log_worker_main,
+                               ring)) {
+    free(ring->cells);
+    free(ring);
+    return NULL;
+  }
+  return ring;
+}
+
+/* The worker exits only once the ring is empty, so nothing is lost. It
+   needs the output lock to drain, so callers must not hold it. */
+static void axidev_io_log_ring_destroy(axidev_io_log_ring *ring) {
+  atomic_store(&ring->stop, true);
+  axidev_io_log_wake_worker(ring);
+  axidev_io_thread_join(&ring->worker);
+  free(ring->cells);
+  free(ring);
+}
+
+AXIDEV_IO_API bool axidev_io_log_set_async(bool enabled) {
+  axidev_io_log_ring *expected = NULL;
+  axidev_io_log_ring *ring;
+
+  axidev_io_call_once(&g_log_once, axidev_io_log_init_once);
+  if (g_log_in_sink) {
+    return false;
+  }
+  if (enabled) {
+    if (atomic_load(&g_log_ring) != NULL) {
+      return true;
+    }
+    ring = axidev_io_log_ring_create();
+    if (ring == NULL) {
+      return false;
+    }
+    /* A concurrent enable may have won; this ring is then discarded. */
+    if (!atomic_compare_exchange_strong(&g_log_ring, &expected, ring)) {
+      axidev_io_log_ring_destroy(ring);
+    }
+    return true;
+  }
+
+  ring = atomic_exchange(&g_log_ring, NULL);
+  if (ring == NULL) {
+    return true;
+  }
+  while (atomic_load(&g_log_ring_users) != 0) {
+    axidev_io_sleep_ms(0);
+  }
+  axidev_io_log_ring_destroy(ring);
+  return true;
+}
+
+AXIDEV_IO_API void axidev_io_log_flush(void) {
+  axidev_io_log_ring *ring;
+  size_t target;
+
+  axidev_io_call_once(&g_log_once, axidev_io_log_init_once);
+  /* The worker delivering to this sink cannot also drain for it. */
+  if (g_log_in_sink) {
+    return;
+  }
+  atomic_fetch_add(&g_log_ring_users, 1u);
+  ring = atomic_load(&g_log_ring);
+  if (ring != NULL) {
+    target = atomic_load(&ring->enqueue_pos);
+    while (atomic_load(&ring->written) < target) {
+      axidev_io_sleep_ms(1);
+    }
+  }
+  atomic_fetch_sub(&g_log_ring_users, 1u);
+}
+
+/* Gives queued messages a bounded chance to reach the sink before the
+   process goes away. The worker is not joined: on some exit paths it has
+   already been terminated. */
+static void axidev_io_log_drain_at_exit(void) {
+  axidev_io_log_ring *ring;
+  uint64_t deadline_ms;
+  size_t target;
+
+  if (g_log_in_sink) {
+    return;
+  }
+  atomic_fetch_add(&g_log_ring_users, 1u);
+  ring = atomic_load(&g_log_ring);
+  if (ring != NULL) {
+    target = atomic_load(&ring->enqueue_pos);
+    deadline_ms =
+        axidev_io_monotonic_time_ms() + AXIDEV_IO_LOG_EXIT_DRAIN_MS;
+    while (atomic_load(&ring->written) < target &&
+           axidev_io_monotonic_time_ms() < deadline_ms) {
+      axidev_io_sleep_ms(1);
+    }
+  }
+  atomic_fetch_sub(&g_log_ring_users, 1u);
+}
+
+AXIDEV_IO_API uint64_t axidev_io_log_dropped_count(void) {
+  return atomic_load(&g_log_dropped);
+}
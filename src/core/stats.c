@@ -0,0 +1,94 @@
+#include "../internal/stats.h"
+
+#include <stdatomic.h>
+
+typedef struct axidev_io_stat_slot {
+  _Atomic uint64_t value;
+  char pad[64 - sizeof(uint64_t)];
+} axidev_io_stat_slot;
+
+typedef struct axidev_io_stat_histogram_slots {
+  _Atomic uint64_t max;
+  _Atomic uint64_t buckets[AXIDEV_IO_STATS_HISTOGRAM_BUCKETS];
+} axidev_io_stat_histogram_slots;
+
+static axidev_io_stat_slot g_counters[AXIDEV_IO_STAT_COUNTER_COUNT];
+static axidev_io_stat_histogram_slots
+    g_histograms[AXIDEV_IO_STAT_HISTOGRAM_COUNT];
+
+void axidev_io_stats_add(axidev_io_stat_counter counter, uint64_t amount) {
+  atomic_fetch_add_explicit(&g_counters[counter].value, amount,
+                            memory_order_relaxed);
+}
+
+void axidev_io_stats_record(axidev_io_stat_histogram histogram,
+                            uint64_t value) {
+  axidev_io_stat_histogram_slots *slots = &g_histograms[histogram];
+  uint64_t max = atomic_load_explicit(&slots->max, memory_order_relaxed);
+
+  atomic_fetch_add_explicit(
+      &slots->buckets[axidev_io_stats_bucket(
+          value, AXIDEV_IO_STATS_HISTOGRAM_BUCKETS)],
+      1u, memory_order_relaxed);
+  while (value > max &&
+         !atomic_compare_exchange_weak_explicit(&slots->max, &max, value,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+  }
+}
+
+static uint64_t axidev_io_stats_counter(axidev_io_stat_counter counter) {
+  return atomic_load_explicit(&g_counters[counter].value,
+                              memory_order_relaxed);
+}
+
+static void axidev_io_stats_copy_histogram(axidev_io_stat_histogram histogram,
+                                           axidev_io_stats_histogram_t *out) {
+  axidev_io_stat_histogram_slots *slots = &g_histograms[histogram];
+
+  out->samples = 0;
+  for (size_t i = 0; i < AXIDEV_IO_STATS_HISTOGRAM_BUCKETS; ++i) {
+    out->buckets[i] =
+        atomic_load_explicit(&slots->buckets[i], memory_order_relaxed);
+    out->samples += out->buckets[i];
+  }
+  out->max = atomic_load_explicit(&slots->max, memory_order_relaxed);
+}
+
+/* Counters are read one at a time, so a snapshot taken while events flow
+   may be a few events apart between fields. */
+void axidev_io_stats_snapshot(axidev_io_stats_t *out_stats) {
+  out_stats->sender_events_sent =
+      axidev_io_stats_counter(AXIDEV_IO_STAT_SENDER_EVENTS_SENT);
+  out_stats->sender_writes =
+      axidev_io_stats_counter(AXIDEV_IO_STAT_SENDER_WRITES);
+  out_stats->sender_write_failures =
+      axidev_io_stats_counter(AXIDEV_IO_STAT_SENDER_WRITE_FAILURES);
+  out_stats->listener_events_received =
+      axidev_io_stats_counter(AXIDEV_IO_STAT_LISTENER_EVENTS_RECEIVED);
+  out_stats->listener_events_delivered =
+      axidev_io_stats_counter(AXIDEV_IO_STAT_LISTENER_EVENTS_DELIVERED);
+  out_stats->listener_events_deduplicated =
+      axidev_io_stats_counter(AXIDEV_IO_STAT_LISTENER_EVENTS_DEDUPLICATED);
+  out_stats->listener_events_dropped =
+      axidev_io_stats_counter(AXIDEV_IO_STAT_LISTENER_EVENTS_DROPPED);
+  axidev_io_stats_copy_histogram(AXIDEV_IO_STAT_TAP_DURATION_US,
+                                 &out_stats->tap_duration_us);
+  axidev_io_stats_copy_histogram(AXIDEV_IO_STAT_CALLBACK_DURATION_NS,
+                                 &out_stats->callback_duration_ns);
+  axidev_io_stats_copy_histogram(AXIDEV_IO_STAT_LISTENER_QUEUE_DEPTH,
+                                 &out_stats->listener_queue_depth);
+}
+
+void axidev_io_stats_reset(void) {
+  for (size_t i = 0; i < AXIDEV_IO_STAT_COUNTER_COUNT; ++i) {
+    atomic_store_explicit(&g_counters[i].value, 0, memory_order_relaxed);
+  }
+  for (size_t i = 0; i < AXIDEV_IO_STAT_HISTOGRAM_COUNT; ++i) {
+    atomic_store_explicit(&g_histograms[i].max, 0, memory_order_relaxed);
+    for (size_t j = 0; j < AXIDEV_IO_STATS_HISTOGRAM_BUCKETS; ++j) {
+      atomic_store_explicit(&g_histograms[i].buckets[j], 0,
+                            memory_order_relaxed);
+    }
+  }
+}
@@ -14,7 +14,6 @@
 
 typedef struct axidev_io_private_runtime {
   axidev_io_mutex state_lock;
-  axidev_io_mutex error_lock;
 } axidev_io_private_runtime;
 
 void axidev_io_context_ensure_runtime(void);
@@ -28,6 +27,20 @@ void axidev_io_set_last_errorf(const char *fmt, ...);
 void axidev_io_set_last_errorfv(const char *fmt, va_list args);
 void axidev_io_set_last_error_result(const char *function_name,
                                      axidev_io_result result);
+/* The last error lives in a fixed per-thread buffer of this size. */
+#define AXIDEV_IO_LAST_ERROR_MAX 512
+typedef struct axidev_io_error_record {
+  axidev_io_result code;
+  char message[AXIDEV_IO_LAST_ERROR_MAX];
+} axidev_io_error_record;
+void axidev_io_set_last_error_code(axidev_io_result result);
+/* Copy this thread's last error out and back in, so a worker thread can hand
+   its error to the thread waiting on it. */
+void axidev_io_last_error_save(axidev_io_error_record *out);
+void axidev_io_last_error_restore(const axidev_io_error_record *record);
+axidev_io_result axidev_io_get_last_error_code_internal(void);
+/* Never NULL; empty when no message is set. */
+const char *axidev_io_get_last_error_message_internal(void);
 void axidev_io_clear_last_error_internal(void);
 char *axidev_io_duplicate_string(const char *text);
 
@@ -36,9 +49,6 @@ void axidev_io_keyboard_reset_public_listener_state(void);
 void axidev_io_keyboard_reset_public_keymap_state(void);
 void axidev_io_keyboard_reset_public_state(void);
 
-static inline void *axidev_io_sender_storage_ptr(void) {
-  return (void *)axidev_io_global->keyboard.sender.storage.bytes;
-}
 
 static inline void *axidev_io_listener_storage_ptr(void) {
   return (void *)axidev_io_global->keyboard.listener.storage.bytes;
@@ -48,9 +58,23 @@ static inline void *axidev_io_keymap_storage_ptr(void) {
   return (void *)axidev_io_global->keyboard.keymap.storage.bytes;
 }
 
+/* Sender state that sender calls on this thread act on: a handle's context
+   while an axidev_io_sender_* call runs, NULL for the global sender. */
+extern AXIDEV_IO_THREAD_LOCAL axidev_io_keyboard_sender_context
+    *axidev_io_sender_binding;
+
 static inline axidev_io_keyboard_sender_context *
 axidev_io_sender_public_context(void) {
-  return &axidev_io_global->keyboard.sender;
+  return axidev_io_sender_binding != NULL ? axidev_io_sender_binding
+                                          : &axidev_io_global->keyboard.sender;
+}
+
+static inline bool axidev_io_sender_is_default(void) {
+  return axidev_io_sender_binding == NULL;
+}
+
+static inline void *axidev_io_sender_storage_ptr(void) {
+  return (void *)axidev_io_sender_public_context()->storage.bytes;
 }
 
 static inline axidev_io_keyboard_listener_context *
@@ -12,7 +12,9 @@ typedef enum axidev_io_result {
   AXIDEV_IO_RESULT_NOT_FOUND,
   AXIDEV_IO_RESULT_BUFFER_TOO_SMALL,
   AXIDEV_IO_RESULT_PLATFORM_ERROR,
-  AXIDEV_IO_RESULT_INTERNAL_ERROR
+  AXIDEV_IO_RESULT_INTERNAL_ERROR,
+  AXIDEV_IO_RESULT_QUEUE_FULL,
+  AXIDEV_IO_RESULT_CANCELLED
 } axidev_io_result;
 
 static inline const char *axidev_io_result_to_string(axidev_io_result result) {
@@ -35,6 +37,10 @@ static inline const char *axidev_io_result_to_string(axidev_io_result result) {
     return "buffer_too_small";
   case AXIDEV_IO_RESULT_PLATFORM_ERROR:
     return "platform_error";
+  case AXIDEV_IO_RESULT_QUEUE_FULL:
+    return "queue_full";
+  case AXIDEV_IO_RESULT_CANCELLED:
+    return "cancelled";
   case AXIDEV_IO_RESULT_INTERNAL_ERROR:
   default:
     return "internal_error";
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef AXIDEV_IO_INTERNAL_STATS_H
+#define AXIDEV_IO_INTERNAL_STATS_H
+
+#include <axidev-io/c_api.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Counters behind axidev_io_get_stats(). Each sits on its own cache line
+   and is bumped with a relaxed atomic add. */
+typedef enum axidev_io_stat_counter {
+  AXIDEV_IO_STAT_SENDER_EVENTS_SENT,
+  AXIDEV_IO_STAT_SENDER_WRITES,
+  AXIDEV_IO_STAT_SENDER_WRITE_FAILURES,
+  AXIDEV_IO_STAT_LISTENER_EVENTS_RECEIVED,
+  AXIDEV_IO_STAT_LISTENER_EVENTS_DELIVERED,
+  AXIDEV_IO_STAT_LISTENER_EVENTS_DEDUPLICATED,
+  AXIDEV_IO_STAT_LISTENER_EVENTS_DROPPED,
+  AXIDEV_IO_STAT_COUNTER_COUNT
+} axidev_io_stat_counter;
+
+typedef enum axidev_io_stat_histogram {
+  AXIDEV_IO_STAT_TAP_DURATION_US,
+  AXIDEV_IO_STAT_CALLBACK_DURATION_NS,
+  AXIDEV_IO_STAT_LISTENER_QUEUE_DEPTH,
+  AXIDEV_IO_STAT_HISTOGRAM_COUNT
+} axidev_io_stat_histogram;
+
+void axidev_io_stats_add(axidev_io_stat_counter counter, uint64_t amount);
+void axidev_io_stats_record(axidev_io_stat_histogram histogram,
+                            uint64_t value);
+void axidev_io_stats_snapshot(axidev_io_stats_t *out_stats);
+void axidev_io_stats_reset(void);
+
+/* Log2 bucket of `value`: 0 for 0, i for [2^(i-1), 2^i), and the last of
+   `bucket_count` for everything larger. */
+static inline size_t axidev_io_stats_bucket(uint64_t value,
+                                            size_t bucket_count) {
+  size_t bucket = 0;
+
+  while (value != 0 && bucket + 1 < bucket_count) {
+    value >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+#endif
@@ -2,6 +2,7 @@
 #ifndef AXIDEV_IO_INTERNAL_THREAD_H
 #define AXIDEV_IO_INTERNAL_THREAD_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -32,19 +33,48 @@ typedef struct axidev_io_mutex {
   bool initialized;
 } axidev_io_mutex;
 
+typedef struct axidev_io_cond {
+#ifdef _WIN32
+  CONDITION_VARIABLE native;
+#else
+  pthread_cond_t native;
+#endif
+  bool initialized;
+} axidev_io_cond;
+
+/* `done` is set with release order once `fn` has returned, so callers after
+   initialization take one acquire load and no lock. */
 typedef struct axidev_io_once {
+  atomic_bool done;
 #ifdef _WIN32
   INIT_ONCE native;
 #else
   pthread_mutex_t mutex;
-  bool called;
 #endif
 } axidev_io_once;
 
+/* Paces a run of events against absolute monotonic deadlines: each wait ends
+   `interval_us` after the previous deadline rather than after the previous
+   wakeup, so oversleeping does not accumulate. `spin_us` busy-waits the last
+   stretch before each deadline for sub-millisecond accuracy. */
+typedef struct axidev_io_pacer {
+  uint64_t deadline_ns;
+  uint32_t spin_us;
+#ifdef _WIN32
+  HANDLE timer;
+#endif
+} axidev_io_pacer;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AXIDEV_IO_THREAD_LOCAL __declspec(thread)
+#else
+#define AXIDEV_IO_THREAD_LOCAL _Thread_local
+#endif
+
 #ifdef _WIN32
-#define AXIDEV_IO_ONCE_INIT {INIT_ONCE_STATIC_INIT}
+#define AXIDEV_IO_ONCE_INIT {false, INIT_ONCE_STATIC_INIT}
 #else
-#define AXIDEV_IO_ONCE_INIT {PTHREAD_MUTEX_INITIALIZER, false}
+#define AXIDEV_IO_ONCE_INIT {false, PTHREAD_MUTEX_INITIALIZER}
 #endif
 
 bool axidev_io_mutex_init(axidev_io_mutex *mutex);
@@ -52,13 +82,60 @@ void axidev_io_mutex_destroy(axidev_io_mutex *mutex);
 void axidev_io_mutex_lock(axidev_io_mutex *mutex);
 void axidev_io_mutex_unlock(axidev_io_mutex *mutex);
 
+bool axidev_io_cond_init(axidev_io_cond *cond);
+void axidev_io_cond_destroy(axidev_io_cond *cond);
+void axidev_io_cond_wait(axidev_io_cond *cond, axidev_io_mutex *mutex);
+/* Returns false when `milliseconds` elapse without a wakeup. Spurious
+   wakeups are possible, so callers re-check their predicate either way. */
+bool axidev_io_cond_timed_wait_ms(axidev_io_cond *cond, axidev_io_mutex *mutex,
+                                  uint32_t milliseconds);
+void axidev_io_cond_signal(axidev_io_cond *cond);
+void axidev_io_cond_broadcast(axidev_io_cond *cond);
+
 bool axidev_io_thread_create(axidev_io_thread *thread, axidev_io_thread_fn fn,
                              void *user_data);
 void axidev_io_thread_join(axidev_io_thread *thread);
 
-void axidev_io_call_once(axidev_io_once *once, void (*fn)(void));
+/* Runs `fn` once; other callers block until it has returned. */
+void axidev_io_call_once_slow(axidev_io_once *once, void (*fn)(void));
+static inline void axidev_io_call_once(axidev_io_once *once,
+                                       void (*fn)(void)) {
+  if (!atomic_load_explicit(&once->done, memory_order_acquire)) {
+    axidev_io_call_once_slow(once, fn);
+  }
+}
 void axidev_io_sleep_ms(uint32_t milliseconds);
 void axidev_io_sleep_us(uint32_t microseconds);
 uint64_t axidev_io_monotonic_time_ms(void);
+uint64_t axidev_io_monotonic_time_ns(void);
+
+#ifdef _WIN32
+/* Creates an auto-reset waitable timer, high-resolution where the system
+   supports it. Returns NULL on failure. */
+HANDLE axidev_io_create_waitable_timer(void);
+#endif
+
+void axidev_io_pacer_init(axidev_io_pacer *pacer);
+void axidev_io_pacer_destroy(axidev_io_pacer *pacer);
+void axidev_io_pacer_wait(axidev_io_pacer *pacer, uint32_t interval_us);
+/* Sleeps until the absolute monotonic `deadline_ns`, spinning for the last
+   `spin_us`; returns at once if it has passed. The pacer's own deadline is
+   left alone. */
+void axidev_io_pacer_wait_until(axidev_io_pacer *pacer, uint64_t deadline_ns);
+
+/* A pacer that fell more than one interval behind (the caller was idle, or
+   the interval is below timer resolution) restarts from `now_ns` instead of
+   bursting to catch up. */
+static inline uint64_t axidev_io_pacer_next_deadline(axidev_io_pacer *pacer,
+                                                     uint32_t interval_us,
+                                                     uint64_t now_ns) {
+  uint64_t interval_ns = (uint64_t)interval_us * 1000u;
+
+  if (pacer->deadline_ns == 0 || pacer->deadline_ns + interval_ns < now_ns) {
+    pacer->deadline_ns = now_ns;
+  }
+  pacer->deadline_ns += interval_ns;
+  return pacer->deadline_ns;
+}
 
 #endif
@@ -56,6 +56,70 @@ void axidev_io_mutex_unlock(axidev_io_mutex *mutex) {
   }
 }
 
+bool axidev_io_cond_init(axidev_io_cond *cond) {
+  pthread_condattr_t attr;
+  int status;
+
+  if (cond == NULL || cond->initialized) {
+    return cond != NULL;
+  }
+  if (pthread_condattr_init(&attr) != 0) {
+    return false;
+  }
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  status = pthread_cond_init(&cond->native, &attr);
+  pthread_condattr_destroy(&attr);
+  if (status != 0) {
+    return false;
+  }
+  cond->initialized = true;
+  return true;
+}
+
+void axidev_io_cond_destroy(axidev_io_cond *cond) {
+  if (cond == NULL || !cond->initialized) {
+    return;
+  }
+  pthread_cond_destroy(&cond->native);
+  cond->initialized = false;
+}
+
+void axidev_io_cond_wait(axidev_io_cond *cond, axidev_io_mutex *mutex) {
+  if (cond != NULL && cond->initialized && mutex != NULL &&
+      mutex->initialized) {
+    pthread_cond_wait(&cond->native, &mutex->native);
+  }
+}
+
+bool axidev_io_cond_timed_wait_ms(axidev_io_cond *cond, axidev_io_mutex *mutex,
+                                  uint32_t milliseconds) {
+  struct timespec deadline;
+  uint64_t nanoseconds;
+
+  if (cond == NULL || !cond->initialized || mutex == NULL ||
+      !mutex->initialized) {
+    return false;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  nanoseconds = (uint64_t)deadline.tv_nsec + (uint64_t)milliseconds * 1000000u;
+  deadline.tv_sec += (time_t)(nanoseconds / 1000000000u);
+  deadline.tv_nsec = (long)(nanoseconds % 1000000000u);
+  return pthread_cond_timedwait(&cond->native, &mutex->native, &deadline) !=
+         ETIMEDOUT;
+}
+
+void axidev_io_cond_signal(axidev_io_cond *cond) {
+  if (cond != NULL && cond->initialized) {
+    pthread_cond_signal(&cond->native);
+  }
+}
+
+void axidev_io_cond_broadcast(axidev_io_cond *cond) {
+  if (cond != NULL && cond->initialized) {
+    pthread_cond_broadcast(&cond->native);
+  }
+}
+
 bool axidev_io_thread_create(axidev_io_thread *thread, axidev_io_thread_fn fn,
                              void *user_data) {
   axidev_io_thread_start_data *start_data;
@@ -89,18 +153,16 @@ void axidev_io_thread_join(axidev_io_thread *thread) {
   thread->joinable = false;
 }
 
-void axidev_io_call_once(axidev_io_once *once, void (*fn)(void)) {
+void axidev_io_call_once_slow(axidev_io_once *once, void (*fn)(void)) {
   if (once == NULL || fn == NULL) {
     return;
   }
   pthread_mutex_lock(&once->mutex);
-  if (once->called) {
-    pthread_mutex_unlock(&once->mutex);
-    return;
+  if (!atomic_load_explicit(&once->done, memory_order_relaxed)) {
+    fn();
+    atomic_store_explicit(&once->done, true, memory_order_release);
   }
-  once->called = true;
   pthread_mutex_unlock(&once->mutex);
-  fn();
 }
 
 static void axidev_io_sleep_ns(uint64_t nanoseconds) {
@@ -128,4 +190,51 @@ uint64_t axidev_io_monotonic_time_ms(void) {
   return ((uint64_t)ts.tv_sec * 1000u) + ((uint64_t)ts.tv_nsec / 1000000u);
 }
 
+uint64_t axidev_io_monotonic_time_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+void axidev_io_pacer_init(axidev_io_pacer *pacer) {
+  if (pacer == NULL) {
+    return;
+  }
+  pacer->deadline_ns = 0;
+  pacer->spin_us = 0;
+}
+
+void axidev_io_pacer_destroy(axidev_io_pacer *pacer) {
+  if (pacer != NULL) {
+    pacer->deadline_ns = 0;
+  }
+}
+
+void axidev_io_pacer_wait_until(axidev_io_pacer *pacer, uint64_t deadline_ns) {
+  uint64_t spin_ns = (uint64_t)pacer->spin_us * 1000u;
+  struct timespec request;
+
+  if (deadline_ns > spin_ns) {
+    uint64_t sleep_until_ns = deadline_ns - spin_ns;
+
+    request.tv_sec = (time_t)(sleep_until_ns / 1000000000u);
+    request.tv_nsec = (long)(sleep_until_ns % 1000000000u);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &request, NULL) ==
+           EINTR) {
+    }
+  }
+  while (pacer->spin_us != 0 && axidev_io_monotonic_time_ns() < deadline_ns) {
+  }
+}
+
+void axidev_io_pacer_wait(axidev_io_pacer *pacer, uint32_t interval_us) {
+  if (pacer == NULL || interval_us == 0) {
+    return;
+  }
+
+  axidev_io_pacer_wait_until(
+      pacer, axidev_io_pacer_next_deadline(pacer, interval_us,
+                                           axidev_io_monotonic_time_ns()));
+}
+
 #endif
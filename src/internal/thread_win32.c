@@ -4,6 +4,10 @@
 
 #include <process.h>
 
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 typedef struct axidev_io_thread_start_data {
   axidev_io_thread_fn fn;
   void *user_data;
@@ -57,6 +61,50 @@ void axidev_io_mutex_unlock(axidev_io_mutex *mutex) {
   }
 }
 
+bool axidev_io_cond_init(axidev_io_cond *cond) {
+  if (cond == NULL || cond->initialized) {
+    return cond != NULL;
+  }
+  InitializeConditionVariable(&cond->native);
+  cond->initialized = true;
+  return true;
+}
+
+void axidev_io_cond_destroy(axidev_io_cond *cond) {
+  if (cond != NULL) {
+    cond->initialized = false;
+  }
+}
+
+void axidev_io_cond_wait(axidev_io_cond *cond, axidev_io_mutex *mutex) {
+  if (cond != NULL && cond->initialized && mutex != NULL &&
+      mutex->initialized) {
+    SleepConditionVariableCS(&cond->native, &mutex->native, INFINITE);
+  }
+}
+
+bool axidev_io_cond_timed_wait_ms(axidev_io_cond *cond, axidev_io_mutex *mutex,
+                                  uint32_t milliseconds) {
+  if (cond == NULL || !cond->initialized || mutex == NULL ||
+      !mutex->initialized) {
+    return false;
+  }
+  return SleepConditionVariableCS(&cond->native, &mutex->native,
+                                  (DWORD)milliseconds) != 0;
+}
+
+void axidev_io_cond_signal(axidev_io_cond *cond) {
+  if (cond != NULL && cond->initialized) {
+    WakeConditionVariable(&cond->native);
+  }
+}
+
+void axidev_io_cond_broadcast(axidev_io_cond *cond) {
+  if (cond != NULL && cond->initialized) {
+    WakeAllConditionVariable(&cond->native);
+  }
+}
+
 bool axidev_io_thread_create(axidev_io_thread *thread, axidev_io_thread_fn fn,
                              void *user_data) {
   axidev_io_thread_start_data *start_data;
@@ -97,11 +145,12 @@ void axidev_io_thread_join(axidev_io_thread *thread) {
   thread->joinable = false;
 }
 
-void axidev_io_call_once(axidev_io_once *once, void (*fn)(void)) {
+void axidev_io_call_once_slow(axidev_io_once *once, void (*fn)(void)) {
   if (once == NULL || fn == NULL) {
     return;
   }
   InitOnceExecuteOnce(&once->native, axidev_io_once_trampoline, fn, NULL);
+  atomic_store_explicit(&once->done, true, memory_order_release);
 }
 
 void axidev_io_sleep_ms(uint32_t milliseconds) { Sleep(milliseconds); }
@@ -116,4 +165,82 @@ void axidev_io_sleep_us(uint32_t microseconds) {
 
 uint64_t axidev_io_monotonic_time_ms(void) { return GetTickCount64(); }
 
+uint64_t axidev_io_monotonic_time_ns(void) {
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+
+  if (frequency.QuadPart == 0) {
+    QueryPerformanceFrequency(&frequency);
+  }
+  QueryPerformanceCounter(&counter);
+  return ((uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000ull) +
+         ((uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000ull /
+          (uint64_t)frequency.QuadPart);
+}
+
+HANDLE axidev_io_create_waitable_timer(void) {
+  HANDLE timer;
+
+  /* High-resolution timers need Windows 10 1803; older systems fall back to
+     a regular waitable timer with scheduler-tick granularity. */
+  timer = CreateWaitableTimerExW(
+      NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+  if (timer == NULL) {
+    timer = CreateWaitableTimerW(NULL, FALSE, NULL);
+  }
+  return timer;
+}
+
+void axidev_io_pacer_init(axidev_io_pacer *pacer) {
+  if (pacer == NULL) {
+    return;
+  }
+  pacer->deadline_ns = 0;
+  pacer->spin_us = 0;
+  pacer->timer = axidev_io_create_waitable_timer();
+}
+
+void axidev_io_pacer_destroy(axidev_io_pacer *pacer) {
+  if (pacer == NULL) {
+    return;
+  }
+  if (pacer->timer != NULL) {
+    CloseHandle(pacer->timer);
+    pacer->timer = NULL;
+  }
+  pacer->deadline_ns = 0;
+}
+
+void axidev_io_pacer_wait_until(axidev_io_pacer *pacer, uint64_t deadline_ns) {
+  uint64_t spin_ns = (uint64_t)pacer->spin_us * 1000u;
+  uint64_t now_ns = axidev_io_monotonic_time_ns();
+  uint64_t sleep_until_ns = deadline_ns > spin_ns ? deadline_ns - spin_ns : 0;
+
+  if (sleep_until_ns > now_ns) {
+    /* Waitable timers take their due time relative to the system clock, so
+       the absolute monotonic deadline is converted to a relative wait. */
+    LARGE_INTEGER due;
+    due.QuadPart = -(LONGLONG)((sleep_until_ns - now_ns + 99u) / 100u);
+    if (pacer->timer != NULL &&
+        SetWaitableTimer(pacer->timer, &due, 0, NULL, NULL, FALSE)) {
+      WaitForSingleObject(pacer->timer, INFINITE);
+    } else {
+      Sleep((DWORD)((sleep_until_ns - now_ns + 999999u) / 1000000u));
+    }
+  }
+  while (pacer->spin_us != 0 && axidev_io_monotonic_time_ns() < deadline_ns) {
+    YieldProcessor();
+  }
+}
+
+void axidev_io_pacer_wait(axidev_io_pacer *pacer, uint32_t interval_us) {
+  if (pacer == NULL || interval_us == 0) {
+    return;
+  }
+
+  axidev_io_pacer_wait_until(
+      pacer, axidev_io_pacer_next_deadline(pacer, interval_us,
+                                           axidev_io_monotonic_time_ns()));
+}
+
 #endif
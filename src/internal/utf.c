@@ -4,6 +4,15 @@
 
 #include <stb/stb_ds.h>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AXIDEV_IO_UTF8_SCAN_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define AXIDEV_IO_UTF8_SCAN_NEON 1
+#endif
+
 bool axidev_io_utf8_decode_one(const char **cursor, uint32_t *out_codepoint) {
   const unsigned char *ptr;
   uint32_t codepoint;
@@ -95,6 +104,51 @@ bool axidev_io_utf8_append(uint32_t codepoint, char **buffer) {
   return true;
 }
 
+static bool axidev_io_utf8_is_run_byte(unsigned char byte, char stop) {
+  return byte != 0u && byte < 0x80u && byte != (unsigned char)stop;
+}
+
+size_t axidev_io_utf8_ascii_run(const char *text, size_t limit, char stop) {
+  const unsigned char *ptr = (const unsigned char *)text;
+  size_t length = 0;
+
+  if (ptr == NULL) {
+    return 0;
+  }
+
+#if defined(AXIDEV_IO_UTF8_SCAN_SSE2) || defined(AXIDEV_IO_UTF8_SCAN_NEON)
+  {
+    /* The caller's length bounds the vector loop, so no load reaches past
+       the terminator and no call rescans the rest of the string. */
+    while (length + 16u <= limit) {
+#if defined(AXIDEV_IO_UTF8_SCAN_SSE2)
+      __m128i chunk = _mm_loadu_si128((const __m128i *)(ptr + length));
+      /* The sign bit of `chunk` flags bytes >= 0x80. */
+      __m128i special =
+          _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(stop)), chunk);
+      if (_mm_movemask_epi8(special) != 0) {
+        break;
+      }
+#else
+      uint8x16_t chunk = vld1q_u8(ptr + length);
+      uint8x16_t special =
+          vorrq_u8(vceqq_u8(chunk, vdupq_n_u8((uint8_t)stop)),
+                   vcgeq_u8(chunk, vdupq_n_u8(0x80u)));
+      if (vmaxvq_u8(special) != 0u) {
+        break;
+      }
+#endif
+      length += 16u;
+    }
+  }
+#endif
+
+  while (length < limit && axidev_io_utf8_is_run_byte(ptr[length], stop)) {
+    ++length;
+  }
+  return length;
+}
+
 bool axidev_io_utf8_is_ascii_alpha(uint32_t codepoint) {
   return (codepoint >= 'A' && codepoint <= 'Z') ||
          (codepoint >= 'a' && codepoint <= 'z');
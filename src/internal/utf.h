@@ -8,6 +8,10 @@
 
 bool axidev_io_utf8_decode_one(const char **cursor, uint32_t *out_codepoint);
 bool axidev_io_utf8_append(uint32_t codepoint, char **buffer);
+/* Length of the leading run of `text` made of ASCII bytes other than `stop`;
+   the run ends at the terminator, `stop` or the first non-ASCII byte.
+   `limit` is strlen(text); no byte at or past it is read. */
+size_t axidev_io_utf8_ascii_run(const char *text, size_t limit, char stop);
 bool axidev_io_utf8_is_ascii_alpha(uint32_t codepoint);
 uint32_t axidev_io_utf8_to_lower_ascii(uint32_t codepoint);
 
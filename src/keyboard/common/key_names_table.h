@@ -0,0 +1,739 @@
+/* Generated by scripts/gen_key_names.py; do not edit. */
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_KEY_NAMES_TABLE_H
+#define AXIDEV_IO_KEYBOARD_KEY_NAMES_TABLE_H
+
+#include <axidev-io/c_api.h>
+
+#include <stdint.h>
+
+typedef struct axidev_io_key_name_entry {
+  const char *name;
+  axidev_io_keyboard_key_t key;
+} axidev_io_key_name_entry;
+
+#define AXIDEV_IO_KEY_NAME_SLOTS 447u
+#define AXIDEV_IO_KEY_NAME_BUCKETS 112u
+#define AXIDEV_IO_KEY_NAME_MAX_LENGTH 18u
+
+static const char *const axidev_io_key_canonical_names[] = {
+    [AXIDEV_IO_KEY_UNKNOWN] = "Unknown",
+    [AXIDEV_IO_KEY_A] = "A",
+    [AXIDEV_IO_KEY_B] = "B",
+    [AXIDEV_IO_KEY_C] = "C",
+    [AXIDEV_IO_KEY_D] = "D",
+    [AXIDEV_IO_KEY_E] = "E",
+    [AXIDEV_IO_KEY_F] = "F",
+    [AXIDEV_IO_KEY_G] = "G",
+    [AXIDEV_IO_KEY_H] = "H",
+    [AXIDEV_IO_KEY_I] = "I",
+    [AXIDEV_IO_KEY_J] = "J",
+    [AXIDEV_IO_KEY_K] = "K",
+    [AXIDEV_IO_KEY_L] = "L",
+    [AXIDEV_IO_KEY_M] = "M",
+    [AXIDEV_IO_KEY_N] = "N",
+    [AXIDEV_IO_KEY_O] = "O",
+    [AXIDEV_IO_KEY_P] = "P",
+    [AXIDEV_IO_KEY_Q] = "Q",
+    [AXIDEV_IO_KEY_R] = "R",
+    [AXIDEV_IO_KEY_S] = "S",
+    [AXIDEV_IO_KEY_T] = "T",
+    [AXIDEV_IO_KEY_U] = "U",
+    [AXIDEV_IO_KEY_V] = "V",
+    [AXIDEV_IO_KEY_W] = "W",
+    [AXIDEV_IO_KEY_X] = "X",
+    [AXIDEV_IO_KEY_Y] = "Y",
+    [AXIDEV_IO_KEY_Z] = "Z",
+    [AXIDEV_IO_KEY_NUM0] = "0",
+    [AXIDEV_IO_KEY_NUM1] = "1",
+    [AXIDEV_IO_KEY_NUM2] = "2",
+    [AXIDEV_IO_KEY_NUM3] = "3",
+    [AXIDEV_IO_KEY_NUM4] = "4",
+    [AXIDEV_IO_KEY_NUM5] = "5",
+    [AXIDEV_IO_KEY_NUM6] = "6",
+    [AXIDEV_IO_KEY_NUM7] = "7",
+    [AXIDEV_IO_KEY_NUM8] = "8",
+    [AXIDEV_IO_KEY_NUM9] = "9",
+    [AXIDEV_IO_KEY_F1] = "F1",
+    [AXIDEV_IO_KEY_F2] = "F2",
+    [AXIDEV_IO_KEY_F3] = "F3",
+    [AXIDEV_IO_KEY_F4] = "F4",
+    [AXIDEV_IO_KEY_F5] = "F5",
+    [AXIDEV_IO_KEY_F6] = "F6",
+    [AXIDEV_IO_KEY_F7] = "F7",
+    [AXIDEV_IO_KEY_F8] = "F8",
+    [AXIDEV_IO_KEY_F9] = "F9",
+    [AXIDEV_IO_KEY_F10] = "F10",
+    [AXIDEV_IO_KEY_F11] = "F11",
+    [AXIDEV_IO_KEY_F12] = "F12",
+    [AXIDEV_IO_KEY_F13] = "F13",
+    [AXIDEV_IO_KEY_F14] = "F14",
+    [AXIDEV_IO_KEY_F15] = "F15",
+    [AXIDEV_IO_KEY_F16] = "F16",
+    [AXIDEV_IO_KEY_F17] = "F17",
+    [AXIDEV_IO_KEY_F18] = "F18",
+    [AXIDEV_IO_KEY_F19] = "F19",
+    [AXIDEV_IO_KEY_F20] = "F20",
+    [AXIDEV_IO_KEY_ENTER] = "Enter",
+    [AXIDEV_IO_KEY_ESCAPE] = "Escape",
+    [AXIDEV_IO_KEY_BACKSPACE] = "Backspace",
+    [AXIDEV_IO_KEY_TAB] = "Tab",
+    [AXIDEV_IO_KEY_SPACE] = "Space",
+    [AXIDEV_IO_KEY_LEFT] = "Left",
+    [AXIDEV_IO_KEY_RIGHT] = "Right",
+    [AXIDEV_IO_KEY_UP] = "Up",
+    [AXIDEV_IO_KEY_DOWN] = "Down",
+    [AXIDEV_IO_KEY_HOME] = "Home",
+    [AXIDEV_IO_KEY_END] = "End",
+    [AXIDEV_IO_KEY_PAGE_UP] = "PageUp",
+    [AXIDEV_IO_KEY_PAGE_DOWN] = "PageDown",
+    [AXIDEV_IO_KEY_DELETE] = "Delete",
+    [AXIDEV_IO_KEY_INSERT] = "Insert",
+    [AXIDEV_IO_KEY_PRINT_SCREEN] = "PrintScreen",
+    [AXIDEV_IO_KEY_SCROLL_LOCK] = "ScrollLock",
+    [AXIDEV_IO_KEY_PAUSE] = "Pause",
+    [AXIDEV_IO_KEY_NUMPAD_DIVIDE] = "NumpadDivide",
+    [AXIDEV_IO_KEY_NUMPAD_MULTIPLY] = "NumpadMultiply",
+    [AXIDEV_IO_KEY_NUMPAD_MINUS] = "NumpadMinus",
+    [AXIDEV_IO_KEY_NUMPAD_PLUS] = "NumpadPlus",
+    [AXIDEV_IO_KEY_NUMPAD_ENTER] = "NumpadEnter",
+    [AXIDEV_IO_KEY_NUMPAD_DECIMAL] = "NumpadDecimal",
+    [AXIDEV_IO_KEY_NUMPAD0] = "Numpad0",
+    [AXIDEV_IO_KEY_NUMPAD1] = "Numpad1",
+    [AXIDEV_IO_KEY_NUMPAD2] = "Numpad2",
+    [AXIDEV_IO_KEY_NUMPAD3] = "Numpad3",
+    [AXIDEV_IO_KEY_NUMPAD4] = "Numpad4",
+    [AXIDEV_IO_KEY_NUMPAD5] = "Numpad5",
+    [AXIDEV_IO_KEY_NUMPAD6] = "Numpad6",
+    [AXIDEV_IO_KEY_NUMPAD7] = "Numpad7",
+    [AXIDEV_IO_KEY_NUMPAD8] = "Numpad8",
+    [AXIDEV_IO_KEY_NUMPAD9] = "Numpad9",
+    [AXIDEV_IO_KEY_SHIFT_LEFT] = "ShiftLeft",
+    [AXIDEV_IO_KEY_SHIFT_RIGHT] = "ShiftRight",
+    [AXIDEV_IO_KEY_CTRL_LEFT] = "CtrlLeft",
+    [AXIDEV_IO_KEY_CTRL_RIGHT] = "CtrlRight",
+    [AXIDEV_IO_KEY_ALT_LEFT] = "AltLeft",
+    [AXIDEV_IO_KEY_ALT_RIGHT] = "AltRight",
+    [AXIDEV_IO_KEY_SUPER_LEFT] = "SuperLeft",
+    [AXIDEV_IO_KEY_SUPER_RIGHT] = "SuperRight",
+    [AXIDEV_IO_KEY_CAPS_LOCK] = "CapsLock",
+    [AXIDEV_IO_KEY_NUM_LOCK] = "NumLock",
+    [AXIDEV_IO_KEY_HELP] = "Help",
+    [AXIDEV_IO_KEY_MENU] = "Menu",
+    [AXIDEV_IO_KEY_POWER] = "Power",
+    [AXIDEV_IO_KEY_SLEEP] = "Sleep",
+    [AXIDEV_IO_KEY_WAKE] = "Wake",
+    [AXIDEV_IO_KEY_MUTE] = "Mute",
+    [AXIDEV_IO_KEY_VOLUME_DOWN] = "VolumeDown",
+    [AXIDEV_IO_KEY_VOLUME_UP] = "VolumeUp",
+    [AXIDEV_IO_KEY_MEDIA_PLAY_PAUSE] = "MediaPlayPause",
+    [AXIDEV_IO_KEY_MEDIA_STOP] = "MediaStop",
+    [AXIDEV_IO_KEY_MEDIA_NEXT] = "MediaNext",
+    [AXIDEV_IO_KEY_MEDIA_PREVIOUS] = "MediaPrevious",
+    [AXIDEV_IO_KEY_BRIGHTNESS_DOWN] = "BrightnessDown",
+    [AXIDEV_IO_KEY_BRIGHTNESS_UP] = "BrightnessUp",
+    [AXIDEV_IO_KEY_EJECT] = "Eject",
+    [AXIDEV_IO_KEY_GRAVE] = "`",
+    [AXIDEV_IO_KEY_MINUS] = "-",
+    [AXIDEV_IO_KEY_EQUAL] = "=",
+    [AXIDEV_IO_KEY_LEFT_BRACKET] = "[",
+    [AXIDEV_IO_KEY_RIGHT_BRACKET] = "]",
+    [AXIDEV_IO_KEY_BACKSLASH] = "\\",
+    [AXIDEV_IO_KEY_SEMICOLON] = ";",
+    [AXIDEV_IO_KEY_APOSTROPHE] = "'",
+    [AXIDEV_IO_KEY_COMMA] = ",",
+    [AXIDEV_IO_KEY_PERIOD] = ".",
+    [AXIDEV_IO_KEY_SLASH] = "/",
+    [AXIDEV_IO_KEY_AT] = "At",
+    [AXIDEV_IO_KEY_HASHTAG] = "Hashtag",
+    [AXIDEV_IO_KEY_EXCLAMATION] = "Exclamation",
+    [AXIDEV_IO_KEY_DOLLAR] = "Dollar",
+    [AXIDEV_IO_KEY_PERCENT] = "Percent",
+    [AXIDEV_IO_KEY_CARET] = "Caret",
+    [AXIDEV_IO_KEY_AMPERSAND] = "Ampersand",
+    [AXIDEV_IO_KEY_ASTERISK] = "Asterisk",
+    [AXIDEV_IO_KEY_LEFT_PAREN] = "LeftParen",
+    [AXIDEV_IO_KEY_RIGHT_PAREN] = "RightParen",
+    [AXIDEV_IO_KEY_UNDERSCORE] = "Underscore",
+    [AXIDEV_IO_KEY_PLUS] = "Plus",
+    [AXIDEV_IO_KEY_COLON] = "Colon",
+    [AXIDEV_IO_KEY_QUOTE] = "Quote",
+    [AXIDEV_IO_KEY_QUESTION_MARK] = "QuestionMark",
+    [AXIDEV_IO_KEY_BAR] = "Bar",
+    [AXIDEV_IO_KEY_LESS_THAN] = "LessThan",
+    [AXIDEV_IO_KEY_GREATER_THAN] = "GreaterThan",
+    [AXIDEV_IO_KEY_ASCII_NUL] = "NUL",
+    [AXIDEV_IO_KEY_ASCII_SOH] = "SOH",
+    [AXIDEV_IO_KEY_ASCII_STX] = "STX",
+    [AXIDEV_IO_KEY_ASCII_ETX] = "ETX",
+    [AXIDEV_IO_KEY_ASCII_EOT] = "EOT",
+    [AXIDEV_IO_KEY_ASCII_ENQ] = "ENQ",
+    [AXIDEV_IO_KEY_ASCII_ACK] = "ACK",
+    [AXIDEV_IO_KEY_ASCII_BELL] = "Bell",
+    [AXIDEV_IO_KEY_ASCII_VT] = "VT",
+    [AXIDEV_IO_KEY_ASCII_FF] = "FF",
+    [AXIDEV_IO_KEY_ASCII_SO] = "SO",
+    [AXIDEV_IO_KEY_ASCII_SI] = "SI",
+    [AXIDEV_IO_KEY_ASCII_DLE] = "DLE",
+    [AXIDEV_IO_KEY_ASCII_DC1] = "DC1",
+    [AXIDEV_IO_KEY_ASCII_DC2] = "DC2",
+    [AXIDEV_IO_KEY_ASCII_DC3] = "DC3",
+    [AXIDEV_IO_KEY_ASCII_DC4] = "DC4",
+    [AXIDEV_IO_KEY_ASCII_NAK] = "NAK",
+    [AXIDEV_IO_KEY_ASCII_SYN] = "SYN",
+    [AXIDEV_IO_KEY_ASCII_ETB] = "ETB",
+    [AXIDEV_IO_KEY_ASCII_CAN] = "CAN",
+    [AXIDEV_IO_KEY_ASCII_EM] = "EM",
+    [AXIDEV_IO_KEY_ASCII_SUB] = "SUB",
+    [AXIDEV_IO_KEY_ASCII_FS] = "FS",
+    [AXIDEV_IO_KEY_ASCII_GS] = "GS",
+    [AXIDEV_IO_KEY_ASCII_RS] = "RS",
+    [AXIDEV_IO_KEY_ASCII_US] = "US",
+    [AXIDEV_IO_KEY_NUMPAD_EQUAL] = "NumpadEqual",
+    [AXIDEV_IO_KEY_DEGREE] = "Degree",
+    [AXIDEV_IO_KEY_STERLING] = "Sterling",
+    [AXIDEV_IO_KEY_MU] = "Mu",
+    [AXIDEV_IO_KEY_PLUS_MINUS] = "PlusMinus",
+    [AXIDEV_IO_KEY_DEAD_CIRCUMFLEX] = "DeadCircumflex",
+    [AXIDEV_IO_KEY_DEAD_DIAERESIS] = "DeadDiaeresis",
+    [AXIDEV_IO_KEY_SECTION] = "Section",
+    [AXIDEV_IO_KEY_CANCEL] = "Cancel",
+    [AXIDEV_IO_KEY_REDO] = "Redo",
+    [AXIDEV_IO_KEY_UNDO] = "Undo",
+    [AXIDEV_IO_KEY_FIND] = "Find",
+    [AXIDEV_IO_KEY_HANGUL] = "Hangul",
+    [AXIDEV_IO_KEY_HANGUL_HANJA] = "HangulHanja",
+    [AXIDEV_IO_KEY_KATAKANA] = "Katakana",
+    [AXIDEV_IO_KEY_HIRAGANA] = "Hiragana",
+    [AXIDEV_IO_KEY_HENKAN] = "Henkan",
+    [AXIDEV_IO_KEY_MUHENKAN] = "Muhenkan",
+    [AXIDEV_IO_KEY_OE] = "OE",
+    [AXIDEV_IO_KEY_oe] = "oe",
+    [AXIDEV_IO_KEY_SUN_PROPS] = "SunProps",
+    [AXIDEV_IO_KEY_SUN_FRONT] = "SunFront",
+    [AXIDEV_IO_KEY_COPY] = "Copy",
+    [AXIDEV_IO_KEY_OPEN] = "Open",
+    [AXIDEV_IO_KEY_PASTE] = "Paste",
+    [AXIDEV_IO_KEY_CUT] = "Cut",
+    [AXIDEV_IO_KEY_CALCULATOR] = "Calculator",
+    [AXIDEV_IO_KEY_EXPLORER] = "Explorer",
+    [AXIDEV_IO_KEY_PHONE] = "Phone",
+    [AXIDEV_IO_KEY_WEB_CAM] = "WebCam",
+    [AXIDEV_IO_KEY_AUDIO_RECORD] = "AudioRecord",
+    [AXIDEV_IO_KEY_AUDIO_REWIND] = "AudioRewind",
+    [AXIDEV_IO_KEY_AUDIO_PRESET] = "AudioPreset",
+    [AXIDEV_IO_KEY_MESSENGER] = "Messenger",
+    [AXIDEV_IO_KEY_SEARCH] = "Search",
+    [AXIDEV_IO_KEY_GO] = "Go",
+    [AXIDEV_IO_KEY_FINANCE] = "Finance",
+    [AXIDEV_IO_KEY_GAME] = "Game",
+    [AXIDEV_IO_KEY_SHOP] = "Shop",
+    [AXIDEV_IO_KEY_HOME_PAGE] = "HomePage",
+    [AXIDEV_IO_KEY_RELOAD] = "Reload",
+    [AXIDEV_IO_KEY_CLOSE] = "Close",
+    [AXIDEV_IO_KEY_SEND] = "Send",
+    [AXIDEV_IO_KEY_XFER] = "Xfer",
+    [AXIDEV_IO_KEY_LAUNCH_A] = "LaunchA",
+    [AXIDEV_IO_KEY_LAUNCH_B] = "LaunchB",
+    [AXIDEV_IO_KEY_LAUNCH1] = "Launch1",
+    [AXIDEV_IO_KEY_LAUNCH2] = "Launch2",
+    [AXIDEV_IO_KEY_LAUNCH3] = "Launch3",
+    [AXIDEV_IO_KEY_LAUNCH4] = "Launch4",
+    [AXIDEV_IO_KEY_LAUNCH5] = "Launch5",
+    [AXIDEV_IO_KEY_LAUNCH6] = "Launch6",
+    [AXIDEV_IO_KEY_LAUNCH7] = "Launch7",
+    [AXIDEV_IO_KEY_LAUNCH8] = "Launch8",
+    [AXIDEV_IO_KEY_LAUNCH9] = "Launch9",
+    [AXIDEV_IO_KEY_TOUCHPAD_TOGGLE] = "TouchpadToggle",
+    [AXIDEV_IO_KEY_TOUCHPAD_ON] = "TouchpadOn",
+    [AXIDEV_IO_KEY_TOUCHPAD_OFF] = "TouchpadOff",
+    [AXIDEV_IO_KEY_KBD_LIGHT_ON_OFF] = "KbdLightOnOff",
+    [AXIDEV_IO_KEY_KBD_BRIGHTNESS_DOWN] = "KbdBrightnessDown",
+    [AXIDEV_IO_KEY_KBD_BRIGHTNESS_UP] = "KbdBrightnessUp",
+    [AXIDEV_IO_KEY_MAIL] = "Mail",
+    [AXIDEV_IO_KEY_MAIL_FORWARD] = "MailForward",
+    [AXIDEV_IO_KEY_SAVE] = "Save",
+    [AXIDEV_IO_KEY_DOCUMENTS] = "Documents",
+    [AXIDEV_IO_KEY_BATTERY] = "Battery",
+    [AXIDEV_IO_KEY_BLUETOOTH] = "Bluetooth",
+    [AXIDEV_IO_KEY_WLAN] = "WLAN",
+    [AXIDEV_IO_KEY_UWB] = "UWB",
+    [AXIDEV_IO_KEY_NEXT_VMODE] = "Next_VMode",
+    [AXIDEV_IO_KEY_PREV_VMODE] = "Prev_VMode",
+    [AXIDEV_IO_KEY_MON_BRIGHTNESS_CYCLE] = "MonBrightnessCycle",
+    [AXIDEV_IO_KEY_BRIGHTNESS_AUTO] = "BrightnessAuto",
+    [AXIDEV_IO_KEY_DISPLAY_OFF] = "DisplayOff",
+    [AXIDEV_IO_KEY_WWAN] = "WWAN",
+    [AXIDEV_IO_KEY_RF_KILL] = "RFKill",
+};
+
+static const uint16_t
+    axidev_io_key_name_displacements[AXIDEV_IO_KEY_NAME_BUCKETS] = {
+        150u, 85u, 43u, 37u, 46u, 39u, 225u, 1u, 141u, 53u, 86u, 28u, 1u, 10u,
+        38u, 0u, 2u, 32u, 31u, 135u, 5u, 10u, 74u, 41u, 61u, 64u, 49u, 18u, 1u,
+        21u, 72u, 31u, 0u, 0u, 133u, 0u, 0u, 118u, 31u, 14u, 0u, 279u, 47u, 0u,
+        67u, 0u, 125u, 96u, 0u, 0u, 82u, 20u, 55u, 0u, 148u, 5u, 39u, 48u, 198u,
+        24u, 18u, 124u, 62u, 52u, 38u, 116u, 105u, 206u, 8u, 243u, 108u, 86u,
+        350u, 6u, 7u, 8u, 84u, 0u, 0u, 40u, 163u, 0u, 34u, 0u, 84u, 4u, 48u,
+        74u, 16u, 14u, 25u, 596u, 44u, 292u, 831u, 0u, 10u, 332u, 45u, 51u,
+        335u, 464u, 72u, 21u, 172u, 6u, 219u, 204u, 5u, 238u, 945u, 484u,
+};
+
+/* Lowercased spellings, each at its perfect-hash slot. */
+static const axidev_io_key_name_entry
+    axidev_io_key_name_slots[AXIDEV_IO_KEY_NAME_SLOTS] = {
+        {"hash", AXIDEV_IO_KEY_HASHTAG},
+        {"bluetooth", AXIDEV_IO_KEY_BLUETOOTH},
+        {"{", AXIDEV_IO_KEY_LEFT_BRACKET},
+        {"kp_begin", AXIDEV_IO_KEY_NUMPAD5},
+        {"kp8", AXIDEV_IO_KEY_NUMPAD8},
+        {"audiorewind", AXIDEV_IO_KEY_AUDIO_REWIND},
+        {"search", AXIDEV_IO_KEY_SEARCH},
+        {"&", AXIDEV_IO_KEY_AMPERSAND},
+        {"hangulhanja", AXIDEV_IO_KEY_HANGUL_HANJA},
+        {"_", AXIDEV_IO_KEY_MINUS},
+        {"kp_equal", AXIDEV_IO_KEY_NUMPAD_EQUAL},
+        {"numpad1", AXIDEV_IO_KEY_NUMPAD1},
+        {"6", AXIDEV_IO_KEY_NUM6},
+        {"dc2", AXIDEV_IO_KEY_ASCII_DC2},
+        {"kp_del", AXIDEV_IO_KEY_NUMPAD_DECIMAL},
+        {"l", AXIDEV_IO_KEY_L},
+        {"numpaddecimal", AXIDEV_IO_KEY_NUMPAD_DECIMAL},
+        {"brightnessup", AXIDEV_IO_KEY_BRIGHTNESS_UP},
+        {"send", AXIDEV_IO_KEY_SEND},
+        {"eject", AXIDEV_IO_KEY_EJECT},
+        {"kp_0", AXIDEV_IO_KEY_NUMPAD0},
+        {"n", AXIDEV_IO_KEY_N},
+        {"dc4", AXIDEV_IO_KEY_ASCII_DC4},
+        {"ff", AXIDEV_IO_KEY_ASCII_FF},
+        {"kpprior", AXIDEV_IO_KEY_NUMPAD9},
+        {"deadcircumflex", AXIDEV_IO_KEY_DEAD_CIRCUMFLEX},
+        {"brightnessauto", AXIDEV_IO_KEY_BRIGHTNESS_AUTO},
+        {"super", AXIDEV_IO_KEY_SUPER_LEFT},
+        {"iso_level5_shift", AXIDEV_IO_KEY_ALT_RIGHT},
+        {"rfkill", AXIDEV_IO_KEY_RF_KILL},
+        {"y", AXIDEV_IO_KEY_Y},
+        {"del", AXIDEV_IO_KEY_ASCII_DEL},
+        {".", AXIDEV_IO_KEY_PERIOD},
+        {"b", AXIDEV_IO_KEY_B},
+        {"exclamation", AXIDEV_IO_KEY_EXCLAMATION},
+        {"kp_subtract", AXIDEV_IO_KEY_NUMPAD_MINUS},
+        {"pageup", AXIDEV_IO_KEY_PAGE_UP},
+        {"pound", AXIDEV_IO_KEY_HASHTAG},
+        {"mute", AXIDEV_IO_KEY_MUTE},
+        {"`", AXIDEV_IO_KEY_GRAVE},
+        {"kphome", AXIDEV_IO_KEY_NUMPAD7},
+        {"4", AXIDEV_IO_KEY_NUM4},
+        {"left", AXIDEV_IO_KEY_LEFT},
+        {"f11", AXIDEV_IO_KEY_F11},
+        {"super_r", AXIDEV_IO_KEY_SUPER_RIGHT},
+        {"dle", AXIDEV_IO_KEY_ASCII_DLE},
+        {"right", AXIDEV_IO_KEY_RIGHT},
+        {"muhenkan", AXIDEV_IO_KEY_MUHENKAN},
+        {"apostrophe", AXIDEV_IO_KEY_APOSTROPHE},
+        {"can", AXIDEV_IO_KEY_ASCII_CAN},
+        {"*", AXIDEV_IO_KEY_ASTERISK},
+        {"backslash", AXIDEV_IO_KEY_BACKSLASH},
+        {"launch2", AXIDEV_IO_KEY_LAUNCH2},
+        {"ampersand", AXIDEV_IO_KEY_AMPERSAND},
+        {"kp_prior", AXIDEV_IO_KEY_NUMPAD9},
+        {"\035", AXIDEV_IO_KEY_ASCII_GS},
+        {"ccedilla", AXIDEV_IO_KEY_C},
+        {"meta", AXIDEV_IO_KEY_SUPER_LEFT},
+        {"'", AXIDEV_IO_KEY_APOSTROPHE},
+        {"find", AXIDEV_IO_KEY_FIND},
+        {"kpadd", AXIDEV_IO_KEY_NUMPAD_PLUS},
+        {"etx", AXIDEV_IO_KEY_ASCII_ETX},
+        {"leftparen", AXIDEV_IO_KEY_LEFT_PAREN},
+        {"touchpadoff", AXIDEV_IO_KEY_TOUCHPAD_OFF},
+        {"!", AXIDEV_IO_KEY_EXCLAMATION},
+        {"lparen", AXIDEV_IO_KEY_LEFT_PAREN},
+        {"control", AXIDEV_IO_KEY_CTRL_LEFT},
+        {"f9", AXIDEV_IO_KEY_F9},
+        {"control_l", AXIDEV_IO_KEY_CTRL_LEFT},
+        {"return", AXIDEV_IO_KEY_ENTER},
+        {"kp_left", AXIDEV_IO_KEY_NUMPAD4},
+        {"bell", AXIDEV_IO_KEY_ASCII_BELL},
+        {"gs", AXIDEV_IO_KEY_ASCII_GS},
+        {"1", AXIDEV_IO_KEY_NUM1},
+        {"kpbegin", AXIDEV_IO_KEY_NUMPAD5},
+        {"\030", AXIDEV_IO_KEY_ASCII_CAN},
+        {"dot", AXIDEV_IO_KEY_PERIOD},
+        {"kbdbrightnessup", AXIDEV_IO_KEY_KBD_BRIGHTNESS_UP},
+        {"break", AXIDEV_IO_KEY_PAUSE},
+        {"m", AXIDEV_IO_KEY_M},
+        {"$", AXIDEV_IO_KEY_DOLLAR},
+        {"shift_l", AXIDEV_IO_KEY_SHIFT_LEFT},
+        {"\024", AXIDEV_IO_KEY_ASCII_DC4},
+        {"win", AXIDEV_IO_KEY_SUPER_LEFT},
+        {"printscreen", AXIDEV_IO_KEY_PRINT_SCREEN},
+        {"f19", AXIDEV_IO_KEY_F19},
+        {"kpright", AXIDEV_IO_KEY_NUMPAD6},
+        {"scroll_lock", AXIDEV_IO_KEY_SCROLL_LOCK},
+        {"so", AXIDEV_IO_KEY_ASCII_SO},
+        {"]", AXIDEV_IO_KEY_RIGHT_BRACKET},
+        {"equal", AXIDEV_IO_KEY_EQUAL},
+        {"f", AXIDEV_IO_KEY_F},
+        {"wake", AXIDEV_IO_KEY_WAKE},
+        {"kpplus", AXIDEV_IO_KEY_NUMPAD_PLUS},
+        {"k", AXIDEV_IO_KEY_K},
+        {"launch8", AXIDEV_IO_KEY_LAUNCH8},
+        {"backspace", AXIDEV_IO_KEY_BACKSPACE},
+        {"colon", AXIDEV_IO_KEY_COLON},
+        {"delete", AXIDEV_IO_KEY_DELETE},
+        {"print", AXIDEV_IO_KEY_PRINT_SCREEN},
+        {"t", AXIDEV_IO_KEY_T},
+        {"num0", AXIDEV_IO_KEY_NUM0},
+        {"close", AXIDEV_IO_KEY_CLOSE},
+        {"9", AXIDEV_IO_KEY_NUM9},
+        {"comma", AXIDEV_IO_KEY_COMMA},
+        {"hyphen", AXIDEV_IO_KEY_MINUS},
+        {"sub", AXIDEV_IO_KEY_ASCII_SUB},
+        {"down", AXIDEV_IO_KEY_DOWN},
+        {"caps_lock", AXIDEV_IO_KEY_CAPS_LOCK},
+        {"0", AXIDEV_IO_KEY_NUM0},
+        {"num3", AXIDEV_IO_KEY_NUM3},
+        {"exclam", AXIDEV_IO_KEY_EXCLAMATION},
+        {"rs", AXIDEV_IO_KEY_ASCII_RS},
+        {"ugrave", AXIDEV_IO_KEY_U},
+        {"minus", AXIDEV_IO_KEY_MINUS},
+        {"lessthan", AXIDEV_IO_KEY_LESS_THAN},
+        {"cancel", AXIDEV_IO_KEY_CANCEL},
+        {"phone", AXIDEV_IO_KEY_PHONE},
+        {"kp_2", AXIDEV_IO_KEY_NUMPAD2},
+        {"quote", AXIDEV_IO_KEY_QUOTE},
+        {"sys_req", AXIDEV_IO_KEY_PRINT_SCREEN},
+        {"kpup", AXIDEV_IO_KEY_NUMPAD8},
+        {"copy", AXIDEV_IO_KEY_COPY},
+        {";", AXIDEV_IO_KEY_SEMICOLON},
+        {"\032", AXIDEV_IO_KEY_ASCII_SUB},
+        {"ctrlright", AXIDEV_IO_KEY_CTRL_RIGHT},
+        {"o", AXIDEV_IO_KEY_O},
+        {"displayoff", AXIDEV_IO_KEY_DISPLAY_OFF},
+        {"wlan", AXIDEV_IO_KEY_WLAN},
+        {"next", AXIDEV_IO_KEY_PAGE_DOWN},
+        {"launch7", AXIDEV_IO_KEY_LAUNCH7},
+        {"kp_add", AXIDEV_IO_KEY_NUMPAD_PLUS},
+        {"rparen", AXIDEV_IO_KEY_RIGHT_PAREN},
+        {"\004", AXIDEV_IO_KEY_ASCII_EOT},
+        {"percent", AXIDEV_IO_KEY_PERCENT},
+        {"7", AXIDEV_IO_KEY_NUM7},
+        {"altright", AXIDEV_IO_KEY_ALT_RIGHT},
+        {"hiragana", AXIDEV_IO_KEY_HIRAGANA},
+        {"kp_divide", AXIDEV_IO_KEY_NUMPAD_DIVIDE},
+        {"enter", AXIDEV_IO_KEY_ENTER},
+        {"kbdbrightnessdown", AXIDEV_IO_KEY_KBD_BRIGHTNESS_DOWN},
+        {"kpequal", AXIDEV_IO_KEY_NUMPAD_EQUAL},
+        {"help", AXIDEV_IO_KEY_HELP},
+        {"kp_4", AXIDEV_IO_KEY_NUMPAD4},
+        {"deaddiaeresis", AXIDEV_IO_KEY_DEAD_DIAERESIS},
+        {"numpad0", AXIDEV_IO_KEY_NUMPAD0},
+        {"\026", AXIDEV_IO_KEY_ASCII_SYN},
+        {"alt_r", AXIDEV_IO_KEY_ALT_RIGHT},
+        {"launch5", AXIDEV_IO_KEY_LAUNCH5},
+        {"i", AXIDEV_IO_KEY_I},
+        {"explorer", AXIDEV_IO_KEY_EXPLORER},
+        {"xfer", AXIDEV_IO_KEY_XFER},
+        {"\002", AXIDEV_IO_KEY_ASCII_STX},
+        {"grave", AXIDEV_IO_KEY_GRAVE},
+        {"dead_diaeresis", AXIDEV_IO_KEY_DEAD_DIAERESIS},
+        {"launch6", AXIDEV_IO_KEY_LAUNCH6},
+        {"scrolllock", AXIDEV_IO_KEY_SCROLL_LOCK},
+        {"go", AXIDEV_IO_KEY_GO},
+        {"5", AXIDEV_IO_KEY_NUM5},
+        {"numpad3", AXIDEV_IO_KEY_NUMPAD3},
+        {"hyper_l", AXIDEV_IO_KEY_SUPER_LEFT},
+        {"num4", AXIDEV_IO_KEY_NUM4},
+        {"prior", AXIDEV_IO_KEY_PAGE_UP},
+        {"oe", AXIDEV_IO_KEY_oe},
+        {"%", AXIDEV_IO_KEY_PERCENT},
+        {"kpenter", AXIDEV_IO_KEY_NUMPAD_ENTER},
+        {"a", AXIDEV_IO_KEY_A},
+        {"quotedbl", AXIDEV_IO_KEY_QUOTE},
+        {"spacebar", AXIDEV_IO_KEY_SPACE},
+        {"f18", AXIDEV_IO_KEY_F18},
+        {"numpad5", AXIDEV_IO_KEY_NUMPAD5},
+        {"\016", AXIDEV_IO_KEY_ASCII_SO},
+        {"num8", AXIDEV_IO_KEY_NUM8},
+        {"star", AXIDEV_IO_KEY_ASTERISK},
+        {"at", AXIDEV_IO_KEY_AT},
+        {"\005", AXIDEV_IO_KEY_ASCII_ENQ},
+        {"section", AXIDEV_IO_KEY_SECTION},
+        {"~", AXIDEV_IO_KEY_GRAVE},
+        {"kp4", AXIDEV_IO_KEY_NUMPAD4},
+        {"kp_multiply", AXIDEV_IO_KEY_NUMPAD_MULTIPLY},
+        {"game", AXIDEV_IO_KEY_GAME},
+        {"meta_l", AXIDEV_IO_KEY_SUPER_LEFT},
+        {"period", AXIDEV_IO_KEY_PERIOD},
+        {"numpadplus", AXIDEV_IO_KEY_NUMPAD_PLUS},
+        {"superright", AXIDEV_IO_KEY_SUPER_RIGHT},
+        {"f7", AXIDEV_IO_KEY_F7},
+        {"dollar", AXIDEV_IO_KEY_DOLLAR},
+        {"us", AXIDEV_IO_KEY_ASCII_US},
+        {"launcha", AXIDEV_IO_KEY_LAUNCH_A},
+        {"3", AXIDEV_IO_KEY_NUM3},
+        {"launch4", AXIDEV_IO_KEY_LAUNCH4},
+        {"insert", AXIDEV_IO_KEY_INSERT},
+        {"<", AXIDEV_IO_KEY_COMMA},
+        {"\020", AXIDEV_IO_KEY_ASCII_DLE},
+        {",", AXIDEV_IO_KEY_COMMA},
+        {"uwb", AXIDEV_IO_KEY_UWB},
+        {"documents", AXIDEV_IO_KEY_DOCUMENTS},
+        {"questionmark", AXIDEV_IO_KEY_QUESTION_MARK},
+        {"agrave", AXIDEV_IO_KEY_A},
+        {"c", AXIDEV_IO_KEY_C},
+        {"f5", AXIDEV_IO_KEY_F5},
+        {"launchb", AXIDEV_IO_KEY_LAUNCH_B},
+        {"launch1", AXIDEV_IO_KEY_LAUNCH1},
+        {"kp_next", AXIDEV_IO_KEY_NUMPAD3},
+        {"\021", AXIDEV_IO_KEY_ASCII_DC1},
+        {"f20", AXIDEV_IO_KEY_F20},
+        {"bar", AXIDEV_IO_KEY_BAR},
+        {"num1", AXIDEV_IO_KEY_NUM1},
+        {"\015", AXIDEV_IO_KEY_ENTER},
+        {"kpnext", AXIDEV_IO_KEY_NUMPAD3},
+        {"mu", AXIDEV_IO_KEY_MU},
+        {"pause", AXIDEV_IO_KEY_PAUSE},
+        {"num5", AXIDEV_IO_KEY_NUM5},
+        {"kp_plus", AXIDEV_IO_KEY_NUMPAD_PLUS},
+        {"?", AXIDEV_IO_KEY_SLASH},
+        {"^", AXIDEV_IO_KEY_CARET},
+        {"mailforward", AXIDEV_IO_KEY_MAIL_FORWARD},
+        {"fs", AXIDEV_IO_KEY_ASCII_FS},
+        {"redo", AXIDEV_IO_KEY_REDO},
+        {"\025", AXIDEV_IO_KEY_ASCII_NAK},
+        {"q", AXIDEV_IO_KEY_Q},
+        {"kpinsert", AXIDEV_IO_KEY_NUMPAD0},
+        {"medianext", AXIDEV_IO_KEY_MEDIA_NEXT},
+        {"v", AXIDEV_IO_KEY_V},
+        {"[", AXIDEV_IO_KEY_LEFT_BRACKET},
+        {"kpsubtract", AXIDEV_IO_KEY_NUMPAD_MINUS},
+        {"kpdelete", AXIDEV_IO_KEY_NUMPAD_DECIMAL},
+        {"bang", AXIDEV_IO_KEY_EXCLAMATION},
+        {"calculator", AXIDEV_IO_KEY_CALCULATOR},
+        {"pagedown", AXIDEV_IO_KEY_PAGE_DOWN},
+        {"\017", AXIDEV_IO_KEY_ASCII_SI},
+        {"numpad6", AXIDEV_IO_KEY_NUMPAD6},
+        {"kp_end", AXIDEV_IO_KEY_NUMPAD1},
+        {"\027", AXIDEV_IO_KEY_ASCII_ETB},
+        {"s", AXIDEV_IO_KEY_S},
+        {"kpdiv", AXIDEV_IO_KEY_NUMPAD_DIVIDE},
+        {"greater", AXIDEV_IO_KEY_GREATER_THAN},
+        {"reload", AXIDEV_IO_KEY_RELOAD},
+        {"alt_l", AXIDEV_IO_KEY_ALT_LEFT},
+        {"sterling", AXIDEV_IO_KEY_STERLING},
+        {"numpadenter", AXIDEV_IO_KEY_NUMPAD_ENTER},
+        {"numpaddivide", AXIDEV_IO_KEY_NUMPAD_DIVIDE},
+        {"lt", AXIDEV_IO_KEY_LESS_THAN},
+        {"less", AXIDEV_IO_KEY_LESS_THAN},
+        {"plus", AXIDEV_IO_KEY_PLUS},
+        {"vt", AXIDEV_IO_KEY_ASCII_VT},
+        {"space", AXIDEV_IO_KEY_SPACE},
+        {"finance", AXIDEV_IO_KEY_FINANCE},
+        {"sunprops", AXIDEV_IO_KEY_SUN_PROPS},
+        {"gt", AXIDEV_IO_KEY_GREATER_THAN},
+        {"kp9", AXIDEV_IO_KEY_NUMPAD9},
+        {"enq", AXIDEV_IO_KEY_ASCII_ENQ},
+        {"touchpadon", AXIDEV_IO_KEY_TOUCHPAD_ON},
+        {"kp6", AXIDEV_IO_KEY_NUMPAD6},
+        {"\011", AXIDEV_IO_KEY_TAB},
+        {"homepage", AXIDEV_IO_KEY_HOME_PAGE},
+        {"pipe", AXIDEV_IO_KEY_BAR},
+        {"kp1", AXIDEV_IO_KEY_NUMPAD1},
+        {"r", AXIDEV_IO_KEY_R},
+        {"kpend", AXIDEV_IO_KEY_NUMPAD1},
+        {"f8", AXIDEV_IO_KEY_F8},
+        {"shift_r", AXIDEV_IO_KEY_SHIFT_RIGHT},
+        {"caret", AXIDEV_IO_KEY_CARET},
+        {"eacute", AXIDEV_IO_KEY_E},
+        {"j", AXIDEV_IO_KEY_J},
+        {"dead_circumflex", AXIDEV_IO_KEY_DEAD_CIRCUMFLEX},
+        {"num_lock", AXIDEV_IO_KEY_NUM_LOCK},
+        {"touchpadtoggle", AXIDEV_IO_KEY_TOUCHPAD_TOGGLE},
+        {"parenleft", AXIDEV_IO_KEY_LEFT_PAREN},
+        {"num6", AXIDEV_IO_KEY_NUM6},
+        {"prev_vmode", AXIDEV_IO_KEY_PREV_VMODE},
+        {"underscore", AXIDEV_IO_KEY_UNDERSCORE},
+        {"kp5", AXIDEV_IO_KEY_NUMPAD5},
+        {"\006", AXIDEV_IO_KEY_ASCII_ACK},
+        {"shiftright", AXIDEV_IO_KEY_SHIFT_RIGHT},
+        {"\\", AXIDEV_IO_KEY_BACKSLASH},
+        {"rightparen", AXIDEV_IO_KEY_RIGHT_PAREN},
+        {"kp_home", AXIDEV_IO_KEY_NUMPAD7},
+        {"dc3", AXIDEV_IO_KEY_ASCII_DC3},
+        {"egrave", AXIDEV_IO_KEY_E},
+        {"up", AXIDEV_IO_KEY_UP},
+        {"shift", AXIDEV_IO_KEY_SHIFT_LEFT},
+        {"esc", AXIDEV_IO_KEY_ESCAPE},
+        {"question", AXIDEV_IO_KEY_QUESTION_MARK},
+        {"undo", AXIDEV_IO_KEY_UNDO},
+        {"power", AXIDEV_IO_KEY_POWER},
+        {"d", AXIDEV_IO_KEY_D},
+        {"(", AXIDEV_IO_KEY_LEFT_PAREN},
+        {"etb", AXIDEV_IO_KEY_ASCII_ETB},
+        {"menu", AXIDEV_IO_KEY_MENU},
+        {"nul", AXIDEV_IO_KEY_ASCII_NUL},
+        {"=", AXIDEV_IO_KEY_EQUAL},
+        {"parenright", AXIDEV_IO_KEY_RIGHT_PAREN},
+        {"syn", AXIDEV_IO_KEY_ASCII_SYN},
+        {"\014", AXIDEV_IO_KEY_ASCII_FF},
+        {"kp_minus", AXIDEV_IO_KEY_NUMPAD_MINUS},
+        {" ", AXIDEV_IO_KEY_SPACE},
+        {"num2", AXIDEV_IO_KEY_NUM2},
+        {"webcam", AXIDEV_IO_KEY_WEB_CAM},
+        {"numpadequal", AXIDEV_IO_KEY_NUMPAD_EQUAL},
+        {"plusminus", AXIDEV_IO_KEY_PLUS_MINUS},
+        {"\177", AXIDEV_IO_KEY_DELETE},
+        {"f13", AXIDEV_IO_KEY_F13},
+        {"shop", AXIDEV_IO_KEY_SHOP},
+        {"kp7", AXIDEV_IO_KEY_NUMPAD7},
+        {"volumedown", AXIDEV_IO_KEY_VOLUME_DOWN},
+        {"sleep", AXIDEV_IO_KEY_SLEEP},
+        {"\"", AXIDEV_IO_KEY_APOSTROPHE},
+        {"stx", AXIDEV_IO_KEY_ASCII_STX},
+        {"henkan", AXIDEV_IO_KEY_HENKAN},
+        {"linefeed", AXIDEV_IO_KEY_ENTER},
+        {"\022", AXIDEV_IO_KEY_ASCII_DC2},
+        {"8", AXIDEV_IO_KEY_NUM8},
+        {"volumeup", AXIDEV_IO_KEY_VOLUME_UP},
+        {"kp_7", AXIDEV_IO_KEY_NUMPAD7},
+        {"unknown", AXIDEV_IO_KEY_UNKNOWN},
+        {"audiopreset", AXIDEV_IO_KEY_AUDIO_PRESET},
+        {"dc1", AXIDEV_IO_KEY_ASCII_DC1},
+        {"kp_mul", AXIDEV_IO_KEY_NUMPAD_MULTIPLY},
+        {")", AXIDEV_IO_KEY_RIGHT_PAREN},
+        {"hangul", AXIDEV_IO_KEY_HANGUL},
+        {"f6", AXIDEV_IO_KEY_F6},
+        {"numpad2", AXIDEV_IO_KEY_NUMPAD2},
+        {"bracketright", AXIDEV_IO_KEY_RIGHT_BRACKET},
+        {"ack", AXIDEV_IO_KEY_ASCII_ACK},
+        {"numpad8", AXIDEV_IO_KEY_NUMPAD8},
+        {"slash", AXIDEV_IO_KEY_SLASH},
+        {"eot", AXIDEV_IO_KEY_ASCII_EOT},
+        {"e", AXIDEV_IO_KEY_E},
+        {"kp2", AXIDEV_IO_KEY_NUMPAD2},
+        {"kp_decimal", AXIDEV_IO_KEY_NUMPAD_DECIMAL},
+        {"-", AXIDEV_IO_KEY_MINUS},
+        {"ctrlleft", AXIDEV_IO_KEY_CTRL_LEFT},
+        {"hashtag", AXIDEV_IO_KEY_HASHTAG},
+        {"shiftleft", AXIDEV_IO_KEY_SHIFT_LEFT},
+        {"p", AXIDEV_IO_KEY_P},
+        {"#", AXIDEV_IO_KEY_HASHTAG},
+        {"kp_delete", AXIDEV_IO_KEY_NUMPAD_DECIMAL},
+        {"+", AXIDEV_IO_KEY_EQUAL},
+        {"kp_8", AXIDEV_IO_KEY_NUMPAD8},
+        {"superleft", AXIDEV_IO_KEY_SUPER_LEFT},
+        {"\003", AXIDEV_IO_KEY_ASCII_ETX},
+        {"w", AXIDEV_IO_KEY_W},
+        {"f15", AXIDEV_IO_KEY_F15},
+        {"/", AXIDEV_IO_KEY_SLASH},
+        {"launch3", AXIDEV_IO_KEY_LAUNCH3},
+        {"iso_level3_shift", AXIDEV_IO_KEY_ALT_RIGHT},
+        {"save", AXIDEV_IO_KEY_SAVE},
+        {"soh", AXIDEV_IO_KEY_ASCII_SOH},
+        {"kp_right", AXIDEV_IO_KEY_NUMPAD6},
+        {"\007", AXIDEV_IO_KEY_ASCII_BELL},
+        {"kpmultiply", AXIDEV_IO_KEY_NUMPAD_MULTIPLY},
+        {"kpdown", AXIDEV_IO_KEY_NUMPAD2},
+        {"\037", AXIDEV_IO_KEY_ASCII_US},
+        {"numpadminus", AXIDEV_IO_KEY_NUMPAD_MINUS},
+        {"f17", AXIDEV_IO_KEY_F17},
+        {"kpmul", AXIDEV_IO_KEY_NUMPAD_MULTIPLY},
+        {"kp_insert", AXIDEV_IO_KEY_NUMPAD0},
+        {">", AXIDEV_IO_KEY_PERIOD},
+        {"si", AXIDEV_IO_KEY_ASCII_SI},
+        {"tab", AXIDEV_IO_KEY_TAB},
+        {"numpad4", AXIDEV_IO_KEY_NUMPAD4},
+        {"open", AXIDEV_IO_KEY_OPEN},
+        {"u", AXIDEV_IO_KEY_U},
+        {"asterisk", AXIDEV_IO_KEY_ASTERISK},
+        {"battery", AXIDEV_IO_KEY_BATTERY},
+        {"mediastop", AXIDEV_IO_KEY_MEDIA_STOP},
+        {"launch9", AXIDEV_IO_KEY_LAUNCH9},
+        {"x", AXIDEV_IO_KEY_X},
+        {"mediaprevious", AXIDEV_IO_KEY_MEDIA_PREVIOUS},
+        {"bracketleft", AXIDEV_IO_KEY_LEFT_BRACKET},
+        {"f2", AXIDEV_IO_KEY_F2},
+        {"kp_9", AXIDEV_IO_KEY_NUMPAD9},
+        {"f3", AXIDEV_IO_KEY_F3},
+        {"monbrightnesscycle", AXIDEV_IO_KEY_MON_BRIGHTNESS_CYCLE},
+        {"kp0", AXIDEV_IO_KEY_NUMPAD0},
+        {"kp_div", AXIDEV_IO_KEY_NUMPAD_DIVIDE},
+        {":", AXIDEV_IO_KEY_SEMICOLON},
+        {"wwan", AXIDEV_IO_KEY_WWAN},
+        {"\010", AXIDEV_IO_KEY_BACKSPACE},
+        {"greaterthan", AXIDEV_IO_KEY_GREATER_THAN},
+        {"kbdlightonoff", AXIDEV_IO_KEY_KBD_LIGHT_ON_OFF},
+        {"kpminus", AXIDEV_IO_KEY_NUMPAD_MINUS},
+        {"\023", AXIDEV_IO_KEY_ASCII_DC3},
+        {"kp_6", AXIDEV_IO_KEY_NUMPAD6},
+        {"altleft", AXIDEV_IO_KEY_ALT_LEFT},
+        {"\034", AXIDEV_IO_KEY_ASCII_FS},
+        {"kp_enter", AXIDEV_IO_KEY_NUMPAD_ENTER},
+        {"2", AXIDEV_IO_KEY_NUM2},
+        {"kp3", AXIDEV_IO_KEY_NUMPAD3},
+        {"f4", AXIDEV_IO_KEY_F4},
+        {"end", AXIDEV_IO_KEY_END},
+        {"super_l", AXIDEV_IO_KEY_SUPER_LEFT},
+        {"z", AXIDEV_IO_KEY_Z},
+        {"kpdel", AXIDEV_IO_KEY_NUMPAD_DECIMAL},
+        {"next_vmode", AXIDEV_IO_KEY_NEXT_VMODE},
+        {"numpad7", AXIDEV_IO_KEY_NUMPAD7},
+        {"sunfront", AXIDEV_IO_KEY_SUN_FRONT},
+        {"em", AXIDEV_IO_KEY_ASCII_EM},
+        {"\001", AXIDEV_IO_KEY_ASCII_SOH},
+        {"kp_up", AXIDEV_IO_KEY_NUMPAD8},
+        {"f14", AXIDEV_IO_KEY_F14},
+        {"}", AXIDEV_IO_KEY_RIGHT_BRACKET},
+        {"kpdecimal", AXIDEV_IO_KEY_NUMPAD_DECIMAL},
+        {"numpadmultiply", AXIDEV_IO_KEY_NUMPAD_MULTIPLY},
+        {"paste", AXIDEV_IO_KEY_PASTE},
+        {"@", AXIDEV_IO_KEY_AT},
+        {"audiorecord", AXIDEV_IO_KEY_AUDIO_RECORD},
+        {"kp_3", AXIDEV_IO_KEY_NUMPAD3},
+        {"dash", AXIDEV_IO_KEY_MINUS},
+        {"katakana", AXIDEV_IO_KEY_KATAKANA},
+        {"\033", AXIDEV_IO_KEY_ESCAPE},
+        {"f10", AXIDEV_IO_KEY_F10},
+        {"f12", AXIDEV_IO_KEY_F12},
+        {"cut", AXIDEV_IO_KEY_CUT},
+        {"mail", AXIDEV_IO_KEY_MAIL},
+        {"brightnessdown", AXIDEV_IO_KEY_BRIGHTNESS_DOWN},
+        {"degree", AXIDEV_IO_KEY_DEGREE},
+        {"\012", AXIDEV_IO_KEY_ENTER},
+        {"|", AXIDEV_IO_KEY_BACKSLASH},
+        {"kp_5", AXIDEV_IO_KEY_NUMPAD5},
+        {"ctrl", AXIDEV_IO_KEY_CTRL_LEFT},
+        {"f1", AXIDEV_IO_KEY_F1},
+        {"\036", AXIDEV_IO_KEY_ASCII_RS},
+        {"messenger", AXIDEV_IO_KEY_MESSENGER},
+        {"\031", AXIDEV_IO_KEY_ASCII_EM},
+        {"kpdivide", AXIDEV_IO_KEY_NUMPAD_DIVIDE},
+        {"g", AXIDEV_IO_KEY_G},
+        {"semicolon", AXIDEV_IO_KEY_SEMICOLON},
+        {"f16", AXIDEV_IO_KEY_F16},
+        {"iso_left_tab", AXIDEV_IO_KEY_TAB},
+        {"numpad9", AXIDEV_IO_KEY_NUMPAD9},
+        {"num7", AXIDEV_IO_KEY_NUM7},
+        {"num9", AXIDEV_IO_KEY_NUM9},
+        {"kpleft", AXIDEV_IO_KEY_NUMPAD4},
+        {"capslock", AXIDEV_IO_KEY_CAPS_LOCK},
+        {"numlock", AXIDEV_IO_KEY_NUM_LOCK},
+        {"kp_down", AXIDEV_IO_KEY_NUMPAD2},
+        {"home", AXIDEV_IO_KEY_HOME},
+        {"nak", AXIDEV_IO_KEY_ASCII_NAK},
+        {"control_r", AXIDEV_IO_KEY_CTRL_RIGHT},
+        {"mediaplaypause", AXIDEV_IO_KEY_MEDIA_PLAY_PAUSE},
+        {"h", AXIDEV_IO_KEY_H},
+        {"escape", AXIDEV_IO_KEY_ESCAPE},
+        {"\013", AXIDEV_IO_KEY_ASCII_VT},
+        {"kp_1", AXIDEV_IO_KEY_NUMPAD1},
+        {"alt", AXIDEV_IO_KEY_ALT_LEFT},
+};
+
+/* Spellings matched case-sensitively before the hash lookup. */
+static const axidev_io_key_name_entry axidev_io_key_exact_names[] = {
+    {"OE", AXIDEV_IO_KEY_OE},
+};
+
+#endif
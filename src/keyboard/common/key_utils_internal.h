@@ -6,10 +6,17 @@
 
 const char *axidev_io_key_to_string_const(axidev_io_keyboard_key_t key);
 char *axidev_io_key_to_string_alloc(axidev_io_keyboard_key_t key);
+/* Both _buf variants copy snprintf-style: the result is truncated to fit and
+   NUL-terminated when `len` > 0, and the full length is returned. */
+size_t axidev_io_key_to_string_buf(axidev_io_keyboard_key_t key, char *buf,
+                                   size_t len);
 axidev_io_keyboard_key_t axidev_io_string_to_key_internal(const char *input);
 char *
 axidev_io_key_to_string_with_modifier_alloc(axidev_io_keyboard_key_t key,
                                             axidev_io_keyboard_modifier_t mods);
+size_t axidev_io_key_to_string_with_modifier_buf(
+    axidev_io_keyboard_key_t key, axidev_io_keyboard_modifier_t mods,
+    char *buf, size_t len);
 bool axidev_io_string_to_key_with_modifier_internal(
     const char *input, axidev_io_keyboard_key_with_modifier_t *out_key_mod);
 
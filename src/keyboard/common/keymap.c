@@ -2,18 +2,22 @@
 
 #include <axidev-io/c_api.h>
 
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "key_utils_internal.h"
+#include "keymap_snapshot_internal.h"
 
 #ifdef _WIN32
 #include "windows_keymap_internal.h"
 #elif defined(__linux__)
-#include "linux_keysym_internal.h"
-#include "linux_layout_internal.h"
-#include <xkbcommon/xkbcommon.h>
+#include "linux_layout_cache_internal.h"
 #endif
 
+static atomic_ullong g_keymap_generation;
+
 axidev_io_keyboard_keymap_impl *axidev_io_keymap_impl_get(void) {
   return (axidev_io_keyboard_keymap_impl *)axidev_io_keymap_storage_ptr();
 }
@@ -48,169 +52,420 @@ uint32_t axidev_io_keymap_encode_code_mods(int32_t keycode,
   return ((uint32_t)keycode << 8) | mod_bits;
 }
 
-static void axidev_io_keymap_copy_char_mappings(
-    axidev_io_keymap_char_mapping_entry *source,
-    axidev_io_keymap_char_mapping_entry **destination) {
+static uint32_t
+axidev_io_keymap_mod_combo(axidev_io_keyboard_modifier_t mods) {
+  return axidev_io_keymap_encode_code_mods(0, mods) &
+         (AXIDEV_IO_KEYMAP_MOD_COMBOS - 1u);
+}
+
+static bool axidev_io_keymap_code_in_range(int32_t keycode) {
+  return keycode >= 0 && (uint32_t)keycode < AXIDEV_IO_KEYMAP_CODE_LIMIT;
+}
+
+axidev_io_result axidev_io_keymap_tables_build(
+    axidev_io_keymap_tables **out_tables,
+    const axidev_io_keymap_key_to_int_entry *key_to_code,
+    const axidev_io_keymap_int_to_key_entry *code_to_key,
+    const axidev_io_keymap_uint_to_key_entry *code_and_mods_to_key,
+    const axidev_io_keymap_char_mapping_entry *char_to_mapping) {
+  axidev_io_keymap_tables *tables;
   ptrdiff_t index;
+  size_t i;
 
-  if (source == NULL) {
-    return;
+  if (out_tables == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+
+  tables = (axidev_io_keymap_tables *)calloc(1, sizeof(*tables));
+  if (tables == NULL) {
+    axidev_io_set_last_errorf("failed to allocate keymap tables");
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  for (i = 0; i < AXIDEV_IO_KEYMAP_KEY_LIMIT; ++i) {
+    tables->key_to_code[i] = AXIDEV_IO_KEYMAP_NO_CODE;
   }
+  for (i = 0; i < AXIDEV_IO_KEYMAP_CODE_LIMIT; ++i) {
+    size_t combo;
 
-  for (index = 0; index < hmlen(source); ++index) {
-    hmput(*destination, source[index].key, source[index].value);
+    tables->code_to_key[i] = AXIDEV_IO_KEYMAP_NO_KEY;
+    for (combo = 0; combo < AXIDEV_IO_KEYMAP_MOD_COMBOS; ++combo) {
+      tables->code_mods_to_key[i][combo] = AXIDEV_IO_KEYMAP_NO_KEY;
+    }
+  }
+
+  for (index = 0; index < hmlen(key_to_code); ++index) {
+    if (key_to_code[index].key < AXIDEV_IO_KEYMAP_KEY_LIMIT) {
+      tables->key_to_code[key_to_code[index].key] = key_to_code[index].value;
+    }
+  }
+  for (index = 0; index < hmlen(code_to_key); ++index) {
+    if (axidev_io_keymap_code_in_range(code_to_key[index].key)) {
+      tables->code_to_key[code_to_key[index].key] =
+          (uint16_t)code_to_key[index].value;
+    }
+  }
+  for (index = 0; index < hmlen(code_and_mods_to_key); ++index) {
+    uint32_t code = code_and_mods_to_key[index].key >> 8;
+    uint32_t combo = code_and_mods_to_key[index].key &
+                     (AXIDEV_IO_KEYMAP_MOD_COMBOS - 1u);
+
+    if (code < AXIDEV_IO_KEYMAP_CODE_LIMIT) {
+      tables->code_mods_to_key[code][combo] =
+          (uint16_t)code_and_mods_to_key[index].value;
+    }
   }
+  for (index = 0; index < hmlen(char_to_mapping); ++index) {
+    uint32_t codepoint = char_to_mapping[index].key;
+
+    if (codepoint < AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT) {
+      tables->fast_chars[codepoint] = char_to_mapping[index].value;
+      tables->fast_char_present[codepoint] = true;
+    } else {
+      hmput(tables->char_overflow, codepoint, char_to_mapping[index].value);
+    }
+    ++tables->char_count;
+  }
+
+  *out_tables = tables;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+void axidev_io_keymap_tables_free(axidev_io_keymap_tables **tables) {
+  if (tables == NULL || *tables == NULL) {
+    return;
+  }
+  hmfree((*tables)->char_overflow);
+  free(*tables);
+  *tables = NULL;
 }
 
-static void axidev_io_keymap_copy_int_key_mappings(
-    axidev_io_keymap_int_to_key_entry *source,
-    axidev_io_keymap_int_to_key_entry **destination) {
+bool axidev_io_keymap_tables_lookup_char(
+    const axidev_io_keymap_tables *tables, uint32_t codepoint,
+    axidev_io_keyboard_mapping_value *out_mapping) {
+  axidev_io_keymap_char_mapping_entry *overflow;
   ptrdiff_t index;
 
-  if (source == NULL) {
-    return;
+  if (tables == NULL) {
+    return false;
+  }
+  if (codepoint < AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT) {
+    if (!tables->fast_char_present[codepoint]) {
+      return false;
+    }
+    if (out_mapping != NULL) {
+      *out_mapping = tables->fast_chars[codepoint];
+    }
+    return true;
   }
 
-  for (index = 0; index < hmlen(source); ++index) {
-    hmput(*destination, source[index].key, source[index].value);
+  overflow = tables->char_overflow;
+  index = hmgeti(overflow, codepoint);
+  if (index < 0) {
+    return false;
+  }
+  if (out_mapping != NULL) {
+    *out_mapping = overflow[index].value;
   }
+  return true;
 }
 
-static void axidev_io_keymap_copy_uint_key_mappings(
-    axidev_io_keymap_uint_to_key_entry *source,
-    axidev_io_keymap_uint_to_key_entry **destination) {
-  ptrdiff_t index;
+static axidev_io_keyboard_key_t
+axidev_io_keymap_tables_base_key(const axidev_io_keymap_tables *tables,
+                                 int32_t keycode) {
+  uint16_t key;
 
-  if (source == NULL) {
-    return;
+  if (tables == NULL || !axidev_io_keymap_code_in_range(keycode)) {
+    return AXIDEV_IO_KEY_UNKNOWN;
   }
+  key = tables->code_to_key[keycode];
+  return key == AXIDEV_IO_KEYMAP_NO_KEY ? AXIDEV_IO_KEY_UNKNOWN
+                                        : (axidev_io_keyboard_key_t)key;
+}
 
-  for (index = 0; index < hmlen(source); ++index) {
-    hmput(*destination, source[index].key, source[index].value);
+axidev_io_keyboard_key_t
+axidev_io_keymap_tables_key_from_code(const axidev_io_keymap_tables *tables,
+                                      int32_t keycode,
+                                      axidev_io_keyboard_modifier_t mods) {
+  uint16_t key;
+
+  if (tables == NULL || !axidev_io_keymap_code_in_range(keycode)) {
+    return AXIDEV_IO_KEY_UNKNOWN;
+  }
+  key = tables->code_mods_to_key[keycode][axidev_io_keymap_mod_combo(mods)];
+  if (key != AXIDEV_IO_KEYMAP_NO_KEY) {
+    return (axidev_io_keyboard_key_t)key;
   }
+  return axidev_io_keymap_tables_base_key(tables, keycode);
 }
 
-static void axidev_io_keymap_copy_key_int_mappings(
-    axidev_io_keymap_key_to_int_entry *source,
-    axidev_io_keymap_key_to_int_entry **destination) {
-  ptrdiff_t index;
+/* Fills the ASCII taps of `set`, which must already be the active set. */
+static void
+axidev_io_keymap_fill_ascii_taps(axidev_io_keymap_layout_set *set) {
+  uint32_t codepoint;
 
-  if (source == NULL) {
-    return;
+  for (codepoint = 0; codepoint < AXIDEV_IO_KEYMAP_ASCII_LIMIT; ++codepoint) {
+    axidev_io_keymap_ascii_tap *tap = &set->ascii_taps[codepoint];
+    axidev_io_keyboard_key_with_modifier_t key_mod;
+    axidev_io_keyboard_key_t resolved_key;
+
+    memset(tap, 0, sizeof(*tap));
+    if (axidev_io_keymap_lookup_character(codepoint, &key_mod) !=
+            AXIDEV_IO_RESULT_OK ||
+        axidev_io_keymap_resolve_key_request(key_mod, &tap->keycode,
+                                             &tap->mods, &resolved_key) !=
+            AXIDEV_IO_RESULT_OK) {
+      continue;
+    }
+    tap->key = (uint16_t)resolved_key;
+    tap->present = true;
   }
+}
+
+/* What identifies the layout the platform currently uses. */
+typedef struct axidev_io_keymap_layout_key {
+#ifdef _WIN32
+  HKL hkl;
+#elif defined(__linux__)
+  axidev_io_xkb_rule_names_strings names;
+  uint32_t group;
+#else
+  char unused;
+#endif
+} axidev_io_keymap_layout_key;
+
+static void axidev_io_keymap_detect_layout(axidev_io_keymap_layout_key *key) {
+  memset(key, 0, sizeof(*key));
+#ifdef _WIN32
+  key->hkl = GetKeyboardLayout(0);
+#elif defined(__linux__)
+  key->names = axidev_io_detect_xkb_rule_names();
+  key->group = axidev_io_linux_layout_observed_group();
+#endif
+}
 
-  for (index = 0; index < hmlen(source); ++index) {
-    hmput(*destination, source[index].key, source[index].value);
+static bool
+axidev_io_keymap_layout_set_matches(const axidev_io_keymap_layout_set *set,
+                                    const axidev_io_keymap_layout_key *key) {
+#ifdef _WIN32
+  return set->hkl == (void *)key->hkl;
+#elif defined(__linux__)
+  return set->group == key->group &&
+         axidev_io_linux_rule_names_equal(&set->layout->names, &key->names);
+#else
+  (void)set;
+  (void)key;
+  return false;
+#endif
+}
+
+static void
+axidev_io_keymap_layout_set_free(axidev_io_keymap_layout_set *set) {
+  if (set == NULL) {
+    return;
   }
+#if defined(__linux__)
+  /* The compiled layout owns the tables. */
+  set->tables = NULL;
+  axidev_io_linux_layout_release(set->layout);
+#endif
+  axidev_io_keymap_tables_free(&set->tables);
+  free(set);
 }
 
-axidev_io_result axidev_io_keyboard_keymap_initialize(void) {
-  axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
+/* Builds the tables for `key`; the ASCII taps are filled once the set is
+   active. */
+static axidev_io_result
+axidev_io_keymap_layout_set_create(const char *operation,
+                                   const axidev_io_keymap_layout_key *key,
+                                   axidev_io_keymap_layout_set **out_set) {
+#if defined(_WIN32) || defined(__linux__)
+  axidev_io_keymap_layout_set *set;
+  axidev_io_result result = AXIDEV_IO_RESULT_OK;
 
-  axidev_io_keyboard_keymap_free();
-  memset(impl, 0, sizeof(*impl));
+  set = (axidev_io_keymap_layout_set *)calloc(1, sizeof(*set));
+  if (set == NULL) {
+    axidev_io_set_last_errorf("failed to allocate keymap tables");
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
 
 #ifdef _WIN32
   {
     axidev_io_windows_keymap windows_keymap;
-    memset(&windows_keymap, 0, sizeof(windows_keymap));
-    axidev_io_windows_keymap_init(&windows_keymap, GetKeyboardLayout(0));
-    axidev_io_keymap_copy_char_mappings(windows_keymap.char_to_keycode,
-                                        &impl->char_to_mapping);
-    axidev_io_keymap_copy_int_key_mappings(windows_keymap.vk_to_key,
-                                           &impl->code_to_key);
-    axidev_io_keymap_copy_uint_key_mappings(windows_keymap.vk_and_mods_to_key,
-                                            &impl->code_and_mods_to_key);
-    axidev_io_keymap_copy_key_int_mappings(windows_keymap.key_to_vk,
-                                           &impl->key_to_code);
-    axidev_io_windows_keymap_free(&windows_keymap);
-    axidev_io_global->keyboard.backend_type = AXIDEV_IO_BACKEND_WINDOWS;
-  }
-#elif defined(__linux__)
-  {
-    axidev_io_linux_keymap linux_keymap;
-    struct xkb_context *xkb_context = NULL;
-    struct xkb_keymap *xkb_keymap = NULL;
-    struct xkb_state *xkb_state = NULL;
-    memset(&linux_keymap, 0, sizeof(linux_keymap));
-    xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-    if (xkb_context == NULL) {
-      axidev_io_set_xkb_keymap_error("axidev_io_keyboard_initialize");
-      return AXIDEV_IO_RESULT_PLATFORM_ERROR;
-    }
+    char identity[AXIDEV_IO_KEYMAP_SNAPSHOT_IDENTITY_LEN];
 
-    {
-      axidev_io_xkb_rule_names_strings names =
-          axidev_io_detect_xkb_rule_names();
-      struct xkb_rule_names native_names;
-      memset(&native_names, 0, sizeof(native_names));
-      native_names.rules = names.rules[0] != '\0' ? names.rules : NULL;
-      native_names.model = names.model[0] != '\0' ? names.model : NULL;
-      native_names.layout = names.layout[0] != '\0' ? names.layout : NULL;
-      native_names.variant = names.variant[0] != '\0' ? names.variant : NULL;
-      native_names.options = names.options[0] != '\0' ? names.options : NULL;
-      xkb_keymap = xkb_keymap_new_from_names(
-          xkb_context, names.has_any ? &native_names : NULL,
-          XKB_KEYMAP_COMPILE_NO_FLAGS);
-      if (xkb_keymap == NULL) {
-        xkb_context_unref(xkb_context);
-        axidev_io_set_xkb_keymap_error("axidev_io_keyboard_initialize");
-        return AXIDEV_IO_RESULT_PLATFORM_ERROR;
-      }
-
-      xkb_state = xkb_state_new(xkb_keymap);
-      if (xkb_state == NULL) {
-        xkb_keymap_unref(xkb_keymap);
-        xkb_context_unref(xkb_context);
-        axidev_io_set_xkb_keymap_error("axidev_io_keyboard_initialize");
-        return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+    (void)operation;
+    set->hkl = (void *)key->hkl;
+    axidev_io_windows_layout_identity(key->hkl, identity, sizeof(identity));
+    if (axidev_io_keymap_snapshot_load(identity, &set->tables) ==
+        AXIDEV_IO_RESULT_OK) {
+      WORD vk_to_scan[256];
+
+      axidev_io_windows_fill_scan_codes(vk_to_scan, key->hkl);
+      memcpy(set->vk_to_scan, vk_to_scan, sizeof(set->vk_to_scan));
+    } else {
+      memset(&windows_keymap, 0, sizeof(windows_keymap));
+      axidev_io_windows_keymap_init(&windows_keymap, key->hkl);
+      result = axidev_io_keymap_tables_build(
+          &set->tables, windows_keymap.key_to_vk, windows_keymap.vk_to_key,
+          windows_keymap.vk_and_mods_to_key, windows_keymap.char_to_keycode);
+      memcpy(set->vk_to_scan, windows_keymap.vk_to_scan,
+             sizeof(set->vk_to_scan));
+      axidev_io_windows_keymap_free(&windows_keymap);
+      if (result == AXIDEV_IO_RESULT_OK) {
+        axidev_io_keymap_snapshot_store(identity, set->tables);
       }
     }
+  }
+#else
+  result = axidev_io_linux_layout_acquire_names(operation, &key->names, false,
+                                                &set->layout);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    set->group = key->group;
+    result = axidev_io_linux_layout_group_tables(operation, set->layout,
+                                                 key->group, &set->tables);
+  }
+#endif
 
-    axidev_io_linux_keymap_init(&linux_keymap, xkb_keymap, xkb_state);
-    axidev_io_keymap_copy_char_mappings(linux_keymap.char_to_keycode,
-                                        &impl->char_to_mapping);
-    axidev_io_keymap_copy_int_key_mappings(linux_keymap.evdev_to_key,
-                                           &impl->code_to_key);
-    axidev_io_keymap_copy_uint_key_mappings(linux_keymap.code_and_mods_to_key,
-                                            &impl->code_and_mods_to_key);
-    axidev_io_keymap_copy_key_int_mappings(linux_keymap.key_to_evdev,
-                                           &impl->key_to_code);
-    axidev_io_linux_keymap_free(&linux_keymap);
-    if (xkb_state != NULL) {
-      xkb_state_unref(xkb_state);
-    }
-    if (xkb_keymap != NULL) {
-      xkb_keymap_unref(xkb_keymap);
-    }
-    if (xkb_context != NULL) {
-      xkb_context_unref(xkb_context);
-    }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_keymap_layout_set_free(set);
+    return result;
   }
+  *out_set = set;
+  return AXIDEV_IO_RESULT_OK;
 #else
+  (void)operation;
+  (void)key;
+  (void)out_set;
   return AXIDEV_IO_RESULT_NOT_SUPPORTED;
 #endif
+}
+
+/* Moves `set` to the front of the recently used list and makes it active.
+   A new set that overflows the list releases the least recently used one. */
+static void
+axidev_io_keymap_activate(axidev_io_keyboard_keymap_impl *impl,
+                          axidev_io_keymap_layout_set *set) {
+  size_t index = impl->recent_count;
+  size_t i;
+
+  for (i = 0; i < impl->recent_count; ++i) {
+    if (impl->recent[i] == set) {
+      index = i;
+      break;
+    }
+  }
+  if (index == impl->recent_count) {
+    if (impl->recent_count == AXIDEV_IO_KEYMAP_RECENT_LAYOUTS) {
+      --index;
+      axidev_io_keymap_layout_set_free(impl->recent[index]);
+    } else {
+      ++impl->recent_count;
+    }
+  }
+  memmove(&impl->recent[1], &impl->recent[0], index * sizeof(impl->recent[0]));
+  impl->recent[0] = set;
+  impl->active = set;
+}
+
+axidev_io_result axidev_io_keyboard_keymap_initialize(void) {
+  axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
+  axidev_io_keymap_layout_key key;
+  axidev_io_keymap_layout_set *set = NULL;
+  axidev_io_result result;
+
+  axidev_io_keyboard_keymap_free();
+  memset(impl, 0, sizeof(*impl));
+
+  axidev_io_keymap_detect_layout(&key);
+  result = axidev_io_keymap_layout_set_create("axidev_io_keyboard_initialize",
+                                              &key, &set);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+#ifdef _WIN32
+  axidev_io_global->keyboard.backend_type = AXIDEV_IO_BACKEND_WINDOWS;
+#endif
 
   axidev_io_keymap_public_context()->initialized = true;
-  AXIDEV_IO_LOG_DEBUG("keymap initialized: char=%td code=%td code+mods=%td "
-                      "key=%td",
-                      hmlen(impl->char_to_mapping), hmlen(impl->code_to_key),
-                      hmlen(impl->code_and_mods_to_key),
-                      hmlen(impl->key_to_code));
+  axidev_io_keymap_activate(impl, set);
+  axidev_io_keymap_fill_ascii_taps(set);
+  atomic_fetch_add(&g_keymap_generation, 1u);
+  AXIDEV_IO_LOG_DEBUG("keymap initialized: chars=%zu (%td outside the fast "
+                      "table)",
+                      set->tables->char_count,
+                      hmlen(set->tables->char_overflow));
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result axidev_io_keymap_refresh(bool *out_changed) {
+  axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
+  axidev_io_keymap_layout_key key;
+  axidev_io_keymap_layout_set *set = NULL;
+  bool built = false;
+  size_t i;
+
+  if (out_changed != NULL) {
+    *out_changed = false;
+  }
+  if (!axidev_io_keymap_public_context()->initialized) {
+    return AXIDEV_IO_RESULT_NOT_INITIALIZED;
+  }
+
+  axidev_io_keymap_detect_layout(&key);
+  if (axidev_io_keymap_layout_set_matches(impl->active, &key)) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  for (i = 1; i < impl->recent_count; ++i) {
+    if (axidev_io_keymap_layout_set_matches(impl->recent[i], &key)) {
+      set = impl->recent[i];
+      break;
+    }
+  }
+  if (set == NULL) {
+    axidev_io_result result = axidev_io_keymap_layout_set_create(
+        "axidev_io_keyboard_refresh_layout", &key, &set);
+
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
+    }
+    built = true;
+  }
+
+  axidev_io_keymap_activate(impl, set);
+  if (built) {
+    axidev_io_keymap_fill_ascii_taps(set);
+  }
+  atomic_fetch_add(&g_keymap_generation, 1u);
+  AXIDEV_IO_LOG_DEBUG("keymap switched to a %s layout (%zu cached)",
+                      built ? "new" : "recently used", impl->recent_count);
+  if (out_changed != NULL) {
+    *out_changed = true;
+  }
   return AXIDEV_IO_RESULT_OK;
 }
 
+uint64_t axidev_io_keymap_generation(void) {
+  return (uint64_t)atomic_load(&g_keymap_generation);
+}
+
 void axidev_io_keyboard_keymap_free(void) {
   axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
+  size_t i;
 
-  hmfree(impl->char_to_mapping);
-  hmfree(impl->code_to_key);
-  hmfree(impl->code_and_mods_to_key);
-  hmfree(impl->key_to_code);
+  for (i = 0; i < impl->recent_count; ++i) {
+    axidev_io_keymap_layout_set_free(impl->recent[i]);
+  }
   memset(impl, 0, sizeof(*impl));
   axidev_io_keymap_public_context()->initialized = false;
 }
 
+const axidev_io_keymap_ascii_tap *axidev_io_keymap_ascii_taps(void) {
+  if (!axidev_io_keymap_public_context()->initialized) {
+    return NULL;
+  }
+  return axidev_io_keymap_impl_get()->active->ascii_taps;
+}
+
 axidev_io_result axidev_io_keymap_lookup_character(
     uint32_t codepoint, axidev_io_keyboard_key_with_modifier_t *out_key) {
   axidev_io_keyboard_keymap_lookup mapping;
@@ -234,7 +489,7 @@ axidev_io_result
 axidev_io_keymap_lookup_mapping(uint32_t codepoint,
                                 axidev_io_keyboard_keymap_lookup *out_mapping) {
   axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
-  ptrdiff_t index;
+  axidev_io_keyboard_mapping_value value;
 
   if (out_mapping == NULL) {
     return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
@@ -244,14 +499,14 @@ axidev_io_keymap_lookup_mapping(uint32_t codepoint,
     return AXIDEV_IO_RESULT_NOT_INITIALIZED;
   }
 
-  index = hmgeti(impl->char_to_mapping, codepoint);
-  if (index < 0) {
+  if (!axidev_io_keymap_tables_lookup_char(impl->active->tables, codepoint,
+                                           &value)) {
     return AXIDEV_IO_RESULT_NOT_FOUND;
   }
 
-  out_mapping->keycode = impl->char_to_mapping[index].value.keycode;
-  out_mapping->required_mods = impl->char_to_mapping[index].value.required_mods;
-  out_mapping->produced_key = impl->char_to_mapping[index].value.produced_key;
+  out_mapping->keycode = value.keycode;
+  out_mapping->required_mods = value.required_mods;
+  out_mapping->produced_key = value.produced_key;
 
   if (out_mapping->produced_key == AXIDEV_IO_KEY_UNKNOWN &&
       out_mapping->keycode >= 0) {
@@ -270,8 +525,7 @@ axidev_io_keymap_key_from_code(int32_t keycode,
                                axidev_io_keyboard_modifier_t mods,
                                axidev_io_keyboard_key_t *out_key) {
   axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
-  uint32_t encoded_code_mods;
-  ptrdiff_t index;
+  axidev_io_keyboard_key_t key;
 
   if (out_key == NULL) {
     return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
@@ -281,21 +535,21 @@ axidev_io_keymap_key_from_code(int32_t keycode,
     return AXIDEV_IO_RESULT_NOT_INITIALIZED;
   }
 
-  encoded_code_mods = axidev_io_keymap_encode_code_mods(keycode, mods);
-  index = hmgeti(impl->code_and_mods_to_key, encoded_code_mods);
-  if (index >= 0) {
-    *out_key = impl->code_and_mods_to_key[index].value;
-    return AXIDEV_IO_RESULT_OK;
+  key = axidev_io_keymap_tables_key_from_code(impl->active->tables, keycode,
+                                              mods);
+  if (key == AXIDEV_IO_KEY_UNKNOWN) {
+    return AXIDEV_IO_RESULT_NOT_FOUND;
   }
 
-  return axidev_io_keymap_base_key_from_code(keycode, out_key);
+  *out_key = key;
+  return AXIDEV_IO_RESULT_OK;
 }
 
 axidev_io_result
 axidev_io_keymap_base_key_from_code(int32_t keycode,
                                     axidev_io_keyboard_key_t *out_key) {
   axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
-  ptrdiff_t index;
+  axidev_io_keyboard_key_t key;
 
   if (out_key == NULL) {
     return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
@@ -305,20 +559,20 @@ axidev_io_keymap_base_key_from_code(int32_t keycode,
     return AXIDEV_IO_RESULT_NOT_INITIALIZED;
   }
 
-  index = hmgeti(impl->code_to_key, keycode);
-  if (index < 0) {
+  key = axidev_io_keymap_tables_base_key(impl->active->tables, keycode);
+  if (key == AXIDEV_IO_KEY_UNKNOWN) {
     return AXIDEV_IO_RESULT_NOT_FOUND;
   }
 
-  *out_key = impl->code_to_key[index].value;
+  *out_key = key;
   return AXIDEV_IO_RESULT_OK;
 }
 
 axidev_io_result axidev_io_keymap_code_for_key(axidev_io_keyboard_key_t key,
                                                int32_t *out_keycode) {
   axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
+  const axidev_io_keymap_tables *tables;
   uint32_t key_id;
-  ptrdiff_t index;
 
   if (out_keycode == NULL) {
     return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
@@ -328,13 +582,14 @@ axidev_io_result axidev_io_keymap_code_for_key(axidev_io_keyboard_key_t key,
     return AXIDEV_IO_RESULT_NOT_INITIALIZED;
   }
 
+  tables = impl->active->tables;
   key_id = (uint32_t)key;
-  index = hmgeti(impl->key_to_code, key_id);
-  if (index < 0) {
+  if (key_id >= AXIDEV_IO_KEYMAP_KEY_LIMIT ||
+      tables->key_to_code[key_id] == AXIDEV_IO_KEYMAP_NO_CODE) {
     return AXIDEV_IO_RESULT_NOT_FOUND;
   }
 
-  *out_keycode = impl->key_to_code[index].value;
+  *out_keycode = tables->key_to_code[key_id];
   return AXIDEV_IO_RESULT_OK;
 }
 
@@ -375,7 +630,8 @@ axidev_io_result axidev_io_keymap_resolve_key_request(
 bool axidev_io_keymap_can_type_character(uint32_t codepoint) {
   axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
   return axidev_io_keymap_public_context()->initialized &&
-         hmgeti(impl->char_to_mapping, codepoint) >= 0;
+         axidev_io_keymap_tables_lookup_char(impl->active->tables, codepoint,
+                                             NULL);
 }
 
 bool axidev_io_keyboard_key_to_codepoint(axidev_io_keyboard_key_t key,
@@ -37,13 +37,79 @@ typedef struct axidev_io_keymap_key_to_int_entry {
   int32_t value;
 } axidev_io_keymap_key_to_int_entry;
 
+/* Platform codes stay below this bound: evdev codes are < KEY_MAX (0x2ff) and
+   Windows virtual keys are < 256. */
+#define AXIDEV_IO_KEYMAP_CODE_LIMIT 0x300u
+#define AXIDEV_IO_KEYMAP_KEY_LIMIT ((uint32_t)AXIDEV_IO_KEY_RF_KILL + 1u)
+/* Shift, Ctrl and Alt are the modifiers that select a layout level. */
+#define AXIDEV_IO_KEYMAP_MOD_COMBOS 8u
+#define AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT 256u
+#define AXIDEV_IO_KEYMAP_NO_KEY UINT16_MAX
+#define AXIDEV_IO_KEYMAP_NO_CODE (-1)
+
+/* Direct-indexed form of a platform keymap, built once from the platform
+   hashmaps. Codepoints below AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT are looked up
+   in a flat table; the rest of Unicode falls back to `char_overflow`. */
+typedef struct axidev_io_keymap_tables {
+  int32_t key_to_code[AXIDEV_IO_KEYMAP_KEY_LIMIT];
+  uint16_t code_to_key[AXIDEV_IO_KEYMAP_CODE_LIMIT];
+  uint16_t code_mods_to_key[AXIDEV_IO_KEYMAP_CODE_LIMIT]
+                           [AXIDEV_IO_KEYMAP_MOD_COMBOS];
+  axidev_io_keyboard_mapping_value fast_chars[AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT];
+  bool fast_char_present[AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT];
+  axidev_io_keymap_char_mapping_entry *char_overflow;
+  size_t char_count;
+} axidev_io_keymap_tables;
+
+#define AXIDEV_IO_KEYMAP_ASCII_LIMIT 128u
+
+/* A character resolved all the way to the tap that types it. `present` is
+   false when typing it needs the general path (Unicode fallback or an
+   error). */
+typedef struct axidev_io_keymap_ascii_tap {
+  int32_t keycode;
+  uint16_t key;
+  axidev_io_keyboard_modifier_t mods;
+  bool present;
+} axidev_io_keymap_ascii_tap;
+
+/* Layouts whose table sets stay built after the user switches away. */
+#define AXIDEV_IO_KEYMAP_RECENT_LAYOUTS 4u
+
+/* Everything the keymap resolves for one platform layout. A set is built
+   the first time its layout is detected and kept while it is among the
+   recently used ones, so switching back to it only swaps a pointer. */
+typedef struct axidev_io_keymap_layout_set {
+  axidev_io_keymap_tables *tables;
+  /* What axidev_io_keymap_lookup_character() followed by
+     axidev_io_keymap_resolve_key_request() yields for each ASCII character,
+     filled when the set is built so text runs skip both calls. */
+  axidev_io_keymap_ascii_tap ascii_taps[AXIDEV_IO_KEYMAP_ASCII_LIMIT];
+#ifdef _WIN32
+  /* HKL the set was built for. */
+  void *hkl;
+  uint16_t vk_to_scan[256];
+#elif defined(__linux__)
+  /* Shared compiled layout that owns `tables`, and the XKB group they
+     resolve. */
+  struct axidev_io_linux_compiled_layout *layout;
+  uint32_t group;
+#endif
+} axidev_io_keymap_layout_set;
+
 typedef struct axidev_io_keyboard_keymap_impl {
-  axidev_io_keymap_char_mapping_entry *char_to_mapping;
-  axidev_io_keymap_int_to_key_entry *code_to_key;
-  axidev_io_keymap_uint_to_key_entry *code_and_mods_to_key;
-  axidev_io_keymap_key_to_int_entry *key_to_code;
+  /* The set lookups read; always `recent[0]`. Only swapped under the
+     context lock, like every other keymap access from the sender. */
+  axidev_io_keymap_layout_set *active;
+  /* Most recently used first. */
+  axidev_io_keymap_layout_set *recent[AXIDEV_IO_KEYMAP_RECENT_LAYOUTS];
+  size_t recent_count;
 } axidev_io_keyboard_keymap_impl;
 
+_Static_assert(sizeof(axidev_io_keyboard_keymap_impl) <=
+                   AXIDEV_IO_KEYBOARD_KEYMAP_STORAGE_SIZE,
+               "keymap storage is too small");
+
 typedef struct axidev_io_keyboard_keymap_lookup {
   int32_t keycode;
   axidev_io_keyboard_modifier_t required_mods;
@@ -54,11 +120,22 @@ axidev_io_keyboard_keymap_impl *axidev_io_keymap_impl_get(void);
 
 axidev_io_result axidev_io_keyboard_keymap_initialize(void);
 void axidev_io_keyboard_keymap_free(void);
+/* Incremented by every successful initialize and layout switch; anything
+   resolved against the keymap can compare it to detect either. Listener
+   threads read it without the context lock. */
+uint64_t axidev_io_keymap_generation(void);
+/* Re-detects the platform layout (the thread's HKL on Windows, the XKB rule
+   names and the group axidev_io_linux_layout_observed_group() reports on
+   Linux) and makes its table set active, reusing a recently used set when
+   one matches. `out_changed` may be NULL. */
+axidev_io_result axidev_io_keymap_refresh(bool *out_changed);
 
 #if defined(__linux__)
 void axidev_io_set_xkb_keymap_error(const char *operation);
 #endif
 
+/* The ASCII tap table of the active keymap, or NULL before initialize. */
+const axidev_io_keymap_ascii_tap *axidev_io_keymap_ascii_taps(void);
 axidev_io_result axidev_io_keymap_lookup_character(
     uint32_t codepoint, axidev_io_keyboard_key_with_modifier_t *out_key);
 axidev_io_result
@@ -81,6 +158,23 @@ bool axidev_io_keymap_can_type_character(uint32_t codepoint);
 uint32_t axidev_io_keymap_encode_code_mods(int32_t keycode,
                                            axidev_io_keyboard_modifier_t mods);
 
+axidev_io_result axidev_io_keymap_tables_build(
+    axidev_io_keymap_tables **out_tables,
+    const axidev_io_keymap_key_to_int_entry *key_to_code,
+    const axidev_io_keymap_int_to_key_entry *code_to_key,
+    const axidev_io_keymap_uint_to_key_entry *code_and_mods_to_key,
+    const axidev_io_keymap_char_mapping_entry *char_to_mapping);
+void axidev_io_keymap_tables_free(axidev_io_keymap_tables **tables);
+bool axidev_io_keymap_tables_lookup_char(
+    const axidev_io_keymap_tables *tables, uint32_t codepoint,
+    axidev_io_keyboard_mapping_value *out_mapping);
+/* Level-specific key for `keycode` under `mods`, falling back to the base
+   key; AXIDEV_IO_KEY_UNKNOWN when the code is unmapped. */
+axidev_io_keyboard_key_t
+axidev_io_keymap_tables_key_from_code(const axidev_io_keymap_tables *tables,
+                                      int32_t keycode,
+                                      axidev_io_keyboard_modifier_t mods);
+
 bool axidev_io_keyboard_key_to_codepoint(axidev_io_keyboard_key_t key,
                                          uint32_t *out_codepoint);
 
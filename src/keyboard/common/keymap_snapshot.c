@@ -0,0 +1,467 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "keymap_snapshot_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define AXIDEV_IO_KEYMAP_SNAPSHOT_PREFIX "axidev-io-keymap-"
+#define AXIDEV_IO_KEYMAP_SNAPSHOT_SUFFIX ".bin"
+
+/* Everything before `char_overflow` is plain arrays and is stored as is. */
+#define AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE                                  \
+  offsetof(axidev_io_keymap_tables, char_overflow)
+
+typedef struct axidev_io_keymap_snapshot_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t tables_size;
+  uint32_t entry_size;
+  uint32_t overflow_count;
+  uint64_t char_count;
+  uint64_t checksum;
+  char identity[AXIDEV_IO_KEYMAP_SNAPSHOT_IDENTITY_LEN];
+} axidev_io_keymap_snapshot_header;
+
+static const char g_snapshot_magic[8] = {'A', 'X', 'I', 'O',
+                                         'K', 'M', 'A', 'P'};
+
+static axidev_io_once g_snapshot_once = AXIDEV_IO_ONCE_INIT;
+static axidev_io_mutex g_snapshot_lock;
+static char *g_snapshot_directory = NULL;
+
+static void axidev_io_keymap_snapshot_init_once(void) {
+  axidev_io_mutex_init(&g_snapshot_lock);
+}
+
+uint64_t axidev_io_fnv1a(uint64_t hash, const void *data, size_t len) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  size_t i;
+
+  for (i = 0; i < len; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static uint64_t axidev_io_keymap_snapshot_checksum(
+    const char *identity, const void *tables, const void *entries,
+    size_t entries_size) {
+  uint64_t hash = AXIDEV_IO_FNV1A_SEED;
+
+  hash = axidev_io_fnv1a(hash, identity, strlen(identity));
+  hash = axidev_io_fnv1a(hash, tables, AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE);
+  return axidev_io_fnv1a(hash, entries, entries_size);
+}
+
+/* Returns a heap path for `identity`, or NULL when snapshots are disabled. */
+static char *axidev_io_keymap_snapshot_path(const char *identity,
+                                            const char *suffix) {
+  char *path = NULL;
+
+  axidev_io_call_once(&g_snapshot_once, axidev_io_keymap_snapshot_init_once);
+  axidev_io_mutex_lock(&g_snapshot_lock);
+  if (g_snapshot_directory != NULL) {
+    uint64_t name_hash =
+        axidev_io_fnv1a(AXIDEV_IO_FNV1A_SEED, identity, strlen(identity));
+    size_t len = strlen(g_snapshot_directory) + 96u;
+
+    path = (char *)malloc(len);
+    if (path != NULL) {
+      snprintf(path, len, "%s/" AXIDEV_IO_KEYMAP_SNAPSHOT_PREFIX "%016llx%s",
+               g_snapshot_directory, (unsigned long long)name_hash, suffix);
+    }
+  }
+  axidev_io_mutex_unlock(&g_snapshot_lock);
+  return path;
+}
+
+axidev_io_result axidev_io_keymap_snapshot_set_directory(const char *path) {
+  char *copy = NULL;
+  size_t len;
+
+  if (path != NULL && path[0] != '\0') {
+    copy = axidev_io_duplicate_string(path);
+    if (copy == NULL) {
+      return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+    }
+    len = strlen(copy);
+    while (len > 1 && (copy[len - 1] == '/' || copy[len - 1] == '\\')) {
+      copy[--len] = '\0';
+    }
+#ifdef _WIN32
+    _mkdir(copy);
+#else
+    mkdir(copy, 0700);
+#endif
+  }
+
+  axidev_io_call_once(&g_snapshot_once, axidev_io_keymap_snapshot_init_once);
+  axidev_io_mutex_lock(&g_snapshot_lock);
+  free(g_snapshot_directory);
+  g_snapshot_directory = copy;
+  axidev_io_mutex_unlock(&g_snapshot_lock);
+  return AXIDEV_IO_RESULT_OK;
+}
+
+static bool axidev_io_keymap_snapshot_is_file_name(const char *name) {
+  size_t len = strlen(name);
+  size_t prefix_len = strlen(AXIDEV_IO_KEYMAP_SNAPSHOT_PREFIX);
+  size_t suffix_len = strlen(AXIDEV_IO_KEYMAP_SNAPSHOT_SUFFIX);
+
+  return len > prefix_len + suffix_len &&
+         strncmp(name, AXIDEV_IO_KEYMAP_SNAPSHOT_PREFIX, prefix_len) == 0 &&
+         strcmp(name + len - suffix_len, AXIDEV_IO_KEYMAP_SNAPSHOT_SUFFIX) ==
+             0;
+}
+
+axidev_io_result axidev_io_keymap_snapshot_invalidate(void) {
+  axidev_io_result result = AXIDEV_IO_RESULT_OK;
+  char path[4096];
+
+  axidev_io_call_once(&g_snapshot_once, axidev_io_keymap_snapshot_init_once);
+  axidev_io_mutex_lock(&g_snapshot_lock);
+  if (g_snapshot_directory == NULL) {
+    axidev_io_mutex_unlock(&g_snapshot_lock);
+    return AXIDEV_IO_RESULT_OK;
+  }
+
+#ifdef _WIN32
+  {
+    WIN32_FIND_DATAA entry;
+    HANDLE find;
+
+    snprintf(path, sizeof(path), "%s\\" AXIDEV_IO_KEYMAP_SNAPSHOT_PREFIX "*",
+             g_snapshot_directory);
+    find = FindFirstFileA(path, &entry);
+    if (find != INVALID_HANDLE_VALUE) {
+      do {
+        if (axidev_io_keymap_snapshot_is_file_name(entry.cFileName)) {
+          snprintf(path, sizeof(path), "%s\\%s", g_snapshot_directory,
+                   entry.cFileName);
+          if (!DeleteFileA(path)) {
+            result = AXIDEV_IO_RESULT_PLATFORM_ERROR;
+          }
+        }
+      } while (FindNextFileA(find, &entry));
+      FindClose(find);
+    }
+  }
+#else
+  {
+    DIR *directory = opendir(g_snapshot_directory);
+    struct dirent *entry;
+
+    if (directory != NULL) {
+      while ((entry = readdir(directory)) != NULL) {
+        if (axidev_io_keymap_snapshot_is_file_name(entry->d_name)) {
+          snprintf(path, sizeof(path), "%s/%s", g_snapshot_directory,
+                   entry->d_name);
+          if (unlink(path) != 0) {
+            result = AXIDEV_IO_RESULT_PLATFORM_ERROR;
+          }
+        }
+      }
+      closedir(directory);
+    }
+  }
+#endif
+  axidev_io_mutex_unlock(&g_snapshot_lock);
+
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_set_last_errorf("failed to remove one or more keymap snapshots");
+  }
+  return result;
+}
+
+/* Modifier bits a stored character mapping may require. */
+#define AXIDEV_IO_KEYMAP_SNAPSHOT_MOD_MASK                                     \
+  (AXIDEV_IO_MOD_SHIFT | AXIDEV_IO_MOD_CTRL | AXIDEV_IO_MOD_ALT |              \
+   AXIDEV_IO_MOD_SUPER | AXIDEV_IO_MOD_CAPSLOCK | AXIDEV_IO_MOD_NUMLOCK)
+
+static bool axidev_io_keymap_snapshot_key_valid(uint32_t key) {
+  return key < AXIDEV_IO_KEYMAP_KEY_LIMIT;
+}
+
+static bool axidev_io_keymap_snapshot_code_valid(int32_t code) {
+  return code >= 0 && (uint32_t)code < AXIDEV_IO_KEYMAP_CODE_LIMIT;
+}
+
+static bool axidev_io_keymap_snapshot_mapping_valid(
+    const axidev_io_keyboard_mapping_value *mapping) {
+  return axidev_io_keymap_snapshot_code_valid(mapping->keycode) &&
+         ((uint32_t)mapping->required_mods &
+          ~(uint32_t)AXIDEV_IO_KEYMAP_SNAPSHOT_MOD_MASK) == 0 &&
+         axidev_io_keymap_snapshot_key_valid(
+             (uint32_t)mapping->produced_key);
+}
+
+/* A checksum only proves the file is intact, not that it came from this
+   build, so every value that later indexes a direct table is range-checked
+   before the tables are used. */
+static bool
+axidev_io_keymap_snapshot_tables_valid(const axidev_io_keymap_tables *tables) {
+  const unsigned char *present =
+      (const unsigned char *)tables->fast_char_present;
+  size_t i;
+  size_t combo;
+
+  for (i = 0; i < AXIDEV_IO_KEYMAP_KEY_LIMIT; ++i) {
+    if (tables->key_to_code[i] != AXIDEV_IO_KEYMAP_NO_CODE &&
+        !axidev_io_keymap_snapshot_code_valid(tables->key_to_code[i])) {
+      return false;
+    }
+  }
+  for (i = 0; i < AXIDEV_IO_KEYMAP_CODE_LIMIT; ++i) {
+    if (tables->code_to_key[i] != AXIDEV_IO_KEYMAP_NO_KEY &&
+        !axidev_io_keymap_snapshot_key_valid(tables->code_to_key[i])) {
+      return false;
+    }
+    for (combo = 0; combo < AXIDEV_IO_KEYMAP_MOD_COMBOS; ++combo) {
+      uint16_t key = tables->code_mods_to_key[i][combo];
+      if (key != AXIDEV_IO_KEYMAP_NO_KEY &&
+          !axidev_io_keymap_snapshot_key_valid(key)) {
+        return false;
+      }
+    }
+  }
+  for (i = 0; i < AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT; ++i) {
+    if (present[i] > 1u) {
+      return false;
+    }
+    if (present[i] != 0u &&
+        !axidev_io_keymap_snapshot_mapping_valid(&tables->fast_chars[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool axidev_io_keymap_snapshot_entry_valid(
+    const axidev_io_keymap_char_mapping_entry *entry) {
+  return entry->key >= AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT &&
+         entry->key <= 0x10FFFFu &&
+         axidev_io_keymap_snapshot_mapping_valid(&entry->value);
+}
+
+/* Copies a validated mapped image into freshly allocated tables. Returns
+   NOT_FOUND for anything that does not verify, so the caller rebuilds. */
+static axidev_io_result
+axidev_io_keymap_snapshot_decode(const char *identity,
+                                 const unsigned char *data, size_t size,
+                                 axidev_io_keymap_tables **out_tables) {
+  const axidev_io_keymap_snapshot_header *header;
+  const unsigned char *tables_data;
+  const axidev_io_keymap_char_mapping_entry *entries;
+  axidev_io_keymap_tables *tables;
+  size_t entries_size;
+  uint32_t i;
+
+  if (size < sizeof(*header)) {
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+  header = (const axidev_io_keymap_snapshot_header *)data;
+  if (memcmp(header->magic, g_snapshot_magic, sizeof(g_snapshot_magic)) != 0 ||
+      header->version != AXIDEV_IO_KEYMAP_SNAPSHOT_VERSION ||
+      header->tables_size != AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE ||
+      header->entry_size != sizeof(*entries) ||
+      strncmp(header->identity, identity, sizeof(header->identity)) != 0) {
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+  entries_size = (size_t)header->overflow_count * sizeof(*entries);
+  if (size != sizeof(*header) + AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE +
+                  entries_size) {
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+
+  tables_data = data + sizeof(*header);
+  entries = (const axidev_io_keymap_char_mapping_entry
+                 *)(tables_data + AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE);
+  if (axidev_io_keymap_snapshot_checksum(identity, tables_data, entries,
+                                         entries_size) != header->checksum) {
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+
+  tables = (axidev_io_keymap_tables *)calloc(1, sizeof(*tables));
+  if (tables == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  memcpy(tables, tables_data, AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE);
+  if (!axidev_io_keymap_snapshot_tables_valid(tables) ||
+      header->char_count >
+          (uint64_t)AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT + header->overflow_count) {
+    free(tables);
+    AXIDEV_IO_LOG_DEBUG("keymap snapshot has out-of-range entries");
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+  for (i = 0; i < header->overflow_count; ++i) {
+    axidev_io_keymap_char_mapping_entry entry;
+
+    memcpy(&entry, &entries[i], sizeof(entry));
+    if (!axidev_io_keymap_snapshot_entry_valid(&entry)) {
+      axidev_io_keymap_tables_free(&tables);
+      AXIDEV_IO_LOG_DEBUG("keymap snapshot has out-of-range entries");
+      return AXIDEV_IO_RESULT_NOT_FOUND;
+    }
+    hmput(tables->char_overflow, entry.key, entry.value);
+  }
+  tables->char_count = (size_t)header->char_count;
+  *out_tables = tables;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_keymap_snapshot_load(const char *identity,
+                               axidev_io_keymap_tables **out_tables) {
+  axidev_io_result result = AXIDEV_IO_RESULT_NOT_FOUND;
+  char *path;
+
+  if (identity == NULL || out_tables == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  path = axidev_io_keymap_snapshot_path(identity,
+                                        AXIDEV_IO_KEYMAP_SNAPSHOT_SUFFIX);
+  if (path == NULL) {
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+
+#ifdef _WIN32
+  {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+      LARGE_INTEGER file_size;
+      HANDLE mapping = NULL;
+      const void *view = NULL;
+
+      if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+      }
+      if (mapping != NULL) {
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      }
+      if (view != NULL) {
+        result = axidev_io_keymap_snapshot_decode(
+            identity, (const unsigned char *)view, (size_t)file_size.QuadPart,
+            out_tables);
+        UnmapViewOfFile(view);
+      }
+      if (mapping != NULL) {
+        CloseHandle(mapping);
+      }
+      CloseHandle(file);
+    }
+  }
+#else
+  {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      struct stat info;
+
+      if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE,
+                          fd, 0);
+        if (view != MAP_FAILED) {
+          result = axidev_io_keymap_snapshot_decode(
+              identity, (const unsigned char *)view, (size_t)info.st_size,
+              out_tables);
+          munmap(view, (size_t)info.st_size);
+        }
+      }
+      close(fd);
+    }
+  }
+#endif
+
+  if (result == AXIDEV_IO_RESULT_OK) {
+    AXIDEV_IO_LOG_DEBUG("loaded keymap snapshot %s", path);
+  }
+  free(path);
+  return result;
+}
+
+void axidev_io_keymap_snapshot_store(const char *identity,
+                                     const axidev_io_keymap_tables *tables) {
+  axidev_io_keymap_snapshot_header header;
+  axidev_io_keymap_char_mapping_entry *overflow;
+  char *path;
+  char *temp_path;
+  char temp_suffix[48];
+  FILE *file;
+  bool written;
+
+  if (identity == NULL || tables == NULL ||
+      strlen(identity) >= sizeof(header.identity)) {
+    return;
+  }
+#ifdef _WIN32
+  snprintf(temp_suffix, sizeof(temp_suffix), ".%d.tmp", _getpid());
+#else
+  snprintf(temp_suffix, sizeof(temp_suffix), ".%ld.tmp", (long)getpid());
+#endif
+  path = axidev_io_keymap_snapshot_path(identity,
+                                        AXIDEV_IO_KEYMAP_SNAPSHOT_SUFFIX);
+  temp_path = axidev_io_keymap_snapshot_path(identity, temp_suffix);
+  if (path == NULL || temp_path == NULL) {
+    free(path);
+    free(temp_path);
+    return;
+  }
+
+  overflow = tables->char_overflow;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, g_snapshot_magic, sizeof(header.magic));
+  header.version = AXIDEV_IO_KEYMAP_SNAPSHOT_VERSION;
+  header.tables_size = (uint32_t)AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE;
+  header.entry_size = (uint32_t)sizeof(*overflow);
+  header.overflow_count = (uint32_t)hmlen(overflow);
+  header.char_count = (uint64_t)tables->char_count;
+  header.checksum = axidev_io_keymap_snapshot_checksum(
+      identity, tables, overflow,
+      (size_t)header.overflow_count * sizeof(*overflow));
+  snprintf(header.identity, sizeof(header.identity), "%s", identity);
+
+  /* Written to a private name and renamed so readers never map a partial
+     file. */
+  file = fopen(temp_path, "wb");
+  written = file != NULL &&
+            fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(tables, AXIDEV_IO_KEYMAP_SNAPSHOT_TABLES_SIZE, 1, file) ==
+                1 &&
+            (header.overflow_count == 0 ||
+             fwrite(overflow, sizeof(*overflow), header.overflow_count,
+                    file) == header.overflow_count);
+  if (file != NULL && fclose(file) != 0) {
+    written = false;
+  }
+#ifdef _WIN32
+  written = written &&
+            MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  written = written && rename(temp_path, path) == 0;
+#endif
+  if (!written) {
+    remove(temp_path);
+    AXIDEV_IO_LOG_DEBUG("could not write keymap snapshot %s", path);
+  }
+  free(path);
+  free(temp_path);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_KEYMAP_SNAPSHOT_INTERNAL_H
+#define AXIDEV_IO_KEYBOARD_KEYMAP_SNAPSHOT_INTERNAL_H
+
+#include "keymap_internal.h"
+
+/* Bump whenever axidev_io_keymap_tables or the file layout changes. */
+#define AXIDEV_IO_KEYMAP_SNAPSHOT_VERSION 1u
+#define AXIDEV_IO_KEYMAP_SNAPSHOT_IDENTITY_LEN 512u
+/* Initial value for axidev_io_fnv1a(). */
+#define AXIDEV_IO_FNV1A_SEED 0xcbf29ce484222325ull
+
+/* Persistent copies of resolved keymap tables, one file per layout identity
+   (XKB rule names or HKL, each with a fingerprint of the layout data behind
+   it) inside a caller-chosen directory. Snapshots are
+   disabled until a directory is set. */
+axidev_io_result axidev_io_keymap_snapshot_set_directory(const char *path);
+/* 64-bit FNV-1a of `len` bytes, continuing from `hash`. */
+uint64_t axidev_io_fnv1a(uint64_t hash, const void *data, size_t len);
+/* Deletes every snapshot in the configured directory. */
+axidev_io_result axidev_io_keymap_snapshot_invalidate(void);
+/* NOT_FOUND covers a disabled cache, a missing file, and a file that fails
+   validation; callers rebuild the tables in every case. */
+axidev_io_result
+axidev_io_keymap_snapshot_load(const char *identity,
+                               axidev_io_keymap_tables **out_tables);
+/* Best effort: failures are logged and otherwise ignored. */
+void axidev_io_keymap_snapshot_store(const char *identity,
+                                     const axidev_io_keymap_tables *tables);
+
+#endif
@@ -272,6 +272,7 @@ void axidev_io_linux_keymap_init(axidev_io_linux_keymap *out_keymap,
                                  struct xkb_state *state) {
   xkb_keycode_t min_key;
   xkb_keycode_t max_key;
+  xkb_layout_index_t group;
 
   if (out_keymap == NULL) {
     return;
@@ -285,6 +286,8 @@ void axidev_io_linux_keymap_init(axidev_io_linux_keymap *out_keymap,
 
   min_key = xkb_keymap_min_keycode(keymap);
   max_key = xkb_keymap_max_keycode(keymap);
+  /* The scan keeps whichever group the caller locked on `state`. */
+  group = xkb_state_serialize_layout(state, XKB_STATE_LAYOUT_LOCKED);
 
   {
     xkb_mod_index_t shift_mod =
@@ -353,9 +356,9 @@ void axidev_io_linux_keymap_init(axidev_io_linux_keymap *out_keymap,
         axidev_io_keyboard_key_t char_key = AXIDEV_IO_KEY_UNKNOWN;
         axidev_io_keyboard_mapping_value mapping_value;
 
-        xkb_state_update_mask(state, scans[i].mask, 0, 0, 0, 0, 0);
+        xkb_state_update_mask(state, scans[i].mask, 0, 0, 0, 0, group);
         character = xkb_state_key_get_utf32(state, xkb_key);
-        xkb_state_update_mask(state, 0, 0, 0, 0, 0, 0);
+        xkb_state_update_mask(state, 0, 0, 0, 0, 0, group);
         if (character == 0) {
           continue;
         }
@@ -402,6 +405,73 @@ void axidev_io_linux_keymap_free(axidev_io_linux_keymap *keymap) {
   memset(keymap, 0, sizeof(*keymap));
 }
 
+/* Keysym resolution including the name-based fallback; only used while the
+   table is built because it formats and allocates. */
+static axidev_io_keyboard_key_t
+axidev_io_linux_keysym_to_key_slow(xkb_keysym_t sym) {
+  axidev_io_keyboard_key_t key = axidev_io_linux_keysym_to_key(sym);
+  char name[64];
+
+  if (key == AXIDEV_IO_KEY_UNKNOWN &&
+      xkb_keysym_get_name(sym, name, sizeof(name)) > 0) {
+    key = axidev_io_string_to_key_internal(name);
+  }
+  return key;
+}
+
+void axidev_io_linux_keysym_table_build(
+    struct xkb_keymap *keymap, axidev_io_keymap_uint_to_key_entry **out_table) {
+  xkb_keycode_t min_keycode;
+  xkb_keycode_t max_keycode;
+  xkb_keycode_t keycode;
+
+  *out_table = NULL;
+  if (keymap == NULL) {
+    return;
+  }
+  min_keycode = xkb_keymap_min_keycode(keymap);
+  max_keycode = xkb_keymap_max_keycode(keymap);
+  for (keycode = min_keycode; keycode <= max_keycode; ++keycode) {
+    xkb_layout_index_t layouts =
+        xkb_keymap_num_layouts_for_key(keymap, keycode);
+    xkb_layout_index_t layout;
+
+    for (layout = 0; layout < layouts; ++layout) {
+      xkb_level_index_t levels =
+          xkb_keymap_num_levels_for_key(keymap, keycode, layout);
+      xkb_level_index_t level;
+
+      for (level = 0; level < levels; ++level) {
+        const xkb_keysym_t *syms = NULL;
+        int count = xkb_keymap_key_get_syms_by_level(keymap, keycode, layout,
+                                                     level, &syms);
+        int i;
+
+        for (i = 0; i < count; ++i) {
+          axidev_io_keyboard_key_t key;
+
+          if (hmgeti(*out_table, syms[i]) >= 0) {
+            continue;
+          }
+          key = axidev_io_linux_keysym_to_key_slow(syms[i]);
+          if (key != AXIDEV_IO_KEY_UNKNOWN) {
+            hmput(*out_table, syms[i], key);
+          }
+        }
+      }
+    }
+  }
+}
+
+axidev_io_keyboard_key_t axidev_io_linux_keysym_table_lookup(
+    const axidev_io_keymap_uint_to_key_entry *table, xkb_keysym_t sym) {
+  axidev_io_keymap_uint_to_key_entry *entries =
+      (axidev_io_keymap_uint_to_key_entry *)table;
+  ptrdiff_t index = hmgeti(entries, sym);
+
+  return index >= 0 ? entries[index].value : AXIDEV_IO_KEY_UNKNOWN;
+}
+
 axidev_io_keyboard_key_t axidev_io_linux_resolve_key_from_evdev_and_mods(
     const axidev_io_linux_keymap *keymap, int evdev_code,
     axidev_io_keyboard_modifier_t mods) {
@@ -20,10 +20,19 @@ uint32_t axidev_io_encode_evdev_mods(int evdev_code,
                                      axidev_io_keyboard_modifier_t mods);
 axidev_io_keyboard_key_t axidev_io_linux_keysym_to_key(xkb_keysym_t sym);
 void axidev_io_linux_keymap_fill_fallback(axidev_io_linux_keymap *keymap);
+/* Resolves the group currently locked on `state`; a fresh state scans the
+   first one. */
 void axidev_io_linux_keymap_init(axidev_io_linux_keymap *out_keymap,
                                  struct xkb_keymap *keymap,
                                  struct xkb_state *state);
 void axidev_io_linux_keymap_free(axidev_io_linux_keymap *keymap);
+/* Keysym -> key map covering every keysym `keymap` can produce, resolving
+   keysym names up front so lookups never format or allocate. Free with
+   hmfree(). */
+void axidev_io_linux_keysym_table_build(
+    struct xkb_keymap *keymap, axidev_io_keymap_uint_to_key_entry **out_table);
+axidev_io_keyboard_key_t axidev_io_linux_keysym_table_lookup(
+    const axidev_io_keymap_uint_to_key_entry *table, xkb_keysym_t sym);
 axidev_io_keyboard_key_t axidev_io_linux_resolve_key_from_evdev_and_mods(
     const axidev_io_linux_keymap *keymap, int evdev_code,
     axidev_io_keyboard_modifier_t mods);
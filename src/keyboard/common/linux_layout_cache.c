@@ -0,0 +1,430 @@
+#if defined(__linux__)
+
+#include "linux_layout_cache_internal.h"
+
+#include <dirent.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "keymap_snapshot_internal.h"
+#include "linux_keysym_internal.h"
+
+static axidev_io_once g_layout_cache_once = AXIDEV_IO_ONCE_INIT;
+static axidev_io_mutex g_layout_cache_lock;
+static axidev_io_linux_compiled_layout **g_layout_cache = NULL;
+static atomic_uint g_observed_group;
+static axidev_io_once g_xkb_library_once = AXIDEV_IO_ONCE_INIT;
+static uint64_t g_xkb_library_fingerprint;
+
+static void axidev_io_linux_layout_cache_init_once(void) {
+  axidev_io_mutex_init(&g_layout_cache_lock);
+}
+
+bool axidev_io_linux_rule_names_equal(
+    const axidev_io_xkb_rule_names_strings *a,
+    const axidev_io_xkb_rule_names_strings *b) {
+  return a->has_any == b->has_any && strcmp(a->rules, b->rules) == 0 &&
+         strcmp(a->model, b->model) == 0 &&
+         strcmp(a->layout, b->layout) == 0 &&
+         strcmp(a->variant, b->variant) == 0 &&
+         strcmp(a->options, b->options) == 0;
+}
+
+static void
+axidev_io_linux_layout_destroy(axidev_io_linux_compiled_layout *layout) {
+  if (layout == NULL) {
+    return;
+  }
+  axidev_io_keymap_tables_free(&layout->tables);
+  for (size_t group = 1; group < AXIDEV_IO_LINUX_LAYOUT_MAX_GROUPS; ++group) {
+    axidev_io_keymap_tables_free(&layout->group_tables[group]);
+  }
+  if (layout->keymap != NULL) {
+    xkb_keymap_unref(layout->keymap);
+  }
+  if (layout->context != NULL) {
+    xkb_context_unref(layout->context);
+  }
+  free(layout);
+}
+
+/* Folds the path and the inode, size and mtime in `info` into `hash`; a
+   NULL `info` (a missing file) folds as zeros. */
+static uint64_t axidev_io_linux_fold_stat(uint64_t hash, const char *path,
+                                          const struct stat *info) {
+  uint64_t fields[3] = {0, 0, 0};
+
+  if (info != NULL) {
+    fields[0] = (uint64_t)info->st_ino;
+    fields[1] = (uint64_t)info->st_size;
+    fields[2] = (uint64_t)info->st_mtime;
+  }
+  hash = axidev_io_fnv1a(hash, path, strlen(path));
+  return axidev_io_fnv1a(hash, fields, sizeof(fields));
+}
+
+static uint64_t axidev_io_linux_fold_file(uint64_t hash, const char *path) {
+  struct stat info;
+
+  return axidev_io_linux_fold_stat(hash, path,
+                                   stat(path, &info) == 0 ? &info : NULL);
+}
+
+/* Hashes every file under `directory`, descending `depth` more levels.
+   Per-file hashes are summed so the result does not depend on readdir
+   order. */
+static uint64_t axidev_io_linux_fold_tree(const char *directory,
+                                          unsigned int depth) {
+  DIR *handle = opendir(directory);
+  struct dirent *entry;
+  uint64_t sum = 0;
+
+  if (handle == NULL) {
+    return 0;
+  }
+  while ((entry = readdir(handle)) != NULL) {
+    char path[512];
+    struct stat info;
+    int length;
+
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    length = snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    if (length < 0 || (size_t)length >= sizeof(path) ||
+        stat(path, &info) != 0) {
+      continue;
+    }
+    if (S_ISDIR(info.st_mode)) {
+      if (depth > 0) {
+        sum += axidev_io_linux_fold_tree(path, depth - 1u);
+      }
+    } else if (S_ISREG(info.st_mode)) {
+      sum += axidev_io_linux_fold_stat(AXIDEV_IO_FNV1A_SEED, path, &info);
+    }
+  }
+  closedir(handle);
+  return sum;
+}
+
+/* libxkbcommon has no runtime version call, so the library file mapped
+   into this process stands in for its version. */
+static void axidev_io_linux_xkb_library_init_once(void) {
+  FILE *maps = fopen("/proc/self/maps", "r");
+  char line[512];
+  uint64_t hash = AXIDEV_IO_FNV1A_SEED;
+
+  if (maps != NULL) {
+    while (fgets(line, sizeof(line), maps) != NULL) {
+      char *path = strchr(line, '/');
+      if (path != NULL && strstr(path, "libxkbcommon.so") != NULL) {
+        path[strcspn(path, "\n")] = '\0';
+        hash = axidev_io_linux_fold_file(hash, path);
+        break;
+      }
+    }
+    fclose(maps);
+  }
+  g_xkb_library_fingerprint = hash;
+}
+
+/* Levels of subdirectories fingerprinted below each component directory;
+   xkeyboard-config nests vendor symbols one level deep. */
+#define AXIDEV_IO_LINUX_XKB_TREE_DEPTH 2u
+
+/* Fingerprints the data a compile could read: the library, and in every
+   include root each file under the rules, keycodes, types, compat and
+   symbols directories. That covers the rules, the layout symbols and
+   whatever the variants and options pull in, since resolving the exact
+   include set would take a compile. Editing, adding or removing any of
+   these files changes the snapshot identity. */
+static uint64_t
+axidev_io_linux_xkb_data_fingerprint(struct xkb_context *context) {
+  static const char *const components[] = {"rules", "keycodes", "types",
+                                           "compat", "symbols"};
+  uint64_t hash;
+
+  axidev_io_call_once(&g_xkb_library_once,
+                      axidev_io_linux_xkb_library_init_once);
+  hash = g_xkb_library_fingerprint;
+  for (unsigned int i = 0; i < xkb_context_num_include_paths(context); ++i) {
+    const char *root = xkb_context_include_path_get(context, i);
+    char path[512];
+
+    if (root == NULL) {
+      continue;
+    }
+    for (size_t c = 0; c < sizeof(components) / sizeof(components[0]); ++c) {
+      uint64_t tree;
+
+      snprintf(path, sizeof(path), "%s/%s", root, components[c]);
+      hash = axidev_io_linux_fold_file(hash, path);
+      tree = axidev_io_linux_fold_tree(path, AXIDEV_IO_LINUX_XKB_TREE_DEPTH);
+      hash = axidev_io_fnv1a(hash, &tree, sizeof(tree));
+    }
+  }
+  return hash;
+}
+
+static void
+axidev_io_linux_layout_identity(const axidev_io_xkb_rule_names_strings *names,
+                                struct xkb_context *context, char *buffer,
+                                size_t buffer_size) {
+  uint64_t fingerprint = axidev_io_linux_xkb_data_fingerprint(context);
+
+  snprintf(buffer, buffer_size,
+           "xkb:%d:rules=%s;model=%s;layout=%s;variant=%s;options=%s;"
+           "data=%016llx",
+           names->has_any ? 1 : 0, names->rules, names->model, names->layout,
+           names->variant, names->options, (unsigned long long)fingerprint);
+}
+
+static axidev_io_result
+axidev_io_linux_layout_compile_keymap(const char *operation,
+                                      axidev_io_linux_compiled_layout *layout) {
+  const axidev_io_xkb_rule_names_strings *names = &layout->names;
+  struct xkb_rule_names native_names;
+
+  if (layout->context == NULL) {
+    layout->context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    if (layout->context == NULL) {
+      axidev_io_set_xkb_keymap_error(operation);
+      return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+    }
+  }
+
+  memset(&native_names, 0, sizeof(native_names));
+  native_names.rules = names->rules[0] != '\0' ? names->rules : NULL;
+  native_names.model = names->model[0] != '\0' ? names->model : NULL;
+  native_names.layout = names->layout[0] != '\0' ? names->layout : NULL;
+  native_names.variant = names->variant[0] != '\0' ? names->variant : NULL;
+  native_names.options = names->options[0] != '\0' ? names->options : NULL;
+  layout->keymap = xkb_keymap_new_from_names(
+      layout->context, names->has_any ? &native_names : NULL,
+      XKB_KEYMAP_COMPILE_NO_FLAGS);
+  if (layout->keymap == NULL) {
+    axidev_io_set_xkb_keymap_error(operation);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  return AXIDEV_IO_RESULT_OK;
+}
+
+static axidev_io_result
+axidev_io_linux_layout_build_tables(const char *operation,
+                                    axidev_io_linux_compiled_layout *layout,
+                                    uint32_t group,
+                                    axidev_io_keymap_tables **out_tables) {
+  struct xkb_state *state;
+  axidev_io_linux_keymap linux_keymap;
+  axidev_io_result result;
+
+  /* The level scan mutates its state, so it gets a private one. */
+  state = xkb_state_new(layout->keymap);
+  if (state == NULL) {
+    axidev_io_set_xkb_keymap_error(operation);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  if (group != 0) {
+    xkb_state_update_mask(state, 0, 0, 0, 0, 0, group);
+  }
+
+  memset(&linux_keymap, 0, sizeof(linux_keymap));
+  axidev_io_linux_keymap_init(&linux_keymap, layout->keymap, state);
+  result = axidev_io_keymap_tables_build(
+      out_tables, linux_keymap.key_to_evdev, linux_keymap.evdev_to_key,
+      linux_keymap.code_and_mods_to_key, linux_keymap.char_to_keycode);
+  axidev_io_linux_keymap_free(&linux_keymap);
+  xkb_state_unref(state);
+  return result;
+}
+
+static axidev_io_result
+axidev_io_linux_layout_create(const char *operation,
+                              const axidev_io_xkb_rule_names_strings *names,
+                              axidev_io_linux_compiled_layout **out_layout) {
+  axidev_io_linux_compiled_layout *layout;
+  char identity[AXIDEV_IO_KEYMAP_SNAPSHOT_IDENTITY_LEN];
+  axidev_io_result result;
+
+  layout = (axidev_io_linux_compiled_layout *)calloc(1, sizeof(*layout));
+  if (layout == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  layout->names = *names;
+  /* The include roots fingerprinted into the identity come from the same
+     context a snapshot miss compiles with. */
+  layout->context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+  if (layout->context == NULL) {
+    axidev_io_set_xkb_keymap_error(operation);
+    free(layout);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+
+  axidev_io_linux_layout_identity(names, layout->context, identity,
+                                  sizeof(identity));
+  if (axidev_io_keymap_snapshot_load(identity, &layout->tables) ==
+      AXIDEV_IO_RESULT_OK) {
+    *out_layout = layout;
+    return AXIDEV_IO_RESULT_OK;
+  }
+
+  result = axidev_io_linux_layout_compile_keymap(operation, layout);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_linux_layout_build_tables(operation, layout, 0,
+                                                 &layout->tables);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_linux_layout_destroy(layout);
+    return result;
+  }
+  axidev_io_keymap_snapshot_store(identity, layout->tables);
+  AXIDEV_IO_LOG_DEBUG("compiled xkb layout '%s' (variant '%s')",
+                      names->layout, names->variant);
+
+  *out_layout = layout;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_linux_layout_acquire(const char *operation, bool need_keymap,
+                               axidev_io_linux_compiled_layout **out_layout) {
+  axidev_io_xkb_rule_names_strings names = axidev_io_detect_xkb_rule_names();
+
+  return axidev_io_linux_layout_acquire_names(operation, &names, need_keymap,
+                                              out_layout);
+}
+
+axidev_io_result axidev_io_linux_layout_acquire_names(
+    const char *operation, const axidev_io_xkb_rule_names_strings *names,
+    bool need_keymap, axidev_io_linux_compiled_layout **out_layout) {
+  axidev_io_linux_compiled_layout *layout = NULL;
+  axidev_io_result result = AXIDEV_IO_RESULT_OK;
+  ptrdiff_t i;
+
+  if (names == NULL || out_layout == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  *out_layout = NULL;
+
+  axidev_io_call_once(&g_layout_cache_once,
+                      axidev_io_linux_layout_cache_init_once);
+
+  /* Compiling under the lock keeps a concurrent sender and listener start
+     from both paying for the same layout. */
+  axidev_io_mutex_lock(&g_layout_cache_lock);
+  for (i = 0; i < arrlen(g_layout_cache); ++i) {
+    if (axidev_io_linux_rule_names_equal(&g_layout_cache[i]->names, names)) {
+      layout = g_layout_cache[i];
+      break;
+    }
+  }
+  if (layout == NULL) {
+    result = axidev_io_linux_layout_create(operation, names, &layout);
+    if (result == AXIDEV_IO_RESULT_OK) {
+      arrput(g_layout_cache, layout);
+    }
+  }
+  if (result == AXIDEV_IO_RESULT_OK && need_keymap && layout->keymap == NULL) {
+    result = axidev_io_linux_layout_compile_keymap(operation, layout);
+    if (result != AXIDEV_IO_RESULT_OK && layout->refcount == 0) {
+      for (i = 0; i < arrlen(g_layout_cache); ++i) {
+        if (g_layout_cache[i] == layout) {
+          arrdelswap(g_layout_cache, i);
+          break;
+        }
+      }
+      axidev_io_linux_layout_destroy(layout);
+    }
+    if (result != AXIDEV_IO_RESULT_OK) {
+      layout = NULL;
+    }
+  }
+  if (layout != NULL) {
+    ++layout->refcount;
+    *out_layout = layout;
+  }
+  axidev_io_mutex_unlock(&g_layout_cache_lock);
+  return result;
+}
+
+void axidev_io_linux_layout_release(axidev_io_linux_compiled_layout *layout) {
+  ptrdiff_t i;
+
+  if (layout == NULL) {
+    return;
+  }
+
+  axidev_io_call_once(&g_layout_cache_once,
+                      axidev_io_linux_layout_cache_init_once);
+  axidev_io_mutex_lock(&g_layout_cache_lock);
+  if (layout->refcount > 0) {
+    --layout->refcount;
+  }
+  if (layout->refcount == 0) {
+    for (i = 0; i < arrlen(g_layout_cache); ++i) {
+      if (g_layout_cache[i] == layout) {
+        arrdelswap(g_layout_cache, i);
+        break;
+      }
+    }
+    if (arrlen(g_layout_cache) == 0) {
+      arrfree(g_layout_cache);
+    }
+    axidev_io_linux_layout_destroy(layout);
+  }
+  axidev_io_mutex_unlock(&g_layout_cache_lock);
+}
+
+axidev_io_result
+axidev_io_linux_layout_group_tables(const char *operation,
+                                    axidev_io_linux_compiled_layout *layout,
+                                    uint32_t group,
+                                    axidev_io_keymap_tables **out_tables) {
+  axidev_io_result result = AXIDEV_IO_RESULT_OK;
+
+  if (layout == NULL || out_tables == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if (group == 0) {
+    *out_tables = layout->tables;
+    return AXIDEV_IO_RESULT_OK;
+  }
+
+  axidev_io_call_once(&g_layout_cache_once,
+                      axidev_io_linux_layout_cache_init_once);
+  axidev_io_mutex_lock(&g_layout_cache_lock);
+  if (layout->keymap == NULL) {
+    result = axidev_io_linux_layout_compile_keymap(operation, layout);
+  }
+  if (result == AXIDEV_IO_RESULT_OK) {
+    if (group >= AXIDEV_IO_LINUX_LAYOUT_MAX_GROUPS ||
+        group >= xkb_keymap_num_layouts(layout->keymap)) {
+      *out_tables = layout->tables;
+    } else {
+      if (layout->group_tables[group] == NULL) {
+        result = axidev_io_linux_layout_build_tables(
+            operation, layout, group, &layout->group_tables[group]);
+      }
+      if (result == AXIDEV_IO_RESULT_OK) {
+        *out_tables = layout->group_tables[group];
+        AXIDEV_IO_LOG_DEBUG("using xkb layout '%s' group %u",
+                            layout->names.layout, (unsigned int)group);
+      }
+    }
+  }
+  axidev_io_mutex_unlock(&g_layout_cache_lock);
+  return result;
+}
+
+void axidev_io_linux_layout_note_group(uint32_t group) {
+  atomic_store_explicit(&g_observed_group, group, memory_order_relaxed);
+}
+
+uint32_t axidev_io_linux_layout_observed_group(void) {
+  return atomic_load_explicit(&g_observed_group, memory_order_relaxed);
+}
+
+#endif
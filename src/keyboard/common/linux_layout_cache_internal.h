@@ -0,0 +1,66 @@
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_LINUX_LAYOUT_CACHE_INTERNAL_H
+#define AXIDEV_IO_KEYBOARD_LINUX_LAYOUT_CACHE_INTERNAL_H
+
+#if defined(__linux__)
+
+#include <xkbcommon/xkbcommon.h>
+
+#include "keymap_internal.h"
+#include "linux_layout_internal.h"
+
+/* XKB's own limit on groups in one keymap. */
+#define AXIDEV_IO_LINUX_LAYOUT_MAX_GROUPS 4u
+
+/* A compiled XKB layout and its resolved tables, shared process-wide by the
+   sender keymap and the listener. Everything here is immutable once built,
+   so holders on different threads may read it without locking; per-thread
+   modifier tracking needs its own xkb_state from `keymap`. When the tables
+   come from an on-disk snapshot, `context` and `keymap` stay NULL until a
+   holder asks for them. `group_tables` entries only go from NULL to built,
+   under the cache lock, so they are read through
+   axidev_io_linux_layout_group_tables(). */
+typedef struct axidev_io_linux_compiled_layout {
+  axidev_io_xkb_rule_names_strings names;
+  struct xkb_context *context;
+  struct xkb_keymap *keymap;
+  /* Tables of the first group. */
+  axidev_io_keymap_tables *tables;
+  /* Tables of the later groups, built the first time one is asked for;
+     entry 0 stays NULL. */
+  axidev_io_keymap_tables *group_tables[AXIDEV_IO_LINUX_LAYOUT_MAX_GROUPS];
+  uint32_t refcount;
+} axidev_io_linux_compiled_layout;
+
+bool axidev_io_linux_rule_names_equal(
+    const axidev_io_xkb_rule_names_strings *a,
+    const axidev_io_xkb_rule_names_strings *b);
+
+/* Returns the cached layout for the currently detected rule names, compiling
+   it on first use. `need_keymap` also guarantees a compiled `keymap`.
+   `operation` names the caller in XKB error messages. */
+axidev_io_result
+axidev_io_linux_layout_acquire(const char *operation, bool need_keymap,
+                               axidev_io_linux_compiled_layout **out_layout);
+/* Same, for rule names the caller already detected. */
+axidev_io_result axidev_io_linux_layout_acquire_names(
+    const char *operation, const axidev_io_xkb_rule_names_strings *names,
+    bool need_keymap, axidev_io_linux_compiled_layout **out_layout);
+void axidev_io_linux_layout_release(axidev_io_linux_compiled_layout *layout);
+
+/* Tables for XKB group `group` of a held layout, building them on first use.
+   Groups the keymap does not have resolve to the first one. */
+axidev_io_result
+axidev_io_linux_layout_group_tables(const char *operation,
+                                    axidev_io_linux_compiled_layout *layout,
+                                    uint32_t group,
+                                    axidev_io_keymap_tables **out_tables);
+
+/* The effective group the listener last tracked. The sender has no XKB
+   state of its own, so a layout refresh picks its group up from here. */
+void axidev_io_linux_layout_note_group(uint32_t group);
+uint32_t axidev_io_linux_layout_observed_group(void);
+
+#endif
+
+#endif
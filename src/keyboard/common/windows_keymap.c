@@ -4,6 +4,8 @@
 
 #include <axidev-io/c_api.h>
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <stb/stb_ds.h>
@@ -297,9 +299,24 @@ void axidev_io_windows_keymap_init(axidev_io_windows_keymap *out_keymap,
     }
   }
 
+  axidev_io_windows_fill_scan_codes(out_keymap->vk_to_scan, layout);
   axidev_io_windows_fill_fallback(out_keymap);
 }
 
+void axidev_io_windows_fill_scan_codes(WORD *vk_to_scan, HKL layout) {
+  UINT vk;
+
+  if (vk_to_scan == NULL) {
+    return;
+  }
+  if (layout == NULL) {
+    layout = GetKeyboardLayout(0);
+  }
+  for (vk = 0; vk < 256u; ++vk) {
+    vk_to_scan[vk] = (WORD)MapVirtualKeyEx(vk, MAPVK_VK_TO_VSC, layout);
+  }
+}
+
 void axidev_io_windows_keymap_free(axidev_io_windows_keymap *keymap) {
   if (keymap == NULL) {
     return;
@@ -341,4 +358,85 @@ axidev_io_keyboard_key_t axidev_io_windows_resolve_key_from_vk_and_mods(
   return AXIDEV_IO_KEY_UNKNOWN;
 }
 
+#define AXIDEV_IO_WINDOWS_LAYOUTS_KEY                                          \
+  "SYSTEM\\CurrentControlSet\\Control\\Keyboard Layouts"
+
+/* Finds the KLID registry key name of `layout`. The high word of an HKL is
+   either a layout language, a "Layout Id" when its top nibble is 0xF, or
+   part of an IME's full KLID. */
+static bool axidev_io_windows_layout_klid(HKL layout, char *out,
+                                          size_t out_size) {
+  WORD device = HIWORD((ULONG_PTR)layout);
+  HKEY layouts;
+  DWORD index;
+  bool found = false;
+
+  if ((device & 0xF000u) == 0xE000u) {
+    snprintf(out, out_size, "%08lX",
+             (unsigned long)((ULONG_PTR)layout & 0xFFFFFFFFu));
+    return true;
+  }
+  if ((device & 0xF000u) != 0xF000u) {
+    snprintf(out, out_size, "0000%04X", (unsigned int)device);
+    return true;
+  }
+  if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, AXIDEV_IO_WINDOWS_LAYOUTS_KEY, 0,
+                    KEY_READ, &layouts) != ERROR_SUCCESS) {
+    return false;
+  }
+  for (index = 0; !found; ++index) {
+    char name[16];
+    char layout_id[16];
+    DWORD name_size = sizeof(name);
+    DWORD id_size = sizeof(layout_id);
+
+    if (RegEnumKeyExA(layouts, index, name, &name_size, NULL, NULL, NULL,
+                      NULL) != ERROR_SUCCESS) {
+      break;
+    }
+    if (RegGetValueA(layouts, name, "Layout Id", RRF_RT_REG_SZ, NULL,
+                     layout_id, &id_size) == ERROR_SUCCESS &&
+        strtoul(layout_id, NULL, 16) == (unsigned long)(device & 0x0FFFu)) {
+      snprintf(out, out_size, "%s", name);
+      found = true;
+    }
+  }
+  RegCloseKey(layouts);
+  return found;
+}
+
+void axidev_io_windows_layout_identity(HKL layout, char *buffer,
+                                       size_t buffer_size) {
+  char klid[16];
+  char key_path[128];
+  char file[MAX_PATH];
+  char path[MAX_PATH * 2];
+  DWORD file_size = sizeof(file);
+  WIN32_FILE_ATTRIBUTE_DATA attributes;
+  UINT directory_length;
+
+  if (!axidev_io_windows_layout_klid(layout, klid, sizeof(klid))) {
+    snprintf(buffer, buffer_size, "hkl:%p", (void *)layout);
+    return;
+  }
+  snprintf(key_path, sizeof(key_path), "%s\\%s",
+           AXIDEV_IO_WINDOWS_LAYOUTS_KEY, klid);
+  directory_length = GetSystemDirectoryA(path, MAX_PATH);
+  if (RegGetValueA(HKEY_LOCAL_MACHINE, key_path, "Layout File", RRF_RT_REG_SZ,
+                   NULL, file, &file_size) != ERROR_SUCCESS ||
+      directory_length == 0 || directory_length >= MAX_PATH) {
+    snprintf(buffer, buffer_size, "hkl:%p;klid=%s", (void *)layout, klid);
+    return;
+  }
+  snprintf(path + directory_length, sizeof(path) - directory_length, "\\%s",
+           file);
+  memset(&attributes, 0, sizeof(attributes));
+  GetFileAttributesExA(path, GetFileExInfoStandard, &attributes);
+  snprintf(buffer, buffer_size,
+           "hkl:%p;klid=%s;dll=%s;size=%lu;mtime=%08lx%08lx", (void *)layout,
+           klid, file, (unsigned long)attributes.nFileSizeLow,
+           (unsigned long)attributes.ftLastWriteTime.dwHighDateTime,
+           (unsigned long)attributes.ftLastWriteTime.dwLowDateTime);
+}
+
 #endif
@@ -13,16 +13,26 @@ typedef struct axidev_io_windows_keymap {
   axidev_io_keymap_int_to_key_entry *vk_to_key;
   axidev_io_keymap_char_mapping_entry *char_to_keycode;
   axidev_io_keymap_uint_to_key_entry *vk_and_mods_to_key;
+  /* Hardware scan code per virtual key for the layout; 0 when unmapped. */
+  WORD vk_to_scan[256];
 } axidev_io_windows_keymap;
 
 uint32_t axidev_io_encode_vk_mods(WORD vk, axidev_io_keyboard_modifier_t mods);
 void axidev_io_windows_keymap_init(axidev_io_windows_keymap *out_keymap,
                                    HKL layout);
 void axidev_io_windows_keymap_free(axidev_io_windows_keymap *keymap);
+/* Fills the 256-entry virtual key to scan code table for `layout`. */
+void axidev_io_windows_fill_scan_codes(WORD *vk_to_scan, HKL layout);
 axidev_io_keyboard_key_t axidev_io_windows_resolve_key_from_vk_and_mods(
     const axidev_io_windows_keymap *keymap, WORD vk,
     axidev_io_keyboard_modifier_t mods);
 bool axidev_io_is_windows_extended_key(WORD vk);
+/* Writes the snapshot identity of `layout`: the HKL plus its KLID and the
+   name, size and write time of the layout DLL behind it, so an updated DLL
+   gets fresh tables. Falls back to the HKL alone when the registry does not
+   resolve it. */
+void axidev_io_windows_layout_identity(HKL layout, char *buffer,
+                                       size_t buffer_size);
 
 #endif
 
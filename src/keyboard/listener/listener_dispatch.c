@@ -0,0 +1,451 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "listener_internal.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+/* Power of two so indices can wrap with a mask. */
+#define AXIDEV_IO_LISTENER_QUEUE_CAPACITY 1024u
+
+/* Single-producer/single-consumer ring for pull mode. The backend thread
+   pushes through the batch callback; axidev_io_listener_read_events() pops
+   under the context lock, so there is only ever one consumer. */
+struct axidev_io_listener_event_queue {
+  atomic_size_t head;
+  char head_pad[64 - sizeof(atomic_size_t)];
+  atomic_size_t tail;
+  char tail_pad[64 - sizeof(atomic_size_t)];
+  axidev_io_keyboard_listener_impl *impl;
+#if defined(_WIN32)
+  /* Manual-reset event, signalled while events may be pending. */
+  HANDLE ready_event;
+#elif defined(__linux__)
+  /* Non-blocking eventfd, readable while events may be pending. */
+  int ready_fd;
+#endif
+  axidev_io_key_event_t slots[AXIDEV_IO_LISTENER_QUEUE_CAPACITY];
+};
+
+static void
+axidev_io_listener_record_latency(axidev_io_keyboard_listener_impl *impl,
+                                  axidev_io_key_event_t *events, size_t count,
+                                  uint64_t now_ns) {
+  uint64_t now_us = now_ns / 1000u;
+  uint64_t max_us =
+      atomic_load_explicit(&impl->latency_max_us, memory_order_relaxed);
+
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t latency_us =
+        now_us > events[i].timestamp_us ? now_us - events[i].timestamp_us : 0;
+
+    events[i].dispatch_time_us = now_us;
+    atomic_fetch_add_explicit(
+        &impl->latency_buckets[axidev_io_stats_bucket(
+            latency_us, AXIDEV_IO_LISTENER_LATENCY_BUCKETS)],
+        1, memory_order_relaxed);
+    if (latency_us > max_us) {
+      max_us = latency_us;
+    }
+  }
+  atomic_store_explicit(&impl->latency_max_us, max_us, memory_order_relaxed);
+}
+
+void axidev_io_keyboard_listener_deliver(
+    axidev_io_keyboard_listener_impl *impl, axidev_io_key_event_t *events,
+    size_t count) {
+  const axidev_io_listener_subscriber_set *set;
+  bool delivered = false;
+  uint64_t start_ns;
+
+  if (count == 0) {
+    return;
+  }
+  start_ns = axidev_io_monotonic_time_ns();
+  axidev_io_listener_record_latency(impl, events, count, start_ns);
+
+  /* Odd while `set` is in use; writers read it to know when a retired set
+     can be freed. */
+  atomic_fetch_add(&impl->dispatch_seq, 1u);
+  set = atomic_load(&impl->subscribers);
+  if (set != NULL) {
+    if (set->batch_callback != NULL) {
+      set->batch_callback(events, count, set->user_data);
+      delivered = true;
+    } else if (set->callback != NULL) {
+      for (size_t i = 0; i < count; ++i) {
+        set->callback(events[i].codepoint, events[i].key_mod,
+                      events[i].pressed, set->user_data);
+      }
+      delivered = true;
+    }
+    for (size_t i = 0; i < set->count; ++i) {
+      set->entries[i].callback(events, count, set->entries[i].user_data);
+      delivered = true;
+    }
+  }
+  atomic_fetch_add(&impl->dispatch_seq, 1u);
+
+  if (delivered) {
+    atomic_fetch_add(&impl->events_delivered, (uint64_t)count);
+    axidev_io_stats_add(AXIDEV_IO_STAT_LISTENER_EVENTS_DELIVERED, count);
+    axidev_io_stats_record(AXIDEV_IO_STAT_CALLBACK_DURATION_NS,
+                           axidev_io_monotonic_time_ns() - start_ns);
+  }
+}
+
+/* Copies the session callback and the first `count` entries of `from`
+   into a new set with room for `capacity` entries. */
+static axidev_io_listener_subscriber_set *
+axidev_io_listener_subscriber_set_copy(
+    const axidev_io_listener_subscriber_set *from, size_t count,
+    size_t capacity) {
+  axidev_io_listener_subscriber_set *set =
+      (axidev_io_listener_subscriber_set *)calloc(
+          1, sizeof(*set) + capacity * sizeof(set->entries[0]));
+
+  if (set == NULL) {
+    return NULL;
+  }
+  if (from != NULL) {
+    set->callback = from->callback;
+    set->batch_callback = from->batch_callback;
+    set->user_data = from->user_data;
+    if (count > 0) {
+      memcpy(set->entries, from->entries, count * sizeof(set->entries[0]));
+    }
+  }
+  set->count = count;
+  return set;
+}
+
+static void axidev_io_listener_subscribers_publish(
+    axidev_io_keyboard_listener_impl *impl,
+    axidev_io_listener_subscriber_set *next) {
+  axidev_io_listener_subscriber_set *previous =
+      atomic_exchange(&impl->subscribers, next);
+
+  if (previous != NULL) {
+    previous->retired_seq = atomic_load(&impl->dispatch_seq);
+    previous->retired_next = impl->retired;
+    impl->retired = previous;
+  }
+  axidev_io_keyboard_listener_reclaim(impl);
+}
+
+void axidev_io_keyboard_listener_reclaim(
+    axidev_io_keyboard_listener_impl *impl) {
+  uint64_t seq = atomic_load(&impl->dispatch_seq);
+  axidev_io_listener_subscriber_set **link = &impl->retired;
+
+  while (*link != NULL) {
+    axidev_io_listener_subscriber_set *set = *link;
+
+    /* An even sequence at retirement means the dispatcher was idle and its
+       next load sees the new set; any change since means it has left the
+       dispatch that might have loaded this one. */
+    if ((set->retired_seq & 1u) == 0 || set->retired_seq != seq) {
+      *link = set->retired_next;
+      free(set);
+    } else {
+      link = &set->retired_next;
+    }
+  }
+}
+
+void axidev_io_keyboard_listener_release_subscribers(
+    axidev_io_keyboard_listener_impl *impl) {
+  axidev_io_listener_subscriber_set *set =
+      atomic_exchange(&impl->subscribers, NULL);
+
+  free(set);
+  while (impl->retired != NULL) {
+    set = impl->retired;
+    impl->retired = set->retired_next;
+    free(set);
+  }
+}
+
+axidev_io_result axidev_io_keyboard_listener_set_callback(
+    axidev_io_keyboard_listener_impl *impl,
+    axidev_io_keyboard_listener_cb callback,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data) {
+  const axidev_io_listener_subscriber_set *current =
+      atomic_load(&impl->subscribers);
+  size_t count = current != NULL ? current->count : 0;
+  axidev_io_listener_subscriber_set *next =
+      axidev_io_listener_subscriber_set_copy(current, count, count);
+
+  if (next == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  next->callback = callback;
+  next->batch_callback = batch_callback;
+  next->user_data = user_data;
+  axidev_io_listener_subscribers_publish(impl, next);
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result axidev_io_keyboard_listener_subscribe_internal(
+    axidev_io_keyboard_listener_impl *impl,
+    axidev_io_keyboard_listener_batch_cb callback, void *user_data,
+    uint64_t *out_token) {
+  const axidev_io_listener_subscriber_set *current =
+      atomic_load(&impl->subscribers);
+  size_t count = current != NULL ? current->count : 0;
+  axidev_io_listener_subscriber_set *next;
+
+  if (callback == NULL || out_token == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  next = axidev_io_listener_subscriber_set_copy(current, count, count + 1);
+  if (next == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  next->entries[count].token = ++impl->next_token;
+  next->entries[count].callback = callback;
+  next->entries[count].user_data = user_data;
+  next->count = count + 1;
+  *out_token = next->entries[count].token;
+  axidev_io_listener_subscribers_publish(impl, next);
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result axidev_io_keyboard_listener_unsubscribe_internal(
+    axidev_io_keyboard_listener_impl *impl, uint64_t token) {
+  const axidev_io_listener_subscriber_set *current =
+      atomic_load(&impl->subscribers);
+  axidev_io_listener_subscriber_set *next;
+  size_t index = 0;
+
+  while (current != NULL && index < current->count &&
+         current->entries[index].token != token) {
+    ++index;
+  }
+  if (token == 0 || current == NULL || index == current->count) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+
+  next = axidev_io_listener_subscriber_set_copy(current, index,
+                                                current->count - 1);
+  if (next == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  memcpy(next->entries + index, current->entries + index + 1,
+         (current->count - index - 1) * sizeof(next->entries[0]));
+  next->count = current->count - 1;
+  axidev_io_listener_subscribers_publish(impl, next);
+  return AXIDEV_IO_RESULT_OK;
+}
+
+void axidev_io_listener_filter_build_codes(
+    const axidev_io_listener_filter_t *filter,
+    const axidev_io_keymap_tables *tables, uint32_t code_count,
+    uint8_t *out_codes) {
+  bool has_keys = axidev_io_listener_filter_has_keys(filter);
+
+  for (uint32_t code = 0; code < code_count; ++code) {
+    uint8_t flags = has_keys ? 0 : AXIDEV_IO_LISTENER_CODE_PASS;
+
+    for (uint32_t mods = 0; has_keys && mods < AXIDEV_IO_KEYMAP_MOD_COMBOS;
+         ++mods) {
+      axidev_io_keyboard_key_t key = axidev_io_keymap_tables_key_from_code(
+          tables, (int32_t)code, (axidev_io_keyboard_modifier_t)mods);
+      if (key == AXIDEV_IO_KEY_UNKNOWN) {
+        flags |= AXIDEV_IO_LISTENER_CODE_UNMAPPED;
+      } else if (axidev_io_listener_filter_accepts_key(filter, key)) {
+        flags |= AXIDEV_IO_LISTENER_CODE_PASS;
+      }
+    }
+    out_codes[code] = flags;
+  }
+}
+
+static void
+axidev_io_listener_queue_signal(axidev_io_listener_event_queue *queue) {
+#if defined(_WIN32)
+  SetEvent(queue->ready_event);
+#elif defined(__linux__)
+  uint64_t one = 1;
+  /* A saturated counter is still readable, so a failed write is harmless. */
+  ssize_t written = write(queue->ready_fd, &one, sizeof(one));
+  (void)written;
+#else
+  (void)queue;
+#endif
+}
+
+static void
+axidev_io_listener_queue_clear_signal(axidev_io_listener_event_queue *queue) {
+#if defined(_WIN32)
+  ResetEvent(queue->ready_event);
+#elif defined(__linux__)
+  uint64_t count;
+  ssize_t consumed = read(queue->ready_fd, &count, sizeof(count));
+  (void)consumed;
+#else
+  (void)queue;
+#endif
+}
+
+/* Batch callback installed for pull mode; runs on the backend thread. */
+static void axidev_io_listener_queue_push(const axidev_io_key_event_t *events,
+                                          size_t count, void *user_data) {
+  axidev_io_listener_event_queue *queue =
+      (axidev_io_listener_event_queue *)user_data;
+  axidev_io_keyboard_listener_impl *impl = queue->impl;
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+  size_t room = AXIDEV_IO_LISTENER_QUEUE_CAPACITY - (head - tail);
+  size_t accepted = count < room ? count : room;
+  size_t used;
+
+  for (size_t i = 0; i < accepted; ++i) {
+    queue->slots[(head + i) & (AXIDEV_IO_LISTENER_QUEUE_CAPACITY - 1u)] =
+        events[i];
+  }
+  atomic_store_explicit(&queue->head, head + accepted, memory_order_release);
+  if (accepted < count) {
+    atomic_fetch_add_explicit(&impl->events_dropped,
+                              (uint64_t)(count - accepted),
+                              memory_order_relaxed);
+    axidev_io_stats_add(AXIDEV_IO_STAT_LISTENER_EVENTS_DROPPED,
+                        count - accepted);
+  }
+  /* Only this thread writes the high-water mark in pull mode. */
+  used = head + accepted - tail;
+  axidev_io_stats_record(AXIDEV_IO_STAT_LISTENER_QUEUE_DEPTH, used);
+  if ((unsigned)used >
+      atomic_load_explicit(&impl->queue_high_water, memory_order_relaxed)) {
+    atomic_store_explicit(&impl->queue_high_water, (unsigned)used,
+                          memory_order_relaxed);
+  }
+  if (accepted > 0) {
+    axidev_io_listener_queue_signal(queue);
+  }
+}
+
+static void
+axidev_io_listener_queue_destroy(axidev_io_listener_event_queue *queue) {
+  if (queue == NULL) {
+    return;
+  }
+#if defined(_WIN32)
+  if (queue->ready_event != NULL) {
+    CloseHandle(queue->ready_event);
+  }
+#elif defined(__linux__)
+  if (queue->ready_fd >= 0) {
+    close(queue->ready_fd);
+  }
+#endif
+  free(queue);
+}
+
+axidev_io_result axidev_io_keyboard_listener_open_queue_internal(
+    axidev_io_listener_wait_handle_t *out_handle) {
+  axidev_io_keyboard_listener_impl *impl = axidev_io_listener_impl_get();
+  axidev_io_listener_event_queue *queue;
+  axidev_io_result result;
+
+  if (out_handle == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if (impl->queue != NULL) {
+    return AXIDEV_IO_RESULT_ALREADY_INITIALIZED;
+  }
+
+  queue = (axidev_io_listener_event_queue *)calloc(1, sizeof(*queue));
+  if (queue == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  queue->impl = impl;
+#if defined(_WIN32)
+  queue->ready_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+  if (queue->ready_event == NULL) {
+    axidev_io_set_last_errorf("CreateEvent failed: %lu",
+                              (unsigned long)GetLastError());
+    free(queue);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+#elif defined(__linux__)
+  queue->ready_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (queue->ready_fd < 0) {
+    axidev_io_set_last_errorf("listener queue eventfd failed: %s",
+                              strerror(errno));
+    free(queue);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+#endif
+
+  impl->queue = queue;
+  result = axidev_io_keyboard_listener_start_internal(
+      NULL, axidev_io_listener_queue_push, queue);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    impl->queue = NULL;
+    axidev_io_listener_queue_destroy(queue);
+    return result;
+  }
+  impl->queue_capacity = AXIDEV_IO_LISTENER_QUEUE_CAPACITY;
+
+#if defined(_WIN32)
+  *out_handle = queue->ready_event;
+#elif defined(__linux__)
+  *out_handle = queue->ready_fd;
+#else
+  *out_handle = 0;
+#endif
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result axidev_io_keyboard_listener_read_events_internal(
+    axidev_io_key_event_t *events, size_t max_events, size_t *out_count) {
+  axidev_io_listener_event_queue *queue =
+      axidev_io_listener_impl_get()->queue;
+  size_t tail;
+  size_t head;
+  size_t count;
+
+  *out_count = 0;
+  if (queue == NULL) {
+    return AXIDEV_IO_RESULT_NOT_INITIALIZED;
+  }
+  if (events == NULL && max_events > 0) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+
+  /* Clear first: anything pushed after this point signals again. */
+  axidev_io_listener_queue_clear_signal(queue);
+  tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  head = atomic_load_explicit(&queue->head, memory_order_acquire);
+  count = head - tail < max_events ? head - tail : max_events;
+  for (size_t i = 0; i < count; ++i) {
+    events[i] =
+        queue->slots[(tail + i) & (AXIDEV_IO_LISTENER_QUEUE_CAPACITY - 1u)];
+  }
+  atomic_store_explicit(&queue->tail, tail + count, memory_order_release);
+  if (head - tail > count) {
+    axidev_io_listener_queue_signal(queue);
+  }
+  *out_count = count;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+void axidev_io_keyboard_listener_close_queue_internal(void) {
+  axidev_io_keyboard_listener_impl *impl = axidev_io_listener_impl_get();
+
+  axidev_io_listener_queue_destroy(impl->queue);
+  impl->queue = NULL;
+}
@@ -3,16 +3,68 @@
 #define AXIDEV_IO_KEYBOARD_LISTENER_INTERNAL_H
 
 #include "../../internal/context.h"
+#include "../../internal/stats.h"
 
 #include <stdatomic.h>
 
 #include "../common/keymap_internal.h"
 
-typedef struct axidev_io_keyboard_listener_impl {
+/* Most events a backend collects before handing them to the callback. */
+#define AXIDEV_IO_LISTENER_BATCH_CAPACITY 64u
+
+typedef struct axidev_io_listener_event_queue axidev_io_listener_event_queue;
+
+typedef struct axidev_io_listener_subscriber {
+  uint64_t token;
+  axidev_io_keyboard_listener_batch_cb callback;
+  void *user_data;
+} axidev_io_listener_subscriber;
+
+/* Everything the dispatcher calls for one batch. A published set is never
+   modified; writers copy it, swap the copy in and retire the old one. */
+typedef struct axidev_io_listener_subscriber_set {
+  struct axidev_io_listener_subscriber_set *retired_next;
+  uint64_t retired_seq;
+  /* Session callback; at most one of the two is set. */
   axidev_io_keyboard_listener_cb callback;
+  axidev_io_keyboard_listener_batch_cb batch_callback;
   void *user_data;
-  axidev_io_mutex callback_lock;
-  bool callback_lock_ready;
+  size_t count;
+  axidev_io_listener_subscriber entries[];
+} axidev_io_listener_subscriber_set;
+
+/* Per-code flags built from the session filter. PASS: some Shift/Ctrl/Alt
+   combination maps the code to a selected key. UNMAPPED: some combination
+   maps it to nothing, so a backend with its own fallback may add PASS. */
+#define AXIDEV_IO_LISTENER_CODE_PASS 0x01u
+#define AXIDEV_IO_LISTENER_CODE_UNMAPPED 0x02u
+
+typedef struct axidev_io_keyboard_listener_impl {
+  /* Session callback and subscribers. Replaced whole under the context
+     lock and read by the dispatcher with a single atomic load. */
+  _Atomic(axidev_io_listener_subscriber_set *) subscribers;
+  /* Bumped on entry to and exit from each dispatch. */
+  _Atomic uint64_t dispatch_seq;
+  /* Sets swapped out while a dispatch may still be reading them. */
+  axidev_io_listener_subscriber_set *retired;
+  uint64_t next_token;
+  /* Pull-mode ring, set from axidev_io_listener_open_queue() until stop. */
+  axidev_io_listener_event_queue *queue;
+  /* AXIDEV_IO_LISTENER_OPTION_* flags, read by the next start. */
+  uint32_t options;
+  /* Set by axidev_io_listener_set_filter(); backends copy it at start. */
+  axidev_io_listener_filter_t filter;
+  /* Backend of the running session; UNKNOWN while stopped. */
+  axidev_io_keyboard_backend_type_t backend_type;
+  /* Per-session counters behind axidev_io_listener_get_stats(). The queue
+     fields stay zero for backends that do not queue events. */
+  _Atomic uint64_t events_delivered;
+  _Atomic uint64_t events_dropped;
+  atomic_uint queue_high_water;
+  uint32_t queue_capacity;
+  /* Written only by the thread that calls the callback. */
+  _Atomic uint64_t latency_buckets[AXIDEV_IO_LISTENER_LATENCY_BUCKETS];
+  _Atomic uint64_t latency_max_us;
 #ifdef _WIN32
   axidev_io_thread worker;
   void *hook;
@@ -37,7 +89,104 @@ _Static_assert(sizeof(axidev_io_keyboard_listener_impl) <=
 axidev_io_keyboard_listener_impl *axidev_io_listener_impl_get(void);
 
 axidev_io_result axidev_io_keyboard_listener_start_internal(
-    axidev_io_keyboard_listener_cb callback, void *user_data);
+    axidev_io_keyboard_listener_cb callback,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data);
 void axidev_io_keyboard_listener_stop_internal(void);
 
+/* One transition for axidev_io_keyboard_listener_replay_for_tests(): an
+   evdev code on Linux, a virtual key on Windows. */
+typedef struct axidev_io_listener_synthetic_key {
+  uint32_t code;
+  bool pressed;
+} axidev_io_listener_synthetic_key;
+
+/* Runs `keys` through the backend's translation against the current
+   layout, as a stopped listener's next session would, and delivers the
+   results to `batch_callback` and the subscribers on the calling thread.
+   Lets tests and benchmarks drive translation without OS input. */
+axidev_io_result axidev_io_keyboard_listener_replay_for_tests(
+    const axidev_io_listener_synthetic_key *keys, size_t count,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data);
+
+/* Stamps `dispatch_time_us`, records latency and hands `count` translated
+   events to the session callback and then to every subscriber. Takes no
+   lock. Runs on the backend thread. */
+void axidev_io_keyboard_listener_deliver(
+    axidev_io_keyboard_listener_impl *impl, axidev_io_key_event_t *events,
+    size_t count);
+
+/* Subscriber set writers. They run under the context lock and never wait
+   for the dispatcher. */
+axidev_io_result axidev_io_keyboard_listener_set_callback(
+    axidev_io_keyboard_listener_impl *impl,
+    axidev_io_keyboard_listener_cb callback,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data);
+axidev_io_result axidev_io_keyboard_listener_subscribe_internal(
+    axidev_io_keyboard_listener_impl *impl,
+    axidev_io_keyboard_listener_batch_cb callback, void *user_data,
+    uint64_t *out_token);
+axidev_io_result axidev_io_keyboard_listener_unsubscribe_internal(
+    axidev_io_keyboard_listener_impl *impl, uint64_t token);
+/* Frees retired sets the dispatcher can no longer be reading. */
+void axidev_io_keyboard_listener_reclaim(
+    axidev_io_keyboard_listener_impl *impl);
+/* Frees every set; only valid while nothing can dispatch. */
+void axidev_io_keyboard_listener_release_subscribers(
+    axidev_io_keyboard_listener_impl *impl);
+
+/* Pull mode: starts the listener with an internal ring as its sink. The
+   ring is released by axidev_io_keyboard_listener_close_queue_internal()
+   once the backend has stopped. */
+axidev_io_result axidev_io_keyboard_listener_open_queue_internal(
+    axidev_io_listener_wait_handle_t *out_handle);
+axidev_io_result axidev_io_keyboard_listener_read_events_internal(
+    axidev_io_key_event_t *events, size_t max_events, size_t *out_count);
+void axidev_io_keyboard_listener_close_queue_internal(void);
+
+static inline bool
+axidev_io_listener_filter_has_keys(const axidev_io_listener_filter_t *filter) {
+  for (size_t i = 0; i < AXIDEV_IO_LISTENER_FILTER_WORDS; ++i) {
+    if (filter->keys[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static inline bool
+axidev_io_listener_filter_is_active(const axidev_io_listener_filter_t *filter) {
+  return filter->required_mods != AXIDEV_IO_MOD_NONE ||
+         axidev_io_listener_filter_has_keys(filter);
+}
+
+static inline bool
+axidev_io_listener_filter_accepts_key(const axidev_io_listener_filter_t *filter,
+                                      axidev_io_keyboard_key_t key) {
+  if ((uint32_t)key >= AXIDEV_IO_LISTENER_FILTER_WORDS * 64u) {
+    return false;
+  }
+  if (((filter->keys[key / 64u] >> (key % 64u)) & 1u) != 0) {
+    return true;
+  }
+  return !axidev_io_listener_filter_has_keys(filter);
+}
+
+/* Fills `out_codes[0, code_count)` with AXIDEV_IO_LISTENER_CODE_* flags. */
+void axidev_io_listener_filter_build_codes(
+    const axidev_io_listener_filter_t *filter,
+    const axidev_io_keymap_tables *tables, uint32_t code_count,
+    uint8_t *out_codes);
+
+static inline void axidev_io_keyboard_listener_reset_stats(
+    axidev_io_keyboard_listener_impl *impl) {
+  atomic_store(&impl->events_delivered, 0);
+  atomic_store(&impl->events_dropped, 0);
+  atomic_store(&impl->queue_high_water, 0);
+  impl->queue_capacity = 0;
+  for (size_t i = 0; i < AXIDEV_IO_LISTENER_LATENCY_BUCKETS; ++i) {
+    atomic_store(&impl->latency_buckets[i], 0);
+  }
+  atomic_store(&impl->latency_max_us, 0);
+}
+
 #endif
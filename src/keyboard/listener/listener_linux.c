@@ -1,16 +1,27 @@
 #if defined(__linux__)
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "listener_internal.h"
 
 #include <axidev-io/c_api.h>
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <libinput.h>
 #include <libudev.h>
+#include <linux/input.h>
 #include <poll.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <time.h>
 #include <unistd.h>
 #include <xkbcommon/xkbcommon-keysyms.h>
 #include <xkbcommon/xkbcommon.h>
@@ -19,29 +30,128 @@
 
 #include "../common/key_utils_internal.h"
 #include "../common/linux_keysym_internal.h"
-#include "../common/linux_layout_internal.h"
+#include "../common/linux_layout_cache_internal.h"
+
+/* Per-keycode session state. */
+typedef struct axidev_io_linux_key_slot {
+  /* Codepoint reported again on release; 0 when none is pending. */
+  uint32_t pending_codepoint;
+  /* The last press passed the session filter. */
+  bool reported;
+} axidev_io_linux_key_slot;
 
-typedef struct axidev_io_pending_codepoint_entry {
-  uint32_t key;
-  uint32_t value;
-} axidev_io_pending_codepoint_entry;
+/* Modifier bits of the session keymap, resolved once at start. */
+typedef struct axidev_io_linux_mod_masks {
+  xkb_mod_mask_t shift;
+  xkb_mod_mask_t ctrl;
+  xkb_mod_mask_t alt;
+  xkb_mod_mask_t super;
+  xkb_mod_mask_t caps;
+} axidev_io_linux_mod_masks;
+
+#define AXIDEV_IO_EVDEV_DIR "/dev/input"
+#define AXIDEV_IO_EVDEV_MAX_DEVICES 32u
+#define AXIDEV_IO_EVDEV_READ_BATCH 64u
+#define AXIDEV_IO_EVDEV_BITS_PER_LONG (8u * sizeof(unsigned long))
+#define AXIDEV_IO_EVDEV_LONGS(bits)                                            \
+  (((bits) + AXIDEV_IO_EVDEV_BITS_PER_LONG - 1u) /                             \
+   AXIDEV_IO_EVDEV_BITS_PER_LONG)
+
+/* One keyboard opened by the evdev backend. */
+typedef struct axidev_io_linux_evdev_device {
+  int fd;
+  /* N of /dev/input/eventN, used to match inotify removals. */
+  unsigned int number;
+  /* Set after SYN_DROPPED until the next SYN_REPORT. */
+  bool syncing;
+  /* Keys this device currently holds down, so they can be released when it
+     disappears or resynchronised after dropped events. */
+  unsigned long down[AXIDEV_IO_EVDEV_LONGS(KEY_CNT)];
+} axidev_io_linux_evdev_device;
 
 struct axidev_io_linux_listener_platform {
+  /* AXIDEV_IO_LISTENER_OPTION_EVDEV, latched at start. */
+  bool use_evdev;
+  /* Session copy of the listener filter; `filter_codes` holds
+     AXIDEV_IO_LISTENER_CODE_* flags per evdev code. */
+  axidev_io_listener_filter_t filter;
+  bool filtering;
+  uint8_t filter_codes[AXIDEV_IO_KEYMAP_CODE_LIMIT];
   struct libinput *libinput;
-  struct xkb_context *xkb_context;
-  struct xkb_keymap *xkb_keymap;
+  axidev_io_linux_compiled_layout *layout;
   struct xkb_state *xkb_state;
-  axidev_io_linux_keymap keymap;
-  axidev_io_pending_codepoint_entry *pending_codepoints;
+  /* Tables of the XKB group `xkb_state` has in effect. */
+  axidev_io_keymap_tables *tables;
+  uint32_t group;
+  /* axidev_io_keymap_generation() as of the last check of `layout` against
+     the detected rule names. */
+  uint64_t keymap_generation;
+  axidev_io_linux_mod_masks mod_masks;
+  axidev_io_keymap_uint_to_key_entry *keysym_to_key;
+  /* Indexed by evdev code, which stays below AXIDEV_IO_KEYMAP_CODE_LIMIT. */
+  axidev_io_linux_key_slot keys[AXIDEV_IO_KEYMAP_CODE_LIMIT];
+  /* Events translated during the current drain, delivered together. */
+  axidev_io_key_event_t batch[AXIDEV_IO_LISTENER_BATCH_CAPACITY];
+  size_t batch_count;
   atomic_bool startup_failed;
+  /* The worker's error behind `startup_failed`, re-raised by start on the
+     calling thread. */
+  axidev_io_error_record startup_error;
+  /* eventfd the worker blocks on next to libinput; written to make it
+     re-check `running`. -1 outside a session. */
+  int wake_fd;
+  /* evdev backend: inotify watch on /dev/input and the open keyboards. */
+  int inotify_fd;
+  axidev_io_linux_evdev_device devices[AXIDEV_IO_EVDEV_MAX_DEVICES];
+  size_t device_count;
 };
 
+static void axidev_io_linux_listener_wake(
+    struct axidev_io_linux_listener_platform *platform) {
+  uint64_t one = 1;
+
+  if (platform->wake_fd >= 0) {
+    /* Any nonzero count wakes the worker, so a failed write on an already
+       signalled counter is harmless. */
+    ssize_t written = write(platform->wake_fd, &one, sizeof(one));
+    (void)written;
+  }
+}
+
+static void axidev_io_linux_listener_close_wake_fd(
+    struct axidev_io_linux_listener_platform *platform) {
+  if (platform->wake_fd >= 0) {
+    close(platform->wake_fd);
+    platform->wake_fd = -1;
+  }
+}
+
+/* Keeps the error just recorded on this thread for start to report. */
+static void axidev_io_linux_listener_fail_startup(
+    struct axidev_io_linux_listener_platform *platform,
+    axidev_io_result result) {
+  axidev_io_last_error_save(&platform->startup_error);
+  platform->startup_error.code = result;
+  atomic_store(&platform->startup_failed, true);
+}
+
+/* Moves a failed worker's error onto the calling thread. */
+static axidev_io_result axidev_io_linux_listener_startup_result(
+    struct axidev_io_linux_listener_platform *platform) {
+  if (!atomic_load(&platform->startup_failed)) {
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  axidev_io_last_error_restore(&platform->startup_error);
+  return platform->startup_error.code;
+}
+
 static void axidev_io_linux_listener_reset_session_state(
     struct axidev_io_linux_listener_platform *platform) {
   if (platform == NULL) {
     return;
   }
-  hmfree(platform->pending_codepoints);
+  memset(platform->keys, 0, sizeof(platform->keys));
+  platform->batch_count = 0;
 }
 
 static int axidev_io_open_restricted(const char *path, int flags,
@@ -74,136 +184,372 @@ static uint32_t axidev_io_codepoint_from_key(axidev_io_keyboard_key_t key) {
   return 0;
 }
 
-static void axidev_io_listener_invoke_callback(
-    axidev_io_keyboard_listener_impl *impl, uint32_t codepoint,
-    axidev_io_keyboard_key_with_modifier_t key_mod, bool pressed) {
-  axidev_io_keyboard_listener_cb callback;
-  void *user_data;
+static void
+axidev_io_linux_listener_flush(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_linux_listener_platform *platform = impl->platform;
 
-  axidev_io_mutex_lock(&impl->callback_lock);
-  callback = impl->callback;
-  user_data = impl->user_data;
-  axidev_io_mutex_unlock(&impl->callback_lock);
+  axidev_io_keyboard_listener_deliver(impl, platform->batch,
+                                      platform->batch_count);
+  platform->batch_count = 0;
+}
+
+static xkb_mod_mask_t axidev_io_linux_mod_mask(struct xkb_keymap *keymap,
+                                               const char *name) {
+  xkb_mod_index_t index = xkb_keymap_mod_get_index(keymap, name);
 
-  if (callback != NULL) {
-    callback(codepoint, key_mod, pressed, user_data);
+  if (index == XKB_MOD_INVALID || index >= 32u) {
+    return 0;
   }
+  return (xkb_mod_mask_t)1u << index;
+}
+
+static void axidev_io_linux_resolve_mod_masks(struct xkb_keymap *keymap,
+                                              axidev_io_linux_mod_masks *out) {
+  out->shift = axidev_io_linux_mod_mask(keymap, XKB_MOD_NAME_SHIFT);
+  out->ctrl = axidev_io_linux_mod_mask(keymap, XKB_MOD_NAME_CTRL);
+  out->alt = axidev_io_linux_mod_mask(keymap, XKB_MOD_NAME_ALT);
+  out->super = axidev_io_linux_mod_mask(keymap, XKB_MOD_NAME_LOGO);
+  out->caps = axidev_io_linux_mod_mask(keymap, XKB_MOD_NAME_CAPS);
 }
 
-static axidev_io_keyboard_modifier_t
-axidev_io_linux_current_mods(struct xkb_state *state) {
+static axidev_io_keyboard_modifier_t axidev_io_linux_current_mods(
+    const struct axidev_io_linux_listener_platform *platform) {
+  const axidev_io_linux_mod_masks *masks = &platform->mod_masks;
+  xkb_mod_mask_t active =
+      xkb_state_serialize_mods(platform->xkb_state, XKB_STATE_MODS_EFFECTIVE);
   axidev_io_keyboard_modifier_t mods = AXIDEV_IO_MOD_NONE;
 
-  if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_SHIFT,
-                                   XKB_STATE_MODS_EFFECTIVE)) {
+  if ((active & masks->shift) != 0) {
     mods |= AXIDEV_IO_MOD_SHIFT;
   }
-  if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_CTRL,
-                                   XKB_STATE_MODS_EFFECTIVE)) {
+  if ((active & masks->ctrl) != 0) {
     mods |= AXIDEV_IO_MOD_CTRL;
   }
-  if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_ALT,
-                                   XKB_STATE_MODS_EFFECTIVE)) {
+  if ((active & masks->alt) != 0) {
     mods |= AXIDEV_IO_MOD_ALT;
   }
-  if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_LOGO,
-                                   XKB_STATE_MODS_EFFECTIVE)) {
+  if ((active & masks->super) != 0) {
     mods |= AXIDEV_IO_MOD_SUPER;
   }
-  if (xkb_state_mod_name_is_active(state, "Lock", XKB_STATE_MODS_EFFECTIVE)) {
+  if ((active & masks->caps) != 0) {
     mods |= AXIDEV_IO_MOD_CAPSLOCK;
   }
 
   return mods;
 }
 
-static void axidev_io_listener_handle_key_event(
-    axidev_io_keyboard_listener_impl *impl,
-    struct libinput_event_keyboard *keyboard_event) {
+static void axidev_io_linux_filter_add_keysym_codes(
+    struct axidev_io_linux_listener_platform *platform);
+
+static void axidev_io_linux_listener_build_filter_codes(
+    struct axidev_io_linux_listener_platform *platform) {
+  if (platform->filtering) {
+    axidev_io_listener_filter_build_codes(&platform->filter, platform->tables,
+                                          AXIDEV_IO_KEYMAP_CODE_LIMIT,
+                                          platform->filter_codes);
+    axidev_io_linux_filter_add_keysym_codes(platform);
+  }
+}
+
+/* Derives the modifier masks, keysym table and filter codes of the session
+   layout. */
+static void axidev_io_linux_listener_load_layout(
+    struct axidev_io_linux_listener_platform *platform) {
+  axidev_io_linux_resolve_mod_masks(platform->layout->keymap,
+                                    &platform->mod_masks);
+  hmfree(platform->keysym_to_key);
+  axidev_io_linux_keysym_table_build(platform->layout->keymap,
+                                     &platform->keysym_to_key);
+  axidev_io_linux_listener_build_filter_codes(platform);
+}
+
+/* Switches to the tables of the group the last key put in effect; each
+   group's tables are built once per compiled layout. */
+static void axidev_io_linux_listener_follow_group(
+    struct axidev_io_linux_listener_platform *platform) {
+  uint32_t group = (uint32_t)xkb_state_serialize_layout(
+      platform->xkb_state, XKB_STATE_LAYOUT_EFFECTIVE);
+  axidev_io_keymap_tables *tables;
+
+  if (group == platform->group) {
+    return;
+  }
+  if (axidev_io_linux_layout_group_tables("axidev_io_listener_start",
+                                          platform->layout, group,
+                                          &tables) != AXIDEV_IO_RESULT_OK) {
+    return;
+  }
+  platform->group = group;
+  platform->tables = tables;
+  axidev_io_linux_layout_note_group(group);
+  axidev_io_linux_listener_build_filter_codes(platform);
+}
+
+/* After a keymap reinitialize or layout refresh, moves the session onto the
+   layout now detected. Held modifiers and the locked group carry over, so
+   the session keeps running across the switch. */
+static void axidev_io_linux_listener_follow_layout(
+    struct axidev_io_linux_listener_platform *platform) {
+  axidev_io_xkb_rule_names_strings names = axidev_io_detect_xkb_rule_names();
+  struct xkb_state *old_state = platform->xkb_state;
+  axidev_io_linux_compiled_layout *layout;
+  struct xkb_state *state;
+
+  platform->keymap_generation = axidev_io_keymap_generation();
+  if (axidev_io_linux_rule_names_equal(&platform->layout->names, &names)) {
+    return;
+  }
+  if (axidev_io_linux_layout_acquire_names("axidev_io_listener_start", &names,
+                                           true, &layout) !=
+      AXIDEV_IO_RESULT_OK) {
+    AXIDEV_IO_LOG_WARN("listener keeps xkb layout '%s': '%s' failed to "
+                       "compile",
+                       platform->layout->names.layout, names.layout);
+    return;
+  }
+  state = xkb_state_new(layout->keymap);
+  if (state == NULL) {
+    axidev_io_linux_layout_release(layout);
+    return;
+  }
+  xkb_state_update_mask(
+      state, xkb_state_serialize_mods(old_state, XKB_STATE_MODS_DEPRESSED),
+      xkb_state_serialize_mods(old_state, XKB_STATE_MODS_LATCHED),
+      xkb_state_serialize_mods(old_state, XKB_STATE_MODS_LOCKED), 0, 0,
+      xkb_state_serialize_layout(old_state, XKB_STATE_LAYOUT_LOCKED));
+  xkb_state_unref(old_state);
+  axidev_io_linux_layout_release(platform->layout);
+  platform->xkb_state = state;
+  platform->layout = layout;
+  platform->tables = layout->tables;
+  axidev_io_linux_listener_load_layout(platform);
+  /* No group matches, so the group's tables are looked up afresh. */
+  platform->group = UINT32_MAX;
+  axidev_io_linux_listener_follow_group(platform);
+  AXIDEV_IO_LOG_DEBUG("listener switched to xkb layout '%s' (variant '%s')",
+                      names.layout, names.variant);
+}
+
+/* Feeds one evdev key transition through the session XKB state and queues
+   the translated event. Both backends end up here. */
+static void
+axidev_io_listener_translate_key(axidev_io_keyboard_listener_impl *impl,
+                                 uint32_t keycode, bool pressed,
+                                 uint64_t timestamp_us) {
   struct axidev_io_linux_listener_platform *platform = impl->platform;
-  uint32_t keycode;
-  bool pressed;
+  const axidev_io_listener_filter_t *filter;
   xkb_keycode_t xkb_key;
   axidev_io_keyboard_modifier_t mods;
-  xkb_keysym_t keysym;
+  xkb_keysym_t keysym = XKB_KEY_NoSymbol;
   uint32_t codepoint = 0;
   axidev_io_keyboard_key_t mapped_key;
-  ptrdiff_t pending_index;
+  axidev_io_linux_key_slot *slot;
 
-  if (platform == NULL || keyboard_event == NULL) {
+  if (platform == NULL || keycode >= AXIDEV_IO_KEYMAP_CODE_LIMIT) {
     return;
   }
-
-  keycode = libinput_event_keyboard_get_key(keyboard_event);
-  pressed = libinput_event_keyboard_get_key_state(keyboard_event) ==
-            LIBINPUT_KEY_STATE_PRESSED;
+  axidev_io_stats_add(AXIDEV_IO_STAT_LISTENER_EVENTS_RECEIVED, 1u);
+  if (axidev_io_keymap_generation() != platform->keymap_generation) {
+    axidev_io_linux_listener_follow_layout(platform);
+  }
+  filter = &platform->filter;
+  slot = &platform->keys[keycode];
   xkb_key = (xkb_keycode_t)(keycode + 8u);
   xkb_state_update_key(platform->xkb_state, xkb_key,
                        pressed ? XKB_KEY_DOWN : XKB_KEY_UP);
-  mods = axidev_io_linux_current_mods(platform->xkb_state);
-  keysym = xkb_state_key_get_one_sym(platform->xkb_state, xkb_key);
-
-  if (pressed) {
-    uint32_t cp = (uint32_t)xkb_keysym_to_utf32(keysym);
-    if (cp >= 0x20u && cp != 0x7Fu) {
-      hmput(platform->pending_codepoints, keycode, cp);
-    } else {
-      (void)hmdel(platform->pending_codepoints, keycode);
+  axidev_io_linux_listener_follow_group(platform);
+  if (platform->filtering) {
+    /* Releases follow their press; presses must pass the code and modifier
+       checks before anything is translated. */
+    if (!pressed) {
+      if (!slot->reported) {
+        return;
+      }
+    } else if ((platform->filter_codes[keycode] &
+                AXIDEV_IO_LISTENER_CODE_PASS) == 0) {
+      return;
     }
-  } else {
-    pending_index = hmgeti(platform->pending_codepoints, keycode);
-    if (pending_index >= 0) {
-      codepoint = platform->pending_codepoints[pending_index].value;
-      (void)hmdel(platform->pending_codepoints, keycode);
+  }
+  mods = axidev_io_linux_current_mods(platform);
+  if (pressed && platform->filtering &&
+      (mods & filter->required_mods) != filter->required_mods) {
+    return;
+  }
+  if (!filter->keys_only) {
+    keysym = xkb_state_key_get_one_sym(platform->xkb_state, xkb_key);
+    if (pressed) {
+      uint32_t cp = (uint32_t)xkb_keysym_to_utf32(keysym);
+      slot->pending_codepoint = (cp >= 0x20u && cp != 0x7Fu) ? cp : 0;
+    } else {
+      codepoint = slot->pending_codepoint;
+      slot->pending_codepoint = 0;
     }
   }
 
-  mapped_key = axidev_io_linux_resolve_key_from_evdev_and_mods(
-      &platform->keymap, (int)keycode, mods);
+  mapped_key = axidev_io_keymap_tables_key_from_code(
+      platform->tables, (int32_t)keycode, mods);
   if (mapped_key == AXIDEV_IO_KEY_UNKNOWN) {
-    mapped_key = axidev_io_linux_keysym_to_key(keysym);
-    if (mapped_key == AXIDEV_IO_KEY_UNKNOWN) {
-      char name[64];
-      if (xkb_keysym_get_name(keysym, name, sizeof(name)) > 0) {
-        mapped_key = axidev_io_string_to_key_internal(name);
-      }
+    if (filter->keys_only) {
+      keysym = xkb_state_key_get_one_sym(platform->xkb_state, xkb_key);
     }
+    mapped_key =
+        axidev_io_linux_keysym_table_lookup(platform->keysym_to_key, keysym);
+  }
+  if (platform->filtering) {
+    if (pressed && !axidev_io_listener_filter_accepts_key(filter, mapped_key)) {
+      slot->pending_codepoint = 0;
+      return;
+    }
+    slot->reported = pressed;
   }
 
-  if (mapped_key != AXIDEV_IO_KEY_UNKNOWN &&
+  if (!filter->keys_only && mapped_key != AXIDEV_IO_KEY_UNKNOWN &&
       !axidev_io_keyboard_has_modifier(mods, AXIDEV_IO_MOD_SHIFT)) {
     uint32_t derived = axidev_io_codepoint_from_key(mapped_key);
     if (derived != 0) {
       codepoint = derived;
       if (pressed) {
-        hmput(platform->pending_codepoints, keycode, derived);
+        slot->pending_codepoint = derived;
       }
     }
   }
 
   {
-    axidev_io_keyboard_key_with_modifier_t key_mod = {mapped_key, mods};
-    axidev_io_listener_invoke_callback(impl, codepoint, key_mod, pressed);
+    axidev_io_key_event_t *event = &platform->batch[platform->batch_count++];
+    event->timestamp_us = timestamp_us;
+    event->dispatch_time_us = 0;
+    event->codepoint = codepoint;
+    event->code = keycode;
+    event->key_mod.key = mapped_key;
+    event->key_mod.mods = mods;
+    event->pressed = pressed;
+  }
+  if (platform->batch_count == AXIDEV_IO_LISTENER_BATCH_CAPACITY) {
+    axidev_io_linux_listener_flush(impl);
   }
 }
 
-static int axidev_io_listener_thread_main(void *user_data) {
-  axidev_io_keyboard_listener_impl *impl =
-      (axidev_io_keyboard_listener_impl *)user_data;
+static void axidev_io_listener_handle_key_event(
+    axidev_io_keyboard_listener_impl *impl,
+    struct libinput_event_keyboard *keyboard_event) {
+  if (keyboard_event == NULL) {
+    return;
+  }
+  /* libinput stamps events with CLOCK_MONOTONIC, the library's clock. */
+  axidev_io_listener_translate_key(
+      impl, libinput_event_keyboard_get_key(keyboard_event),
+      libinput_event_keyboard_get_key_state(keyboard_event) ==
+          LIBINPUT_KEY_STATE_PRESSED,
+      libinput_event_keyboard_get_time_usec(keyboard_event));
+}
+
+static void
+axidev_io_listener_drain_events(axidev_io_keyboard_listener_impl *impl) {
+  struct libinput *libinput = impl->platform->libinput;
+  struct libinput_event *event;
+
+  libinput_dispatch(libinput);
+  while ((event = libinput_get_event(libinput)) != NULL) {
+    if (libinput_event_get_type(event) == LIBINPUT_EVENT_KEYBOARD_KEY) {
+      axidev_io_listener_handle_key_event(
+          impl, libinput_event_get_keyboard_event(event));
+    }
+    libinput_event_destroy(event);
+  }
+  axidev_io_linux_listener_flush(impl);
+}
+
+/* Codes the tables leave unmapped under some modifiers are resolved through
+   their keysyms at run time; let them through when any of their keysyms
+   names a selected key. */
+static void axidev_io_linux_filter_add_keysym_codes(
+    struct axidev_io_linux_listener_platform *platform) {
+  struct xkb_keymap *keymap = platform->layout->keymap;
+
+  for (uint32_t code = 0; code < AXIDEV_IO_KEYMAP_CODE_LIMIT; ++code) {
+    xkb_keycode_t xkb_key = (xkb_keycode_t)(code + 8u);
+    xkb_layout_index_t layouts;
+
+    if ((platform->filter_codes[code] &
+         (AXIDEV_IO_LISTENER_CODE_PASS | AXIDEV_IO_LISTENER_CODE_UNMAPPED)) !=
+        AXIDEV_IO_LISTENER_CODE_UNMAPPED) {
+      continue;
+    }
+    layouts = xkb_keymap_num_layouts_for_key(keymap, xkb_key);
+    for (xkb_layout_index_t layout = 0; layout < layouts; ++layout) {
+      xkb_level_index_t levels =
+          xkb_keymap_num_levels_for_key(keymap, xkb_key, layout);
+      for (xkb_level_index_t level = 0; level < levels; ++level) {
+        const xkb_keysym_t *syms = NULL;
+        int count = xkb_keymap_key_get_syms_by_level(keymap, xkb_key, layout,
+                                                     level, &syms);
+        for (int i = 0; i < count; ++i) {
+          if (axidev_io_listener_filter_accepts_key(
+                  &platform->filter, axidev_io_linux_keysym_table_lookup(
+                                         platform->keysym_to_key, syms[i]))) {
+            platform->filter_codes[code] |= AXIDEV_IO_LISTENER_CODE_PASS;
+          }
+        }
+      }
+    }
+  }
+}
+
+/* Compiles the session XKB state and lookup tables. On failure the error is
+   kept for start and `startup_failed` is set. */
+static bool axidev_io_linux_listener_begin_session(
+    axidev_io_keyboard_listener_impl *impl) {
   struct axidev_io_linux_listener_platform *platform = impl->platform;
-  struct udev *udev;
-  int fd;
-  struct pollfd poll_fd;
+  axidev_io_result result;
 
-  if (platform == NULL) {
-    atomic_store(&impl->running, false);
-    return 1;
+  result = axidev_io_linux_layout_acquire("axidev_io_listener_start", true,
+                                          &platform->layout);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_linux_listener_fail_startup(platform, result);
+    return false;
   }
 
+  platform->xkb_state = xkb_state_new(platform->layout->keymap);
+  if (platform->xkb_state == NULL) {
+    axidev_io_set_xkb_keymap_error("axidev_io_listener_start");
+    axidev_io_linux_layout_release(platform->layout);
+    platform->layout = NULL;
+    axidev_io_linux_listener_fail_startup(platform,
+                                          AXIDEV_IO_RESULT_PLATFORM_ERROR);
+    return false;
+  }
+  platform->tables = platform->layout->tables;
+  platform->group = 0;
+  platform->keymap_generation = axidev_io_keymap_generation();
+  axidev_io_linux_layout_note_group(0);
+  axidev_io_linux_listener_load_layout(platform);
+  return true;
+}
+
+static void axidev_io_linux_listener_end_session(
+    struct axidev_io_linux_listener_platform *platform) {
   axidev_io_linux_listener_reset_session_state(platform);
+  hmfree(platform->keysym_to_key);
+  if (platform->xkb_state != NULL) {
+    xkb_state_unref(platform->xkb_state);
+    platform->xkb_state = NULL;
+  }
+  axidev_io_linux_layout_release(platform->layout);
+  platform->layout = NULL;
+  platform->tables = NULL;
+}
+
+static int axidev_io_listener_run_libinput(
+    axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_linux_listener_platform *platform = impl->platform;
+  struct udev *udev;
+  struct pollfd poll_fds[2];
 
   udev = udev_new();
   if (udev == NULL) {
+    axidev_io_set_last_error_message("udev_new failed");
+    axidev_io_linux_listener_fail_startup(platform,
+                                          AXIDEV_IO_RESULT_PLATFORM_ERROR);
     atomic_store(&impl->running, false);
     return 1;
   }
@@ -212,6 +558,11 @@ static int axidev_io_listener_thread_main(void *user_data) {
       libinput_udev_create_context(&g_libinput_interface, NULL, udev);
   if (platform->libinput == NULL ||
       libinput_udev_assign_seat(platform->libinput, "seat0") < 0) {
+    axidev_io_set_last_error_message(
+        platform->libinput == NULL ? "libinput context creation failed"
+                                   : "libinput cannot assign seat0");
+    axidev_io_linux_listener_fail_startup(platform,
+                                          AXIDEV_IO_RESULT_PLATFORM_ERROR);
     if (platform->libinput != NULL) {
       libinput_unref(platform->libinput);
       platform->libinput = NULL;
@@ -221,160 +572,477 @@ static int axidev_io_listener_thread_main(void *user_data) {
     return 1;
   }
 
-  platform->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-  if (platform->xkb_context == NULL) {
-    axidev_io_set_xkb_keymap_error("axidev_io_listener_start");
+  if (!axidev_io_linux_listener_begin_session(impl)) {
     libinput_unref(platform->libinput);
     platform->libinput = NULL;
     udev_unref(udev);
-    atomic_store(&platform->startup_failed, true);
     atomic_store(&impl->running, false);
     return 1;
   }
+  atomic_store(&impl->ready, true);
 
-  {
-    axidev_io_xkb_rule_names_strings names = axidev_io_detect_xkb_rule_names();
-    struct xkb_rule_names native_names;
-    memset(&native_names, 0, sizeof(native_names));
-    native_names.rules = names.rules[0] != '\0' ? names.rules : NULL;
-    native_names.model = names.model[0] != '\0' ? names.model : NULL;
-    native_names.layout = names.layout[0] != '\0' ? names.layout : NULL;
-    native_names.variant = names.variant[0] != '\0' ? names.variant : NULL;
-    native_names.options = names.options[0] != '\0' ? names.options : NULL;
-    platform->xkb_keymap = xkb_keymap_new_from_names(
-        platform->xkb_context, names.has_any ? &native_names : NULL,
-        XKB_KEYMAP_COMPILE_NO_FLAGS);
-  }
-  if (platform->xkb_keymap == NULL) {
-    axidev_io_set_xkb_keymap_error("axidev_io_listener_start");
-    xkb_context_unref(platform->xkb_context);
-    platform->xkb_context = NULL;
-    libinput_unref(platform->libinput);
-    platform->libinput = NULL;
-    udev_unref(udev);
-    atomic_store(&platform->startup_failed, true);
-    atomic_store(&impl->running, false);
-    return 1;
+  poll_fds[0].fd = libinput_get_fd(platform->libinput);
+  poll_fds[0].events = POLLIN;
+  poll_fds[1].fd = platform->wake_fd;
+  poll_fds[1].events = POLLIN;
+
+  /* Seat assignment already queued the device-added events. */
+  axidev_io_listener_drain_events(impl);
+  while (atomic_load(&impl->running)) {
+    int poll_result;
+
+    poll_fds[0].revents = 0;
+    poll_fds[1].revents = 0;
+    poll_result = poll(poll_fds, 2, -1);
+    if (poll_result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      AXIDEV_IO_LOG_ERROR("listener poll failed: %s", strerror(errno));
+      break;
+    }
+    if ((poll_fds[1].revents & POLLIN) != 0) {
+      uint64_t wakes;
+      ssize_t consumed = read(platform->wake_fd, &wakes, sizeof(wakes));
+      (void)consumed;
+    }
+    if ((poll_fds[0].revents & POLLIN) != 0) {
+      axidev_io_listener_drain_events(impl);
+    }
   }
 
-  platform->xkb_state = xkb_state_new(platform->xkb_keymap);
-  if (platform->xkb_state == NULL) {
-    axidev_io_set_xkb_keymap_error("axidev_io_listener_start");
-    xkb_keymap_unref(platform->xkb_keymap);
-    platform->xkb_keymap = NULL;
-    xkb_context_unref(platform->xkb_context);
-    platform->xkb_context = NULL;
+  axidev_io_linux_listener_end_session(platform);
+  if (platform->libinput != NULL) {
     libinput_unref(platform->libinput);
     platform->libinput = NULL;
-    udev_unref(udev);
-    atomic_store(&platform->startup_failed, true);
-    atomic_store(&impl->running, false);
-    return 1;
   }
+  udev_unref(udev);
+  atomic_store(&impl->ready, false);
+  return 0;
+}
 
-  axidev_io_linux_keymap_init(&platform->keymap, platform->xkb_keymap,
-                              platform->xkb_state);
-  atomic_store(&impl->ready, true);
+static bool axidev_io_evdev_test_bit(const unsigned long *bits,
+                                     unsigned int bit) {
+  return ((bits[bit / AXIDEV_IO_EVDEV_BITS_PER_LONG] >>
+           (bit % AXIDEV_IO_EVDEV_BITS_PER_LONG)) &
+          1ul) != 0;
+}
 
-  fd = libinput_get_fd(platform->libinput);
-  poll_fd.fd = fd;
-  poll_fd.events = POLLIN;
-  poll_fd.revents = 0;
+static void axidev_io_evdev_assign_bit(unsigned long *bits, unsigned int bit,
+                                       bool value) {
+  unsigned long mask = 1ul << (bit % AXIDEV_IO_EVDEV_BITS_PER_LONG);
 
-  while (atomic_load(&impl->running)) {
-    int poll_result = poll(&poll_fd, 1, 100);
-    if (poll_result > 0 && (poll_fd.revents & POLLIN)) {
-      struct libinput_event *event;
-      libinput_dispatch(platform->libinput);
-      while ((event = libinput_get_event(platform->libinput)) != NULL) {
-        if (libinput_event_get_type(event) == LIBINPUT_EVENT_KEYBOARD_KEY) {
-          axidev_io_listener_handle_key_event(
-              impl, libinput_event_get_keyboard_event(event));
+  if (value) {
+    bits[bit / AXIDEV_IO_EVDEV_BITS_PER_LONG] |= mask;
+  } else {
+    bits[bit / AXIDEV_IO_EVDEV_BITS_PER_LONG] &= ~mask;
+  }
+}
+
+/* Only devices with letter, space and enter keys count as keyboards, which
+   leaves out pointers, touchpads and power or media buttons. */
+static bool axidev_io_evdev_is_keyboard(int fd) {
+  unsigned long ev_bits[AXIDEV_IO_EVDEV_LONGS(EV_CNT)];
+  unsigned long key_bits[AXIDEV_IO_EVDEV_LONGS(KEY_CNT)];
+
+  memset(ev_bits, 0, sizeof(ev_bits));
+  memset(key_bits, 0, sizeof(key_bits));
+  if (ioctl(fd, EVIOCGBIT(0, sizeof(ev_bits)), ev_bits) < 0 ||
+      !axidev_io_evdev_test_bit(ev_bits, EV_KEY) ||
+      ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) < 0) {
+    return false;
+  }
+  return axidev_io_evdev_test_bit(key_bits, KEY_A) &&
+         axidev_io_evdev_test_bit(key_bits, KEY_Z) &&
+         axidev_io_evdev_test_bit(key_bits, KEY_SPACE) &&
+         axidev_io_evdev_test_bit(key_bits, KEY_ENTER);
+}
+
+static bool axidev_io_evdev_parse_node(const char *name,
+                                       unsigned int *out_number) {
+  unsigned int number = 0;
+  const char *cursor;
+
+  if (strncmp(name, "event", 5) != 0 || name[5] == '\0') {
+    return false;
+  }
+  for (cursor = name + 5; *cursor != '\0'; ++cursor) {
+    if (*cursor < '0' || *cursor > '9' || number > 100000u) {
+      return false;
+    }
+    number = number * 10u + (unsigned int)(*cursor - '0');
+  }
+  *out_number = number;
+  return true;
+}
+
+static void
+axidev_io_evdev_open_device(struct axidev_io_linux_listener_platform *platform,
+                            const char *name) {
+  axidev_io_linux_evdev_device *device;
+  unsigned int number;
+  char path[64];
+  clockid_t clock_id = CLOCK_MONOTONIC;
+  int fd;
+
+  if (!axidev_io_evdev_parse_node(name, &number)) {
+    return;
+  }
+  for (size_t i = 0; i < platform->device_count; ++i) {
+    if (platform->devices[i].number == number) {
+      return;
+    }
+  }
+  if (platform->device_count == AXIDEV_IO_EVDEV_MAX_DEVICES) {
+    AXIDEV_IO_LOG_WARN("evdev listener ignores %s: too many keyboards", name);
+    return;
+  }
+
+  snprintf(path, sizeof(path), AXIDEV_IO_EVDEV_DIR "/%s", name);
+  /* Nodes usually appear before udev applies their permissions; IN_ATTRIB
+     brings us back here once it has. */
+  fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  if (!axidev_io_evdev_is_keyboard(fd)) {
+    close(fd);
+    return;
+  }
+  /* Kernel timestamps default to CLOCK_REALTIME. */
+  if (ioctl(fd, EVIOCSCLOCKID, &clock_id) < 0) {
+    AXIDEV_IO_LOG_DEBUG("evdev listener: %s keeps realtime timestamps", path);
+  }
+
+  device = &platform->devices[platform->device_count++];
+  memset(device, 0, sizeof(*device));
+  device->fd = fd;
+  device->number = number;
+  AXIDEV_IO_LOG_DEBUG("evdev listener opened %s", path);
+}
+
+/* Releases what the device still holds, as libinput does on removal, then
+   drops it. */
+static void
+axidev_io_evdev_close_device(axidev_io_keyboard_listener_impl *impl,
+                             size_t index) {
+  struct axidev_io_linux_listener_platform *platform = impl->platform;
+  axidev_io_linux_evdev_device *device = &platform->devices[index];
+  uint64_t now_us = axidev_io_monotonic_time_ns() / 1000u;
+
+  for (unsigned int code = 0; code < AXIDEV_IO_KEYMAP_CODE_LIMIT; ++code) {
+    if (axidev_io_evdev_test_bit(device->down, code)) {
+      axidev_io_listener_translate_key(impl, code, false, now_us);
+    }
+  }
+  close(device->fd);
+  platform->devices[index] = platform->devices[--platform->device_count];
+}
+
+/* After SYN_DROPPED, reconciles our view of held keys with the kernel's. */
+static void axidev_io_evdev_resync(axidev_io_keyboard_listener_impl *impl,
+                                   axidev_io_linux_evdev_device *device) {
+  unsigned long state[AXIDEV_IO_EVDEV_LONGS(KEY_CNT)];
+  uint64_t now_us = axidev_io_monotonic_time_ns() / 1000u;
+
+  memset(state, 0, sizeof(state));
+  if (ioctl(device->fd, EVIOCGKEY(sizeof(state)), state) < 0) {
+    return;
+  }
+  for (unsigned int code = 0; code < AXIDEV_IO_KEYMAP_CODE_LIMIT; ++code) {
+    bool down = axidev_io_evdev_test_bit(state, code);
+    if (down != axidev_io_evdev_test_bit(device->down, code)) {
+      axidev_io_evdev_assign_bit(device->down, code, down);
+      axidev_io_listener_translate_key(impl, code, down, now_us);
+    }
+  }
+}
+
+/* Drains one device; returns false once it is gone. */
+static bool axidev_io_evdev_read_device(axidev_io_keyboard_listener_impl *impl,
+                                        axidev_io_linux_evdev_device *device) {
+  struct input_event events[AXIDEV_IO_EVDEV_READ_BATCH];
+
+  for (;;) {
+    ssize_t bytes = read(device->fd, events, sizeof(events));
+    size_t count;
+
+    if (bytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN;
+    }
+    if (bytes == 0) {
+      return false;
+    }
+    count = (size_t)bytes / sizeof(events[0]);
+    for (size_t i = 0; i < count; ++i) {
+      const struct input_event *event = &events[i];
+      bool pressed;
+
+      if (event->type == EV_SYN) {
+        if (event->code == SYN_DROPPED) {
+          device->syncing = true;
+        } else if (event->code == SYN_REPORT && device->syncing) {
+          device->syncing = false;
+          axidev_io_evdev_resync(impl, device);
         }
-        libinput_event_destroy(event);
+        continue;
+      }
+      /* Like libinput, leave kernel autorepeat (value 2) out. */
+      if (device->syncing || event->type != EV_KEY || event->value == 2 ||
+          event->code >= AXIDEV_IO_KEYMAP_CODE_LIMIT) {
+        continue;
       }
+      pressed = event->value != 0;
+      if (pressed == axidev_io_evdev_test_bit(device->down, event->code)) {
+        continue;
+      }
+      axidev_io_evdev_assign_bit(device->down, event->code, pressed);
+      axidev_io_listener_translate_key(
+          impl, event->code, pressed,
+          (uint64_t)event->input_event_sec * 1000000u +
+              (uint64_t)event->input_event_usec);
+    }
+    if (count < AXIDEV_IO_EVDEV_READ_BATCH) {
+      return true;
     }
-    axidev_io_sleep_ms(1);
   }
+}
 
-  axidev_io_linux_keymap_free(&platform->keymap);
-  axidev_io_linux_listener_reset_session_state(platform);
-  if (platform->xkb_state != NULL) {
-    xkb_state_unref(platform->xkb_state);
-    platform->xkb_state = NULL;
+static void
+axidev_io_evdev_handle_inotify(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_linux_listener_platform *platform = impl->platform;
+  _Alignas(struct inotify_event) char buffer[4096];
+
+  for (;;) {
+    ssize_t bytes = read(platform->inotify_fd, buffer, sizeof(buffer));
+    char *cursor = buffer;
+
+    if (bytes <= 0) {
+      if (bytes < 0 && errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    while (cursor < buffer + bytes) {
+      const struct inotify_event *event = (const struct inotify_event *)cursor;
+      unsigned int number;
+
+      cursor += sizeof(*event) + event->len;
+      if (event->len == 0) {
+        continue;
+      }
+      if ((event->mask & (IN_CREATE | IN_ATTRIB)) != 0) {
+        axidev_io_evdev_open_device(platform, event->name);
+      } else if ((event->mask & IN_DELETE) != 0 &&
+                 axidev_io_evdev_parse_node(event->name, &number)) {
+        for (size_t i = 0; i < platform->device_count; ++i) {
+          if (platform->devices[i].number == number) {
+            axidev_io_evdev_close_device(impl, i);
+            break;
+          }
+        }
+      }
+    }
   }
-  if (platform->xkb_keymap != NULL) {
-    xkb_keymap_unref(platform->xkb_keymap);
-    platform->xkb_keymap = NULL;
+}
+
+static void
+axidev_io_evdev_close_all(struct axidev_io_linux_listener_platform *platform) {
+  for (size_t i = 0; i < platform->device_count; ++i) {
+    close(platform->devices[i].fd);
   }
-  if (platform->xkb_context != NULL) {
-    xkb_context_unref(platform->xkb_context);
-    platform->xkb_context = NULL;
+  platform->device_count = 0;
+  if (platform->inotify_fd >= 0) {
+    close(platform->inotify_fd);
+    platform->inotify_fd = -1;
   }
-  if (platform->libinput != NULL) {
-    libinput_unref(platform->libinput);
-    platform->libinput = NULL;
+}
+
+static int
+axidev_io_listener_run_evdev(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_linux_listener_platform *platform = impl->platform;
+  struct pollfd poll_fds[2 + AXIDEV_IO_EVDEV_MAX_DEVICES];
+  DIR *dir;
+  struct dirent *entry;
+
+  platform->device_count = 0;
+  /* Watch before scanning so a device plugged in between is not missed. */
+  platform->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (platform->inotify_fd < 0 ||
+      inotify_add_watch(platform->inotify_fd, AXIDEV_IO_EVDEV_DIR,
+                        IN_CREATE | IN_ATTRIB | IN_DELETE) < 0) {
+    axidev_io_set_last_errorf("evdev listener cannot watch %s: %s",
+                              AXIDEV_IO_EVDEV_DIR, strerror(errno));
+    axidev_io_evdev_close_all(platform);
+    axidev_io_linux_listener_fail_startup(platform,
+                                          AXIDEV_IO_RESULT_PLATFORM_ERROR);
+    atomic_store(&impl->running, false);
+    return 1;
   }
-  udev_unref(udev);
+  if (!axidev_io_linux_listener_begin_session(impl)) {
+    axidev_io_evdev_close_all(platform);
+    atomic_store(&impl->running, false);
+    return 1;
+  }
+
+  dir = opendir(AXIDEV_IO_EVDEV_DIR);
+  if (dir != NULL) {
+    while ((entry = readdir(dir)) != NULL) {
+      axidev_io_evdev_open_device(platform, entry->d_name);
+    }
+    closedir(dir);
+  }
+  if (platform->device_count == 0) {
+    AXIDEV_IO_LOG_WARN("evdev listener found no readable keyboards in %s",
+                       AXIDEV_IO_EVDEV_DIR);
+  }
+  atomic_store(&impl->ready, true);
+
+  while (atomic_load(&impl->running)) {
+    size_t device_count = platform->device_count;
+    int poll_result;
+
+    poll_fds[0].fd = platform->wake_fd;
+    poll_fds[1].fd = platform->inotify_fd;
+    for (size_t i = 0; i < device_count; ++i) {
+      poll_fds[2 + i].fd = platform->devices[i].fd;
+    }
+    for (size_t i = 0; i < 2 + device_count; ++i) {
+      poll_fds[i].events = POLLIN;
+      poll_fds[i].revents = 0;
+    }
+    poll_result = poll(poll_fds, (nfds_t)(2 + device_count), -1);
+    if (poll_result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      AXIDEV_IO_LOG_ERROR("listener poll failed: %s", strerror(errno));
+      break;
+    }
+    if ((poll_fds[0].revents & POLLIN) != 0) {
+      uint64_t wakes;
+      ssize_t consumed = read(platform->wake_fd, &wakes, sizeof(wakes));
+      (void)consumed;
+    }
+    /* Backwards, so closing a device only moves one already visited. */
+    for (size_t i = device_count; i-- > 0;) {
+      short revents = poll_fds[2 + i].revents;
+      if (revents == 0) {
+        continue;
+      }
+      if ((revents & (POLLERR | POLLHUP | POLLNVAL)) != 0 ||
+          !axidev_io_evdev_read_device(impl, &platform->devices[i])) {
+        axidev_io_evdev_close_device(impl, i);
+      }
+    }
+    if ((poll_fds[1].revents & POLLIN) != 0) {
+      axidev_io_evdev_handle_inotify(impl);
+    }
+    axidev_io_linux_listener_flush(impl);
+  }
+
+  axidev_io_evdev_close_all(platform);
+  axidev_io_linux_listener_end_session(platform);
   atomic_store(&impl->ready, false);
   return 0;
 }
 
+static int axidev_io_listener_thread_main(void *user_data) {
+  axidev_io_keyboard_listener_impl *impl =
+      (axidev_io_keyboard_listener_impl *)user_data;
+  struct axidev_io_linux_listener_platform *platform = impl->platform;
+
+  if (platform == NULL) {
+    atomic_store(&impl->running, false);
+    return 1;
+  }
+
+  axidev_io_linux_listener_reset_session_state(platform);
+  return platform->use_evdev ? axidev_io_listener_run_evdev(impl)
+                             : axidev_io_listener_run_libinput(impl);
+}
+
 axidev_io_keyboard_listener_impl *axidev_io_listener_impl_get(void) {
   return (axidev_io_keyboard_listener_impl *)axidev_io_listener_storage_ptr();
 }
 
+static bool axidev_io_linux_listener_ensure_platform(
+    axidev_io_keyboard_listener_impl *impl) {
+  if (impl->platform != NULL) {
+    axidev_io_linux_listener_reset_session_state(impl->platform);
+    return true;
+  }
+  impl->platform = (struct axidev_io_linux_listener_platform *)calloc(
+      1, sizeof(*impl->platform));
+  if (impl->platform == NULL) {
+    return false;
+  }
+  impl->platform->wake_fd = -1;
+  impl->platform->inotify_fd = -1;
+  return true;
+}
+
 axidev_io_result axidev_io_keyboard_listener_start_internal(
-    axidev_io_keyboard_listener_cb callback, void *user_data) {
+    axidev_io_keyboard_listener_cb callback,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data) {
   axidev_io_keyboard_listener_impl *impl = axidev_io_listener_impl_get();
 
-  if (callback == NULL) {
+  if ((callback == NULL) == (batch_callback == NULL)) {
     return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
   }
 
-  if (!impl->callback_lock_ready) {
-    axidev_io_mutex_init(&impl->callback_lock);
-    impl->callback_lock_ready = true;
-  }
-
   if (atomic_load(&impl->running)) {
     return AXIDEV_IO_RESULT_ALREADY_INITIALIZED;
   }
 
-  if (impl->platform == NULL) {
-    impl->platform = (struct axidev_io_linux_listener_platform *)calloc(
-        1, sizeof(*impl->platform));
-    if (impl->platform == NULL) {
-      return AXIDEV_IO_RESULT_INTERNAL_ERROR;
-    }
-  } else {
-    axidev_io_linux_listener_reset_session_state(impl->platform);
+  if (!axidev_io_linux_listener_ensure_platform(impl)) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
   }
 
   atomic_store(&impl->platform->startup_failed, false);
+  impl->platform->use_evdev =
+      (impl->options & AXIDEV_IO_LISTENER_OPTION_EVDEV) != 0;
+  impl->platform->filter = impl->filter;
+  impl->platform->filtering =
+      axidev_io_listener_filter_is_active(&impl->platform->filter);
+  axidev_io_keyboard_listener_reset_stats(impl);
+  axidev_io_linux_listener_close_wake_fd(impl->platform);
+  impl->platform->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (impl->platform->wake_fd < 0) {
+    axidev_io_set_last_errorf("listener eventfd failed: %s",
+                              strerror(errno));
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
 
-  axidev_io_mutex_lock(&impl->callback_lock);
-  impl->callback = callback;
-  impl->user_data = user_data;
-  axidev_io_mutex_unlock(&impl->callback_lock);
+  if (axidev_io_keyboard_listener_set_callback(impl, callback, batch_callback,
+                                                user_data) !=
+      AXIDEV_IO_RESULT_OK) {
+    axidev_io_linux_listener_close_wake_fd(impl->platform);
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
 
   atomic_store(&impl->running, true);
   atomic_store(&impl->ready, false);
   if (!axidev_io_thread_create(&impl->worker, axidev_io_listener_thread_main,
                                impl)) {
     atomic_store(&impl->running, false);
+    axidev_io_linux_listener_close_wake_fd(impl->platform);
     return AXIDEV_IO_RESULT_PLATFORM_ERROR;
   }
 
   for (int i = 0; i < 40; ++i) {
     if (!atomic_load(&impl->running)) {
       axidev_io_thread_join(&impl->worker);
-      if (atomic_load(&impl->platform->startup_failed)) {
-        return AXIDEV_IO_RESULT_PLATFORM_ERROR;
-      }
-      return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+      axidev_io_linux_listener_close_wake_fd(impl->platform);
+      return axidev_io_linux_listener_startup_result(impl->platform);
     }
     if (atomic_load(&impl->ready)) {
+      impl->backend_type = impl->platform->use_evdev
+                               ? AXIDEV_IO_BACKEND_LINUX_EVDEV
+                               : AXIDEV_IO_BACKEND_LINUX_LIBINPUT;
       axidev_io_listener_public_context()->initialized = true;
       axidev_io_listener_public_context()->is_listening = true;
       return AXIDEV_IO_RESULT_OK;
@@ -383,17 +1051,59 @@ axidev_io_result axidev_io_keyboard_listener_start_internal(
   }
 
   if (atomic_load(&impl->ready)) {
+    impl->backend_type = impl->platform->use_evdev
+                             ? AXIDEV_IO_BACKEND_LINUX_EVDEV
+                             : AXIDEV_IO_BACKEND_LINUX_LIBINPUT;
     axidev_io_listener_public_context()->initialized = true;
     axidev_io_listener_public_context()->is_listening = true;
     return AXIDEV_IO_RESULT_OK;
   }
 
   atomic_store(&impl->running, false);
+  axidev_io_linux_listener_wake(impl->platform);
   axidev_io_thread_join(&impl->worker);
-  if (atomic_load(&impl->platform->startup_failed)) {
+  axidev_io_linux_listener_close_wake_fd(impl->platform);
+  return axidev_io_linux_listener_startup_result(impl->platform);
+}
+
+axidev_io_result axidev_io_keyboard_listener_replay_for_tests(
+    const axidev_io_listener_synthetic_key *keys, size_t count,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data) {
+  axidev_io_keyboard_listener_impl *impl = axidev_io_listener_impl_get();
+  struct axidev_io_linux_listener_platform *platform;
+  uint64_t now_us;
+
+  if (batch_callback == NULL || (keys == NULL && count != 0)) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if (atomic_load(&impl->running)) {
+    return AXIDEV_IO_RESULT_ALREADY_INITIALIZED;
+  }
+  if (!axidev_io_linux_listener_ensure_platform(impl)) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  platform = impl->platform;
+  platform->filter = impl->filter;
+  platform->filtering = axidev_io_listener_filter_is_active(&platform->filter);
+  if (axidev_io_keyboard_listener_set_callback(impl, NULL, batch_callback,
+                                                user_data) !=
+      AXIDEV_IO_RESULT_OK) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  if (!axidev_io_linux_listener_begin_session(impl)) {
+    axidev_io_keyboard_listener_set_callback(impl, NULL, NULL, NULL);
     return AXIDEV_IO_RESULT_PLATFORM_ERROR;
   }
-  return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+
+  now_us = axidev_io_monotonic_time_ns() / 1000u;
+  for (size_t i = 0; i < count; ++i) {
+    axidev_io_listener_translate_key(impl, keys[i].code, keys[i].pressed,
+                                     now_us);
+  }
+  axidev_io_linux_listener_flush(impl);
+  axidev_io_linux_listener_end_session(platform);
+  axidev_io_keyboard_listener_set_callback(impl, NULL, NULL, NULL);
+  return AXIDEV_IO_RESULT_OK;
 }
 
 void axidev_io_keyboard_listener_stop_internal(void) {
@@ -405,7 +1115,10 @@ void axidev_io_keyboard_listener_stop_internal(void) {
   }
 
   atomic_store(&impl->running, false);
+  axidev_io_linux_listener_wake(impl->platform);
   axidev_io_thread_join(&impl->worker);
+  axidev_io_linux_listener_close_wake_fd(impl->platform);
+  impl->backend_type = AXIDEV_IO_BACKEND_UNKNOWN;
   axidev_io_listener_public_context()->is_listening = false;
   axidev_io_listener_public_context()->initialized = impl->platform != NULL;
 }
@@ -10,36 +10,84 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <stb/stb_ds.h>
-
 #include "../common/key_utils_internal.h"
 #include "../common/windows_keymap_internal.h"
 
-typedef struct axidev_io_vk_codepoint_entry {
-  uint32_t key;
-  uint32_t value;
-} axidev_io_vk_codepoint_entry;
-
-typedef struct axidev_io_vk_time_entry {
-  uint32_t key;
-  uint64_t value;
-} axidev_io_vk_time_entry;
-
-typedef struct axidev_io_vk_signature {
-  uint32_t codepoint;
-  axidev_io_keyboard_modifier_t mods;
-} axidev_io_vk_signature;
-
-typedef struct axidev_io_vk_signature_entry {
-  uint32_t key;
-  axidev_io_vk_signature value;
-} axidev_io_vk_signature_entry;
+/* Per-virtual-key session state; everything one event reads or writes
+   lives in one slot. */
+typedef struct axidev_io_windows_key_slot {
+  /* Codepoint of the last press, reported again on release; 0 if none. */
+  uint32_t press_codepoint;
+  /* Signature of the last release, used to drop duplicate releases. */
+  uint32_t release_codepoint;
+  uint64_t release_time_ms;
+  axidev_io_keyboard_modifier_t release_mods;
+  bool has_release;
+  /* The last press passed the session filter. */
+  bool reported;
+} axidev_io_windows_key_slot;
+
+/* Power of two so indices can wrap with a mask. */
+#define AXIDEV_IO_WINDOWS_HOOK_RING_CAPACITY 1024u
+/* GetRawInputBuffer() scratch space; a keyboard record is about 40 bytes. */
+#define AXIDEV_IO_WINDOWS_RAW_BUFFER_SIZE 16384u
+#define AXIDEV_IO_WINDOWS_RAW_CLASS L"axidev_io_raw_input"
+
+typedef struct axidev_io_windows_hook_event {
+  KBDLLHOOKSTRUCT kbd;
+  bool pressed;
+} axidev_io_windows_hook_event;
+
+/* Single-producer/single-consumer ring between the hook (producer) and the
+   dispatcher thread (consumer). The indices grow monotonically and sit on
+   separate cache lines. */
+typedef struct axidev_io_windows_hook_ring {
+  atomic_size_t head;
+  char head_pad[64 - sizeof(atomic_size_t)];
+  atomic_size_t tail;
+  char tail_pad[64 - sizeof(atomic_size_t)];
+  axidev_io_windows_hook_event slots[AXIDEV_IO_WINDOWS_HOOK_RING_CAPACITY];
+} axidev_io_windows_hook_ring;
+
+typedef struct axidev_io_windows_listener_layout {
+  HKL layout;
+  axidev_io_keymap_tables *tables;
+} axidev_io_windows_listener_layout;
 
 struct axidev_io_windows_keymap_private {
-  axidev_io_windows_keymap keymap;
-  axidev_io_vk_codepoint_entry *last_press_cp;
-  axidev_io_vk_time_entry *last_release_time;
-  axidev_io_vk_signature_entry *last_release_sig;
+  /* Tables of `layout`, the HKL events were last translated with. */
+  axidev_io_keymap_tables *tables;
+  HKL layout;
+  /* Recently seen layouts, most recent first, so flipping between two
+     layouts does not rebuild their tables. */
+  axidev_io_windows_listener_layout recent[AXIDEV_IO_KEYMAP_RECENT_LAYOUTS];
+  size_t recent_count;
+  /* AXIDEV_IO_LISTENER_OPTION_RAW_INPUT, latched at start. */
+  bool use_raw_input;
+  /* Set by a worker that failed to start, with the error it recorded;
+     start re-raises it on the calling thread after the join. */
+  bool startup_failed;
+  axidev_io_error_record startup_error;
+  /* Session copy of the listener filter; `filter_codes` holds
+     AXIDEV_IO_LISTENER_CODE_* flags per virtual key. */
+  axidev_io_listener_filter_t filter;
+  bool filtering;
+  uint8_t filter_codes[256];
+  RAWINPUT *raw_buffer;
+  axidev_io_windows_key_slot keys[256];
+  /* Deferred dispatch session state; `ring` is NULL when the hook handles
+     events itself. */
+  axidev_io_windows_hook_ring *ring;
+  HANDLE ring_event;
+  axidev_io_thread dispatcher;
+  atomic_bool dispatching;
+  /* Key state as of the last dispatched event, standing in for
+     GetKeyboardState() which is not meaningful off the hook thread. Raw
+     Input sessions use it the same way. */
+  BYTE key_state[256];
+  /* Events the dispatcher translated since its last delivery. */
+  axidev_io_key_event_t batch[AXIDEV_IO_LISTENER_BATCH_CAPACITY];
+  size_t batch_count;
 };
 
 static _Atomic(axidev_io_keyboard_listener_impl *) g_active_listener;
@@ -49,9 +97,70 @@ static void axidev_io_windows_listener_reset_session_state(
   if (platform == NULL) {
     return;
   }
-  hmfree(platform->last_press_cp);
-  hmfree(platform->last_release_time);
-  hmfree(platform->last_release_sig);
+  memset(platform->keys, 0, sizeof(platform->keys));
+}
+
+/* Keeps the error just recorded on the worker thread for start. */
+static void axidev_io_windows_listener_fail_startup(
+    struct axidev_io_windows_keymap_private *platform) {
+  axidev_io_last_error_save(&platform->startup_error);
+  platform->startup_error.code = AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  platform->startup_failed = true;
+}
+
+/* Moves a failed worker's error onto the calling thread. */
+static axidev_io_result axidev_io_windows_listener_startup_result(
+    struct axidev_io_windows_keymap_private *platform) {
+  if (!platform->startup_failed) {
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  axidev_io_last_error_restore(&platform->startup_error);
+  return platform->startup_error.code;
+}
+
+/* Makes the tables of `layout` current, building them unless the layout was
+   seen recently. */
+static axidev_io_result axidev_io_windows_listener_use_layout(
+    struct axidev_io_windows_keymap_private *platform, HKL layout) {
+  axidev_io_windows_listener_layout entry;
+  size_t index = platform->recent_count;
+
+  for (size_t i = 0; i < platform->recent_count; ++i) {
+    if (platform->recent[i].layout == layout) {
+      index = i;
+      break;
+    }
+  }
+  if (index == platform->recent_count) {
+    axidev_io_windows_keymap keymap;
+    axidev_io_result result;
+
+    memset(&entry, 0, sizeof(entry));
+    memset(&keymap, 0, sizeof(keymap));
+    entry.layout = layout;
+    axidev_io_windows_keymap_init(&keymap, layout);
+    result = axidev_io_keymap_tables_build(
+        &entry.tables, keymap.key_to_vk, keymap.vk_to_key,
+        keymap.vk_and_mods_to_key, keymap.char_to_keycode);
+    axidev_io_windows_keymap_free(&keymap);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
+    }
+    if (platform->recent_count == AXIDEV_IO_KEYMAP_RECENT_LAYOUTS) {
+      --index;
+      axidev_io_keymap_tables_free(&platform->recent[index].tables);
+    } else {
+      ++platform->recent_count;
+    }
+  } else {
+    entry = platform->recent[index];
+  }
+  memmove(&platform->recent[1], &platform->recent[0],
+          index * sizeof(platform->recent[0]));
+  platform->recent[0] = entry;
+  platform->tables = entry.tables;
+  platform->layout = layout;
+  return AXIDEV_IO_RESULT_OK;
 }
 
 static uint32_t axidev_io_codepoint_from_key(axidev_io_keyboard_key_t key) {
@@ -67,6 +176,29 @@ static uint32_t axidev_io_codepoint_from_key(axidev_io_keyboard_key_t key) {
   return 0;
 }
 
+static axidev_io_keyboard_modifier_t
+axidev_io_listener_modifiers_from_state(const BYTE *state) {
+  axidev_io_keyboard_modifier_t mods = AXIDEV_IO_MOD_NONE;
+
+  if (state[VK_SHIFT] & 0x80) {
+    mods |= AXIDEV_IO_MOD_SHIFT;
+  }
+  if (state[VK_CONTROL] & 0x80) {
+    mods |= AXIDEV_IO_MOD_CTRL;
+  }
+  if (state[VK_MENU] & 0x80) {
+    mods |= AXIDEV_IO_MOD_ALT;
+  }
+  if ((state[VK_LWIN] & 0x80) || (state[VK_RWIN] & 0x80)) {
+    mods |= AXIDEV_IO_MOD_SUPER;
+  }
+  if (state[VK_CAPITAL] & 0x01) {
+    mods |= AXIDEV_IO_MOD_CAPSLOCK;
+  }
+
+  return mods;
+}
+
 static axidev_io_keyboard_modifier_t axidev_io_listener_derive_modifiers(void) {
   axidev_io_keyboard_modifier_t mods = AXIDEV_IO_MOD_NONE;
 
@@ -89,67 +221,132 @@ static axidev_io_keyboard_modifier_t axidev_io_listener_derive_modifiers(void) {
   return mods;
 }
 
-static void axidev_io_listener_invoke_callback(
-    axidev_io_keyboard_listener_impl *impl, uint32_t codepoint,
-    axidev_io_keyboard_key_with_modifier_t key_mod, bool pressed) {
-  axidev_io_keyboard_listener_cb callback = NULL;
-  void *user_data = NULL;
+static void axidev_io_windows_fill_event(
+    axidev_io_key_event_t *out, const KBDLLHOOKSTRUCT *kbd, uint32_t codepoint,
+    axidev_io_keyboard_key_t key, axidev_io_keyboard_modifier_t mods,
+    bool pressed) {
+  /* The hook time is the low 32 bits of the tick count; rebase its age onto
+     the library's monotonic clock. */
+  DWORD age_ms = GetTickCount() - kbd->time;
+  uint64_t now_us = axidev_io_monotonic_time_ns() / 1000u;
+  uint64_t age_us = (uint64_t)age_ms * 1000u;
+
+  out->timestamp_us = now_us > age_us ? now_us - age_us : 0;
+  out->dispatch_time_us = 0;
+  out->codepoint = codepoint;
+  out->code = (uint32_t)kbd->vkCode;
+  out->key_mod.key = key;
+  out->key_mod.mods = mods;
+  out->pressed = pressed;
+}
+
+/* Runs ToUnicodeEx() for one event; returns false when the hook thread's
+   keyboard state is unavailable. */
+static bool axidev_io_windows_event_codepoint(const KBDLLHOOKSTRUCT *kbd,
+                                              const BYTE *tracked_state,
+                                              HKL layout,
+                                              uint32_t *out_codepoint) {
+  BYTE keyboard_state[256];
+  const BYTE *state = keyboard_state;
+  wchar_t wbuf[4] = {0};
+  int ret;
 
-  axidev_io_mutex_lock(&impl->callback_lock);
-  callback = impl->callback;
-  user_data = impl->user_data;
-  axidev_io_mutex_unlock(&impl->callback_lock);
+  *out_codepoint = 0;
+  if (tracked_state != NULL) {
+    state = tracked_state;
+  } else if (!GetKeyboardState(keyboard_state)) {
+    return false;
+  }
 
-  if (callback != NULL) {
-    callback(codepoint, key_mod, pressed, user_data);
+  ret = ToUnicodeEx((UINT)kbd->vkCode, kbd->scanCode, state, wbuf,
+                    (int)(sizeof(wbuf) / sizeof(wbuf[0])), 0, layout);
+  if (ret == 1) {
+    *out_codepoint = (uint32_t)wbuf[0];
+  } else if (ret >= 2 && wbuf[0] >= 0xD800 && wbuf[0] <= 0xDBFF &&
+             wbuf[1] >= 0xDC00 && wbuf[1] <= 0xDFFF) {
+    *out_codepoint = 0x10000u + ((((uint32_t)wbuf[0] - 0xD800u) << 10) |
+                                 ((uint32_t)wbuf[1] - 0xDC00u));
   }
+  return true;
 }
 
-static void
+/* Translates one hook event into `out`; returns false when it should not
+   be reported. `tracked_state` is the dispatcher's key state; NULL means
+   running inside the hook, where the thread's own key state is current. */
+static bool
 axidev_io_listener_handle_event(axidev_io_keyboard_listener_impl *impl,
-                                const KBDLLHOOKSTRUCT *kbd, bool pressed) {
+                                const KBDLLHOOKSTRUCT *kbd, bool pressed,
+                                const BYTE *tracked_state,
+                                axidev_io_key_event_t *out) {
   struct axidev_io_windows_keymap_private *platform = impl->platform;
+  const axidev_io_listener_filter_t *filter;
+  HKL layout;
   WORD vk;
   axidev_io_keyboard_modifier_t mods;
   axidev_io_keyboard_key_t mapped_key;
-  BYTE keyboard_state[256];
-  wchar_t wbuf[4] = {0};
   uint32_t codepoint = 0;
-  uint32_t vk_key;
-  int ret;
+  axidev_io_windows_key_slot *slot;
 
   if (impl == NULL || kbd == NULL || platform == NULL) {
-    return;
+    return false;
   }
 
   vk = (WORD)kbd->vkCode;
-  vk_key = (uint32_t)vk;
-  mods = axidev_io_listener_derive_modifiers();
-  mapped_key = axidev_io_windows_resolve_key_from_vk_and_mods(&platform->keymap,
-                                                              vk, mods);
-
-  if (!GetKeyboardState(keyboard_state)) {
-    axidev_io_keyboard_key_with_modifier_t key_mod = {mapped_key, mods};
-    axidev_io_listener_invoke_callback(impl, 0, key_mod, pressed);
-    return;
+  if (kbd->vkCode >= 256) {
+    return false;
   }
-
-  ret = ToUnicodeEx(vk, kbd->scanCode, keyboard_state, wbuf,
-                    (int)(sizeof(wbuf) / sizeof(wbuf[0])), 0,
-                    GetKeyboardLayout(0));
-  if (ret == 1) {
-    codepoint = (uint32_t)wbuf[0];
-  } else if (ret >= 2 && wbuf[0] >= 0xD800 && wbuf[0] <= 0xDBFF &&
-             wbuf[1] >= 0xDC00 && wbuf[1] <= 0xDFFF) {
-    codepoint = 0x10000u + ((((uint32_t)wbuf[0] - 0xD800u) << 10) |
-                            ((uint32_t)wbuf[1] - 0xDC00u));
+  axidev_io_stats_add(AXIDEV_IO_STAT_LISTENER_EVENTS_RECEIVED, 1u);
+  /* ToUnicodeEx() follows the thread's layout, so the tables do too. */
+  layout = GetKeyboardLayout(0);
+  if (layout != platform->layout &&
+      axidev_io_windows_listener_use_layout(platform, layout) ==
+          AXIDEV_IO_RESULT_OK &&
+      platform->filtering) {
+    axidev_io_listener_filter_build_codes(&platform->filter, platform->tables,
+                                          256, platform->filter_codes);
+  }
+  filter = &platform->filter;
+  slot = &platform->keys[vk];
+  if (platform->filtering) {
+    /* Releases follow their press; presses must pass the code and modifier
+       checks before anything is translated. */
+    if (!pressed) {
+      if (!slot->reported) {
+        return false;
+      }
+    } else if ((platform->filter_codes[vk] & AXIDEV_IO_LISTENER_CODE_PASS) ==
+               0) {
+      return false;
+    }
+  }
+  mods = tracked_state != NULL
+             ? axidev_io_listener_modifiers_from_state(tracked_state)
+             : axidev_io_listener_derive_modifiers();
+  if (pressed && platform->filtering &&
+      (mods & filter->required_mods) != filter->required_mods) {
+    return false;
+  }
+  mapped_key = axidev_io_keymap_tables_key_from_code(platform->tables,
+                                                     (int32_t)vk, mods);
+  if (platform->filtering) {
+    if (pressed && !axidev_io_listener_filter_accepts_key(filter, mapped_key)) {
+      return false;
+    }
+    slot->reported = pressed;
   }
 
-  if (mapped_key != AXIDEV_IO_KEY_UNKNOWN &&
-      !axidev_io_keyboard_has_modifier(mods, AXIDEV_IO_MOD_SHIFT)) {
-    uint32_t derived = axidev_io_codepoint_from_key(mapped_key);
-    if (derived != 0) {
-      codepoint = derived;
+  if (!filter->keys_only) {
+    if (!axidev_io_windows_event_codepoint(kbd, tracked_state, layout,
+                                           &codepoint)) {
+      axidev_io_windows_fill_event(out, kbd, 0, mapped_key, mods, pressed);
+      return true;
+    }
+    if (mapped_key != AXIDEV_IO_KEY_UNKNOWN &&
+        !axidev_io_keyboard_has_modifier(mods, AXIDEV_IO_MOD_SHIFT)) {
+      uint32_t derived = axidev_io_codepoint_from_key(mapped_key);
+      if (derived != 0) {
+        codepoint = derived;
+      }
     }
   }
 
@@ -159,45 +356,198 @@ axidev_io_listener_handle_event(axidev_io_keyboard_listener_impl *impl,
   }
 
   if (pressed) {
-    if (codepoint != 0) {
-      hmput(platform->last_press_cp, vk_key, codepoint);
-    } else {
-      (void)hmdel(platform->last_press_cp, vk_key);
-    }
+    slot->press_codepoint = codepoint;
   } else {
-    ptrdiff_t press_index;
-    press_index = hmgeti(platform->last_press_cp, vk_key);
-    if (codepoint == 0 && press_index >= 0 &&
-        mapped_key != AXIDEV_IO_KEY_ENTER &&
+    /* Deferred events are handled late, so use their own timestamp. */
+    uint64_t now = tracked_state != NULL ? (uint64_t)kbd->time
+                                         : axidev_io_monotonic_time_ms();
+    bool duplicate;
+
+    if (codepoint == 0 && mapped_key != AXIDEV_IO_KEY_ENTER &&
         mapped_key != AXIDEV_IO_KEY_BACKSPACE) {
-      codepoint = platform->last_press_cp[press_index].value;
+      codepoint = slot->press_codepoint;
+    }
+    duplicate = slot->has_release && (now - slot->release_time_ms) < 50u &&
+                slot->release_codepoint == codepoint &&
+                slot->release_mods == mods;
+    slot->press_codepoint = 0;
+    slot->release_codepoint = codepoint;
+    slot->release_time_ms = now;
+    slot->release_mods = mods;
+    slot->has_release = true;
+    if (duplicate) {
+      axidev_io_stats_add(AXIDEV_IO_STAT_LISTENER_EVENTS_DEDUPLICATED, 1u);
+      return false;
     }
+  }
 
-    {
-      ptrdiff_t time_index = hmgeti(platform->last_release_time, vk_key);
-      ptrdiff_t sig_index = hmgeti(platform->last_release_sig, vk_key);
-      uint64_t now = axidev_io_monotonic_time_ms();
-      if (time_index >= 0 && sig_index >= 0 &&
-          (now - platform->last_release_time[time_index].value) < 50u &&
-          platform->last_release_sig[sig_index].value.codepoint == codepoint &&
-          platform->last_release_sig[sig_index].value.mods == mods) {
-        hmput(platform->last_release_time, vk_key, now);
-        hmput(platform->last_release_sig, vk_key,
-              ((axidev_io_vk_signature){codepoint, mods}));
-        (void)hmdel(platform->last_press_cp, vk_key);
-        return;
-      }
-      hmput(platform->last_release_time, vk_key, now);
-      hmput(platform->last_release_sig, vk_key,
-            ((axidev_io_vk_signature){codepoint, mods}));
-      (void)hmdel(platform->last_press_cp, vk_key);
+  axidev_io_windows_fill_event(out, kbd, codepoint, mapped_key, mods,
+                               pressed);
+  return true;
+}
+
+/* Hook side of deferred dispatch: copy the event, publish it and return. */
+static void
+axidev_io_windows_ring_push(axidev_io_keyboard_listener_impl *impl,
+                            const KBDLLHOOKSTRUCT *kbd, bool pressed) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+  axidev_io_windows_hook_ring *ring = platform->ring;
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  size_t used = head - tail;
+  axidev_io_windows_hook_event *slot;
+
+  if (used >= AXIDEV_IO_WINDOWS_HOOK_RING_CAPACITY) {
+    atomic_fetch_add_explicit(&impl->events_dropped, 1, memory_order_relaxed);
+    axidev_io_stats_add(AXIDEV_IO_STAT_LISTENER_EVENTS_DROPPED, 1u);
+    return;
+  }
+  slot = &ring->slots[head & (AXIDEV_IO_WINDOWS_HOOK_RING_CAPACITY - 1u)];
+  slot->kbd = *kbd;
+  slot->pressed = pressed;
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  /* Only the hook thread writes the high-water mark, unless the pull queue
+     owns the queue statistics. */
+  if (impl->queue == NULL &&
+      (unsigned)(used + 1) >
+      atomic_load_explicit(&impl->queue_high_water, memory_order_relaxed)) {
+    atomic_store_explicit(&impl->queue_high_water, (unsigned)(used + 1),
+                          memory_order_relaxed);
+  }
+  SetEvent(platform->ring_event);
+}
+
+static void axidev_io_windows_seed_key_state(BYTE *state) {
+  int vk;
+
+  for (vk = 0; vk < 256; ++vk) {
+    state[vk] = (GetAsyncKeyState(vk) & 0x8000) ? 0x80 : 0x00;
+  }
+  state[VK_CAPITAL] |= (BYTE)(GetKeyState(VK_CAPITAL) & 0x0001);
+  state[VK_NUMLOCK] |= (BYTE)(GetKeyState(VK_NUMLOCK) & 0x0001);
+  state[VK_SCROLL] |= (BYTE)(GetKeyState(VK_SCROLL) & 0x0001);
+}
+
+static void axidev_io_windows_apply_key_state(BYTE *state, DWORD vk,
+                                              bool pressed) {
+  if (vk >= 256) {
+    return;
+  }
+  if (pressed) {
+    if ((state[vk] & 0x80) == 0) {
+      state[vk] ^= 0x01;
     }
+    state[vk] |= 0x80;
+  } else {
+    state[vk] &= (BYTE)~0x80;
   }
+  state[VK_SHIFT] = (BYTE)((state[VK_LSHIFT] | state[VK_RSHIFT]) & 0x80);
+  state[VK_CONTROL] =
+      (BYTE)((state[VK_LCONTROL] | state[VK_RCONTROL]) & 0x80);
+  state[VK_MENU] = (BYTE)((state[VK_LMENU] | state[VK_RMENU]) & 0x80);
+}
 
-  {
-    axidev_io_keyboard_key_with_modifier_t key_mod = {mapped_key, mods};
-    axidev_io_listener_invoke_callback(impl, codepoint, key_mod, pressed);
+static void
+axidev_io_windows_dispatcher_flush(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+
+  axidev_io_keyboard_listener_deliver(impl, platform->batch,
+                                      platform->batch_count);
+  platform->batch_count = 0;
+}
+
+static void
+axidev_io_windows_dispatch_pending(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+  axidev_io_windows_hook_ring *ring = platform->ring;
+  size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+  while (tail != head) {
+    axidev_io_windows_hook_event event =
+        ring->slots[tail & (AXIDEV_IO_WINDOWS_HOOK_RING_CAPACITY - 1u)];
+    atomic_store_explicit(&ring->tail, ++tail, memory_order_release);
+
+    /* Translate against the state before this event, as the hook sees it,
+       then account for the event itself. */
+    if (axidev_io_listener_handle_event(
+            impl, &event.kbd, event.pressed, platform->key_state,
+            &platform->batch[platform->batch_count])) {
+      ++platform->batch_count;
+    }
+    axidev_io_windows_apply_key_state(platform->key_state, event.kbd.vkCode,
+                                      event.pressed);
+    if (platform->batch_count == AXIDEV_IO_LISTENER_BATCH_CAPACITY) {
+      axidev_io_windows_dispatcher_flush(impl);
+    }
+    if (tail == head) {
+      head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+  }
+  axidev_io_windows_dispatcher_flush(impl);
+}
+
+static int axidev_io_windows_dispatcher_main(void *user_data) {
+  axidev_io_keyboard_listener_impl *impl =
+      (axidev_io_keyboard_listener_impl *)user_data;
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+
+  axidev_io_windows_seed_key_state(platform->key_state);
+  for (;;) {
+    bool stopping = !atomic_load(&platform->dispatching);
+    axidev_io_windows_dispatch_pending(impl);
+    if (stopping) {
+      break;
+    }
+    WaitForSingleObject(platform->ring_event, INFINITE);
+  }
+  return 0;
+}
+
+static void
+axidev_io_windows_dispatcher_stop(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+
+  if (platform->ring == NULL) {
+    return;
+  }
+  if (atomic_load(&platform->dispatching)) {
+    atomic_store(&platform->dispatching, false);
+    SetEvent(platform->ring_event);
+    axidev_io_thread_join(&platform->dispatcher);
+  }
+  CloseHandle(platform->ring_event);
+  platform->ring_event = NULL;
+  free(platform->ring);
+  platform->ring = NULL;
+}
+
+static axidev_io_result
+axidev_io_windows_dispatcher_start(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+
+  platform->ring =
+      (axidev_io_windows_hook_ring *)calloc(1, sizeof(*platform->ring));
+  if (platform->ring == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  platform->ring_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+  if (platform->ring_event == NULL) {
+    free(platform->ring);
+    platform->ring = NULL;
+    axidev_io_set_last_errorf("CreateEvent failed: %lu",
+                              (unsigned long)GetLastError());
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  atomic_store(&platform->dispatching, true);
+  if (!axidev_io_thread_create(&platform->dispatcher,
+                               axidev_io_windows_dispatcher_main, impl)) {
+    atomic_store(&platform->dispatching, false);
+    axidev_io_windows_dispatcher_stop(impl);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
   }
+  impl->queue_capacity = AXIDEV_IO_WINDOWS_HOOK_RING_CAPACITY;
+  return AXIDEV_IO_RESULT_OK;
 }
 
 static LRESULT CALLBACK axidev_io_low_level_keyboard_proc(int nCode,
@@ -214,9 +564,19 @@ static LRESULT CALLBACK axidev_io_low_level_keyboard_proc(int nCode,
     return CallNextHookEx(NULL, nCode, wParam, lParam);
   }
 
-  axidev_io_listener_handle_event(impl, (const KBDLLHOOKSTRUCT *)lParam,
-                                  wParam == WM_KEYDOWN ||
-                                      wParam == WM_SYSKEYDOWN);
+  if (impl->platform->ring != NULL) {
+    axidev_io_windows_ring_push(impl, (const KBDLLHOOKSTRUCT *)lParam,
+                                wParam == WM_KEYDOWN ||
+                                    wParam == WM_SYSKEYDOWN);
+  } else {
+    axidev_io_key_event_t event;
+
+    if (axidev_io_listener_handle_event(
+            impl, (const KBDLLHOOKSTRUCT *)lParam,
+            wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN, NULL, &event)) {
+      axidev_io_keyboard_listener_deliver(impl, &event, 1);
+    }
+  }
   return CallNextHookEx(NULL, nCode, wParam, lParam);
 }
 
@@ -232,6 +592,9 @@ static int axidev_io_listener_thread_main(void *user_data) {
       SetWindowsHookEx(WH_KEYBOARD_LL, axidev_io_low_level_keyboard_proc,
                        GetModuleHandle(NULL), 0);
   if (impl->hook == NULL) {
+    axidev_io_set_last_errorf("SetWindowsHookEx failed: %lu",
+                              (unsigned long)GetLastError());
+    axidev_io_windows_listener_fail_startup(impl->platform);
     atomic_store(&g_active_listener, NULL);
     impl->thread_id = 0;
     atomic_store(&impl->running, false);
@@ -254,58 +617,263 @@ static int axidev_io_listener_thread_main(void *user_data) {
   return 0;
 }
 
+/* Raw Input delivers VK_SHIFT/VK_CONTROL/VK_MENU for both sides; give the
+   translation the sided codes the hook would have seen. Returns false for
+   the 0xFF filler sent around escape sequences. */
+static bool axidev_io_windows_raw_to_hook_event(const RAWKEYBOARD *raw,
+                                                KBDLLHOOKSTRUCT *out,
+                                                bool *out_pressed) {
+  DWORD vk = raw->VKey;
+  bool extended = (raw->Flags & RI_KEY_E0) != 0;
+
+  if (vk == 0 || vk >= 0xFF) {
+    return false;
+  }
+  if (vk == VK_SHIFT) {
+    vk = MapVirtualKeyW(raw->MakeCode, MAPVK_VSC_TO_VK_EX);
+  } else if (vk == VK_CONTROL) {
+    vk = extended ? VK_RCONTROL : VK_LCONTROL;
+  } else if (vk == VK_MENU) {
+    vk = extended ? VK_RMENU : VK_LMENU;
+  }
+
+  memset(out, 0, sizeof(*out));
+  out->vkCode = vk;
+  out->scanCode = raw->MakeCode;
+  *out_pressed = (raw->Flags & RI_KEY_BREAK) == 0;
+  out->flags = (extended ? LLKHF_EXTENDED : 0) | (*out_pressed ? 0 : LLKHF_UP);
+  /* Raw input carries no timestamp; it is read promptly, so use now. */
+  out->time = GetTickCount();
+  return true;
+}
+
+static void axidev_io_windows_raw_handle(axidev_io_keyboard_listener_impl *impl,
+                                         const RAWINPUT *input) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+  KBDLLHOOKSTRUCT kbd;
+  bool pressed;
+
+  if (input->header.dwType != RIM_TYPEKEYBOARD ||
+      !axidev_io_windows_raw_to_hook_event(&input->data.keyboard, &kbd,
+                                           &pressed)) {
+    return;
+  }
+  if (axidev_io_listener_handle_event(
+          impl, &kbd, pressed, platform->key_state,
+          &platform->batch[platform->batch_count])) {
+    ++platform->batch_count;
+  }
+  axidev_io_windows_apply_key_state(platform->key_state, kbd.vkCode, pressed);
+  if (platform->batch_count == AXIDEV_IO_LISTENER_BATCH_CAPACITY) {
+    axidev_io_windows_dispatcher_flush(impl);
+  }
+}
+
+/* Reads every queued WM_INPUT in bulk. */
+static void
+axidev_io_windows_raw_drain(axidev_io_keyboard_listener_impl *impl) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+
+  for (;;) {
+    UINT size = AXIDEV_IO_WINDOWS_RAW_BUFFER_SIZE;
+    UINT count = GetRawInputBuffer(platform->raw_buffer, &size,
+                                   sizeof(RAWINPUTHEADER));
+    RAWINPUT *input = platform->raw_buffer;
+
+    if (count == 0 || count == (UINT)-1) {
+      break;
+    }
+    for (UINT i = 0; i < count; ++i) {
+      axidev_io_windows_raw_handle(impl, input);
+      input = NEXTRAWINPUTBLOCK(input);
+    }
+  }
+}
+
+static void
+axidev_io_windows_raw_read_message(axidev_io_keyboard_listener_impl *impl,
+                                   LPARAM lparam) {
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+  UINT size = AXIDEV_IO_WINDOWS_RAW_BUFFER_SIZE;
+
+  if (GetRawInputData((HRAWINPUT)lparam, RID_INPUT, platform->raw_buffer,
+                      &size, sizeof(RAWINPUTHEADER)) != (UINT)-1) {
+    axidev_io_windows_raw_handle(impl, platform->raw_buffer);
+  }
+}
+
+static void axidev_io_windows_raw_teardown(
+    struct axidev_io_windows_keymap_private *platform, HWND window,
+    HINSTANCE instance) {
+  if (window != NULL) {
+    DestroyWindow(window);
+  }
+  UnregisterClassW(AXIDEV_IO_WINDOWS_RAW_CLASS, instance);
+  free(platform->raw_buffer);
+  platform->raw_buffer = NULL;
+}
+
+static int axidev_io_windows_raw_thread_main(void *user_data) {
+  axidev_io_keyboard_listener_impl *impl =
+      (axidev_io_keyboard_listener_impl *)user_data;
+  struct axidev_io_windows_keymap_private *platform = impl->platform;
+  HINSTANCE instance = GetModuleHandleW(NULL);
+  HWND window = NULL;
+  WNDCLASSEXW window_class;
+  RAWINPUTDEVICE device;
+  MSG message;
+  bool quit = false;
+
+  impl->thread_id = GetCurrentThreadId();
+  axidev_io_windows_listener_reset_session_state(platform);
+  axidev_io_windows_seed_key_state(platform->key_state);
+  platform->raw_buffer = (RAWINPUT *)malloc(AXIDEV_IO_WINDOWS_RAW_BUFFER_SIZE);
+
+  memset(&window_class, 0, sizeof(window_class));
+  window_class.cbSize = sizeof(window_class);
+  window_class.lpfnWndProc = DefWindowProcW;
+  window_class.hInstance = instance;
+  window_class.lpszClassName = AXIDEV_IO_WINDOWS_RAW_CLASS;
+  if (platform->raw_buffer != NULL && RegisterClassExW(&window_class) != 0) {
+    window = CreateWindowExW(0, AXIDEV_IO_WINDOWS_RAW_CLASS, L"", 0, 0, 0, 0,
+                             0, HWND_MESSAGE, NULL, instance, NULL);
+  }
+  device.usUsagePage = 0x01; /* generic desktop */
+  device.usUsage = 0x06;     /* keyboard */
+  device.dwFlags = RIDEV_INPUTSINK;
+  device.hwndTarget = window;
+  if (window == NULL ||
+      !RegisterRawInputDevices(&device, 1, sizeof(device))) {
+    axidev_io_set_last_errorf("raw input registration failed: %lu",
+                              (unsigned long)GetLastError());
+    axidev_io_windows_listener_fail_startup(platform);
+    axidev_io_windows_raw_teardown(platform, window, instance);
+    impl->thread_id = 0;
+    atomic_store(&impl->running, false);
+    atomic_store(&impl->ready, false);
+    return 1;
+  }
+
+  atomic_store(&impl->ready, true);
+  while (!quit) {
+    MsgWaitForMultipleObjectsEx(0, NULL, INFINITE, QS_ALLINPUT,
+                                MWMO_INPUTAVAILABLE);
+    axidev_io_windows_raw_drain(impl);
+    while (PeekMessageW(&message, NULL, 0, 0, PM_REMOVE)) {
+      if (message.message == WM_QUIT) {
+        quit = true;
+        break;
+      }
+      if (message.message == WM_INPUT) {
+        axidev_io_windows_raw_read_message(impl, message.lParam);
+      }
+      DispatchMessageW(&message);
+    }
+    axidev_io_windows_dispatcher_flush(impl);
+  }
+
+  device.dwFlags = RIDEV_REMOVE;
+  device.hwndTarget = NULL;
+  RegisterRawInputDevices(&device, 1, sizeof(device));
+  axidev_io_windows_raw_teardown(platform, window, instance);
+  impl->thread_id = 0;
+  axidev_io_windows_listener_reset_session_state(platform);
+  atomic_store(&impl->ready, false);
+  return 0;
+}
+
 axidev_io_keyboard_listener_impl *axidev_io_listener_impl_get(void) {
   return (axidev_io_keyboard_listener_impl *)axidev_io_listener_storage_ptr();
 }
 
+static axidev_io_result axidev_io_windows_listener_ensure_platform(
+    axidev_io_keyboard_listener_impl *impl) {
+  axidev_io_result result;
+
+  if (impl->platform != NULL) {
+    axidev_io_windows_listener_reset_session_state(impl->platform);
+    return AXIDEV_IO_RESULT_OK;
+  }
+  impl->platform = (struct axidev_io_windows_keymap_private *)calloc(
+      1, sizeof(*impl->platform));
+  if (impl->platform == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  result = axidev_io_windows_listener_use_layout(impl->platform,
+                                                 GetKeyboardLayout(0));
+  if (result != AXIDEV_IO_RESULT_OK) {
+    free(impl->platform);
+    impl->platform = NULL;
+  }
+  return result;
+}
+
 axidev_io_result axidev_io_keyboard_listener_start_internal(
-    axidev_io_keyboard_listener_cb callback, void *user_data) {
+    axidev_io_keyboard_listener_cb callback,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data) {
   axidev_io_keyboard_listener_impl *impl = axidev_io_listener_impl_get();
 
-  if (callback == NULL) {
+  if ((callback == NULL) == (batch_callback == NULL)) {
     return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
   }
 
-  if (!impl->callback_lock_ready) {
-    axidev_io_mutex_init(&impl->callback_lock);
-    impl->callback_lock_ready = true;
-  }
-
   if (atomic_load(&impl->running)) {
     return AXIDEV_IO_RESULT_ALREADY_INITIALIZED;
   }
 
-  if (impl->platform == NULL) {
-    impl->platform = (struct axidev_io_windows_keymap_private *)calloc(
-        1, sizeof(*impl->platform));
-    if (impl->platform == NULL) {
-      return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  {
+    axidev_io_result result = axidev_io_windows_listener_ensure_platform(impl);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
     }
-    axidev_io_windows_keymap_init(&impl->platform->keymap,
-                                  GetKeyboardLayout(0));
-  } else {
-    axidev_io_windows_listener_reset_session_state(impl->platform);
   }
 
-  axidev_io_mutex_lock(&impl->callback_lock);
-  impl->callback = callback;
-  impl->user_data = user_data;
-  axidev_io_mutex_unlock(&impl->callback_lock);
+  if (axidev_io_keyboard_listener_set_callback(impl, callback, batch_callback,
+                                                user_data) !=
+      AXIDEV_IO_RESULT_OK) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  axidev_io_keyboard_listener_reset_stats(impl);
+  impl->platform->startup_failed = false;
+  impl->platform->use_raw_input =
+      (impl->options & AXIDEV_IO_LISTENER_OPTION_RAW_INPUT) != 0;
+  impl->platform->filter = impl->filter;
+  impl->platform->filtering =
+      axidev_io_listener_filter_is_active(&impl->platform->filter);
+  axidev_io_listener_filter_build_codes(&impl->platform->filter,
+                                        impl->platform->tables, 256,
+                                        impl->platform->filter_codes);
+  /* Raw Input is already off the hook chain, so nothing is deferred. */
+  if (!impl->platform->use_raw_input &&
+      (impl->options & AXIDEV_IO_LISTENER_OPTION_DEFERRED_DISPATCH) != 0) {
+    axidev_io_result result = axidev_io_windows_dispatcher_start(impl);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
+    }
+  }
 
   atomic_store(&impl->running, true);
   atomic_store(&impl->ready, false);
-  if (!axidev_io_thread_create(&impl->worker, axidev_io_listener_thread_main,
+  if (!axidev_io_thread_create(&impl->worker,
+                               impl->platform->use_raw_input
+                                   ? axidev_io_windows_raw_thread_main
+                                   : axidev_io_listener_thread_main,
                                impl)) {
     atomic_store(&impl->running, false);
+    axidev_io_windows_dispatcher_stop(impl);
     return AXIDEV_IO_RESULT_PLATFORM_ERROR;
   }
 
   for (int i = 0; i < 40; ++i) {
     if (!atomic_load(&impl->running)) {
       axidev_io_thread_join(&impl->worker);
-      return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+      axidev_io_windows_dispatcher_stop(impl);
+      return axidev_io_windows_listener_startup_result(impl->platform);
     }
     if (atomic_load(&impl->ready)) {
+      impl->backend_type = impl->platform->use_raw_input
+                               ? AXIDEV_IO_BACKEND_WINDOWS_RAW_INPUT
+                               : AXIDEV_IO_BACKEND_WINDOWS;
       axidev_io_listener_public_context()->initialized = true;
       axidev_io_listener_public_context()->is_listening = true;
       return AXIDEV_IO_RESULT_OK;
@@ -314,14 +882,84 @@ axidev_io_result axidev_io_keyboard_listener_start_internal(
   }
 
   if (atomic_load(&impl->ready)) {
+    impl->backend_type = impl->platform->use_raw_input
+                             ? AXIDEV_IO_BACKEND_WINDOWS_RAW_INPUT
+                             : AXIDEV_IO_BACKEND_WINDOWS;
     axidev_io_listener_public_context()->initialized = true;
     axidev_io_listener_public_context()->is_listening = true;
     return AXIDEV_IO_RESULT_OK;
   }
 
   atomic_store(&impl->running, false);
+  if (impl->thread_id != 0) {
+    PostThreadMessage(impl->thread_id, WM_QUIT, 0, 0);
+  }
   axidev_io_thread_join(&impl->worker);
-  return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  axidev_io_windows_dispatcher_stop(impl);
+  return axidev_io_windows_listener_startup_result(impl->platform);
+}
+
+/* Synthetic events are spaced this far apart so consecutive releases of one
+   key are not taken for the hook's duplicates. */
+#define AXIDEV_IO_WINDOWS_REPLAY_SPACING_MS 64u
+
+axidev_io_result axidev_io_keyboard_listener_replay_for_tests(
+    const axidev_io_listener_synthetic_key *keys, size_t count,
+    axidev_io_keyboard_listener_batch_cb batch_callback, void *user_data) {
+  axidev_io_keyboard_listener_impl *impl = axidev_io_listener_impl_get();
+  struct axidev_io_windows_keymap_private *platform;
+  axidev_io_result result;
+  DWORD start_ms;
+
+  if (batch_callback == NULL || (keys == NULL && count != 0)) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if (atomic_load(&impl->running)) {
+    return AXIDEV_IO_RESULT_ALREADY_INITIALIZED;
+  }
+  result = axidev_io_windows_listener_ensure_platform(impl);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+  platform = impl->platform;
+  platform->filter = impl->filter;
+  platform->filtering = axidev_io_listener_filter_is_active(&platform->filter);
+  axidev_io_listener_filter_build_codes(&platform->filter, platform->tables,
+                                        256, platform->filter_codes);
+  if (axidev_io_keyboard_listener_set_callback(impl, NULL, batch_callback,
+                                                user_data) !=
+      AXIDEV_IO_RESULT_OK) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+
+  /* Replay starts with no key held, as a deferred dispatcher would track
+     it, and ends at the current tick. */
+  memset(platform->key_state, 0, sizeof(platform->key_state));
+  platform->batch_count = 0;
+  start_ms = GetTickCount() -
+             (DWORD)count * AXIDEV_IO_WINDOWS_REPLAY_SPACING_MS;
+  for (size_t i = 0; i < count; ++i) {
+    KBDLLHOOKSTRUCT kbd;
+
+    memset(&kbd, 0, sizeof(kbd));
+    kbd.vkCode = keys[i].code;
+    kbd.scanCode = MapVirtualKeyW(keys[i].code, MAPVK_VK_TO_VSC);
+    kbd.flags = keys[i].pressed ? 0 : LLKHF_UP;
+    kbd.time = start_ms + (DWORD)i * AXIDEV_IO_WINDOWS_REPLAY_SPACING_MS;
+    if (axidev_io_listener_handle_event(
+            impl, &kbd, keys[i].pressed, platform->key_state,
+            &platform->batch[platform->batch_count])) {
+      ++platform->batch_count;
+    }
+    axidev_io_windows_apply_key_state(platform->key_state, kbd.vkCode,
+                                      keys[i].pressed);
+    if (platform->batch_count == AXIDEV_IO_LISTENER_BATCH_CAPACITY) {
+      axidev_io_windows_dispatcher_flush(impl);
+    }
+  }
+  axidev_io_windows_dispatcher_flush(impl);
+  axidev_io_keyboard_listener_set_callback(impl, NULL, NULL, NULL);
+  return AXIDEV_IO_RESULT_OK;
 }
 
 void axidev_io_keyboard_listener_stop_internal(void) {
@@ -337,7 +975,10 @@ void axidev_io_keyboard_listener_stop_internal(void) {
     PostThreadMessage(impl->thread_id, WM_QUIT, 0, 0);
   }
   axidev_io_thread_join(&impl->worker);
+  /* The hook is gone, so the dispatcher drains what is left and exits. */
+  axidev_io_windows_dispatcher_stop(impl);
 
+  impl->backend_type = AXIDEV_IO_BACKEND_UNKNOWN;
   axidev_io_listener_public_context()->is_listening = false;
   axidev_io_listener_public_context()->initialized = impl->platform != NULL;
 }
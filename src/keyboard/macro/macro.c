@@ -0,0 +1,447 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "macro_internal.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stb/stb_ds.h>
+
+#include "../common/keymap_internal.h"
+#include "../sender/sender_internal.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint8_t g_macro_magic[4] = {'A', 'X', 'M', 'R'};
+
+#ifdef _WIN32
+#define AXIDEV_IO_MACRO_PLATFORM AXIDEV_IO_MACRO_PLATFORM_WINDOWS
+#else
+#define AXIDEV_IO_MACRO_PLATFORM AXIDEV_IO_MACRO_PLATFORM_LINUX
+#endif
+
+/* Replay waits sleep in slices of this length without the context lock and
+   take it back this long before the deadline to pace the rest. */
+#define AXIDEV_IO_MACRO_WAIT_SLICE_US 10000u
+#define AXIDEV_IO_MACRO_RELOCK_NS 2000000u
+
+static size_t axidev_io_macro_put_varint(uint8_t *out, uint64_t value) {
+  size_t length = 0;
+
+  while (value >= 0x80u) {
+    out[length++] = (uint8_t)(value | 0x80u);
+    value >>= 7;
+  }
+  out[length++] = (uint8_t)value;
+  return length;
+}
+
+static bool axidev_io_macro_get_varint(const uint8_t **cursor,
+                                       const uint8_t *end,
+                                       uint64_t *out_value) {
+  uint64_t value = 0;
+
+  for (unsigned int shift = 0; shift < 64; shift += 7) {
+    uint8_t byte;
+
+    if (*cursor == end) {
+      return false;
+    }
+    byte = *(*cursor)++;
+    value |= (uint64_t)(byte & 0x7Fu) << shift;
+    if ((byte & 0x80u) == 0) {
+      *out_value = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+void axidev_io_macro_write_header(uint8_t out[AXIDEV_IO_MACRO_HEADER_SIZE]) {
+  memcpy(out, g_macro_magic, sizeof(g_macro_magic));
+  out[4] = (uint8_t)AXIDEV_IO_MACRO_VERSION;
+  out[5] = (uint8_t)AXIDEV_IO_MACRO_PLATFORM;
+}
+
+size_t
+axidev_io_macro_encode_event(const axidev_io_macro_event *event,
+                             uint8_t out[AXIDEV_IO_MACRO_RECORD_MAX_SIZE]) {
+  size_t length = axidev_io_macro_put_varint(out, event->delta_us);
+
+  length += axidev_io_macro_put_varint(
+      out + length, ((uint64_t)event->code << 1) | (event->pressed ? 1u : 0u));
+  length += axidev_io_macro_put_varint(out + length, (uint64_t)event->key);
+  out[length++] = (uint8_t)event->mods;
+  return length;
+}
+
+axidev_io_result axidev_io_macro_decode_event(const uint8_t **cursor,
+                                              const uint8_t *end,
+                                              axidev_io_macro_event *out) {
+  uint64_t code;
+  uint64_t key;
+
+  if (!axidev_io_macro_get_varint(cursor, end, &out->delta_us) ||
+      !axidev_io_macro_get_varint(cursor, end, &code) ||
+      !axidev_io_macro_get_varint(cursor, end, &key) || *cursor == end) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if ((code >> 1) >= AXIDEV_IO_KEYMAP_CODE_LIMIT ||
+      key > (uint64_t)AXIDEV_IO_KEY_RF_KILL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  out->code = (uint32_t)(code >> 1);
+  out->pressed = (code & 1u) != 0;
+  out->key = (axidev_io_keyboard_key_t)key;
+  out->mods = (axidev_io_keyboard_modifier_t)**cursor;
+  ++*cursor;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+static axidev_io_result axidev_io_macro_check_header(const uint8_t *data,
+                                                     size_t size) {
+  if (data == NULL || size < AXIDEV_IO_MACRO_HEADER_SIZE ||
+      memcmp(data, g_macro_magic, sizeof(g_macro_magic)) != 0 ||
+      data[4] != AXIDEV_IO_MACRO_VERSION) {
+    axidev_io_set_last_error_message("not an axidev-io macro stream");
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if (data[5] != AXIDEV_IO_MACRO_PLATFORM) {
+    axidev_io_set_last_error_message(
+        "macro stream was recorded on another platform");
+    return AXIDEV_IO_RESULT_NOT_SUPPORTED;
+  }
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_macro_recorder_create_internal(axidev_io_macro_recorder_t **out) {
+  axidev_io_macro_recorder_t *recorder =
+      (axidev_io_macro_recorder_t *)calloc(1, sizeof(*recorder));
+
+  if (recorder == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  if (!axidev_io_mutex_init(&recorder->lock)) {
+    free(recorder);
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  axidev_io_macro_write_header(
+      arraddnptr(recorder->bytes, AXIDEV_IO_MACRO_HEADER_SIZE));
+  *out = recorder;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+void axidev_io_macro_recorder_destroy_internal(
+    axidev_io_macro_recorder_t *recorder) {
+  arrfree(recorder->bytes);
+  axidev_io_mutex_destroy(&recorder->lock);
+  free(recorder);
+}
+
+/* Delays come from the events' input timestamps, so listener dispatch
+   jitter does not end up in the recording. */
+void axidev_io_macro_recorder_append_internal(
+    axidev_io_macro_recorder_t *recorder, const axidev_io_key_event_t *events,
+    size_t count) {
+  axidev_io_mutex_lock(&recorder->lock);
+  for (size_t i = 0; i < count; ++i) {
+    axidev_io_macro_event event;
+    uint8_t record[AXIDEV_IO_MACRO_RECORD_MAX_SIZE];
+    size_t length;
+
+    if (events[i].code >= AXIDEV_IO_KEYMAP_CODE_LIMIT) {
+      continue;
+    }
+    if (recorder->event_count == 0) {
+      recorder->last_timestamp_us = events[i].timestamp_us;
+    }
+    event.delta_us = 0;
+    if (events[i].timestamp_us > recorder->last_timestamp_us) {
+      event.delta_us = events[i].timestamp_us - recorder->last_timestamp_us;
+      recorder->last_timestamp_us = events[i].timestamp_us;
+    }
+    event.code = events[i].code;
+    event.key = events[i].key_mod.key;
+    event.mods = events[i].key_mod.mods;
+    event.pressed = events[i].pressed;
+    length = axidev_io_macro_encode_event(&event, record);
+    memcpy(arraddnptr(recorder->bytes, length), record, length);
+    ++recorder->event_count;
+  }
+  axidev_io_mutex_unlock(&recorder->lock);
+}
+
+size_t axidev_io_macro_recorder_event_count_internal(
+    axidev_io_macro_recorder_t *recorder) {
+  size_t count;
+
+  axidev_io_mutex_lock(&recorder->lock);
+  count = recorder->event_count;
+  axidev_io_mutex_unlock(&recorder->lock);
+  return count;
+}
+
+size_t axidev_io_macro_recorder_copy_internal(
+    axidev_io_macro_recorder_t *recorder, uint8_t *buf, size_t len) {
+  size_t size;
+
+  axidev_io_mutex_lock(&recorder->lock);
+  size = (size_t)arrlen(recorder->bytes);
+  if (buf != NULL) {
+    memcpy(buf, recorder->bytes, len < size ? len : size);
+  }
+  axidev_io_mutex_unlock(&recorder->lock);
+  return size;
+}
+
+void axidev_io_macro_recorder_clear_internal(
+    axidev_io_macro_recorder_t *recorder) {
+  axidev_io_mutex_lock(&recorder->lock);
+  arrsetlen(recorder->bytes, AXIDEV_IO_MACRO_HEADER_SIZE);
+  recorder->event_count = 0;
+  recorder->last_timestamp_us = 0;
+  axidev_io_mutex_unlock(&recorder->lock);
+}
+
+axidev_io_result
+axidev_io_macro_recorder_save_internal(axidev_io_macro_recorder_t *recorder,
+                                       const char *path) {
+  FILE *file;
+  bool written;
+
+  axidev_io_mutex_lock(&recorder->lock);
+  file = fopen(path, "wb");
+  if (file == NULL) {
+    axidev_io_mutex_unlock(&recorder->lock);
+    axidev_io_set_last_errorf("could not open %s: %s", path, strerror(errno));
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  written = fwrite(recorder->bytes, 1, (size_t)arrlen(recorder->bytes),
+                   file) == (size_t)arrlen(recorder->bytes);
+  axidev_io_mutex_unlock(&recorder->lock);
+  if (fclose(file) != 0) {
+    written = false;
+  }
+  if (!written) {
+    axidev_io_set_last_errorf("could not write %s", path);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  return AXIDEV_IO_RESULT_OK;
+}
+
+static void axidev_io_macro_mark_held(uint8_t *held, uint32_t code,
+                                      bool down) {
+  if (down) {
+    held[code / 8u] |= (uint8_t)(1u << (code % 8u));
+  } else {
+    held[code / 8u] &= (uint8_t)~(1u << (code % 8u));
+  }
+}
+
+static bool axidev_io_macro_keyboard_ready(void) {
+  return axidev_io_global->keyboard.initialized &&
+         axidev_io_global->keyboard.sender.initialized &&
+         axidev_io_global->keyboard.keymap.initialized;
+}
+
+static bool axidev_io_macro_cancelled(const atomic_bool *cancel) {
+  return cancel != NULL && atomic_load(cancel);
+}
+
+/* Drops the context lock until shortly before `deadline_ns`, waking every
+   slice to honour `cancel`, then paces the last stretch on the sender with
+   the lock held again. Other callers can inject while a replay idles. */
+static axidev_io_result axidev_io_macro_wait(uint64_t deadline_ns,
+                                             const atomic_bool *cancel) {
+  axidev_io_context_unlock();
+  while (!axidev_io_macro_cancelled(cancel)) {
+    uint64_t now_ns = axidev_io_monotonic_time_ns();
+    uint64_t sleep_us;
+
+    if (now_ns + AXIDEV_IO_MACRO_RELOCK_NS >= deadline_ns) {
+      break;
+    }
+    sleep_us = (deadline_ns - now_ns - AXIDEV_IO_MACRO_RELOCK_NS) / 1000u;
+    if (sleep_us > AXIDEV_IO_MACRO_WAIT_SLICE_US) {
+      sleep_us = AXIDEV_IO_MACRO_WAIT_SLICE_US;
+    }
+    axidev_io_sleep_us((uint32_t)sleep_us);
+  }
+  axidev_io_context_lock();
+  if (axidev_io_macro_cancelled(cancel)) {
+    axidev_io_set_last_error_message("macro replay was cancelled");
+    return AXIDEV_IO_RESULT_CANCELLED;
+  }
+  if (!axidev_io_macro_keyboard_ready()) {
+    axidev_io_set_last_error_message(
+        "keyboard was freed during macro replay");
+    return AXIDEV_IO_RESULT_NOT_INITIALIZED;
+  }
+  axidev_io_keyboard_sender_wait_until_internal(deadline_ns);
+  return AXIDEV_IO_RESULT_OK;
+}
+
+/* Each event goes out at its recorded offset from the start divided by
+   `speed`, so a late event never pushes back the ones after it. Events
+   already due are sent as one batch. */
+axidev_io_result axidev_io_macro_replay_internal(const uint8_t *data,
+                                                 size_t size, double speed,
+                                                 const atomic_bool *cancel) {
+  uint8_t held[AXIDEV_IO_KEYMAP_CODE_LIMIT / 8u];
+  axidev_io_keyboard_key_t held_keys[AXIDEV_IO_KEYMAP_CODE_LIMIT];
+  const uint8_t *cursor;
+  const uint8_t *end;
+  uint64_t start_ns;
+  uint64_t offset_us = 0;
+  axidev_io_result result;
+  axidev_io_result batch_result;
+
+  if (!(speed >= 0.0)) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  result = axidev_io_macro_check_header(data, size);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+  memset(held, 0, sizeof(held));
+  cursor = data + AXIDEV_IO_MACRO_HEADER_SIZE;
+  end = data + size;
+  start_ns = axidev_io_monotonic_time_ns();
+
+  axidev_io_keyboard_sender_begin_batch_internal();
+  while (cursor != end) {
+    axidev_io_macro_event event;
+
+    if (axidev_io_macro_cancelled(cancel)) {
+      axidev_io_set_last_error_message("macro replay was cancelled");
+      result = AXIDEV_IO_RESULT_CANCELLED;
+      break;
+    }
+    result = axidev_io_macro_decode_event(&cursor, end, &event);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      axidev_io_set_last_errorf("macro stream is malformed at byte %zu",
+                                (size_t)(cursor - data));
+      break;
+    }
+    offset_us += event.delta_us;
+    if (speed > 0.0 && event.delta_us != 0) {
+      uint64_t deadline_ns =
+          start_ns + (uint64_t)((double)offset_us * 1000.0 / speed);
+
+      if (deadline_ns > axidev_io_monotonic_time_ns()) {
+        result = axidev_io_keyboard_sender_end_batch_internal();
+        if (result != AXIDEV_IO_RESULT_OK) {
+          axidev_io_keyboard_sender_begin_batch_internal();
+          break;
+        }
+        result = axidev_io_macro_wait(deadline_ns, cancel);
+        if (result == AXIDEV_IO_RESULT_NOT_INITIALIZED) {
+          /* Freeing the keyboard already released its held keys. */
+          return result;
+        }
+        axidev_io_keyboard_sender_begin_batch_internal();
+        if (result != AXIDEV_IO_RESULT_OK) {
+          break;
+        }
+      }
+    }
+    result = axidev_io_keyboard_sender_send_keycode_internal(
+        event.key, (int32_t)event.code, event.pressed);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      break;
+    }
+    axidev_io_macro_mark_held(held, event.code, event.pressed);
+    held_keys[event.code] = event.key;
+  }
+
+  /* A recording cut off mid-press, or a cancelled replay, must not leave
+     keys down. */
+  for (uint32_t code = 0; code < AXIDEV_IO_KEYMAP_CODE_LIMIT; ++code) {
+    if ((held[code / 8u] & (1u << (code % 8u))) != 0) {
+      axidev_io_keyboard_sender_send_keycode_internal(held_keys[code],
+                                                      (int32_t)code, false);
+    }
+  }
+  batch_result = axidev_io_keyboard_sender_end_batch_internal();
+  return result != AXIDEV_IO_RESULT_OK ? result : batch_result;
+}
+
+/* The file is mapped rather than read, so a long recording is paged in as
+   replay reaches it. */
+axidev_io_result axidev_io_macro_replay_file_internal(const char *path,
+                                                      double speed) {
+  axidev_io_result result = AXIDEV_IO_RESULT_PLATFORM_ERROR;
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER file_size;
+  HANDLE mapping = NULL;
+  const void *view = NULL;
+
+  if (file == INVALID_HANDLE_VALUE) {
+    axidev_io_set_last_errorf("could not open %s", path);
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+  if (!GetFileSizeEx(file, &file_size) ||
+      file_size.QuadPart < (LONGLONG)AXIDEV_IO_MACRO_HEADER_SIZE) {
+    CloseHandle(file);
+    return axidev_io_macro_check_header(NULL, 0);
+  }
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping != NULL) {
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (view != NULL) {
+    result = axidev_io_macro_replay_internal(
+        (const uint8_t *)view, (size_t)file_size.QuadPart, speed, NULL);
+    UnmapViewOfFile(view);
+  } else {
+    axidev_io_set_last_errorf("could not map %s", path);
+  }
+  if (mapping != NULL) {
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+#else
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  void *view;
+
+  if (fd < 0) {
+    axidev_io_set_last_errorf("could not open %s: %s", path, strerror(errno));
+    return AXIDEV_IO_RESULT_NOT_FOUND;
+  }
+  if (fstat(fd, &info) != 0 ||
+      info.st_size < (off_t)AXIDEV_IO_MACRO_HEADER_SIZE) {
+    close(fd);
+    return axidev_io_macro_check_header(NULL, 0);
+  }
+  view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) {
+    axidev_io_set_last_errorf("could not map %s: %s", path, strerror(errno));
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  posix_madvise(view, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+  result = axidev_io_macro_replay_internal((const uint8_t *)view,
+                                           (size_t)info.st_size, speed, NULL);
+  munmap(view, (size_t)info.st_size);
+#endif
+  return result;
+}
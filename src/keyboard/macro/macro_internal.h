@@ -0,0 +1,78 @@
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_MACRO_INTERNAL_H
+#define AXIDEV_IO_KEYBOARD_MACRO_INTERNAL_H
+
+#include <stdatomic.h>
+
+#include "../../internal/context.h"
+
+/* Stream layout: "AXMR", a version byte and a platform byte, then one
+   record per event. A record is a LEB128 varint of the microseconds since
+   the previous event, a varint of (code << 1 | pressed), a varint of the
+   key and one byte of modifiers. */
+#define AXIDEV_IO_MACRO_VERSION 1u
+#define AXIDEV_IO_MACRO_HEADER_SIZE 6u
+/* Longest record: 10-byte delay, 2-byte code and key, 1-byte mods. */
+#define AXIDEV_IO_MACRO_RECORD_MAX_SIZE 16u
+
+/* Keycodes are platform codes, so streams carry the platform they were
+   recorded on. */
+#define AXIDEV_IO_MACRO_PLATFORM_LINUX 1u
+#define AXIDEV_IO_MACRO_PLATFORM_WINDOWS 2u
+
+typedef struct axidev_io_macro_event {
+  uint64_t delta_us;
+  uint32_t code;
+  axidev_io_keyboard_key_t key;
+  axidev_io_keyboard_modifier_t mods;
+  bool pressed;
+} axidev_io_macro_event;
+
+struct axidev_io_macro_recorder {
+  axidev_io_mutex lock;
+  /* stb_ds array holding the header and every record so far. */
+  uint8_t *bytes;
+  size_t event_count;
+  uint64_t last_timestamp_us;
+};
+
+void axidev_io_macro_write_header(uint8_t out[AXIDEV_IO_MACRO_HEADER_SIZE]);
+/* Returns the number of bytes written to `out`. */
+size_t
+axidev_io_macro_encode_event(const axidev_io_macro_event *event,
+                             uint8_t out[AXIDEV_IO_MACRO_RECORD_MAX_SIZE]);
+/* Decodes the record at `*cursor` and advances past it. INVALID_ARGUMENT
+   for a truncated or malformed record. */
+axidev_io_result axidev_io_macro_decode_event(const uint8_t **cursor,
+                                              const uint8_t *end,
+                                              axidev_io_macro_event *out);
+
+axidev_io_result
+axidev_io_macro_recorder_create_internal(axidev_io_macro_recorder_t **out);
+void axidev_io_macro_recorder_destroy_internal(
+    axidev_io_macro_recorder_t *recorder);
+void axidev_io_macro_recorder_append_internal(
+    axidev_io_macro_recorder_t *recorder, const axidev_io_key_event_t *events,
+    size_t count);
+size_t
+axidev_io_macro_recorder_event_count_internal(
+    axidev_io_macro_recorder_t *recorder);
+size_t axidev_io_macro_recorder_copy_internal(
+    axidev_io_macro_recorder_t *recorder, uint8_t *buf, size_t len);
+void axidev_io_macro_recorder_clear_internal(
+    axidev_io_macro_recorder_t *recorder);
+axidev_io_result
+axidev_io_macro_recorder_save_internal(axidev_io_macro_recorder_t *recorder,
+                                       const char *path);
+
+/* Both run on the bound sender; callers hold the context lock, which is
+   released across the waits between events. A replay stops with CANCELLED
+   once `cancel` is set, and with NOT_INITIALIZED if the keyboard is freed
+   while it waits. */
+axidev_io_result axidev_io_macro_replay_internal(const uint8_t *data,
+                                                 size_t size, double speed,
+                                                 const atomic_bool *cancel);
+axidev_io_result axidev_io_macro_replay_file_internal(const char *path,
+                                                      double speed);
+
+#endif
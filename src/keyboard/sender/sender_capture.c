@@ -0,0 +1,91 @@
+#include "sender_capture_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define AXIDEV_IO_CAPTURE_MASK (AXIDEV_IO_SENDER_CAPTURE_CAPACITY - 1u)
+
+_Static_assert((AXIDEV_IO_SENDER_CAPTURE_CAPACITY &
+                AXIDEV_IO_CAPTURE_MASK) == 0,
+               "capture capacity must be a power of two");
+
+static axidev_io_result
+axidev_io_sender_capture_start(axidev_io_sender_capture *capture) {
+  memset(capture, 0, sizeof(*capture));
+  capture->ring = (axidev_io_captured_transition_t *)malloc(
+      AXIDEV_IO_SENDER_CAPTURE_CAPACITY * sizeof(*capture->ring));
+  if (capture->ring == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  if (!axidev_io_mutex_init(&capture->lock)) {
+    free(capture->ring);
+    capture->ring = NULL;
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_sender_capture_attach(axidev_io_sender_capture **out_sink,
+                                axidev_io_sender_capture *own,
+                                axidev_io_sender_capture *shared) {
+  axidev_io_result result;
+
+  if (shared != NULL) {
+    *out_sink = shared;
+    return AXIDEV_IO_RESULT_OK;
+  }
+  result = axidev_io_sender_capture_start(own);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    *out_sink = own;
+  }
+  return result;
+}
+
+void axidev_io_sender_capture_detach(axidev_io_sender_capture *sink,
+                                     axidev_io_sender_capture *own) {
+  if (sink == NULL || sink != own) {
+    return;
+  }
+  axidev_io_mutex_destroy(&own->lock);
+  free(own->ring);
+  memset(own, 0, sizeof(*own));
+}
+
+void axidev_io_sender_capture_append(
+    axidev_io_sender_capture *capture,
+    const axidev_io_captured_transition_t *transitions, size_t count) {
+  axidev_io_mutex_lock(&capture->lock);
+  for (size_t i = 0; i < count; ++i) {
+    capture->ring[(capture->head + capture->count) & AXIDEV_IO_CAPTURE_MASK] =
+        transitions[i];
+    if (capture->count == AXIDEV_IO_SENDER_CAPTURE_CAPACITY) {
+      capture->head = (capture->head + 1u) & AXIDEV_IO_CAPTURE_MASK;
+    } else {
+      ++capture->count;
+    }
+  }
+  axidev_io_mutex_unlock(&capture->lock);
+}
+
+size_t axidev_io_sender_capture_read(axidev_io_sender_capture *capture,
+                                     axidev_io_captured_transition_t *out,
+                                     size_t max_count) {
+  size_t count;
+  size_t first;
+
+  axidev_io_mutex_lock(&capture->lock);
+  count = capture->count < max_count ? capture->count : max_count;
+  first = AXIDEV_IO_SENDER_CAPTURE_CAPACITY - capture->head;
+  if (first > count) {
+    first = count;
+  }
+  if (count != 0) {
+    memcpy(out, capture->ring + capture->head, first * sizeof(*out));
+    memcpy(out + first, capture->ring, (count - first) * sizeof(*out));
+  }
+  capture->head = (capture->head + count) & AXIDEV_IO_CAPTURE_MASK;
+  capture->count -= count;
+  axidev_io_mutex_unlock(&capture->lock);
+  return count;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_SENDER_CAPTURE_INTERNAL_H
+#define AXIDEV_IO_KEYBOARD_SENDER_CAPTURE_INTERNAL_H
+
+#include "../../internal/context.h"
+
+/* In-memory sink behind AXIDEV_IO_SENDER_OPTION_CAPTURE. The ring is
+   allocated once at start and overwrites its oldest transitions when full.
+   `lock` serialises the sender thread, the repeat worker and readers. */
+typedef struct axidev_io_sender_capture {
+  axidev_io_mutex lock;
+  axidev_io_captured_transition_t *ring;
+  size_t head;
+  size_t count;
+} axidev_io_sender_capture;
+
+/* Points `*out_sink` at `shared` when it is non-NULL, otherwise starts
+   `own` and points it there. */
+axidev_io_result
+axidev_io_sender_capture_attach(axidev_io_sender_capture **out_sink,
+                                axidev_io_sender_capture *own,
+                                axidev_io_sender_capture *shared);
+/* Stops `own` if `sink` is it; a shared sink is left to its owner. */
+void axidev_io_sender_capture_detach(axidev_io_sender_capture *sink,
+                                     axidev_io_sender_capture *own);
+void axidev_io_sender_capture_append(
+    axidev_io_sender_capture *capture,
+    const axidev_io_captured_transition_t *transitions, size_t count);
+size_t axidev_io_sender_capture_read(axidev_io_sender_capture *capture,
+                                     axidev_io_captured_transition_t *out,
+                                     size_t max_count);
+
+#endif
@@ -2,29 +2,59 @@
 #ifndef AXIDEV_IO_KEYBOARD_SENDER_INTERNAL_H
 #define AXIDEV_IO_KEYBOARD_SENDER_INTERNAL_H
 
+#include "../../internal/stats.h"
 #include "../../internal/thread.h"
 #include "../common/keymap_internal.h"
+#include "sender_capture_internal.h"
+#include "sender_repeat_internal.h"
 
 #include <stdatomic.h>
 
+#if defined(__linux__)
+#include <linux/input.h>
+
+/* Events queued before a single write() to the uinput fd. Large enough for a
+   fully modified tap (4 modifiers down/up, key down/up, one SYN per key).
+   Only whole SYN-terminated frames are written; a frame that would overflow
+   the buffer is ended early with its own SYN_REPORT. */
+#define AXIDEV_IO_LINUX_SENDER_EVENT_BUFFER_LEN 64
+#define AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN ((KEY_MAX + 8) / 8)
+#endif
+
 typedef struct axidev_io_keyboard_sender_impl {
 #ifdef _WIN32
   void *layout;
-  void *repeat_entries;
-  void *repeat_wake_event;
-  axidev_io_mutex repeat_lock;
-  axidev_io_thread repeat_worker;
-  bool repeat_lock_initialized;
-  bool repeat_worker_running;
-  bool repeat_stop_worker;
-  atomic_bool repeat_active;
-  atomic_bool repeat_sends_paused;
-  atomic_int repeat_cancel_key;
-  atomic_int repeat_cancel_mods;
-  size_t repeat_len;
-  size_t repeat_cap;
+  axidev_io_repeat_engine repeat;
+  void *pending_inputs;
+  uint32_t batch_depth;
+  axidev_io_pacer pacer;
+  /* Set under AXIDEV_IO_SENDER_OPTION_CAPTURE: inputs are recorded there
+     instead of going to SendInput. Handles point it at the global sender's
+     buffer when it captures, and at `own_capture` otherwise. */
+  axidev_io_sender_capture *capture;
+  axidev_io_sender_capture own_capture;
 #elif defined(__linux__)
   int fd;
+  size_t pending_len;
+  /* End of the last complete frame in `pending`; events past it wait for
+     their SYN_REPORT. */
+  size_t pending_frame_end;
+  uint32_t batch_depth;
+  struct input_event pending[AXIDEV_IO_LINUX_SENDER_EVENT_BUFFER_LEN];
+  axidev_io_pacer pacer;
+  /* Keycodes registered on the device (all of them unless fast init ran)
+     and keycodes currently held down through it. */
+  bool all_keys_registered;
+  /* The fd or capture buffer belongs to the global sender; a handle
+     sharing it never destroys it. */
+  bool borrowed_device;
+  uint8_t registered_keys[AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN];
+  uint8_t down_keys[AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN];
+  axidev_io_repeat_engine repeat;
+  /* Set under AXIDEV_IO_SENDER_OPTION_CAPTURE, which leaves `fd` at -1:
+     events are recorded there instead of written to a device. */
+  axidev_io_sender_capture *capture;
+  axidev_io_sender_capture own_capture;
   void *xkb_ctx;
   void *xkb_keymap;
   void *xkb_state;
@@ -37,17 +67,45 @@ _Static_assert(sizeof(axidev_io_keyboard_sender_impl) <=
                    AXIDEV_IO_KEYBOARD_SENDER_STORAGE_SIZE,
                "sender storage is too small");
 
+/* Sender state behind an axidev_io_sender_t. Its calls bind `context` as
+   the calling thread's sender, so the backends run unchanged on it. */
+struct axidev_io_sender {
+  axidev_io_keyboard_sender_context context;
+  uint32_t flags;
+};
+
 axidev_io_keyboard_sender_impl *axidev_io_sender_impl_get(void);
 
 axidev_io_result axidev_io_keyboard_sender_initialize(void);
 void axidev_io_keyboard_sender_free(void);
+/* Initializes the bound handle; AXIDEV_IO_SENDER_HANDLE_* `flags`. Needs an
+   initialized global sender to share its device. `device` names an owned
+   device and may be NULL. */
+axidev_io_result axidev_io_keyboard_sender_initialize_handle(
+    uint32_t flags, const axidev_io_virtual_device_t *device);
 axidev_io_result axidev_io_keyboard_sender_request_permissions(void);
+/* Called after the keymap switched layouts. The sender keeps running; only
+   a uinput device that lacks keys of the new layout is replaced. If no new
+   device can be created the old one stays; if the replaced sender cannot
+   restart it is freed, leaving the sender uninitialized. */
+axidev_io_result axidev_io_keyboard_sender_keymap_changed_internal(void);
 axidev_io_result axidev_io_keyboard_sender_key_down_internal(
     axidev_io_keyboard_key_with_modifier_t key_mod, bool repeat);
 axidev_io_result axidev_io_keyboard_sender_key_up_internal(
     axidev_io_keyboard_key_with_modifier_t key_mod);
 axidev_io_result axidev_io_keyboard_sender_tap_internal(
     axidev_io_keyboard_key_with_modifier_t key_mod);
+/* Tap entry point of the public and queued paths; feeds the tap duration
+   histogram of axidev_io_get_stats(). */
+static inline axidev_io_result axidev_io_keyboard_sender_tap_timed(
+    axidev_io_keyboard_key_with_modifier_t key_mod) {
+  uint64_t start_ns = axidev_io_monotonic_time_ns();
+  axidev_io_result result = axidev_io_keyboard_sender_tap_internal(key_mod);
+
+  axidev_io_stats_record(AXIDEV_IO_STAT_TAP_DURATION_US,
+                         (axidev_io_monotonic_time_ns() - start_ns) / 1000u);
+  return result;
+}
 axidev_io_result axidev_io_keyboard_sender_hold_modifier_internal(
     axidev_io_keyboard_modifier_t mods);
 axidev_io_result axidev_io_keyboard_sender_release_modifier_internal(
@@ -55,11 +113,47 @@ axidev_io_result axidev_io_keyboard_sender_release_modifier_internal(
 axidev_io_result axidev_io_keyboard_sender_release_all_modifiers_internal(void);
 axidev_io_result
 axidev_io_keyboard_sender_type_character_internal(uint32_t codepoint);
+/* Primitives for planned text: a tap of an already resolved keycode that
+   leaves modifiers untouched, layout-independent Unicode injection where the
+   backend supports it, and the configured inter-key pause. */
+axidev_io_result
+axidev_io_keyboard_sender_tap_keycode_internal(axidev_io_keyboard_key_t key,
+                                               int32_t keycode);
+axidev_io_result
+axidev_io_keyboard_sender_type_unicode_internal(uint32_t codepoint);
+axidev_io_result axidev_io_keyboard_sender_delay_internal(void);
+/* One transition of an already resolved keycode, tracked in the active
+   modifiers like any other; used by macro replay. */
+axidev_io_result
+axidev_io_keyboard_sender_send_keycode_internal(axidev_io_keyboard_key_t key,
+                                                int32_t keycode, bool down);
+/* Waits on the sender's pacer until the absolute monotonic `deadline_ns`. */
+void axidev_io_keyboard_sender_wait_until_internal(uint64_t deadline_ns);
 void axidev_io_keyboard_sender_flush_internal(void);
+/* Brackets a run of sender calls whose events may be delivered together.
+   Batches nest; events are submitted when the outermost batch ends. */
+void axidev_io_keyboard_sender_begin_batch_internal(void);
+axidev_io_result axidev_io_keyboard_sender_end_batch_internal(void);
 void axidev_io_keyboard_sender_set_key_delay_internal(uint32_t delay_us);
+void axidev_io_keyboard_sender_set_pacing_spin_internal(uint32_t spin_us);
+/* AXIDEV_IO_SENDER_OPTION_* flags; they persist across free/initialize and
+   are read by the next initialize. */
+void axidev_io_keyboard_sender_set_options_internal(uint32_t options);
+uint32_t axidev_io_keyboard_sender_get_options_internal(void);
+/* Reads the global sender's capture buffer whichever sender is bound. */
+size_t axidev_io_keyboard_sender_capture_read_internal(
+    axidev_io_captured_transition_t *out, size_t max_count);
 
 #ifdef _WIN32
 size_t axidev_io_windows_sender_repeat_count_for_tests(void);
+#elif defined(__linux__)
+/* Frame buffer of `impl`, behind the uinput backend's event writes. */
+axidev_io_result
+axidev_io_linux_sender_queue_event(axidev_io_keyboard_sender_impl *impl,
+                                   int type, int code, int value);
+/* Submits every complete frame; an unterminated tail stays queued. */
+axidev_io_result
+axidev_io_linux_sender_flush_frames(axidev_io_keyboard_sender_impl *impl);
 #endif
 
 #endif
@@ -0,0 +1,360 @@
+#include "sender_queue_internal.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stb/stb_ds.h>
+
+#include "../macro/macro_internal.h"
+#include "sender_internal.h"
+#include "typing_plan_internal.h"
+
+typedef enum axidev_io_sender_job_kind {
+  AXIDEV_IO_SENDER_JOB_TEXT = 0,
+  AXIDEV_IO_SENDER_JOB_TAP = 1,
+  AXIDEV_IO_SENDER_JOB_MACRO = 2
+} axidev_io_sender_job_kind;
+
+typedef struct axidev_io_sender_job {
+  uint64_t id;
+  axidev_io_sender_job_kind kind;
+  bool cancelled;
+  char *text;
+  axidev_io_keyboard_key_with_modifier_t key_mod;
+  /* Owned copy of a macro stream and its replay speed. */
+  uint8_t *macro;
+  size_t macro_size;
+  double speed;
+  axidev_io_keyboard_async_cb cb;
+  void *user_data;
+} axidev_io_sender_job;
+
+typedef struct axidev_io_sender_queue {
+  axidev_io_mutex lock;
+  axidev_io_cond wake;
+  axidev_io_cond finished;
+  axidev_io_thread worker;
+  bool worker_running;
+  bool stop_worker;
+  axidev_io_sender_job jobs[AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY];
+  size_t head;
+  size_t len;
+  uint64_t next_id;
+  uint64_t finished_id;
+  uint64_t running_id;
+  atomic_bool running_cancel;
+} axidev_io_sender_queue;
+
+static axidev_io_once g_sender_queue_once = AXIDEV_IO_ONCE_INIT;
+static axidev_io_sender_queue g_sender_queue;
+/* Set on the worker thread, where job callbacks run. */
+static AXIDEV_IO_THREAD_LOCAL bool g_on_sender_worker;
+
+static void axidev_io_sender_queue_init_once(void) {
+  memset(&g_sender_queue, 0, sizeof(g_sender_queue));
+  axidev_io_mutex_init(&g_sender_queue.lock);
+  axidev_io_cond_init(&g_sender_queue.wake);
+  axidev_io_cond_init(&g_sender_queue.finished);
+  g_sender_queue.next_id = 1;
+  atomic_store(&g_sender_queue.running_cancel, false);
+}
+
+static axidev_io_sender_queue *axidev_io_sender_queue_get(void) {
+  axidev_io_call_once(&g_sender_queue_once, axidev_io_sender_queue_init_once);
+  return &g_sender_queue;
+}
+
+static bool axidev_io_sender_queue_keyboard_ready(void) {
+  return axidev_io_global->keyboard.initialized &&
+         axidev_io_global->keyboard.sender.initialized &&
+         axidev_io_global->keyboard.keymap.initialized;
+}
+
+static axidev_io_result
+axidev_io_sender_queue_run_job(const axidev_io_sender_job *job,
+                               axidev_io_sender_queue *queue) {
+  axidev_io_typing_step *steps = NULL;
+  axidev_io_result result;
+
+  axidev_io_context_lock();
+  if (atomic_load(&queue->running_cancel)) {
+    result = AXIDEV_IO_RESULT_CANCELLED;
+  } else if (!axidev_io_sender_queue_keyboard_ready()) {
+    result = AXIDEV_IO_RESULT_NOT_INITIALIZED;
+  } else if (job->kind == AXIDEV_IO_SENDER_JOB_TAP) {
+    result = axidev_io_keyboard_sender_tap_timed(job->key_mod);
+  } else if (job->kind == AXIDEV_IO_SENDER_JOB_MACRO) {
+    result = axidev_io_macro_replay_internal(job->macro, job->macro_size,
+                                             job->speed,
+                                             &queue->running_cancel);
+  } else {
+    result = axidev_io_typing_plan_build(job->text, &steps);
+    if (result == AXIDEV_IO_RESULT_OK) {
+      result = axidev_io_typing_plan_play(steps, (size_t)arrlen(steps),
+                                          &queue->running_cancel);
+    }
+    axidev_io_typing_plan_free(&steps);
+  }
+  axidev_io_context_unlock();
+  return result;
+}
+
+static int axidev_io_sender_queue_worker_main(void *user_data) {
+  axidev_io_sender_queue *queue = (axidev_io_sender_queue *)user_data;
+
+  g_on_sender_worker = true;
+  for (;;) {
+    axidev_io_sender_job job;
+    axidev_io_result result;
+
+    axidev_io_mutex_lock(&queue->lock);
+    while (queue->len == 0 && !queue->stop_worker) {
+      axidev_io_cond_wait(&queue->wake, &queue->lock);
+    }
+    if (queue->len == 0) {
+      axidev_io_mutex_unlock(&queue->lock);
+      break;
+    }
+
+    job = queue->jobs[queue->head];
+    memset(&queue->jobs[queue->head], 0, sizeof(queue->jobs[queue->head]));
+    queue->head = (queue->head + 1u) % AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY;
+    --queue->len;
+    queue->running_id = job.id;
+    atomic_store(&queue->running_cancel, job.cancelled);
+    axidev_io_mutex_unlock(&queue->lock);
+
+    axidev_io_clear_last_error_internal();
+    result = job.cancelled ? AXIDEV_IO_RESULT_CANCELLED
+                           : axidev_io_sender_queue_run_job(&job, queue);
+    if (result != AXIDEV_IO_RESULT_OK &&
+        result != AXIDEV_IO_RESULT_CANCELLED) {
+      AXIDEV_IO_LOG_ERROR("async sender job %llu failed: %s",
+                          (unsigned long long)job.id,
+                          axidev_io_result_to_string(result));
+    }
+    /* The callback reads why a job failed, cancelled included, from the
+       worker's last error. */
+    if (result != AXIDEV_IO_RESULT_OK) {
+      if (axidev_io_get_last_error_message_internal()[0] == '\0') {
+        axidev_io_set_last_error_result("async sender job", result);
+      }
+      axidev_io_set_last_error_code(result);
+    }
+    if (job.cb != NULL) {
+      job.cb(job.id, result == AXIDEV_IO_RESULT_OK, job.user_data);
+    }
+    free(job.text);
+    free(job.macro);
+
+    axidev_io_mutex_lock(&queue->lock);
+    queue->finished_id = job.id;
+    queue->running_id = 0;
+    axidev_io_cond_broadcast(&queue->finished);
+    axidev_io_mutex_unlock(&queue->lock);
+  }
+
+  return 0;
+}
+
+static axidev_io_result axidev_io_sender_queue_push(axidev_io_sender_job *job,
+                                                    uint64_t *out_job_id) {
+  axidev_io_sender_queue *queue = axidev_io_sender_queue_get();
+  size_t tail;
+
+  axidev_io_mutex_lock(&queue->lock);
+  if (queue->len == AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY) {
+    axidev_io_mutex_unlock(&queue->lock);
+    return AXIDEV_IO_RESULT_QUEUE_FULL;
+  }
+  if (!queue->worker_running) {
+    queue->stop_worker = false;
+    if (!axidev_io_thread_create(&queue->worker,
+                                 axidev_io_sender_queue_worker_main, queue)) {
+      axidev_io_mutex_unlock(&queue->lock);
+      return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+    }
+    queue->worker_running = true;
+  }
+
+  job->id = queue->next_id++;
+  tail = (queue->head + queue->len) % AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY;
+  queue->jobs[tail] = *job;
+  ++queue->len;
+  axidev_io_cond_signal(&queue->wake);
+  axidev_io_mutex_unlock(&queue->lock);
+
+  *out_job_id = job->id;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_sender_queue_push_text(const char *text,
+                                 axidev_io_keyboard_async_cb cb,
+                                 void *user_data, uint64_t *out_job_id) {
+  axidev_io_sender_job job;
+  axidev_io_result result;
+
+  if (text == NULL || out_job_id == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+
+  memset(&job, 0, sizeof(job));
+  job.kind = AXIDEV_IO_SENDER_JOB_TEXT;
+  job.text = axidev_io_duplicate_string(text);
+  job.cb = cb;
+  job.user_data = user_data;
+  if (job.text == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+
+  result = axidev_io_sender_queue_push(&job, out_job_id);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    free(job.text);
+  }
+  return result;
+}
+
+axidev_io_result
+axidev_io_sender_queue_push_tap(axidev_io_keyboard_key_with_modifier_t key_mod,
+                                axidev_io_keyboard_async_cb cb,
+                                void *user_data, uint64_t *out_job_id) {
+  axidev_io_sender_job job;
+
+  if (out_job_id == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+
+  memset(&job, 0, sizeof(job));
+  job.kind = AXIDEV_IO_SENDER_JOB_TAP;
+  job.key_mod = key_mod;
+  job.cb = cb;
+  job.user_data = user_data;
+  return axidev_io_sender_queue_push(&job, out_job_id);
+}
+
+axidev_io_result axidev_io_sender_queue_push_macro(
+    const uint8_t *data, size_t size, double speed,
+    axidev_io_keyboard_async_cb cb, void *user_data, uint64_t *out_job_id) {
+  axidev_io_sender_job job;
+  axidev_io_result result;
+
+  if (data == NULL || size == 0 || !(speed >= 0.0) || out_job_id == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+
+  memset(&job, 0, sizeof(job));
+  job.kind = AXIDEV_IO_SENDER_JOB_MACRO;
+  job.macro = (uint8_t *)malloc(size);
+  job.macro_size = size;
+  job.speed = speed;
+  job.cb = cb;
+  job.user_data = user_data;
+  if (job.macro == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  memcpy(job.macro, data, size);
+
+  result = axidev_io_sender_queue_push(&job, out_job_id);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    free(job.macro);
+  }
+  return result;
+}
+
+bool axidev_io_sender_queue_wait(uint64_t job_id, uint32_t timeout_ms) {
+  axidev_io_sender_queue *queue = axidev_io_sender_queue_get();
+  uint64_t deadline_ms = 0;
+  uint64_t target;
+  bool done;
+
+  if (g_on_sender_worker) {
+    return false;
+  }
+  if (timeout_ms != AXIDEV_IO_ASYNC_WAIT_INFINITE) {
+    deadline_ms = axidev_io_monotonic_time_ms() + timeout_ms;
+  }
+
+  axidev_io_mutex_lock(&queue->lock);
+  target = job_id != 0 ? job_id : queue->next_id - 1u;
+  if (target >= queue->next_id) {
+    axidev_io_mutex_unlock(&queue->lock);
+    return false;
+  }
+
+  while (queue->finished_id < target) {
+    if (timeout_ms == AXIDEV_IO_ASYNC_WAIT_INFINITE) {
+      axidev_io_cond_wait(&queue->finished, &queue->lock);
+    } else {
+      uint64_t now_ms = axidev_io_monotonic_time_ms();
+      if (now_ms >= deadline_ms) {
+        break;
+      }
+      axidev_io_cond_timed_wait_ms(&queue->finished, &queue->lock,
+                                   (uint32_t)(deadline_ms - now_ms));
+    }
+  }
+  done = queue->finished_id >= target;
+  axidev_io_mutex_unlock(&queue->lock);
+  return done;
+}
+
+size_t axidev_io_sender_queue_cancel(uint64_t job_id) {
+  axidev_io_sender_queue *queue = axidev_io_sender_queue_get();
+  size_t cancelled = 0;
+  size_t i;
+
+  axidev_io_mutex_lock(&queue->lock);
+  for (i = 0; i < queue->len; ++i) {
+    size_t slot = (queue->head + i) % AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY;
+    axidev_io_sender_job *job = &queue->jobs[slot];
+    if ((job_id == 0 || job->id == job_id) && !job->cancelled) {
+      job->cancelled = true;
+      ++cancelled;
+    }
+  }
+  if (queue->running_id != 0 && (job_id == 0 || queue->running_id == job_id) &&
+      !atomic_exchange(&queue->running_cancel, true)) {
+    ++cancelled;
+  }
+  axidev_io_mutex_unlock(&queue->lock);
+  return cancelled;
+}
+
+size_t axidev_io_sender_queue_pending(void) {
+  axidev_io_sender_queue *queue = axidev_io_sender_queue_get();
+  size_t pending;
+
+  axidev_io_mutex_lock(&queue->lock);
+  pending = queue->len + (queue->running_id != 0 ? 1u : 0u);
+  axidev_io_mutex_unlock(&queue->lock);
+  return pending;
+}
+
+axidev_io_result axidev_io_sender_queue_shutdown(void) {
+  axidev_io_sender_queue *queue = axidev_io_sender_queue_get();
+
+  if (g_on_sender_worker) {
+    axidev_io_set_last_error_message(
+        "cannot be called from an async sender job callback");
+    return AXIDEV_IO_RESULT_NOT_SUPPORTED;
+  }
+  axidev_io_sender_queue_cancel(0);
+  axidev_io_mutex_lock(&queue->lock);
+  if (!queue->worker_running) {
+    axidev_io_mutex_unlock(&queue->lock);
+    return AXIDEV_IO_RESULT_OK;
+  }
+  queue->stop_worker = true;
+  axidev_io_cond_broadcast(&queue->wake);
+  axidev_io_mutex_unlock(&queue->lock);
+
+  axidev_io_thread_join(&queue->worker);
+
+  axidev_io_mutex_lock(&queue->lock);
+  queue->worker_running = false;
+  queue->stop_worker = false;
+  axidev_io_mutex_unlock(&queue->lock);
+  return AXIDEV_IO_RESULT_OK;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_SENDER_QUEUE_INTERNAL_H
+#define AXIDEV_IO_KEYBOARD_SENDER_QUEUE_INTERNAL_H
+
+#include "../../internal/context.h"
+
+/* Bounded FIFO of sender jobs drained by one injection worker. Producers
+   only take the queue lock; the worker takes the context lock per job, so
+   enqueueing never waits behind a running injection. */
+axidev_io_result
+axidev_io_sender_queue_push_text(const char *text,
+                                 axidev_io_keyboard_async_cb cb,
+                                 void *user_data, uint64_t *out_job_id);
+axidev_io_result
+axidev_io_sender_queue_push_tap(axidev_io_keyboard_key_with_modifier_t key_mod,
+                                axidev_io_keyboard_async_cb cb,
+                                void *user_data, uint64_t *out_job_id);
+/* Copies the macro stream; the replay releases the context lock between
+   events, so a long macro does not hold up other injections. */
+axidev_io_result axidev_io_sender_queue_push_macro(
+    const uint8_t *data, size_t size, double speed,
+    axidev_io_keyboard_async_cb cb, void *user_data, uint64_t *out_job_id);
+/* `job_id` 0 waits for every job accepted before the call. Returns false on
+   timeout, for an id that was never issued, or on the worker itself, which
+   could only wait on its own job. */
+bool axidev_io_sender_queue_wait(uint64_t job_id, uint32_t timeout_ms);
+/* `job_id` 0 cancels every queued job and the running one. */
+size_t axidev_io_sender_queue_cancel(uint64_t job_id);
+size_t axidev_io_sender_queue_pending(void);
+/* Cancels outstanding work, lets the worker complete every dropped job as
+   cancelled and joins it. Must be called without the context lock held.
+   NOT_SUPPORTED from a job callback, where the worker would join itself. */
+axidev_io_result axidev_io_sender_queue_shutdown(void);
+
+#endif
@@ -0,0 +1,426 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include "sender_repeat_internal.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stb/stb_ds.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+struct axidev_io_repeat_slot {
+  uint32_t key;
+  size_t value;
+};
+
+static uint32_t
+axidev_io_repeat_pack(axidev_io_keyboard_key_with_modifier_t request) {
+  return ((uint32_t)request.key << 8) | (uint32_t)request.mods;
+}
+
+uint64_t axidev_io_repeat_next_deadline(uint64_t previous_deadline_ns,
+                                        uint64_t interval_ns, uint64_t now_ns) {
+  uint64_t missed_intervals;
+
+  if (interval_ns == 0 || previous_deadline_ns > UINT64_MAX - interval_ns) {
+    return now_ns + 1u;
+  }
+  if (previous_deadline_ns + interval_ns > now_ns) {
+    return previous_deadline_ns + interval_ns;
+  }
+
+  missed_intervals = ((now_ns - previous_deadline_ns) / interval_ns) + 1u;
+  if (missed_intervals > (UINT64_MAX - previous_deadline_ns) / interval_ns) {
+    return now_ns + interval_ns;
+  }
+  return previous_deadline_ns + (missed_intervals * interval_ns);
+}
+
+/* Waits out a fire of `packed` in progress; with `lock` held. */
+static void axidev_io_repeat_wait_fire(axidev_io_repeat_engine *engine,
+                                       uint32_t packed) {
+  while (engine->firing && engine->firing_request == packed) {
+    axidev_io_cond_wait(&engine->fired, &engine->lock);
+  }
+}
+
+/* Places `entry` at heap slot `index` and records it in the index. */
+static void axidev_io_repeat_heap_set(axidev_io_repeat_engine *engine,
+                                      size_t index,
+                                      const axidev_io_repeat_entry *entry) {
+  engine->heap[index] = *entry;
+  hmput(engine->slots, axidev_io_repeat_pack(entry->request), index);
+}
+
+static void axidev_io_repeat_sift_up(axidev_io_repeat_engine *engine,
+                                     size_t index) {
+  axidev_io_repeat_entry entry = engine->heap[index];
+
+  while (index > 0) {
+    size_t parent = (index - 1u) / 2u;
+    if (engine->heap[parent].next_fire_at_ns <= entry.next_fire_at_ns) {
+      break;
+    }
+    axidev_io_repeat_heap_set(engine, index, &engine->heap[parent]);
+    index = parent;
+  }
+  axidev_io_repeat_heap_set(engine, index, &entry);
+}
+
+static void axidev_io_repeat_sift_down(axidev_io_repeat_engine *engine,
+                                       size_t index) {
+  size_t count = (size_t)arrlen(engine->heap);
+  axidev_io_repeat_entry entry = engine->heap[index];
+
+  for (;;) {
+    size_t child = index * 2u + 1u;
+    if (child >= count) {
+      break;
+    }
+    if (child + 1u < count && engine->heap[child + 1u].next_fire_at_ns <
+                                  engine->heap[child].next_fire_at_ns) {
+      ++child;
+    }
+    if (entry.next_fire_at_ns <= engine->heap[child].next_fire_at_ns) {
+      break;
+    }
+    axidev_io_repeat_heap_set(engine, index, &engine->heap[child]);
+    index = child;
+  }
+  axidev_io_repeat_heap_set(engine, index, &entry);
+}
+
+static void axidev_io_repeat_heap_remove(axidev_io_repeat_engine *engine,
+                                         size_t index) {
+  size_t last = (size_t)arrlen(engine->heap) - 1u;
+  axidev_io_repeat_entry moved = engine->heap[last];
+  uint32_t packed = axidev_io_repeat_pack(engine->heap[index].request);
+
+  (void)hmdel(engine->slots, packed);
+  arrsetlen(engine->heap, last);
+  if (index != last) {
+    engine->heap[index] = moved;
+    if (index > 0 && moved.next_fire_at_ns <
+                         engine->heap[(index - 1u) / 2u].next_fire_at_ns) {
+      axidev_io_repeat_sift_up(engine, index);
+    } else {
+      axidev_io_repeat_sift_down(engine, index);
+    }
+  }
+  atomic_store(&engine->count, last);
+}
+
+static void axidev_io_repeat_wake(axidev_io_repeat_engine *engine) {
+#if defined(_WIN32)
+  SetEvent((HANDLE)engine->wake_event);
+#else
+  uint64_t one = 1;
+  ssize_t written = write(engine->wake_fd, &one, sizeof(one));
+  (void)written;
+#endif
+}
+
+/* Arms the timer for `deadline_ns`, or disarms it for UINT64_MAX. */
+static void axidev_io_repeat_arm(axidev_io_repeat_engine *engine,
+                                 uint64_t deadline_ns) {
+#if defined(_WIN32)
+  LARGE_INTEGER due;
+  uint64_t now_ns = axidev_io_monotonic_time_ns();
+
+  if (deadline_ns == UINT64_MAX) {
+    CancelWaitableTimer((HANDLE)engine->timer);
+    return;
+  }
+  /* Relative due times are negative, in 100 ns units. */
+  due.QuadPart = deadline_ns > now_ns
+                     ? -(LONGLONG)((deadline_ns - now_ns + 99u) / 100u)
+                     : -1;
+  SetWaitableTimer((HANDLE)engine->timer, &due, 0, NULL, NULL, FALSE);
+#else
+  struct itimerspec spec;
+
+  memset(&spec, 0, sizeof(spec));
+  if (deadline_ns != UINT64_MAX) {
+    /* An all-zero value would disarm instead of firing at once. */
+    if (deadline_ns == 0) {
+      deadline_ns = 1;
+    }
+    spec.it_value.tv_sec = (time_t)(deadline_ns / 1000000000u);
+    spec.it_value.tv_nsec = (long)(deadline_ns % 1000000000u);
+  }
+  timerfd_settime(engine->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+#endif
+}
+
+static void axidev_io_repeat_wait(axidev_io_repeat_engine *engine) {
+#if defined(_WIN32)
+  HANDLE handles[2];
+
+  handles[0] = (HANDLE)engine->wake_event;
+  handles[1] = (HANDLE)engine->timer;
+  WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+#else
+  struct pollfd fds[2];
+  uint64_t value;
+
+  fds[0].fd = engine->wake_fd;
+  fds[0].events = POLLIN;
+  fds[0].revents = 0;
+  fds[1].fd = engine->timer_fd;
+  fds[1].events = POLLIN;
+  fds[1].revents = 0;
+  if (poll(fds, 2, -1) > 0) {
+    if ((fds[0].revents & POLLIN) != 0 &&
+        read(engine->wake_fd, &value, sizeof(value)) < 0) {
+      value = 0;
+    }
+    if ((fds[1].revents & POLLIN) != 0 &&
+        read(engine->timer_fd, &value, sizeof(value)) < 0) {
+      value = 0;
+    }
+  }
+#endif
+}
+
+static int axidev_io_repeat_worker_main(void *user_data) {
+  axidev_io_repeat_engine *engine = (axidev_io_repeat_engine *)user_data;
+
+  axidev_io_mutex_lock(&engine->lock);
+  while (!engine->stop) {
+    uint64_t now_ns = axidev_io_monotonic_time_ns();
+
+    while (!engine->stop && arrlen(engine->heap) > 0 &&
+           engine->heap[0].next_fire_at_ns <= now_ns) {
+      axidev_io_repeat_entry due = engine->heap[0];
+      uint32_t packed = axidev_io_repeat_pack(due.request);
+      ptrdiff_t slot;
+      size_t index;
+      bool fired;
+
+      engine->firing = true;
+      engine->firing_request = packed;
+      axidev_io_mutex_unlock(&engine->lock);
+      fired = engine->fire(due.keycode, engine->user_data);
+      axidev_io_mutex_lock(&engine->lock);
+      engine->firing = false;
+      axidev_io_cond_broadcast(&engine->fired);
+
+      /* The entry may have been cancelled, or cancelled and added again,
+         while the lock was released; only the one that fired moves on. */
+      slot = hmgeti(engine->slots, packed);
+      if (slot < 0) {
+        continue;
+      }
+      index = engine->slots[slot].value;
+      if (engine->heap[index].next_fire_at_ns != due.next_fire_at_ns) {
+        continue;
+      }
+      if (!fired) {
+        axidev_io_repeat_heap_remove(engine, index);
+        continue;
+      }
+      engine->heap[index].next_fire_at_ns = axidev_io_repeat_next_deadline(
+          due.next_fire_at_ns, due.interval_ns, now_ns);
+      axidev_io_repeat_sift_down(engine, index);
+    }
+    axidev_io_repeat_arm(engine, arrlen(engine->heap) > 0
+                                     ? engine->heap[0].next_fire_at_ns
+                                     : UINT64_MAX);
+    axidev_io_mutex_unlock(&engine->lock);
+    axidev_io_repeat_wait(engine);
+    axidev_io_mutex_lock(&engine->lock);
+  }
+  axidev_io_mutex_unlock(&engine->lock);
+  return 0;
+}
+
+static void axidev_io_repeat_close_handles(axidev_io_repeat_engine *engine) {
+#if defined(_WIN32)
+  if (engine->wake_event != NULL) {
+    CloseHandle((HANDLE)engine->wake_event);
+    engine->wake_event = NULL;
+  }
+  if (engine->timer != NULL) {
+    CloseHandle((HANDLE)engine->timer);
+    engine->timer = NULL;
+  }
+#else
+  if (engine->wake_fd >= 0) {
+    close(engine->wake_fd);
+    engine->wake_fd = -1;
+  }
+  if (engine->timer_fd >= 0) {
+    close(engine->timer_fd);
+    engine->timer_fd = -1;
+  }
+#endif
+}
+
+axidev_io_result axidev_io_repeat_engine_start(axidev_io_repeat_engine *engine,
+                                               axidev_io_repeat_fire_fn fire,
+                                               void *user_data) {
+  if (engine == NULL || fire == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  memset(engine, 0, sizeof(*engine));
+  engine->fire = fire;
+  engine->user_data = user_data;
+#if defined(_WIN32)
+  engine->wake_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+  engine->timer = axidev_io_create_waitable_timer();
+  if (engine->wake_event == NULL || engine->timer == NULL) {
+    axidev_io_set_last_errorf("repeat timer setup failed: %lu",
+                              (unsigned long)GetLastError());
+    axidev_io_repeat_close_handles(engine);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+#else
+  engine->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  engine->timer_fd =
+      timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+  if (engine->wake_fd < 0 || engine->timer_fd < 0) {
+    axidev_io_set_last_errorf("repeat timer setup failed: %s",
+                              strerror(errno));
+    axidev_io_repeat_close_handles(engine);
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+#endif
+  if (!axidev_io_mutex_init(&engine->lock)) {
+    axidev_io_repeat_close_handles(engine);
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  if (!axidev_io_cond_init(&engine->fired)) {
+    axidev_io_mutex_destroy(&engine->lock);
+    axidev_io_repeat_close_handles(engine);
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  if (!axidev_io_thread_create(&engine->worker, axidev_io_repeat_worker_main,
+                               engine)) {
+    axidev_io_cond_destroy(&engine->fired);
+    axidev_io_mutex_destroy(&engine->lock);
+    axidev_io_repeat_close_handles(engine);
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  engine->running = true;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+void axidev_io_repeat_engine_stop(axidev_io_repeat_engine *engine) {
+  if (!engine->running) {
+    return;
+  }
+  axidev_io_mutex_lock(&engine->lock);
+  engine->stop = true;
+  axidev_io_mutex_unlock(&engine->lock);
+  axidev_io_repeat_wake(engine);
+  axidev_io_thread_join(&engine->worker);
+
+  arrfree(engine->heap);
+  hmfree(engine->slots);
+  atomic_store(&engine->count, 0);
+  axidev_io_cond_destroy(&engine->fired);
+  axidev_io_mutex_destroy(&engine->lock);
+  axidev_io_repeat_close_handles(engine);
+  engine->running = false;
+}
+
+bool axidev_io_repeat_engine_contains(
+    axidev_io_repeat_engine *engine,
+    axidev_io_keyboard_key_with_modifier_t request) {
+  bool found;
+
+  if (!engine->running) {
+    return false;
+  }
+  axidev_io_mutex_lock(&engine->lock);
+  found = hmgeti(engine->slots, axidev_io_repeat_pack(request)) >= 0;
+  axidev_io_mutex_unlock(&engine->lock);
+  return found;
+}
+
+axidev_io_result
+axidev_io_repeat_engine_add(axidev_io_repeat_engine *engine,
+                            const axidev_io_repeat_entry *entry) {
+  uint32_t packed = axidev_io_repeat_pack(entry->request);
+  size_t index;
+
+  if (!engine->running) {
+    return AXIDEV_IO_RESULT_NOT_INITIALIZED;
+  }
+  axidev_io_mutex_lock(&engine->lock);
+  if (hmgeti(engine->slots, packed) >= 0) {
+    axidev_io_mutex_unlock(&engine->lock);
+    return AXIDEV_IO_RESULT_ALREADY_INITIALIZED;
+  }
+  index = (size_t)arrlen(engine->heap);
+  arrput(engine->heap, *entry);
+  axidev_io_repeat_sift_up(engine, index);
+  atomic_store(&engine->count, index + 1u);
+  /* Only a new root moves the next wakeup. */
+  if (engine->heap[0].next_fire_at_ns == entry->next_fire_at_ns) {
+    axidev_io_repeat_wake(engine);
+  }
+  axidev_io_mutex_unlock(&engine->lock);
+  return AXIDEV_IO_RESULT_OK;
+}
+
+bool axidev_io_repeat_engine_cancel(
+    axidev_io_repeat_engine *engine,
+    axidev_io_keyboard_key_with_modifier_t request) {
+  ptrdiff_t slot;
+
+  if (!engine->running || atomic_load(&engine->count) == 0) {
+    return false;
+  }
+  axidev_io_mutex_lock(&engine->lock);
+  slot = hmgeti(engine->slots, axidev_io_repeat_pack(request));
+  if (slot >= 0) {
+    /* A stale timer only costs the worker one empty pass. */
+    axidev_io_repeat_heap_remove(engine, engine->slots[slot].value);
+    axidev_io_repeat_wait_fire(engine, axidev_io_repeat_pack(request));
+  }
+  axidev_io_mutex_unlock(&engine->lock);
+  return slot >= 0;
+}
+
+void axidev_io_repeat_engine_drain(axidev_io_repeat_engine *engine,
+                                   axidev_io_repeat_entry **out_entries,
+                                   size_t *out_count) {
+  axidev_io_repeat_entry *entries = NULL;
+  size_t count = 0;
+
+  if (engine->running) {
+    axidev_io_mutex_lock(&engine->lock);
+    count = (size_t)arrlen(engine->heap);
+    if (count > 0) {
+      entries = (axidev_io_repeat_entry *)malloc(count * sizeof(*entries));
+      if (entries != NULL) {
+        memcpy(entries, engine->heap, count * sizeof(*entries));
+      } else {
+        count = 0;
+      }
+    }
+    arrfree(engine->heap);
+    hmfree(engine->slots);
+    atomic_store(&engine->count, 0);
+    while (engine->firing) {
+      axidev_io_cond_wait(&engine->fired, &engine->lock);
+    }
+    axidev_io_mutex_unlock(&engine->lock);
+  }
+  *out_entries = entries;
+  *out_count = count;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_SENDER_REPEAT_INTERNAL_H
+#define AXIDEV_IO_KEYBOARD_SENDER_REPEAT_INTERNAL_H
+
+#include "../../internal/context.h"
+
+#include <stdatomic.h>
+
+/* Emits one repeat of `keycode`; runs on the repeat worker without the
+   engine lock. Returning false stops that key's repeat, so a failing sink
+   is reported once rather than on every tick. */
+typedef bool (*axidev_io_repeat_fire_fn)(int32_t keycode, void *user_data);
+
+typedef struct axidev_io_repeat_entry {
+  axidev_io_keyboard_key_with_modifier_t request;
+  axidev_io_keyboard_key_t resolved_key;
+  int32_t keycode;
+  axidev_io_keyboard_modifier_t mods;
+  uint64_t next_fire_at_ns;
+  uint64_t interval_ns;
+} axidev_io_repeat_entry;
+
+/* Emulated key repeat shared by the sender backends. Held keys sit in a
+   min-heap on `next_fire_at_ns`; an index from request to heap slot makes
+   insert and cancel O(log n). The worker sleeps on a high-resolution timer
+   armed for the root and fires with `lock` released, so a slow write only
+   holds up a cancel of the key being fired: cancel and drain wait for that
+   fire, so no repeat is emitted once they return. */
+typedef struct axidev_io_repeat_engine {
+  axidev_io_mutex lock;
+  axidev_io_thread worker;
+  axidev_io_repeat_fire_fn fire;
+  void *user_data;
+  /* stb_ds array ordered as a binary min-heap. */
+  axidev_io_repeat_entry *heap;
+  /* stb_ds hashmap: packed request -> heap index. */
+  struct axidev_io_repeat_slot *slots;
+  atomic_size_t count;
+  bool running;
+  bool stop;
+  /* Set while the worker fires `firing_request` without `lock`; `fired` is
+     broadcast when it returns. */
+  bool firing;
+  uint32_t firing_request;
+  axidev_io_cond fired;
+#ifdef _WIN32
+  void *wake_event;
+  void *timer;
+#else
+  int wake_fd;
+  int timer_fd;
+#endif
+} axidev_io_repeat_engine;
+
+axidev_io_result axidev_io_repeat_engine_start(axidev_io_repeat_engine *engine,
+                                               axidev_io_repeat_fire_fn fire,
+                                               void *user_data);
+/* Joins the worker; entries still held are returned by a prior drain. */
+void axidev_io_repeat_engine_stop(axidev_io_repeat_engine *engine);
+bool axidev_io_repeat_engine_contains(
+    axidev_io_repeat_engine *engine,
+    axidev_io_keyboard_key_with_modifier_t request);
+axidev_io_result
+axidev_io_repeat_engine_add(axidev_io_repeat_engine *engine,
+                            const axidev_io_repeat_entry *entry);
+/* Returns false when `request` was not repeating. */
+bool axidev_io_repeat_engine_cancel(
+    axidev_io_repeat_engine *engine,
+    axidev_io_keyboard_key_with_modifier_t request);
+/* Moves every entry to a malloc'd array the caller frees. */
+void axidev_io_repeat_engine_drain(axidev_io_repeat_engine *engine,
+                                   axidev_io_repeat_entry **out_entries,
+                                   size_t *out_count);
+
+static inline size_t
+axidev_io_repeat_engine_count(axidev_io_repeat_engine *engine) {
+  return atomic_load(&engine->count);
+}
+
+/* Catches a deadline up past `now_ns` without bursting missed repeats. */
+uint64_t axidev_io_repeat_next_deadline(uint64_t previous_deadline_ns,
+                                        uint64_t interval_ns, uint64_t now_ns);
+
+#endif
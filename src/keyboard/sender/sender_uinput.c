@@ -1,31 +1,69 @@
 #if defined(__linux__)
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "sender_internal.h"
 
 #include <axidev-io/c_api.h>
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <libudev.h>
 #include <linux/input.h>
 #include <linux/uinput.h>
+#include <poll.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
+#include <stb/stb_ds.h>
+
 #include "../common/key_utils_internal.h"
 
+#define AXIDEV_IO_LINUX_WRITE_RETRY_LIMIT 50
+#define AXIDEV_IO_LINUX_WRITE_RETRY_TIMEOUT_MS 10
+/* Settle time after UI_DEV_CREATE when readiness is not detected. */
+#define AXIDEV_IO_LINUX_DEVICE_SETTLE_MS 100
+#define AXIDEV_IO_LINUX_DEVICE_READY_TIMEOUT_MS 250
+#define AXIDEV_IO_LINUX_DEVICE_READY_POLL_MS 2
+/* How long udev may still take once the event node already exists. */
+#define AXIDEV_IO_LINUX_DEVICE_NODE_GRACE_MS 20
+#define AXIDEV_IO_LINUX_DEVICE_NAME "axidev-io virtual keyboard"
+#define AXIDEV_IO_LINUX_DEVICE_VENDOR 0x1234
+#define AXIDEV_IO_LINUX_DEVICE_PRODUCT 0x5678
+/* Emulated repeat timing; matches the kernel's soft-repeat defaults. */
+#define AXIDEV_IO_LINUX_REPEAT_DELAY_NS 250000000ull
+#define AXIDEV_IO_LINUX_REPEAT_INTERVAL_NS 33000000ull
+
+/* A uinput device and the keycodes it registers. */
+typedef struct axidev_io_linux_device {
+  int fd;
+  bool all_keys_registered;
+  uint8_t registered_keys[AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN];
+} axidev_io_linux_device;
+
+/* How far a freshly created device got before the readiness wait ended. */
+typedef enum axidev_io_linux_ready {
+  AXIDEV_IO_LINUX_READY_NONE,
+  AXIDEV_IO_LINUX_READY_NODE,
+  AXIDEV_IO_LINUX_READY_ANNOUNCED
+} axidev_io_linux_ready;
+
+/* Both are only accessed under the context lock. The kept device was left
+   open by a keep-alive free and waits to be adopted by the next
+   initialize. */
+static uint32_t g_sender_options = 0;
+static axidev_io_linux_device g_kept_device = {-1, false, {0}};
+
 axidev_io_keyboard_sender_impl *axidev_io_sender_impl_get(void) {
   return (axidev_io_keyboard_sender_impl *)axidev_io_sender_storage_ptr();
 }
 
-static void axidev_io_sender_delay(void) {
-  uint32_t delay_us = axidev_io_sender_public_context()->key_delay_us;
-  if (delay_us != 0) {
-    axidev_io_sleep_us(delay_us);
-  }
-}
-
 static void
 axidev_io_linux_sender_update_modifier_state(axidev_io_keyboard_key_t key,
                                              bool down) {
@@ -65,29 +103,225 @@ axidev_io_linux_sender_update_modifier_state(axidev_io_keyboard_key_t key,
   }
 }
 
-static void axidev_io_linux_emit(int fd, int type, int code, int value) {
-  struct input_event event;
-  memset(&event, 0, sizeof(event));
-  event.type = (unsigned short)type;
-  event.code = (unsigned short)code;
-  event.value = value;
-  write(fd, &event, sizeof(event));
+static axidev_io_result axidev_io_linux_write_events(int fd,
+                                                     const void *events,
+                                                     size_t size) {
+  const unsigned char *cursor = (const unsigned char *)events;
+  unsigned int retries = 0;
+
+  axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_WRITES, 1u);
+  while (size > 0) {
+    ssize_t written = write(fd, cursor, size);
+    if (written > 0) {
+      cursor += written;
+      size -= (size_t)written;
+      continue;
+    }
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+        retries < AXIDEV_IO_LINUX_WRITE_RETRY_LIMIT) {
+      struct pollfd pfd;
+      pfd.fd = fd;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+      ++retries;
+      poll(&pfd, 1, AXIDEV_IO_LINUX_WRITE_RETRY_TIMEOUT_MS);
+      continue;
+    }
+    axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_WRITE_FAILURES, 1u);
+    axidev_io_set_last_errorf("uinput write failed: %s",
+                              written < 0 ? strerror(errno) : "short write");
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  return AXIDEV_IO_RESULT_OK;
+}
+
+static bool
+axidev_io_linux_has_sink(const axidev_io_keyboard_sender_impl *impl) {
+  return impl->fd >= 0 || impl->capture != NULL;
+}
+
+/* Writes `count` events to the device, or records their key transitions
+   when capturing. */
+static axidev_io_result
+axidev_io_linux_submit_events(axidev_io_keyboard_sender_impl *impl,
+                              const struct input_event *events,
+                              size_t count) {
+  axidev_io_captured_transition_t
+      transitions[AXIDEV_IO_LINUX_SENDER_EVENT_BUFFER_LEN];
+  size_t recorded = 0;
+  size_t key_events = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    key_events += events[i].type == EV_KEY ? 1u : 0u;
+  }
+  if (impl->capture == NULL) {
+    axidev_io_result result;
+
+    if (impl->fd < 0) {
+      return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+    }
+    result = axidev_io_linux_write_events(impl->fd, events,
+                                          count * sizeof(events[0]));
+    if (result == AXIDEV_IO_RESULT_OK) {
+      axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_EVENTS_SENT, key_events);
+    }
+    return result;
+  }
+  axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_EVENTS_SENT, key_events);
+  for (size_t i = 0; i < count; ++i) {
+    if (events[i].type != EV_KEY) {
+      continue;
+    }
+    transitions[recorded].code = (int32_t)events[i].code;
+    transitions[recorded].value = (uint8_t)events[i].value;
+    transitions[recorded].unicode = false;
+    if (++recorded == AXIDEV_IO_LINUX_SENDER_EVENT_BUFFER_LEN) {
+      axidev_io_sender_capture_append(impl->capture, transitions, recorded);
+      recorded = 0;
+    }
+  }
+  axidev_io_sender_capture_append(impl->capture, transitions, recorded);
+  return AXIDEV_IO_RESULT_OK;
 }
 
-static void axidev_io_linux_sync(int fd) {
-  axidev_io_linux_emit(fd, EV_SYN, SYN_REPORT, 0);
+axidev_io_result
+axidev_io_linux_sender_flush_frames(axidev_io_keyboard_sender_impl *impl) {
+  size_t count = impl->pending_frame_end;
+  size_t tail = impl->pending_len - count;
+  axidev_io_result result;
+
+  if (count == 0) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  result = axidev_io_linux_submit_events(impl, impl->pending, count);
+  memmove(impl->pending, impl->pending + count,
+          tail * sizeof(impl->pending[0]));
+  impl->pending_len = tail;
+  impl->pending_frame_end = 0;
+  return result;
 }
 
-static axidev_io_result axidev_io_linux_send_key(int fd, int keycode,
-                                                 bool down) {
-  if (fd < 0 || keycode < 0) {
+axidev_io_result
+axidev_io_linux_sender_queue_event(axidev_io_keyboard_sender_impl *impl,
+                                   int type, int code, int value) {
+  struct input_event *event;
+
+  if (!axidev_io_linux_has_sink(impl)) {
     return AXIDEV_IO_RESULT_PLATFORM_ERROR;
   }
-  axidev_io_linux_emit(fd, EV_KEY, keycode, down ? 1 : 0);
-  axidev_io_linux_sync(fd);
+  /* Other events keep a slot free for the SYN_REPORT ending their frame,
+     so a full buffer always holds at least one complete frame. */
+  if (impl->pending_len + (type == EV_SYN ? 1u : 2u) >
+      AXIDEV_IO_LINUX_SENDER_EVENT_BUFFER_LEN) {
+    axidev_io_result result;
+
+    if (impl->pending_frame_end == 0) {
+      /* One frame fills the buffer: end it here and continue in the next
+         rather than write part of it. */
+      event = &impl->pending[impl->pending_len++];
+      memset(event, 0, sizeof(*event));
+      event->type = EV_SYN;
+      event->code = SYN_REPORT;
+      impl->pending_frame_end = impl->pending_len;
+    }
+    result = axidev_io_linux_sender_flush_frames(impl);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
+    }
+  }
+
+  event = &impl->pending[impl->pending_len++];
+  memset(event, 0, sizeof(*event));
+  event->type = (unsigned short)type;
+  event->code = (unsigned short)code;
+  event->value = value;
+  if (type == EV_SYN) {
+    impl->pending_frame_end = impl->pending_len;
+  }
   return AXIDEV_IO_RESULT_OK;
 }
 
+static axidev_io_result axidev_io_linux_flush_pending(void) {
+  return axidev_io_linux_sender_flush_frames(axidev_io_sender_impl_get());
+}
+
+/* Submits queued events unless an enclosing batch will do it later. */
+static axidev_io_result axidev_io_linux_commit(void) {
+  if (axidev_io_sender_impl_get()->batch_depth != 0) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  return axidev_io_linux_flush_pending();
+}
+
+static axidev_io_result axidev_io_sender_delay(void) {
+  uint32_t delay_us = axidev_io_sender_public_context()->key_delay_us;
+  axidev_io_result result;
+
+  if (delay_us == 0) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  /* Pending events must reach the device before the pause or the delay
+     would no longer separate the transitions. */
+  result = axidev_io_linux_flush_pending();
+  axidev_io_pacer_wait(&axidev_io_sender_impl_get()->pacer, delay_us);
+  return result;
+}
+
+static axidev_io_result axidev_io_linux_emit(int type, int code, int value) {
+  return axidev_io_linux_sender_queue_event(axidev_io_sender_impl_get(), type,
+                                            code, value);
+}
+
+static axidev_io_result axidev_io_linux_sync(void) {
+  return axidev_io_linux_emit(EV_SYN, SYN_REPORT, 0);
+}
+
+static bool axidev_io_linux_keybit_test(const uint8_t *bits, int keycode) {
+  return (bits[keycode / 8] & (uint8_t)(1u << (keycode % 8))) != 0;
+}
+
+static void axidev_io_linux_keybit_assign(uint8_t *bits, int keycode,
+                                          bool value) {
+  if (keycode < 0 || keycode >= KEY_MAX) {
+    return;
+  }
+  if (value) {
+    bits[keycode / 8] |= (uint8_t)(1u << (keycode % 8));
+  } else {
+    bits[keycode / 8] &= (uint8_t)~(1u << (keycode % 8));
+  }
+}
+
+static axidev_io_result axidev_io_linux_send_key(int keycode, bool down) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  axidev_io_result result;
+
+  if (keycode < 0 || keycode >= KEY_MAX) {
+    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  }
+  if (!impl->all_keys_registered &&
+      !axidev_io_linux_keybit_test(impl->registered_keys, keycode)) {
+    axidev_io_set_last_errorf("keycode %d is not registered on the fast-init "
+                              "uinput device",
+                              keycode);
+    return AXIDEV_IO_RESULT_NOT_SUPPORTED;
+  }
+  result = axidev_io_linux_emit(EV_KEY, keycode, down ? 1 : 0);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_linux_sync();
+  }
+  if (result == AXIDEV_IO_RESULT_OK) {
+    axidev_io_linux_keybit_assign(impl->down_keys, keycode, down);
+  }
+  return result;
+}
+
+static axidev_io_result
+axidev_io_linux_queue_release_modifiers(axidev_io_keyboard_modifier_t mods);
+
 static axidev_io_result
 axidev_io_linux_resolve_mapping(axidev_io_keyboard_key_with_modifier_t request,
                                 int32_t *out_keycode,
@@ -100,43 +334,416 @@ axidev_io_linux_resolve_mapping(axidev_io_keyboard_key_with_modifier_t request,
 static axidev_io_result
 axidev_io_linux_send_raw_key(axidev_io_keyboard_key_t key, int32_t keycode,
                              bool down) {
-  axidev_io_result result =
-      axidev_io_linux_send_key(axidev_io_sender_impl_get()->fd, keycode, down);
+  axidev_io_result result = axidev_io_linux_send_key(keycode, down);
   if (result == AXIDEV_IO_RESULT_OK) {
     axidev_io_linux_sender_update_modifier_state(key, down);
   }
   return result;
 }
 
-axidev_io_result axidev_io_keyboard_sender_initialize(void) {
-  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
-  axidev_io_keyboard_sender_context *sender;
+static bool axidev_io_linux_key_is_modifier(axidev_io_keyboard_key_t key) {
+  switch (key) {
+  case AXIDEV_IO_KEY_SHIFT_LEFT:
+  case AXIDEV_IO_KEY_SHIFT_RIGHT:
+  case AXIDEV_IO_KEY_CTRL_LEFT:
+  case AXIDEV_IO_KEY_CTRL_RIGHT:
+  case AXIDEV_IO_KEY_ALT_LEFT:
+  case AXIDEV_IO_KEY_ALT_RIGHT:
+  case AXIDEV_IO_KEY_SUPER_LEFT:
+  case AXIDEV_IO_KEY_SUPER_RIGHT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/* Runs on the repeat worker. It submits straight to the sink, bypassing the
+   pending buffer owned by the sender's thread; a single write keeps the
+   repeat and its SYN in one frame. */
+static bool axidev_io_linux_repeat_fire(int32_t keycode, void *user_data) {
+  axidev_io_keyboard_sender_impl *impl =
+      (axidev_io_keyboard_sender_impl *)user_data;
+  struct input_event events[2];
+
+  memset(events, 0, sizeof(events));
+  events[0].type = EV_KEY;
+  events[0].code = (unsigned short)keycode;
+  events[0].value = 2;
+  events[1].type = EV_SYN;
+  events[1].code = SYN_REPORT;
+  if (axidev_io_linux_submit_events(impl, events, 2) != AXIDEV_IO_RESULT_OK) {
+    AXIDEV_IO_LOG_ERROR("uinput repeat write failed for keycode %d; "
+                        "stopping its repeat",
+                        (int)keycode);
+    return false;
+  }
+  return true;
+}
+
+static axidev_io_result
+axidev_io_linux_release_repeat_entries(axidev_io_repeat_entry *entries,
+                                       size_t count) {
+  axidev_io_result final_result = AXIDEV_IO_RESULT_OK;
+  size_t i;
+
+  for (i = 0; i < count; ++i) {
+    axidev_io_result result = axidev_io_linux_send_raw_key(
+        entries[i].resolved_key, entries[i].keycode, false);
+    if (result == AXIDEV_IO_RESULT_OK) {
+      result = axidev_io_linux_queue_release_modifiers(entries[i].mods);
+    }
+    if (result != AXIDEV_IO_RESULT_OK && final_result == AXIDEV_IO_RESULT_OK) {
+      final_result = result;
+    }
+  }
+
+  free(entries);
+  return final_result;
+}
+
+/* Keycodes the active keymap can emit, plus the modifiers and lock keys the
+   sender presses on its own. */
+static void axidev_io_linux_collect_keymap_keys(uint8_t *bits) {
+  static const int modifier_codes[] = {
+      KEY_LEFTSHIFT, KEY_RIGHTSHIFT, KEY_LEFTCTRL, KEY_RIGHTCTRL,
+      KEY_LEFTALT,   KEY_RIGHTALT,   KEY_LEFTMETA, KEY_RIGHTMETA,
+      KEY_CAPSLOCK,  KEY_NUMLOCK};
+  const axidev_io_keymap_layout_set *set = axidev_io_keymap_impl_get()->active;
+  const axidev_io_keymap_tables *tables = set != NULL ? set->tables : NULL;
+  axidev_io_keymap_char_mapping_entry *overflow;
+  size_t index;
+
+  memset(bits, 0, AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN);
+  for (index = 0; index < sizeof(modifier_codes) / sizeof(modifier_codes[0]);
+       ++index) {
+    axidev_io_linux_keybit_assign(bits, modifier_codes[index], true);
+  }
+  if (tables == NULL) {
+    return;
+  }
+  for (index = 0; index < AXIDEV_IO_KEYMAP_KEY_LIMIT; ++index) {
+    axidev_io_linux_keybit_assign(bits, tables->key_to_code[index], true);
+  }
+  for (index = 0; index < AXIDEV_IO_KEYMAP_FAST_CHAR_LIMIT; ++index) {
+    if (tables->fast_char_present[index]) {
+      axidev_io_linux_keybit_assign(bits, tables->fast_chars[index].keycode,
+                                    true);
+    }
+  }
+  overflow = tables->char_overflow;
+  for (index = 0; index < (size_t)hmlen(overflow); ++index) {
+    axidev_io_linux_keybit_assign(bits, overflow[index].value.keycode, true);
+  }
+}
+
+static bool axidev_io_linux_keybits_cover(const uint8_t *have,
+                                          const uint8_t *need) {
+  size_t index;
+
+  for (index = 0; index < AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN; ++index) {
+    if ((need[index] & (uint8_t)~have[index]) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void axidev_io_linux_destroy_device(int fd) {
+  if (fd >= 0) {
+    ioctl(fd, UI_DEV_DESTROY);
+    close(fd);
+  }
+}
+
+/* Starts listening for udev announcements before the device exists so its
+   "add" event cannot be missed. Leaves both pointers NULL on failure or when
+   no udevd is running, since nothing would ever be announced then. */
+static void axidev_io_linux_open_input_monitor(struct udev **out_udev,
+                                               struct udev_monitor **out_mon) {
+  struct udev *udev = udev_new();
+  struct udev_monitor *monitor = NULL;
+
+  if (udev != NULL) {
+    struct udev_queue *queue = udev_queue_new(udev);
+    bool active = queue != NULL && udev_queue_get_udev_is_active(queue);
+    if (queue != NULL) {
+      udev_queue_unref(queue);
+    }
+    if (active) {
+      monitor = udev_monitor_new_from_netlink(udev, "udev");
+    }
+  }
+  if (monitor != NULL &&
+      (udev_monitor_filter_add_match_subsystem_devtype(monitor, "input",
+                                                       NULL) < 0 ||
+       udev_monitor_enable_receiving(monitor) < 0)) {
+    udev_monitor_unref(monitor);
+    monitor = NULL;
+  }
+  if (monitor == NULL && udev != NULL) {
+    udev_unref(udev);
+    udev = NULL;
+  }
+  *out_udev = udev;
+  *out_mon = monitor;
+}
+
+static bool axidev_io_linux_is_event_node_of(struct udev_device *device,
+                                             const char *sysname) {
+  const char *action = udev_device_get_action(device);
+  const char *devnode = udev_device_get_devnode(device);
+  struct udev_device *parent;
+  const char *parent_name;
+
+  if (action == NULL || strcmp(action, "add") != 0 || devnode == NULL ||
+      strncmp(devnode, "/dev/input/event", 16) != 0) {
+    return false;
+  }
+  /* The parent is owned by `device` and must not be unreferenced. */
+  parent = udev_device_get_parent(device);
+  parent_name = parent != NULL ? udev_device_get_sysname(parent) : NULL;
+  return parent_name != NULL && strcmp(parent_name, sysname) == 0;
+}
+
+/* Reports whether devtmpfs exposes the event node listed under the device's
+   sysfs directory. */
+static bool axidev_io_linux_event_node_exists(const char *sysname) {
+  char dir_path[128];
+  DIR *dir;
+  struct dirent *entry;
+  bool found = false;
+
+  snprintf(dir_path, sizeof(dir_path), "/sys/devices/virtual/input/%s",
+           sysname);
+  dir = opendir(dir_path);
+  if (dir == NULL) {
+    return false;
+  }
+  while (!found && (entry = readdir(dir)) != NULL) {
+    char node_path[300];
+    if (strncmp(entry->d_name, "event", 5) != 0) {
+      continue;
+    }
+    snprintf(node_path, sizeof(node_path), "/dev/input/%s", entry->d_name);
+    found = access(node_path, F_OK) == 0;
+  }
+  closedir(dir);
+  return found;
+}
+
+/* Waits for udev to finish processing the event node of `sysname`; this is
+   the same notification compositors and libinput act on. The node itself is
+   polled too: once it exists udev only gets a short grace period, so a
+   daemon that never announces devices cannot stall every init. */
+static axidev_io_linux_ready
+axidev_io_linux_wait_udev_add(struct udev_monitor *monitor,
+                              const char *sysname, uint64_t deadline_ms) {
+  int fd = udev_monitor_get_fd(monitor);
+  bool node_seen = false;
+
+  if (fd < 0) {
+    return AXIDEV_IO_LINUX_READY_NONE;
+  }
+  for (;;) {
+    uint64_t now_ms = axidev_io_monotonic_time_ms();
+    uint64_t wait_ms;
+    struct pollfd pfd;
+    int ready;
+
+    if (!node_seen && axidev_io_linux_event_node_exists(sysname)) {
+      node_seen = true;
+      if (deadline_ms > now_ms + AXIDEV_IO_LINUX_DEVICE_NODE_GRACE_MS) {
+        deadline_ms = now_ms + AXIDEV_IO_LINUX_DEVICE_NODE_GRACE_MS;
+      }
+    }
+    if (now_ms >= deadline_ms) {
+      return node_seen ? AXIDEV_IO_LINUX_READY_NODE
+                       : AXIDEV_IO_LINUX_READY_NONE;
+    }
+    wait_ms = deadline_ms - now_ms;
+    if (!node_seen && wait_ms > AXIDEV_IO_LINUX_DEVICE_READY_POLL_MS) {
+      wait_ms = AXIDEV_IO_LINUX_DEVICE_READY_POLL_MS;
+    }
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    ready = poll(&pfd, 1, (int)wait_ms);
+    if (ready < 0 && errno != EINTR) {
+      return node_seen || axidev_io_linux_event_node_exists(sysname)
+                 ? AXIDEV_IO_LINUX_READY_NODE
+                 : AXIDEV_IO_LINUX_READY_NONE;
+    }
+    if (ready > 0) {
+      struct udev_device *device = udev_monitor_receive_device(monitor);
+      if (device != NULL) {
+        bool match = axidev_io_linux_is_event_node_of(device, sysname);
+        udev_device_unref(device);
+        if (match) {
+          return AXIDEV_IO_LINUX_READY_ANNOUNCED;
+        }
+      }
+    }
+  }
+}
+
+/* Fallback when udev cannot be monitored: waits for devtmpfs to expose the
+   event node. */
+static axidev_io_linux_ready
+axidev_io_linux_wait_event_node(const char *sysname, uint64_t deadline_ms) {
+  for (;;) {
+    if (axidev_io_linux_event_node_exists(sysname)) {
+      return AXIDEV_IO_LINUX_READY_NODE;
+    }
+    if (axidev_io_monotonic_time_ms() >= deadline_ms) {
+      return AXIDEV_IO_LINUX_READY_NONE;
+    }
+    axidev_io_sleep_ms(AXIDEV_IO_LINUX_DEVICE_READY_POLL_MS);
+  }
+}
+
+/* Closes a half-built device and reports the ioctl that failed. */
+static axidev_io_result axidev_io_linux_device_setup_failed(int fd,
+                                                            const char *what) {
+  int error = errno;
+
+  close(fd);
+  axidev_io_set_last_errorf("uinput %s failed: %s", what, strerror(error));
+  return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+}
+
+/* Creates a device into `out` without touching the sender, so a caller can
+   keep its current device until the new one exists. */
+static axidev_io_result
+axidev_io_linux_create_device(bool fast_init,
+                              const axidev_io_virtual_device_t *device,
+                              axidev_io_linux_device *out) {
+  struct udev *udev = NULL;
+  struct udev_monitor *monitor = NULL;
   struct uinput_setup setup;
+  char sysname[64];
   int keycode;
+  int fd;
 
-  memset(impl, 0, sizeof(*impl));
-  impl->fd = -1;
-  axidev_io_keyboard_reset_public_sender_state();
-  sender = axidev_io_sender_public_context();
-
-  impl->fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
-  if (impl->fd < 0) {
+  fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+  if (fd < 0) {
     return AXIDEV_IO_RESULT_PERMISSION_DENIED;
   }
 
-  ioctl(impl->fd, UI_SET_EVBIT, EV_KEY);
+  if (ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0) {
+    return axidev_io_linux_device_setup_failed(fd, "UI_SET_EVBIT");
+  }
+  if (fast_init) {
+    axidev_io_linux_collect_keymap_keys(out->registered_keys);
+  } else {
+    memset(out->registered_keys, 0xff, sizeof(out->registered_keys));
+  }
+  out->all_keys_registered = !fast_init;
   for (keycode = 0; keycode < KEY_MAX; ++keycode) {
-    ioctl(impl->fd, UI_SET_KEYBIT, keycode);
+    if (axidev_io_linux_keybit_test(out->registered_keys, keycode) &&
+        ioctl(fd, UI_SET_KEYBIT, keycode) < 0) {
+      return axidev_io_linux_device_setup_failed(fd, "UI_SET_KEYBIT");
+    }
   }
 
   memset(&setup, 0, sizeof(setup));
   setup.id.bustype = BUS_USB;
-  setup.id.vendor = 0x1234;
-  setup.id.product = 0x5678;
-  snprintf(setup.name, sizeof(setup.name), "axidev-io virtual keyboard");
-  ioctl(impl->fd, UI_DEV_SETUP, &setup);
-  ioctl(impl->fd, UI_DEV_CREATE);
-  axidev_io_sleep_ms(100);
+  setup.id.vendor = device != NULL && device->vendor_id != 0
+                        ? device->vendor_id
+                        : AXIDEV_IO_LINUX_DEVICE_VENDOR;
+  setup.id.product = device != NULL && device->product_id != 0
+                         ? device->product_id
+                         : AXIDEV_IO_LINUX_DEVICE_PRODUCT;
+  snprintf(setup.name, sizeof(setup.name), "%s",
+           device != NULL && device->name != NULL && device->name[0] != '\0'
+               ? device->name
+               : AXIDEV_IO_LINUX_DEVICE_NAME);
+  if (ioctl(fd, UI_DEV_SETUP, &setup) < 0) {
+    return axidev_io_linux_device_setup_failed(fd, "UI_DEV_SETUP");
+  }
+  if (!fast_init) {
+    if (ioctl(fd, UI_DEV_CREATE) < 0) {
+      return axidev_io_linux_device_setup_failed(fd, "UI_DEV_CREATE");
+    }
+    axidev_io_sleep_ms(AXIDEV_IO_LINUX_DEVICE_SETTLE_MS);
+    out->fd = fd;
+    return AXIDEV_IO_RESULT_OK;
+  }
+
+  axidev_io_linux_open_input_monitor(&udev, &monitor);
+  if (ioctl(fd, UI_DEV_CREATE) < 0) {
+    axidev_io_result result =
+        axidev_io_linux_device_setup_failed(fd, "UI_DEV_CREATE");
+    if (monitor != NULL) {
+      udev_monitor_unref(monitor);
+    }
+    if (udev != NULL) {
+      udev_unref(udev);
+    }
+    return result;
+  }
+  memset(sysname, 0, sizeof(sysname));
+  if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysname) - 1), sysname) < 0 ||
+      sysname[0] == '\0') {
+    /* Kernels before 3.15 cannot name the device; settle as before. */
+    axidev_io_sleep_ms(AXIDEV_IO_LINUX_DEVICE_SETTLE_MS);
+  } else {
+    uint64_t deadline_ms = axidev_io_monotonic_time_ms() +
+                           AXIDEV_IO_LINUX_DEVICE_READY_TIMEOUT_MS;
+    axidev_io_linux_ready ready =
+        monitor != NULL
+            ? axidev_io_linux_wait_udev_add(monitor, sysname, deadline_ms)
+            : axidev_io_linux_wait_event_node(sysname, deadline_ms);
+    if (ready == AXIDEV_IO_LINUX_READY_NODE && monitor != NULL) {
+      AXIDEV_IO_LOG_DEBUG("uinput device %s has its node but no udev "
+                          "announcement; continuing",
+                          sysname);
+    } else if (ready == AXIDEV_IO_LINUX_READY_NONE) {
+      AXIDEV_IO_LOG_WARN("uinput device %s has no event node after %u ms",
+                         sysname,
+                         (unsigned)AXIDEV_IO_LINUX_DEVICE_READY_TIMEOUT_MS);
+    }
+  }
+  if (monitor != NULL) {
+    udev_monitor_unref(monitor);
+  }
+  if (udev != NULL) {
+    udev_unref(udev);
+  }
+  out->fd = fd;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+/* Adopts the device kept by the previous free when it still registers
+   every key the current keymap needs. */
+static bool axidev_io_linux_adopt_kept_device(void) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  uint8_t needed[AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN];
+
+  if (g_kept_device.fd < 0) {
+    return false;
+  }
+  if (!g_kept_device.all_keys_registered) {
+    axidev_io_linux_collect_keymap_keys(needed);
+    if (!axidev_io_linux_keybits_cover(g_kept_device.registered_keys,
+                                       needed)) {
+      AXIDEV_IO_LOG_DEBUG("kept uinput device lacks keys for the current "
+                          "keymap; recreating it");
+      axidev_io_linux_destroy_device(g_kept_device.fd);
+      g_kept_device.fd = -1;
+      return false;
+    }
+  }
+  impl->fd = g_kept_device.fd;
+  impl->all_keys_registered = g_kept_device.all_keys_registered;
+  memcpy(impl->registered_keys, g_kept_device.registered_keys,
+         sizeof(impl->registered_keys));
+  g_kept_device.fd = -1;
+  return true;
+}
+
+static void axidev_io_linux_sender_mark_ready(void) {
+  axidev_io_keyboard_sender_context *sender = axidev_io_sender_public_context();
+  bool capturing = axidev_io_sender_impl_get()->capture != NULL;
 
   sender->initialized = true;
   sender->ready = true;
@@ -146,31 +753,282 @@ axidev_io_result axidev_io_keyboard_sender_initialize(void) {
   sender->capabilities.supports_key_repeat = true;
   sender->capabilities.needs_accessibility_perm = false;
   sender->capabilities.needs_input_monitoring_perm = false;
-  sender->capabilities.needs_uinput_access = true;
-  axidev_io_global->keyboard.backend_type = AXIDEV_IO_BACKEND_LINUX_UINPUT;
+  sender->capabilities.needs_uinput_access = !capturing;
+  axidev_io_global->keyboard.backend_type =
+      capturing ? AXIDEV_IO_BACKEND_CAPTURE : AXIDEV_IO_BACKEND_LINUX_UINPUT;
+}
+
+/* Resetting the public state also wipes the impl storage, so it goes
+   first. */
+static void axidev_io_linux_sender_reset(void) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+
+  axidev_io_keyboard_reset_public_sender_state();
+  memset(impl, 0, sizeof(*impl));
+  impl->fd = -1;
+  axidev_io_pacer_init(&impl->pacer);
+}
+
+static axidev_io_result axidev_io_linux_sender_start_repeat(void) {
+  axidev_io_keyboard_sender_context *sender = axidev_io_sender_public_context();
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+
+  sender->repeat_delay_ns = AXIDEV_IO_LINUX_REPEAT_DELAY_NS;
+  sender->repeat_interval_ns = AXIDEV_IO_LINUX_REPEAT_INTERVAL_NS;
+  return axidev_io_repeat_engine_start(&impl->repeat,
+                                       axidev_io_linux_repeat_fire, impl);
+}
+
+/* The global sender's capture buffer, or NULL when it is not capturing. */
+static axidev_io_sender_capture *axidev_io_linux_shared_capture(void) {
+  const axidev_io_keyboard_sender_context *shared =
+      &axidev_io_global->keyboard.sender;
+
+  if (!shared->initialized) {
+    return NULL;
+  }
+  return ((const axidev_io_keyboard_sender_impl *)shared->storage.bytes)
+      ->capture;
+}
+
+/* Capturing needs no device, so every keycode counts as registered. */
+static axidev_io_result
+axidev_io_linux_sender_start_capture(axidev_io_sender_capture *shared) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+
+  impl->all_keys_registered = true;
+  memset(impl->registered_keys, 0xff, sizeof(impl->registered_keys));
+  return axidev_io_sender_capture_attach(&impl->capture, &impl->own_capture,
+                                         shared);
+}
+
+static axidev_io_result
+axidev_io_linux_sender_initialize_device(
+    const axidev_io_virtual_device_t *device) {
+  axidev_io_result result;
+
+  axidev_io_linux_sender_reset();
+  result = axidev_io_linux_sender_start_repeat();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+  if ((g_sender_options & AXIDEV_IO_SENDER_OPTION_CAPTURE) != 0) {
+    result = axidev_io_linux_sender_start_capture(
+        axidev_io_sender_is_default() ? NULL
+                                      : axidev_io_linux_shared_capture());
+    if (result == AXIDEV_IO_RESULT_OK) {
+      axidev_io_linux_sender_mark_ready();
+    }
+    return result;
+  }
+  /* Handles with their own device never inherit the kept one. */
+  if (!axidev_io_sender_is_default() ||
+      !axidev_io_linux_adopt_kept_device()) {
+    axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+    axidev_io_linux_device created;
+
+    result = axidev_io_linux_create_device(
+        (g_sender_options & AXIDEV_IO_SENDER_OPTION_FAST_INIT) != 0, device,
+        &created);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
+    }
+    impl->fd = created.fd;
+    impl->all_keys_registered = created.all_keys_registered;
+    memcpy(impl->registered_keys, created.registered_keys,
+           sizeof(impl->registered_keys));
+  }
+  axidev_io_linux_sender_mark_ready();
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result axidev_io_keyboard_sender_initialize(void) {
+  return axidev_io_linux_sender_initialize_device(NULL);
+}
+
+axidev_io_result axidev_io_keyboard_sender_initialize_handle(
+    uint32_t flags, const axidev_io_virtual_device_t *device) {
+  const axidev_io_keyboard_sender_context *shared =
+      &axidev_io_global->keyboard.sender;
+  const axidev_io_keyboard_sender_impl *shared_impl =
+      (const axidev_io_keyboard_sender_impl *)shared->storage.bytes;
+  axidev_io_keyboard_sender_impl *impl;
+  axidev_io_result result;
+
+  if ((flags & AXIDEV_IO_SENDER_HANDLE_OWN_DEVICE) != 0) {
+    return axidev_io_linux_sender_initialize_device(device);
+  }
+  if (!shared->initialized ||
+      (shared_impl->fd < 0 && shared_impl->capture == NULL)) {
+    return AXIDEV_IO_RESULT_NOT_INITIALIZED;
+  }
+
+  axidev_io_linux_sender_reset();
+  result = axidev_io_linux_sender_start_repeat();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+  impl = axidev_io_sender_impl_get();
+  impl->borrowed_device = true;
+  if (shared_impl->capture != NULL) {
+    result = axidev_io_linux_sender_start_capture(shared_impl->capture);
+    if (result == AXIDEV_IO_RESULT_OK) {
+      axidev_io_linux_sender_mark_ready();
+    }
+    return result;
+  }
+  /* Each write() to uinput is delivered whole and the frame buffer only
+     writes complete SYN-terminated frames, so handles can share the
+     device. */
+  impl->fd = shared_impl->fd;
+  impl->all_keys_registered = shared_impl->all_keys_registered;
+  memcpy(impl->registered_keys, shared_impl->registered_keys,
+         sizeof(impl->registered_keys));
+  axidev_io_linux_sender_mark_ready();
   return AXIDEV_IO_RESULT_OK;
 }
 
+/* Releases every key still held through the device so a kept device does not
+   leave them stuck until it is reused. */
+static void axidev_io_linux_release_down_keys(void) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  int keycode;
+
+  impl->batch_depth = 0;
+  for (keycode = 0; keycode < KEY_MAX; ++keycode) {
+    if (axidev_io_linux_keybit_test(impl->down_keys, keycode)) {
+      axidev_io_linux_emit(EV_KEY, keycode, 0);
+    }
+  }
+  if (axidev_io_linux_sync() == AXIDEV_IO_RESULT_OK) {
+    axidev_io_linux_flush_pending();
+  }
+}
+
 void axidev_io_keyboard_sender_free(void) {
   axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  axidev_io_repeat_entry *entries = NULL;
+  size_t count = 0;
 
-  if (impl->fd >= 0) {
-    ioctl(impl->fd, UI_DEV_DESTROY);
-    close(impl->fd);
+  /* Zeroed storage reads as fd 0; only a live sender owns its fd. */
+  if (!axidev_io_sender_public_context()->initialized) {
+    impl->fd = -1;
+    impl->capture = NULL;
+  }
+  /* The worker writes to the sink, so it stops before the sink goes. */
+  axidev_io_repeat_engine_drain(&impl->repeat, &entries, &count);
+  axidev_io_repeat_engine_stop(&impl->repeat);
+  if (axidev_io_linux_has_sink(impl)) {
+    impl->batch_depth = 0;
+    axidev_io_linux_release_repeat_entries(entries, count);
+    axidev_io_linux_flush_pending();
+  } else {
+    free(entries);
   }
+  if (axidev_io_linux_has_sink(impl) && impl->borrowed_device) {
+    axidev_io_linux_release_down_keys();
+    impl->fd = -1;
+  }
+  axidev_io_sender_capture_detach(impl->capture, &impl->own_capture);
+  impl->capture = NULL;
+  if (impl->fd >= 0 && axidev_io_sender_is_default() &&
+      (g_sender_options & AXIDEV_IO_SENDER_OPTION_KEEP_DEVICE) != 0 &&
+      g_kept_device.fd < 0) {
+    axidev_io_linux_release_down_keys();
+    g_kept_device.fd = impl->fd;
+    g_kept_device.all_keys_registered = impl->all_keys_registered;
+    memcpy(g_kept_device.registered_keys, impl->registered_keys,
+           sizeof(g_kept_device.registered_keys));
+    impl->fd = -1;
+  }
+  axidev_io_linux_destroy_device(impl->fd);
+  axidev_io_pacer_destroy(&impl->pacer);
+  axidev_io_keyboard_reset_public_sender_state();
   memset(impl, 0, sizeof(*impl));
   impl->fd = -1;
-  axidev_io_keyboard_reset_public_sender_state();
+}
+
+/* Fast-init devices only register the keys of the layout they were created
+   for, so a switch to a layout that types others needs a new device. It is
+   created first: on failure the old device stays in place. Held keys are
+   released on the old device; the pacer and options carry over. */
+axidev_io_result axidev_io_keyboard_sender_keymap_changed_internal(void) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  uint8_t needed[AXIDEV_IO_LINUX_SENDER_KEYBITS_LEN];
+  axidev_io_linux_device created;
+  axidev_io_repeat_entry *entries = NULL;
+  size_t count = 0;
+  axidev_io_result result;
+
+  if (impl->fd < 0 || impl->all_keys_registered || impl->borrowed_device) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  axidev_io_linux_collect_keymap_keys(needed);
+  if (axidev_io_linux_keybits_cover(impl->registered_keys, needed)) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+
+  AXIDEV_IO_LOG_DEBUG("uinput device lacks keys for the new layout; "
+                      "recreating it");
+  result = axidev_io_linux_create_device(true, NULL, &created);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    AXIDEV_IO_LOG_WARN("cannot recreate the uinput device for the new "
+                       "layout; keeping the current one");
+    return result;
+  }
+
+  axidev_io_repeat_engine_drain(&impl->repeat, &entries, &count);
+  axidev_io_repeat_engine_stop(&impl->repeat);
+  impl->batch_depth = 0;
+  axidev_io_linux_release_repeat_entries(entries, count);
+  axidev_io_linux_release_down_keys();
+  axidev_io_linux_destroy_device(impl->fd);
+  impl->fd = created.fd;
+  impl->all_keys_registered = created.all_keys_registered;
+  memcpy(impl->registered_keys, created.registered_keys,
+         sizeof(impl->registered_keys));
+  memset(impl->down_keys, 0, sizeof(impl->down_keys));
+  axidev_io_sender_public_context()->active_modifiers = AXIDEV_IO_MOD_NONE;
+
+  result = axidev_io_linux_sender_start_repeat();
+  if (result != AXIDEV_IO_RESULT_OK) {
+    /* A sender without its repeat worker is not usable; report it as not
+       initialized rather than fail later sends one by one. */
+    axidev_io_keyboard_sender_free();
+  }
+  return result;
+}
+
+void axidev_io_keyboard_sender_set_options_internal(uint32_t options) {
+  g_sender_options = options;
+  if ((options & AXIDEV_IO_SENDER_OPTION_KEEP_DEVICE) == 0 &&
+      g_kept_device.fd >= 0) {
+    axidev_io_linux_destroy_device(g_kept_device.fd);
+    g_kept_device.fd = -1;
+  }
+}
+
+uint32_t axidev_io_keyboard_sender_get_options_internal(void) {
+  return g_sender_options;
+}
+
+size_t axidev_io_keyboard_sender_capture_read_internal(
+    axidev_io_captured_transition_t *out, size_t max_count) {
+  axidev_io_sender_capture *capture = axidev_io_linux_shared_capture();
+
+  return capture != NULL
+             ? axidev_io_sender_capture_read(capture, out, max_count)
+             : 0;
 }
 
 axidev_io_result axidev_io_keyboard_sender_request_permissions(void) {
-  return axidev_io_sender_impl_get()->fd >= 0
+  return axidev_io_linux_has_sink(axidev_io_sender_impl_get())
              ? AXIDEV_IO_RESULT_OK
              : AXIDEV_IO_RESULT_PERMISSION_DENIED;
 }
 
-axidev_io_result axidev_io_keyboard_sender_hold_modifier_internal(
-    axidev_io_keyboard_modifier_t mods) {
+static axidev_io_result
+axidev_io_linux_queue_hold_modifiers(axidev_io_keyboard_modifier_t mods) {
   axidev_io_result result = AXIDEV_IO_RESULT_OK;
 
   if (axidev_io_keyboard_has_modifier(mods, AXIDEV_IO_MOD_SHIFT)) {
@@ -201,8 +1059,8 @@ axidev_io_result axidev_io_keyboard_sender_hold_modifier_internal(
   return result;
 }
 
-axidev_io_result axidev_io_keyboard_sender_release_modifier_internal(
-    axidev_io_keyboard_modifier_t mods) {
+static axidev_io_result
+axidev_io_linux_queue_release_modifiers(axidev_io_keyboard_modifier_t mods) {
   axidev_io_result result = AXIDEV_IO_RESULT_OK;
 
   if (axidev_io_keyboard_has_modifier(mods, AXIDEV_IO_MOD_SHIFT)) {
@@ -233,31 +1091,83 @@ axidev_io_result axidev_io_keyboard_sender_release_modifier_internal(
   return result;
 }
 
+/* Commits whatever was queued, keeping the first failure as the result. */
+static axidev_io_result axidev_io_linux_finish(axidev_io_result result) {
+  axidev_io_result commit_result = axidev_io_linux_commit();
+  return result != AXIDEV_IO_RESULT_OK ? result : commit_result;
+}
+
+axidev_io_result axidev_io_keyboard_sender_hold_modifier_internal(
+    axidev_io_keyboard_modifier_t mods) {
+  return axidev_io_linux_finish(axidev_io_linux_queue_hold_modifiers(mods));
+}
+
+axidev_io_result axidev_io_keyboard_sender_release_modifier_internal(
+    axidev_io_keyboard_modifier_t mods) {
+  return axidev_io_linux_finish(axidev_io_linux_queue_release_modifiers(mods));
+}
+
 axidev_io_result
 axidev_io_keyboard_sender_release_all_modifiers_internal(void) {
-  return axidev_io_keyboard_sender_release_modifier_internal(
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  axidev_io_repeat_entry *entries = NULL;
+  axidev_io_result repeat_result;
+  axidev_io_result modifier_result;
+  size_t count = 0;
+
+  axidev_io_repeat_engine_drain(&impl->repeat, &entries, &count);
+  repeat_result = axidev_io_linux_release_repeat_entries(entries, count);
+  modifier_result = axidev_io_linux_queue_release_modifiers(
       AXIDEV_IO_MOD_SHIFT | AXIDEV_IO_MOD_CTRL | AXIDEV_IO_MOD_ALT |
       AXIDEV_IO_MOD_SUPER);
+  return axidev_io_linux_finish(
+      repeat_result != AXIDEV_IO_RESULT_OK ? repeat_result : modifier_result);
 }
 
 axidev_io_result axidev_io_keyboard_sender_key_down_internal(
     axidev_io_keyboard_key_with_modifier_t key_mod, bool repeat) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  axidev_io_keyboard_sender_context *sender = axidev_io_sender_public_context();
   int32_t keycode;
   axidev_io_keyboard_modifier_t mods;
   axidev_io_keyboard_key_t resolved_key;
   axidev_io_result result =
       axidev_io_linux_resolve_mapping(key_mod, &keycode, &mods, &resolved_key);
-  /* Linux/uinput keeps its existing virtual-device repeat behavior.
-     The repeat flag is only used by the Windows SendInput backend. */
-  (void)repeat;
   if (result != AXIDEV_IO_RESULT_OK) {
     return result;
   }
-  result = axidev_io_keyboard_sender_hold_modifier_internal(mods);
-  if (result != AXIDEV_IO_RESULT_OK) {
+  repeat = repeat && !axidev_io_linux_key_is_modifier(resolved_key);
+  if (repeat && axidev_io_repeat_engine_contains(&impl->repeat, key_mod)) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  result = axidev_io_linux_queue_hold_modifiers(mods);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_linux_send_raw_key(resolved_key, keycode, true);
+  }
+  /* The down must reach the device before the worker can repeat it. */
+  result = axidev_io_linux_finish(result);
+  if (result != AXIDEV_IO_RESULT_OK || !repeat) {
     return result;
   }
-  return axidev_io_linux_send_raw_key(resolved_key, keycode, true);
+
+  {
+    axidev_io_repeat_entry entry;
+
+    entry.request = key_mod;
+    entry.resolved_key = resolved_key;
+    entry.keycode = keycode;
+    entry.mods = mods;
+    entry.next_fire_at_ns =
+        axidev_io_monotonic_time_ns() + sender->repeat_delay_ns;
+    entry.interval_ns = sender->repeat_interval_ns;
+    result = axidev_io_repeat_engine_add(&impl->repeat, &entry);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_linux_send_raw_key(resolved_key, keycode, false);
+    axidev_io_linux_queue_release_modifiers(mods);
+    axidev_io_linux_finish(AXIDEV_IO_RESULT_OK);
+  }
+  return result;
 }
 
 axidev_io_result axidev_io_keyboard_sender_key_up_internal(
@@ -265,16 +1175,21 @@ axidev_io_result axidev_io_keyboard_sender_key_up_internal(
   int32_t keycode;
   axidev_io_keyboard_modifier_t mods;
   axidev_io_keyboard_key_t resolved_key;
-  axidev_io_result result =
+  axidev_io_result result;
+
+  /* Cancelling first guarantees no repeat lands after the key up. */
+  axidev_io_repeat_engine_cancel(&axidev_io_sender_impl_get()->repeat,
+                                 key_mod);
+  result =
       axidev_io_linux_resolve_mapping(key_mod, &keycode, &mods, &resolved_key);
   if (result != AXIDEV_IO_RESULT_OK) {
     return result;
   }
   result = axidev_io_linux_send_raw_key(resolved_key, keycode, false);
-  if (result != AXIDEV_IO_RESULT_OK) {
-    return result;
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_linux_queue_release_modifiers(mods);
   }
-  return axidev_io_keyboard_sender_release_modifier_internal(mods);
+  return axidev_io_linux_finish(result);
 }
 
 axidev_io_result axidev_io_keyboard_sender_tap_internal(
@@ -287,21 +1202,33 @@ axidev_io_result axidev_io_keyboard_sender_tap_internal(
   if (result != AXIDEV_IO_RESULT_OK) {
     return result;
   }
-  result = axidev_io_keyboard_sender_hold_modifier_internal(mods);
+  result = axidev_io_linux_queue_hold_modifiers(mods);
   if (result != AXIDEV_IO_RESULT_OK) {
-    return result;
+    return axidev_io_linux_finish(result);
+  }
+  /* Only a modifier press needs to settle before the key goes down. */
+  if (mods != AXIDEV_IO_MOD_NONE) {
+    result = axidev_io_sender_delay();
+  }
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_linux_send_raw_key(resolved_key, keycode, true);
   }
-  axidev_io_sender_delay();
-  result = axidev_io_linux_send_raw_key(resolved_key, keycode, true);
   if (result != AXIDEV_IO_RESULT_OK) {
-    axidev_io_keyboard_sender_release_modifier_internal(mods);
-    return result;
+    axidev_io_linux_queue_release_modifiers(mods);
+    return axidev_io_linux_finish(result);
   }
-  axidev_io_sender_delay();
-  result = axidev_io_linux_send_raw_key(resolved_key, keycode, false);
-  axidev_io_sender_delay();
-  axidev_io_keyboard_sender_release_modifier_internal(mods);
-  return result;
+  result = axidev_io_sender_delay();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = axidev_io_linux_send_raw_key(resolved_key, keycode, false);
+  }
+  {
+    axidev_io_result delay_result = axidev_io_sender_delay();
+    if (result == AXIDEV_IO_RESULT_OK) {
+      result = delay_result;
+    }
+  }
+  axidev_io_linux_queue_release_modifiers(mods);
+  return axidev_io_linux_finish(result);
 }
 
 axidev_io_result
@@ -315,14 +1242,76 @@ axidev_io_keyboard_sender_type_character_internal(uint32_t codepoint) {
   return axidev_io_keyboard_sender_tap_internal(key_mod);
 }
 
+axidev_io_result
+axidev_io_keyboard_sender_tap_keycode_internal(axidev_io_keyboard_key_t key,
+                                               int32_t keycode) {
+  axidev_io_result result = axidev_io_linux_send_raw_key(key, keycode, true);
+  axidev_io_result step_result;
+
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return axidev_io_linux_finish(result);
+  }
+  result = axidev_io_sender_delay();
+  step_result = axidev_io_linux_send_raw_key(key, keycode, false);
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = step_result;
+  }
+  step_result = axidev_io_sender_delay();
+  if (result == AXIDEV_IO_RESULT_OK) {
+    result = step_result;
+  }
+  return axidev_io_linux_finish(result);
+}
+
+axidev_io_result
+axidev_io_keyboard_sender_type_unicode_internal(uint32_t codepoint) {
+  (void)codepoint;
+  return AXIDEV_IO_RESULT_NOT_SUPPORTED;
+}
+
+axidev_io_result axidev_io_keyboard_sender_delay_internal(void) {
+  return axidev_io_sender_delay();
+}
+
+axidev_io_result
+axidev_io_keyboard_sender_send_keycode_internal(axidev_io_keyboard_key_t key,
+                                                int32_t keycode, bool down) {
+  return axidev_io_linux_finish(
+      axidev_io_linux_send_raw_key(key, keycode, down));
+}
+
+void axidev_io_keyboard_sender_wait_until_internal(uint64_t deadline_ns) {
+  axidev_io_pacer_wait_until(&axidev_io_sender_impl_get()->pacer,
+                             deadline_ns);
+}
+
 void axidev_io_keyboard_sender_flush_internal(void) {
-  if (axidev_io_sender_impl_get()->fd >= 0) {
-    axidev_io_linux_sync(axidev_io_sender_impl_get()->fd);
+  if (axidev_io_linux_has_sink(axidev_io_sender_impl_get()) &&
+      axidev_io_linux_sync() == AXIDEV_IO_RESULT_OK) {
+    axidev_io_linux_flush_pending();
   }
 }
 
+void axidev_io_keyboard_sender_begin_batch_internal(void) {
+  ++axidev_io_sender_impl_get()->batch_depth;
+}
+
+axidev_io_result axidev_io_keyboard_sender_end_batch_internal(void) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+
+  if (impl->batch_depth > 0) {
+    --impl->batch_depth;
+  }
+  return axidev_io_linux_commit();
+}
+
 void axidev_io_keyboard_sender_set_key_delay_internal(uint32_t delay_us) {
   axidev_io_sender_public_context()->key_delay_us = delay_us;
+  axidev_io_sender_impl_get()->pacer.deadline_ns = 0;
+}
+
+void axidev_io_keyboard_sender_set_pacing_spin_internal(uint32_t spin_us) {
+  axidev_io_sender_impl_get()->pacer.spin_us = spin_us;
 }
 
 #endif
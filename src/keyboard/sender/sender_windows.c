@@ -12,20 +12,7 @@
 #include "../common/key_utils_internal.h"
 #include "../common/windows_keymap_internal.h"
 
-typedef struct axidev_io_windows_repeat_entry {
-  axidev_io_keyboard_key_with_modifier_t request;
-  axidev_io_keyboard_key_t resolved_key;
-  int32_t keycode;
-  axidev_io_keyboard_modifier_t mods;
-  uint64_t next_fire_at_ns;
-  uint64_t interval_ns;
-} axidev_io_windows_repeat_entry;
-
-typedef struct axidev_io_windows_repeat_send {
-  axidev_io_keyboard_key_with_modifier_t request;
-  axidev_io_keyboard_key_t resolved_key;
-  int32_t keycode;
-} axidev_io_windows_repeat_send;
+static uint32_t g_sender_options = 0;
 
 axidev_io_keyboard_sender_impl *axidev_io_sender_impl_get(void) {
   return (axidev_io_keyboard_sender_impl *)axidev_io_sender_storage_ptr();
@@ -34,7 +21,7 @@ axidev_io_keyboard_sender_impl *axidev_io_sender_impl_get(void) {
 static void axidev_io_sender_delay(void) {
   uint32_t delay_us = axidev_io_sender_public_context()->key_delay_us;
   if (delay_us != 0) {
-    axidev_io_sleep_us(delay_us);
+    axidev_io_pacer_wait(&axidev_io_sender_impl_get()->pacer, delay_us);
   }
 }
 
@@ -77,27 +64,124 @@ static void axidev_io_sender_update_modifier_state(axidev_io_keyboard_key_t key,
   }
 }
 
-static axidev_io_result axidev_io_windows_send_vk(WORD vk, bool down) {
-  INPUT input;
+static WORD axidev_io_windows_scan_for_vk(WORD vk) {
+  const axidev_io_keymap_layout_set *set = axidev_io_keymap_impl_get()->active;
+  WORD scan = 0;
 
-  memset(&input, 0, sizeof(input));
-  input.type = INPUT_KEYBOARD;
-  input.ki.wVk = vk;
-  input.ki.wScan = (WORD)MapVirtualKeyW(vk, MAPVK_VK_TO_VSC);
-  input.ki.dwFlags = KEYEVENTF_SCANCODE;
+  if (vk < 256u && set != NULL) {
+    scan = (WORD)set->vk_to_scan[vk];
+  }
+  if (scan == 0) {
+    scan = (WORD)MapVirtualKeyW(vk, MAPVK_VK_TO_VSC);
+  }
+  return scan;
+}
+
+static void axidev_io_windows_fill_vk_input(INPUT *input, WORD vk, bool down) {
+  memset(input, 0, sizeof(*input));
+  input->type = INPUT_KEYBOARD;
+  input->ki.wVk = vk;
+  input->ki.wScan = axidev_io_windows_scan_for_vk(vk);
+  input->ki.dwFlags = KEYEVENTF_SCANCODE;
   if (axidev_io_is_windows_extended_key(vk)) {
-    input.ki.dwFlags |= KEYEVENTF_EXTENDEDKEY;
+    input->ki.dwFlags |= KEYEVENTF_EXTENDEDKEY;
   }
   if (!down) {
-    input.ki.dwFlags |= KEYEVENTF_KEYUP;
+    input->ki.dwFlags |= KEYEVENTF_KEYUP;
+  }
+}
+
+/* Records `count` inputs as key transitions; `repeat` marks them as
+   emulated repeats rather than presses. */
+static void axidev_io_windows_capture_inputs(axidev_io_sender_capture *capture,
+                                             const INPUT *inputs, size_t count,
+                                             bool repeat) {
+  axidev_io_captured_transition_t transitions[16];
+  size_t recorded = 0;
+
+  axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_EVENTS_SENT, count);
+  for (size_t i = 0; i < count; ++i) {
+    const KEYBDINPUT *ki = &inputs[i].ki;
+    bool unicode = (ki->dwFlags & KEYEVENTF_UNICODE) != 0;
+
+    transitions[recorded].code = unicode ? (int32_t)ki->wScan
+                                         : (int32_t)ki->wVk;
+    transitions[recorded].value =
+        (ki->dwFlags & KEYEVENTF_KEYUP) != 0 ? 0u : (repeat ? 2u : 1u);
+    transitions[recorded].unicode = unicode;
+    if (++recorded == sizeof(transitions) / sizeof(transitions[0])) {
+      axidev_io_sender_capture_append(capture, transitions, recorded);
+      recorded = 0;
+    }
   }
+  axidev_io_sender_capture_append(capture, transitions, recorded);
+}
 
-  if (SendInput(1, &input, sizeof(input)) == 0) {
+static axidev_io_result
+axidev_io_windows_submit_inputs(axidev_io_keyboard_sender_impl *impl,
+                                INPUT *inputs, size_t count) {
+  UINT sent;
+
+  if (count == 0) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  if (impl->capture != NULL) {
+    axidev_io_windows_capture_inputs(impl->capture, inputs, count, false);
+    return AXIDEV_IO_RESULT_OK;
+  }
+  sent = SendInput((UINT)count, inputs, sizeof(INPUT));
+  axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_WRITES, 1u);
+  axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_EVENTS_SENT, sent);
+  if (sent != (UINT)count) {
+    axidev_io_stats_add(AXIDEV_IO_STAT_SENDER_WRITE_FAILURES, 1u);
     return AXIDEV_IO_RESULT_PLATFORM_ERROR;
   }
   return AXIDEV_IO_RESULT_OK;
 }
 
+/* Inside a batch with no key delay, inputs are collected and submitted by
+   the outermost end_batch in a single SendInput call. Only the thread
+   driving this sender may reach this; the repeat worker submits its inputs
+   directly. */
+static axidev_io_result axidev_io_windows_emit_inputs(const INPUT *inputs,
+                                                      size_t count) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+
+  if (impl->batch_depth > 0 &&
+      axidev_io_sender_public_context()->key_delay_us == 0) {
+    INPUT *pending = (INPUT *)impl->pending_inputs;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+      arrput(pending, inputs[i]);
+    }
+    impl->pending_inputs = pending;
+    return AXIDEV_IO_RESULT_OK;
+  }
+  return axidev_io_windows_submit_inputs(impl, (INPUT *)inputs, count);
+}
+
+static axidev_io_result axidev_io_windows_flush_pending_inputs(void) {
+  axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  INPUT *pending = (INPUT *)impl->pending_inputs;
+  axidev_io_result result;
+
+  if (pending == NULL) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  result = axidev_io_windows_submit_inputs(impl, pending,
+                                           (size_t)arrlen(pending));
+  arrsetlen(pending, 0);
+  return result;
+}
+
+static axidev_io_result axidev_io_windows_send_vk(WORD vk, bool down) {
+  INPUT input;
+
+  axidev_io_windows_fill_vk_input(&input, vk, down);
+  return axidev_io_windows_emit_inputs(&input, 1);
+}
+
 static axidev_io_result axidev_io_windows_send_unicode(uint32_t codepoint) {
   INPUT inputs[4];
   size_t count = 0;
@@ -133,10 +217,7 @@ static axidev_io_result axidev_io_windows_send_unicode(uint32_t codepoint) {
     return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
   }
 
-  if (SendInput((UINT)count, inputs, sizeof(INPUT)) == 0) {
-    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
-  }
-  return AXIDEV_IO_RESULT_OK;
+  return axidev_io_windows_emit_inputs(inputs, count);
 }
 
 static axidev_io_result
@@ -158,71 +239,6 @@ axidev_io_sender_send_raw_key(axidev_io_keyboard_key_t key, int32_t keycode,
   return result;
 }
 
-static axidev_io_windows_repeat_entry *
-axidev_io_windows_repeat_entries(axidev_io_keyboard_sender_impl *impl) {
-  return (axidev_io_windows_repeat_entry *)impl->repeat_entries;
-}
-
-static void
-axidev_io_windows_repeat_remove_at(axidev_io_keyboard_sender_impl *impl,
-                                   size_t index);
-
-static bool
-axidev_io_windows_repeat_try_lock(axidev_io_keyboard_sender_impl *impl) {
-  if (!impl->repeat_lock_initialized) {
-    return false;
-  }
-  return TryEnterCriticalSection(&impl->repeat_lock.native) != 0;
-}
-
-static void axidev_io_windows_repeat_publish_cancel(
-    axidev_io_keyboard_sender_impl *impl,
-    axidev_io_keyboard_key_with_modifier_t request) {
-  atomic_store(&impl->repeat_cancel_mods, (int)request.mods);
-  atomic_store(&impl->repeat_cancel_key, (int)request.key);
-  atomic_store(&impl->repeat_sends_paused, true);
-  if (impl->repeat_wake_event != NULL) {
-    SetEvent((HANDLE)impl->repeat_wake_event);
-  }
-}
-
-static bool axidev_io_windows_repeat_is_cancelled(
-    axidev_io_keyboard_sender_impl *impl,
-    axidev_io_keyboard_key_with_modifier_t request) {
-  int key = atomic_load(&impl->repeat_cancel_key);
-  int mods = atomic_load(&impl->repeat_cancel_mods);
-  return key == (int)request.key && mods == (int)request.mods;
-}
-
-static void axidev_io_windows_repeat_clear_cancel(
-    axidev_io_keyboard_sender_impl *impl,
-    axidev_io_keyboard_key_with_modifier_t request) {
-  if (axidev_io_windows_repeat_is_cancelled(impl, request)) {
-    atomic_store(&impl->repeat_cancel_key, (int)AXIDEV_IO_KEY_UNKNOWN);
-    atomic_store(&impl->repeat_cancel_mods, (int)AXIDEV_IO_MOD_NONE);
-    atomic_store(&impl->repeat_sends_paused, false);
-  }
-}
-
-static void axidev_io_windows_repeat_remove_cancelled_locked(
-    axidev_io_keyboard_sender_impl *impl) {
-  size_t i = 0;
-  while (i < impl->repeat_len) {
-    axidev_io_windows_repeat_entry *entry =
-        &axidev_io_windows_repeat_entries(impl)[i];
-    if (axidev_io_windows_repeat_is_cancelled(impl, entry->request)) {
-      axidev_io_keyboard_key_with_modifier_t request = entry->request;
-      axidev_io_windows_repeat_remove_at(impl, i);
-      axidev_io_windows_repeat_clear_cancel(impl, request);
-      continue;
-    }
-    ++i;
-  }
-  if (impl->repeat_len == 0) {
-    atomic_store(&impl->repeat_active, false);
-  }
-}
-
 static bool axidev_io_windows_key_is_modifier(axidev_io_keyboard_key_t key) {
   switch (key) {
   case AXIDEV_IO_KEY_SHIFT_LEFT:
@@ -239,10 +255,6 @@ static bool axidev_io_windows_key_is_modifier(axidev_io_keyboard_key_t key) {
   }
 }
 
-static uint64_t axidev_io_windows_monotonic_time_ns(void) {
-  return axidev_io_monotonic_time_ms() * 1000000ull;
-}
-
 static axidev_io_result
 axidev_io_windows_read_repeat_settings(uint64_t *out_delay_ns,
                                        uint64_t *out_interval_ns) {
@@ -276,133 +288,9 @@ axidev_io_windows_read_repeat_settings(uint64_t *out_delay_ns,
   return AXIDEV_IO_RESULT_OK;
 }
 
-static size_t axidev_io_windows_repeat_find_request(
-    axidev_io_keyboard_sender_impl *impl,
-    axidev_io_keyboard_key_with_modifier_t request) {
-  axidev_io_windows_repeat_entry *entries =
-      axidev_io_windows_repeat_entries(impl);
-  size_t i;
-
-  for (i = 0; i < impl->repeat_len; ++i) {
-    if (entries[i].request.key == request.key &&
-        entries[i].request.mods == request.mods) {
-      return i;
-    }
-  }
-  return (size_t)-1;
-}
-
-static bool
-axidev_io_windows_repeat_reserve(axidev_io_keyboard_sender_impl *impl,
-                                 size_t needed) {
-  axidev_io_windows_repeat_entry *entries;
-  size_t new_cap;
-
-  if (needed <= impl->repeat_cap) {
-    return true;
-  }
-
-  new_cap = impl->repeat_cap == 0 ? 4u : impl->repeat_cap * 2u;
-  while (new_cap < needed) {
-    new_cap *= 2u;
-  }
-
-  entries = (axidev_io_windows_repeat_entry *)realloc(
-      impl->repeat_entries, new_cap * sizeof(*entries));
-  if (entries == NULL) {
-    return false;
-  }
-
-  impl->repeat_entries = entries;
-  impl->repeat_cap = new_cap;
-  return true;
-}
-
-static void
-axidev_io_windows_repeat_remove_at(axidev_io_keyboard_sender_impl *impl,
-                                   size_t index) {
-  axidev_io_windows_repeat_entry *entries =
-      axidev_io_windows_repeat_entries(impl);
-
-  if (index >= impl->repeat_len) {
-    return;
-  }
-  if (index + 1u < impl->repeat_len) {
-    memmove(&entries[index], &entries[index + 1u],
-            (impl->repeat_len - index - 1u) * sizeof(entries[0]));
-  }
-  --impl->repeat_len;
-}
-
-static uint64_t
-axidev_io_windows_repeat_next_deadline(uint64_t previous_deadline_ns,
-                                       uint64_t interval_ns, uint64_t now_ns) {
-  uint64_t missed_intervals;
-
-  if (interval_ns == 0 || previous_deadline_ns > UINT64_MAX - interval_ns) {
-    return now_ns + 1u;
-  }
-  if (previous_deadline_ns + interval_ns > now_ns) {
-    return previous_deadline_ns + interval_ns;
-  }
-
-  missed_intervals = ((now_ns - previous_deadline_ns) / interval_ns) + 1u;
-  if (missed_intervals > (UINT64_MAX - previous_deadline_ns) / interval_ns) {
-    return now_ns + interval_ns;
-  }
-  return previous_deadline_ns + (missed_intervals * interval_ns);
-}
-
-static DWORD axidev_io_windows_repeat_timeout_ms(uint64_t now_ns,
-                                                 uint64_t deadline_ns) {
-  uint64_t remaining_ns;
-  uint64_t timeout_ms;
-
-  if (deadline_ns <= now_ns) {
-    return 0;
-  }
-  remaining_ns = deadline_ns - now_ns;
-  timeout_ms = (remaining_ns + 999999ull) / 1000000ull;
-  if (timeout_ms > (uint64_t)MAXDWORD) {
-    return MAXDWORD;
-  }
-  return (DWORD)timeout_ms;
-}
-
-static void axidev_io_windows_repeat_drain_entries(
-    axidev_io_keyboard_sender_impl *impl,
-    axidev_io_windows_repeat_entry **out_entries, size_t *out_count) {
-  axidev_io_windows_repeat_entry *entries = NULL;
-  size_t count = 0;
-
-  if (out_entries == NULL || out_count == NULL) {
-    return;
-  }
-
-  if (impl->repeat_lock_initialized) {
-    axidev_io_mutex_lock(&impl->repeat_lock);
-    entries = axidev_io_windows_repeat_entries(impl);
-    count = impl->repeat_len;
-    impl->repeat_entries = NULL;
-    impl->repeat_len = 0;
-    impl->repeat_cap = 0;
-    atomic_store(&impl->repeat_active, false);
-    atomic_store(&impl->repeat_sends_paused, false);
-    atomic_store(&impl->repeat_cancel_key, (int)AXIDEV_IO_KEY_UNKNOWN);
-    atomic_store(&impl->repeat_cancel_mods, (int)AXIDEV_IO_MOD_NONE);
-    axidev_io_mutex_unlock(&impl->repeat_lock);
-  }
-
-  if (impl->repeat_wake_event != NULL) {
-    SetEvent((HANDLE)impl->repeat_wake_event);
-  }
-
-  *out_entries = entries;
-  *out_count = count;
-}
-
-static axidev_io_result axidev_io_windows_release_repeat_entries(
-    axidev_io_windows_repeat_entry *entries, size_t count) {
+static axidev_io_result
+axidev_io_windows_release_repeat_entries(axidev_io_repeat_entry *entries,
+                                         size_t count) {
   axidev_io_result final_result = AXIDEV_IO_RESULT_OK;
   size_t i;
 
@@ -424,161 +312,48 @@ static axidev_io_result axidev_io_windows_release_repeat_entries(
   return final_result;
 }
 
-static int axidev_io_windows_repeat_worker_main(void *user_data) {
+/* Runs on the repeat worker. */
+static bool axidev_io_windows_repeat_fire(int32_t keycode, void *user_data) {
   axidev_io_keyboard_sender_impl *impl =
       (axidev_io_keyboard_sender_impl *)user_data;
-  axidev_io_windows_repeat_send *due = NULL;
-  size_t due_cap = 0;
-
-  for (;;) {
-    axidev_io_windows_repeat_send *new_due;
-    size_t due_count = 0;
-    uint64_t now_ns;
-    uint64_t next_deadline_ns = UINT64_MAX;
-    DWORD timeout_ms;
-    size_t i;
-
-    axidev_io_mutex_lock(&impl->repeat_lock);
-    if (impl->repeat_stop_worker) {
-      axidev_io_mutex_unlock(&impl->repeat_lock);
-      break;
-    }
-
-    axidev_io_windows_repeat_remove_cancelled_locked(impl);
-
-    if (impl->repeat_len == 0) {
-      axidev_io_mutex_unlock(&impl->repeat_lock);
-      WaitForSingleObject((HANDLE)impl->repeat_wake_event, INFINITE);
-      continue;
-    }
-
-    if (impl->repeat_len > due_cap) {
-      size_t needed = impl->repeat_len;
-      axidev_io_mutex_unlock(&impl->repeat_lock);
-
-      new_due =
-          (axidev_io_windows_repeat_send *)realloc(due, needed * sizeof(*due));
-      if (new_due == NULL) {
-        AXIDEV_IO_LOG_ERROR("Windows repeat scheduler allocation failed");
-        axidev_io_sleep_ms(1);
-        continue;
-      }
-      due = new_due;
-      due_cap = needed;
-      continue;
-    }
-
-    now_ns = axidev_io_windows_monotonic_time_ns();
-    for (i = 0; i < impl->repeat_len; ++i) {
-      axidev_io_windows_repeat_entry *entry =
-          &axidev_io_windows_repeat_entries(impl)[i];
-
-      if (entry->next_fire_at_ns <= now_ns) {
-        due[due_count].request = entry->request;
-        due[due_count].resolved_key = entry->resolved_key;
-        due[due_count].keycode = entry->keycode;
-        ++due_count;
-        entry->next_fire_at_ns = axidev_io_windows_repeat_next_deadline(
-            entry->next_fire_at_ns, entry->interval_ns, now_ns);
-      }
-
-      if (entry->next_fire_at_ns < next_deadline_ns) {
-        next_deadline_ns = entry->next_fire_at_ns;
-      }
-    }
-
-    now_ns = axidev_io_windows_monotonic_time_ns();
-    timeout_ms = axidev_io_windows_repeat_timeout_ms(now_ns, next_deadline_ns);
-    axidev_io_mutex_unlock(&impl->repeat_lock);
-
-    for (i = 0; i < due_count; ++i) {
-      if (axidev_io_windows_repeat_is_cancelled(impl, due[i].request)) {
-        continue;
-      }
-      if (!atomic_load(&impl->repeat_sends_paused)) {
-        axidev_io_result result = axidev_io_sender_send_raw_key(
-            due[i].resolved_key, due[i].keycode, true);
-        if (result != AXIDEV_IO_RESULT_OK) {
-          AXIDEV_IO_LOG_ERROR("Windows repeat SendInput failed: %s",
-                              axidev_io_result_to_string(result));
-        }
-      }
-    }
+  INPUT input;
+  axidev_io_result result;
 
-    WaitForSingleObject((HANDLE)impl->repeat_wake_event, timeout_ms);
+  axidev_io_windows_fill_vk_input(&input, (WORD)keycode, true);
+  if (impl->capture != NULL) {
+    axidev_io_windows_capture_inputs(impl->capture, &input, 1, true);
+    return true;
   }
-
-  free(due);
-  return 0;
-}
-
-static axidev_io_result
-axidev_io_windows_repeat_start_state(axidev_io_keyboard_sender_impl *impl) {
-  impl->repeat_wake_event = CreateEventW(NULL, FALSE, FALSE, NULL);
-  if (impl->repeat_wake_event == NULL) {
-    return AXIDEV_IO_RESULT_PLATFORM_ERROR;
+  result = axidev_io_windows_submit_inputs(impl, &input, 1);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    AXIDEV_IO_LOG_ERROR("Windows repeat SendInput failed for VK 0x%02X: %s; "
+                        "stopping its repeat",
+                        (unsigned)keycode, axidev_io_result_to_string(result));
+    return false;
   }
-  atomic_store(&impl->repeat_active, false);
-  atomic_store(&impl->repeat_sends_paused, false);
-  atomic_store(&impl->repeat_cancel_key, (int)AXIDEV_IO_KEY_UNKNOWN);
-  atomic_store(&impl->repeat_cancel_mods, (int)AXIDEV_IO_MOD_NONE);
-  if (!axidev_io_mutex_init(&impl->repeat_lock)) {
-    CloseHandle((HANDLE)impl->repeat_wake_event);
-    impl->repeat_wake_event = NULL;
-    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
-  }
-  impl->repeat_lock_initialized = true;
-  impl->repeat_stop_worker = false;
-  if (!axidev_io_thread_create(&impl->repeat_worker,
-                               axidev_io_windows_repeat_worker_main, impl)) {
-    axidev_io_mutex_destroy(&impl->repeat_lock);
-    impl->repeat_lock_initialized = false;
-    CloseHandle((HANDLE)impl->repeat_wake_event);
-    impl->repeat_wake_event = NULL;
-    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
-  }
-  impl->repeat_worker_running = true;
-  return AXIDEV_IO_RESULT_OK;
+  return true;
 }
 
 static void
 axidev_io_windows_repeat_stop_state(axidev_io_keyboard_sender_impl *impl) {
-  axidev_io_windows_repeat_entry *entries = NULL;
+  axidev_io_repeat_entry *entries = NULL;
   size_t count = 0;
 
-  if (impl->repeat_lock_initialized) {
-    axidev_io_mutex_lock(&impl->repeat_lock);
-    impl->repeat_stop_worker = true;
-    entries = axidev_io_windows_repeat_entries(impl);
-    count = impl->repeat_len;
-    impl->repeat_entries = NULL;
-    impl->repeat_len = 0;
-    impl->repeat_cap = 0;
-    atomic_store(&impl->repeat_active, false);
-    atomic_store(&impl->repeat_sends_paused, false);
-    atomic_store(&impl->repeat_cancel_key, (int)AXIDEV_IO_KEY_UNKNOWN);
-    atomic_store(&impl->repeat_cancel_mods, (int)AXIDEV_IO_MOD_NONE);
-    axidev_io_mutex_unlock(&impl->repeat_lock);
-  }
-
-  if (impl->repeat_wake_event != NULL) {
-    SetEvent((HANDLE)impl->repeat_wake_event);
-  }
-  if (impl->repeat_worker_running) {
-    axidev_io_thread_join(&impl->repeat_worker);
-    impl->repeat_worker_running = false;
-  }
-
+  axidev_io_repeat_engine_drain(&impl->repeat, &entries, &count);
+  axidev_io_repeat_engine_stop(&impl->repeat);
   axidev_io_windows_release_repeat_entries(entries, count);
+}
 
-  if (impl->repeat_lock_initialized) {
-    axidev_io_mutex_destroy(&impl->repeat_lock);
-    impl->repeat_lock_initialized = false;
-  }
-  if (impl->repeat_wake_event != NULL) {
-    CloseHandle((HANDLE)impl->repeat_wake_event);
-    impl->repeat_wake_event = NULL;
+/* The global sender's capture buffer, or NULL when it is not capturing. */
+static axidev_io_sender_capture *axidev_io_windows_shared_capture(void) {
+  const axidev_io_keyboard_sender_context *shared =
+      &axidev_io_global->keyboard.sender;
+
+  if (!shared->initialized) {
+    return NULL;
   }
+  return ((const axidev_io_keyboard_sender_impl *)shared->storage.bytes)
+      ->capture;
 }
 
 axidev_io_result axidev_io_keyboard_sender_initialize(void) {
@@ -586,8 +361,11 @@ axidev_io_result axidev_io_keyboard_sender_initialize(void) {
   axidev_io_keyboard_sender_context *sender;
   axidev_io_result result;
 
-  memset(impl, 0, sizeof(*impl));
+  /* Resetting the public state also wipes the impl storage, so it goes
+     first; otherwise the pacer timer would be lost. */
   axidev_io_keyboard_reset_public_sender_state();
+  memset(impl, 0, sizeof(*impl));
+  axidev_io_pacer_init(&impl->pacer);
   sender = axidev_io_sender_public_context();
 
   impl->layout = GetKeyboardLayout(0);
@@ -597,9 +375,19 @@ axidev_io_result axidev_io_keyboard_sender_initialize(void) {
     return result;
   }
 
-  result = axidev_io_windows_repeat_start_state(impl);
+  if ((g_sender_options & AXIDEV_IO_SENDER_OPTION_CAPTURE) != 0) {
+    result = axidev_io_sender_capture_attach(
+        &impl->capture, &impl->own_capture,
+        axidev_io_sender_is_default() ? NULL
+                                      : axidev_io_windows_shared_capture());
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
+    }
+  }
+
+  result = axidev_io_repeat_engine_start(&impl->repeat,
+                                         axidev_io_windows_repeat_fire, impl);
   if (result != AXIDEV_IO_RESULT_OK) {
-    axidev_io_windows_repeat_stop_state(impl);
     return result;
   }
 
@@ -612,14 +400,29 @@ axidev_io_result axidev_io_keyboard_sender_initialize(void) {
   sender->capabilities.needs_accessibility_perm = false;
   sender->capabilities.needs_input_monitoring_perm = false;
   sender->capabilities.needs_uinput_access = false;
-  axidev_io_global->keyboard.backend_type = AXIDEV_IO_BACKEND_WINDOWS;
+  axidev_io_global->keyboard.backend_type = impl->capture != NULL
+                                               ? AXIDEV_IO_BACKEND_CAPTURE
+                                               : AXIDEV_IO_BACKEND_WINDOWS;
   return AXIDEV_IO_RESULT_OK;
 }
 
+axidev_io_result axidev_io_keyboard_sender_initialize_handle(
+    uint32_t flags, const axidev_io_virtual_device_t *device) {
+  /* SendInput has no device to share or name; a handle only needs its own
+     batch, pacer and repeat state. */
+  (void)flags;
+  (void)device;
+  return axidev_io_keyboard_sender_initialize();
+}
+
 void axidev_io_keyboard_sender_free(void) {
   axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
+  INPUT *pending = (INPUT *)impl->pending_inputs;
 
   axidev_io_windows_repeat_stop_state(impl);
+  arrfree(pending);
+  axidev_io_sender_capture_detach(impl->capture, &impl->own_capture);
+  axidev_io_pacer_destroy(&impl->pacer);
   memset(impl, 0, sizeof(*impl));
   axidev_io_keyboard_reset_public_sender_state();
 }
@@ -695,12 +498,12 @@ axidev_io_result axidev_io_keyboard_sender_release_modifier_internal(
 axidev_io_result
 axidev_io_keyboard_sender_release_all_modifiers_internal(void) {
   axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
-  axidev_io_windows_repeat_entry *entries = NULL;
+  axidev_io_repeat_entry *entries = NULL;
   axidev_io_result repeat_result;
   axidev_io_result modifier_result;
   size_t count = 0;
 
-  axidev_io_windows_repeat_drain_entries(impl, &entries, &count);
+  axidev_io_repeat_engine_drain(&impl->repeat, &entries, &count);
   repeat_result = axidev_io_windows_release_repeat_entries(entries, count);
   modifier_result = axidev_io_keyboard_sender_release_modifier_internal(
       AXIDEV_IO_MOD_SHIFT | AXIDEV_IO_MOD_CTRL | AXIDEV_IO_MOD_ALT |
@@ -732,42 +535,32 @@ axidev_io_result axidev_io_keyboard_sender_key_down_internal(
     return axidev_io_sender_send_raw_key(resolved_key, keycode, true);
   }
 
-  axidev_io_mutex_lock(&impl->repeat_lock);
-  if (axidev_io_windows_repeat_find_request(impl, key_mod) != (size_t)-1) {
-    axidev_io_mutex_unlock(&impl->repeat_lock);
+  if (axidev_io_repeat_engine_contains(&impl->repeat, key_mod)) {
     return AXIDEV_IO_RESULT_OK;
   }
 
   result = axidev_io_keyboard_sender_hold_modifier_internal(mods);
   if (result != AXIDEV_IO_RESULT_OK) {
-    axidev_io_mutex_unlock(&impl->repeat_lock);
     return result;
   }
 
   result = axidev_io_sender_send_raw_key(resolved_key, keycode, true);
-  if (result == AXIDEV_IO_RESULT_OK &&
-      !axidev_io_windows_repeat_reserve(impl, impl->repeat_len + 1u)) {
-    result = AXIDEV_IO_RESULT_INTERNAL_ERROR;
-  }
   if (result == AXIDEV_IO_RESULT_OK) {
-    axidev_io_windows_repeat_entry *entries =
-        axidev_io_windows_repeat_entries(impl);
-    axidev_io_windows_repeat_entry *entry = &entries[impl->repeat_len++];
-
-    entry->request = key_mod;
-    entry->resolved_key = resolved_key;
-    entry->keycode = keycode;
-    entry->mods = mods;
-    entry->next_fire_at_ns =
-        axidev_io_windows_monotonic_time_ns() + sender->repeat_delay_ns;
-    entry->interval_ns = sender->repeat_interval_ns;
-    atomic_store(&impl->repeat_active, true);
-    SetEvent((HANDLE)impl->repeat_wake_event);
-  } else {
+    axidev_io_repeat_entry entry;
+
+    entry.request = key_mod;
+    entry.resolved_key = resolved_key;
+    entry.keycode = keycode;
+    entry.mods = mods;
+    entry.next_fire_at_ns =
+        axidev_io_monotonic_time_ns() + sender->repeat_delay_ns;
+    entry.interval_ns = sender->repeat_interval_ns;
+    result = axidev_io_repeat_engine_add(&impl->repeat, &entry);
+  }
+  if (result != AXIDEV_IO_RESULT_OK) {
     axidev_io_sender_send_raw_key(resolved_key, keycode, false);
     axidev_io_keyboard_sender_release_modifier_internal(mods);
   }
-  axidev_io_mutex_unlock(&impl->repeat_lock);
   return result;
 }
 
@@ -778,11 +571,9 @@ axidev_io_result axidev_io_keyboard_sender_key_up_internal(
   axidev_io_keyboard_modifier_t mods;
   axidev_io_keyboard_key_t resolved_key;
   axidev_io_result result;
-  size_t repeat_index;
 
-  if (atomic_load(&impl->repeat_active)) {
-    axidev_io_windows_repeat_publish_cancel(impl, key_mod);
-  }
+  /* Cancelling first guarantees no repeat lands after the key up. */
+  axidev_io_repeat_engine_cancel(&impl->repeat, key_mod);
 
   result =
       axidev_io_sender_resolve_mapping(key_mod, &keycode, &mods, &resolved_key);
@@ -794,30 +585,7 @@ axidev_io_result axidev_io_keyboard_sender_key_up_internal(
   if (result != AXIDEV_IO_RESULT_OK) {
     return result;
   }
-  result = axidev_io_keyboard_sender_release_modifier_internal(mods);
-
-  if (atomic_load(&impl->repeat_active) &&
-      axidev_io_windows_repeat_try_lock(impl)) {
-    repeat_index = axidev_io_windows_repeat_find_request(impl, key_mod);
-    if (repeat_index != (size_t)-1) {
-      axidev_io_windows_repeat_remove_at(impl, repeat_index);
-      if (impl->repeat_len == 0) {
-        atomic_store(&impl->repeat_active, false);
-      }
-      axidev_io_windows_repeat_clear_cancel(impl, key_mod);
-      SetEvent((HANDLE)impl->repeat_wake_event);
-      axidev_io_mutex_unlock(&impl->repeat_lock);
-      return result;
-    }
-    if (impl->repeat_len == 0) {
-      atomic_store(&impl->repeat_active, false);
-    }
-    if (impl->repeat_len == 0) {
-      axidev_io_windows_repeat_clear_cancel(impl, key_mod);
-    }
-    axidev_io_mutex_unlock(&impl->repeat_lock);
-  }
-  return result;
+  return axidev_io_keyboard_sender_release_modifier_internal(mods);
 }
 
 axidev_io_result axidev_io_keyboard_sender_tap_internal(
@@ -837,7 +605,10 @@ axidev_io_result axidev_io_keyboard_sender_tap_internal(
   if (result != AXIDEV_IO_RESULT_OK) {
     return result;
   }
-  axidev_io_sender_delay();
+  /* Only a modifier press needs to settle before the key goes down. */
+  if (mods != AXIDEV_IO_MOD_NONE) {
+    axidev_io_sender_delay();
+  }
   result = axidev_io_sender_send_raw_key(resolved_key, keycode, true);
   if (result != AXIDEV_IO_RESULT_OK) {
     axidev_io_keyboard_sender_release_modifier_internal(mods);
@@ -865,24 +636,93 @@ axidev_io_keyboard_sender_type_character_internal(uint32_t codepoint) {
   return axidev_io_windows_send_unicode(codepoint);
 }
 
+axidev_io_result
+axidev_io_keyboard_sender_tap_keycode_internal(axidev_io_keyboard_key_t key,
+                                               int32_t keycode) {
+  axidev_io_result result = axidev_io_sender_send_raw_key(key, keycode, true);
+
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+  axidev_io_sender_delay();
+  result = axidev_io_sender_send_raw_key(key, keycode, false);
+  axidev_io_sender_delay();
+  return result;
+}
+
+axidev_io_result
+axidev_io_keyboard_sender_type_unicode_internal(uint32_t codepoint) {
+  return axidev_io_windows_send_unicode(codepoint);
+}
+
+axidev_io_result axidev_io_keyboard_sender_delay_internal(void) {
+  axidev_io_sender_delay();
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_keyboard_sender_send_keycode_internal(axidev_io_keyboard_key_t key,
+                                                int32_t keycode, bool down) {
+  return axidev_io_sender_send_raw_key(key, keycode, down);
+}
+
+void axidev_io_keyboard_sender_wait_until_internal(uint64_t deadline_ns) {
+  axidev_io_pacer_wait_until(&axidev_io_sender_impl_get()->pacer,
+                             deadline_ns);
+}
+
 void axidev_io_keyboard_sender_flush_internal(void) {}
 
-void axidev_io_keyboard_sender_set_key_delay_internal(uint32_t delay_us) {
-  axidev_io_sender_public_context()->key_delay_us = delay_us;
+void axidev_io_keyboard_sender_begin_batch_internal(void) {
+  ++axidev_io_sender_impl_get()->batch_depth;
 }
 
-size_t axidev_io_windows_sender_repeat_count_for_tests(void) {
+axidev_io_result axidev_io_keyboard_sender_end_batch_internal(void) {
   axidev_io_keyboard_sender_impl *impl = axidev_io_sender_impl_get();
-  size_t count;
 
-  if (!impl->repeat_lock_initialized) {
-    return 0;
+  if (impl->batch_depth > 0) {
+    --impl->batch_depth;
   }
+  if (impl->batch_depth != 0) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+  return axidev_io_windows_flush_pending_inputs();
+}
+
+void axidev_io_keyboard_sender_set_key_delay_internal(uint32_t delay_us) {
+  axidev_io_sender_public_context()->key_delay_us = delay_us;
+  axidev_io_sender_impl_get()->pacer.deadline_ns = 0;
+}
 
-  axidev_io_mutex_lock(&impl->repeat_lock);
-  count = impl->repeat_len;
-  axidev_io_mutex_unlock(&impl->repeat_lock);
-  return count;
+void axidev_io_keyboard_sender_set_pacing_spin_internal(uint32_t spin_us) {
+  axidev_io_sender_impl_get()->pacer.spin_us = spin_us;
+}
+
+/* SendInput has no device to update; scan codes come from the keymap. */
+axidev_io_result axidev_io_keyboard_sender_keymap_changed_internal(void) {
+  return AXIDEV_IO_RESULT_OK;
+}
+
+/* SendInput has no device to set up; the options are only remembered. */
+void axidev_io_keyboard_sender_set_options_internal(uint32_t options) {
+  g_sender_options = options;
+}
+
+uint32_t axidev_io_keyboard_sender_get_options_internal(void) {
+  return g_sender_options;
+}
+
+size_t axidev_io_keyboard_sender_capture_read_internal(
+    axidev_io_captured_transition_t *out, size_t max_count) {
+  axidev_io_sender_capture *capture = axidev_io_windows_shared_capture();
+
+  return capture != NULL
+             ? axidev_io_sender_capture_read(capture, out, max_count)
+             : 0;
+}
+
+size_t axidev_io_windows_sender_repeat_count_for_tests(void) {
+  return axidev_io_repeat_engine_count(&axidev_io_sender_impl_get()->repeat);
 }
 
 #endif
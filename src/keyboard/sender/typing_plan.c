@@ -0,0 +1,403 @@
+#include "typing_plan_internal.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stb/stb_ds.h>
+
+#include "../../internal/utf.h"
+#include "../common/keymap_internal.h"
+#include "sender_internal.h"
+
+static bool
+axidev_io_try_consume_modifier_prefix(const char **cursor,
+                                      axidev_io_keyboard_modifier_t *mods) {
+  static const struct {
+    const char *prefix;
+    axidev_io_keyboard_modifier_t flag;
+  } prefixes[] = {
+      {"super+", AXIDEV_IO_MOD_SUPER},  {"super-", AXIDEV_IO_MOD_SUPER},
+      {"cmd+", AXIDEV_IO_MOD_SUPER},    {"cmd-", AXIDEV_IO_MOD_SUPER},
+      {"win+", AXIDEV_IO_MOD_SUPER},    {"win-", AXIDEV_IO_MOD_SUPER},
+      {"meta+", AXIDEV_IO_MOD_SUPER},   {"meta-", AXIDEV_IO_MOD_SUPER},
+      {"ctrl+", AXIDEV_IO_MOD_CTRL},    {"ctrl-", AXIDEV_IO_MOD_CTRL},
+      {"control+", AXIDEV_IO_MOD_CTRL}, {"control-", AXIDEV_IO_MOD_CTRL},
+      {"alt+", AXIDEV_IO_MOD_ALT},      {"alt-", AXIDEV_IO_MOD_ALT},
+      {"opt+", AXIDEV_IO_MOD_ALT},      {"opt-", AXIDEV_IO_MOD_ALT},
+      {"option+", AXIDEV_IO_MOD_ALT},   {"option-", AXIDEV_IO_MOD_ALT},
+      {"shift+", AXIDEV_IO_MOD_SHIFT},  {"shift-", AXIDEV_IO_MOD_SHIFT}};
+  size_t i;
+
+  if (cursor == NULL || *cursor == NULL || mods == NULL) {
+    return false;
+  }
+
+  for (i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
+    size_t length = strlen(prefixes[i].prefix);
+    size_t j;
+    bool matched = true;
+    for (j = 0; j < length; ++j) {
+      char actual = (*cursor)[j];
+      if (actual == '\0') {
+        matched = false;
+        break;
+      }
+      if ((char)tolower((unsigned char)actual) != prefixes[i].prefix[j]) {
+        matched = false;
+        break;
+      }
+    }
+    if (matched) {
+      *mods = (axidev_io_keyboard_modifier_t)(*mods | prefixes[i].flag);
+      *cursor += length;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void axidev_io_typing_plan_push(axidev_io_typing_step **steps,
+                                       axidev_io_typing_step_kind kind,
+                                       axidev_io_keyboard_modifier_t mods,
+                                       axidev_io_keyboard_key_t key,
+                                       uint32_t value) {
+  axidev_io_typing_step step;
+
+  step.kind = (uint8_t)kind;
+  step.mods = mods;
+  step.key = (uint16_t)key;
+  step.value = value;
+  arrput(*steps, step);
+}
+
+/* Moves the planned modifier state from `*held` to `wanted`, releasing
+   before pressing so a key never sees the union of both sets. */
+static void
+axidev_io_typing_plan_set_mods(axidev_io_typing_step **steps,
+                               axidev_io_keyboard_modifier_t *held,
+                               axidev_io_keyboard_modifier_t wanted) {
+  axidev_io_keyboard_modifier_t release =
+      (axidev_io_keyboard_modifier_t)(*held & ~wanted);
+  axidev_io_keyboard_modifier_t press =
+      (axidev_io_keyboard_modifier_t)(wanted & ~*held);
+
+  if (release != AXIDEV_IO_MOD_NONE) {
+    axidev_io_typing_plan_push(steps, AXIDEV_IO_TYPING_STEP_RELEASE_MODS,
+                               release, AXIDEV_IO_KEY_UNKNOWN, 0);
+  }
+  if (press != AXIDEV_IO_MOD_NONE) {
+    axidev_io_typing_plan_push(steps, AXIDEV_IO_TYPING_STEP_HOLD_MODS, press,
+                               AXIDEV_IO_KEY_UNKNOWN, 0);
+  }
+  *held = wanted;
+}
+
+static axidev_io_result axidev_io_typing_plan_add_character(
+    axidev_io_typing_step **steps, axidev_io_keyboard_modifier_t *held,
+    uint32_t codepoint, axidev_io_keyboard_modifier_t latched_mods) {
+  axidev_io_keyboard_key_with_modifier_t key_mod;
+  axidev_io_keyboard_modifier_t mods;
+  axidev_io_keyboard_key_t resolved_key;
+  int32_t keycode;
+  axidev_io_result result;
+
+  result = axidev_io_keymap_lookup_character(codepoint, &key_mod);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    if (latched_mods != AXIDEV_IO_MOD_NONE) {
+      return result;
+    }
+    axidev_io_typing_plan_set_mods(steps, held, AXIDEV_IO_MOD_NONE);
+    axidev_io_typing_plan_push(steps, AXIDEV_IO_TYPING_STEP_UNICODE,
+                               AXIDEV_IO_MOD_NONE, AXIDEV_IO_KEY_UNKNOWN,
+                               codepoint);
+    return AXIDEV_IO_RESULT_OK;
+  }
+
+  key_mod.mods = (axidev_io_keyboard_modifier_t)(key_mod.mods | latched_mods);
+  result = axidev_io_keymap_resolve_key_request(key_mod, &keycode, &mods,
+                                                &resolved_key);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+
+  axidev_io_typing_plan_set_mods(steps, held, mods);
+  axidev_io_typing_plan_push(steps, AXIDEV_IO_TYPING_STEP_TAP,
+                             AXIDEV_IO_MOD_NONE, resolved_key,
+                             (uint32_t)keycode);
+  return AXIDEV_IO_RESULT_OK;
+}
+
+/* Plans a run of plain ASCII from the keymap's precomputed taps, handing
+   characters the table cannot type to the general path. */
+static axidev_io_result axidev_io_typing_plan_add_ascii_run(
+    axidev_io_typing_step **steps, axidev_io_keyboard_modifier_t *held,
+    const axidev_io_keymap_ascii_tap *taps, const char *run, size_t length) {
+  size_t i;
+
+  for (i = 0; i < length; ++i) {
+    const axidev_io_keymap_ascii_tap *tap = &taps[(unsigned char)run[i]];
+    axidev_io_result result;
+
+    if (tap->present) {
+      axidev_io_typing_plan_set_mods(steps, held, tap->mods);
+      axidev_io_typing_plan_push(steps, AXIDEV_IO_TYPING_STEP_TAP,
+                                 AXIDEV_IO_MOD_NONE,
+                                 (axidev_io_keyboard_key_t)tap->key,
+                                 (uint32_t)tap->keycode);
+      continue;
+    }
+    result = axidev_io_typing_plan_add_character(
+        steps, held, (unsigned char)run[i], AXIDEV_IO_MOD_NONE);
+    if (result != AXIDEV_IO_RESULT_OK) {
+      return result;
+    }
+  }
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_typing_plan_build(const char *text,
+                            axidev_io_typing_step **out_steps) {
+  axidev_io_typing_step *steps = NULL;
+  axidev_io_keyboard_modifier_t held = AXIDEV_IO_MOD_NONE;
+  const axidev_io_keymap_ascii_tap *taps = axidev_io_keymap_ascii_taps();
+  const char *cursor = text;
+  const char *end = text != NULL ? text + strlen(text) : NULL;
+
+  if (out_steps == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  *out_steps = NULL;
+  if (text != NULL && text[0] != '\0') {
+    /* Most text is one tap per byte; reserve that up front. */
+    arrsetcap(steps, (size_t)(end - text) + 2u);
+  }
+
+  while (cursor != NULL && *cursor != '\0') {
+    axidev_io_keyboard_modifier_t latched_mods = AXIDEV_IO_MOD_NONE;
+
+    while (axidev_io_try_consume_modifier_prefix(&cursor, &latched_mods)) {
+    }
+
+    while (*cursor != '\0' && *cursor != ',') {
+      const char *previous = cursor;
+      uint32_t codepoint = 0;
+      axidev_io_result result;
+
+      if (taps != NULL && latched_mods == AXIDEV_IO_MOD_NONE) {
+        size_t run =
+            axidev_io_utf8_ascii_run(cursor, (size_t)(end - cursor), ',');
+
+        if (run > 0u) {
+          result = axidev_io_typing_plan_add_ascii_run(&steps, &held, taps,
+                                                       cursor, run);
+          if (result != AXIDEV_IO_RESULT_OK) {
+            arrfree(steps);
+            return result;
+          }
+          cursor += run;
+          continue;
+        }
+      }
+
+      axidev_io_utf8_decode_one(&cursor, &codepoint);
+      if (cursor == previous) {
+        arrfree(steps);
+        return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+      }
+
+      result = axidev_io_typing_plan_add_character(&steps, &held, codepoint,
+                                                   latched_mods);
+      if (result != AXIDEV_IO_RESULT_OK) {
+        arrfree(steps);
+        return result;
+      }
+    }
+
+    if (*cursor == ',') {
+      ++cursor;
+    }
+  }
+
+  axidev_io_typing_plan_set_mods(&steps, &held, AXIDEV_IO_MOD_NONE);
+  *out_steps = steps;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+/* Spreads the per-character budget of `chars_per_second` over the delayed
+   transitions of the plan: two per tap, one per modifier change and none
+   for a Unicode step, which the backend sends as one submission. Shifted
+   text therefore keeps the requested rate. */
+static uint32_t axidev_io_typing_plan_rate_delay_us(
+    const axidev_io_typing_step *steps, size_t count,
+    uint32_t chars_per_second, uint32_t fallback_us) {
+  uint64_t characters = 0;
+  uint64_t transitions = 0;
+  uint64_t delay_us;
+  size_t i;
+
+  for (i = 0; i < count; ++i) {
+    switch (steps[i].kind) {
+    case AXIDEV_IO_TYPING_STEP_TAP:
+      ++characters;
+      transitions += 2u;
+      break;
+    case AXIDEV_IO_TYPING_STEP_UNICODE:
+      ++characters;
+      break;
+    default:
+      ++transitions;
+      break;
+    }
+  }
+  if (transitions == 0) {
+    return fallback_us;
+  }
+  delay_us = (characters * 1000000u + transitions * chars_per_second / 2u) /
+             (transitions * chars_per_second);
+  return delay_us == 0 ? 1u : (uint32_t)delay_us;
+}
+
+axidev_io_result axidev_io_typing_plan_play(const axidev_io_typing_step *steps,
+                                            size_t count,
+                                            const atomic_bool *cancel) {
+  axidev_io_keyboard_sender_context *sender = axidev_io_sender_public_context();
+  axidev_io_keyboard_modifier_t owned = AXIDEV_IO_MOD_NONE;
+  axidev_io_result result = AXIDEV_IO_RESULT_OK;
+  axidev_io_result batch_result;
+  uint32_t key_delay_us = sender->key_delay_us;
+  size_t i;
+
+  if (sender->typing_rate_cps != 0) {
+    sender->key_delay_us = axidev_io_typing_plan_rate_delay_us(
+        steps, count, sender->typing_rate_cps, key_delay_us);
+  }
+
+  /* Lets the backend submit the whole run at once when no key delay is
+     configured. */
+  axidev_io_keyboard_sender_begin_batch_internal();
+  for (i = 0; i < count && result == AXIDEV_IO_RESULT_OK; ++i) {
+    const axidev_io_typing_step *step = &steps[i];
+    axidev_io_keyboard_modifier_t mods;
+
+    if (cancel != NULL && atomic_load(cancel)) {
+      result = AXIDEV_IO_RESULT_CANCELLED;
+      break;
+    }
+
+    switch (step->kind) {
+    case AXIDEV_IO_TYPING_STEP_HOLD_MODS:
+      mods = (axidev_io_keyboard_modifier_t)(step->mods &
+                                             ~sender->active_modifiers);
+      if (mods != AXIDEV_IO_MOD_NONE) {
+        owned = (axidev_io_keyboard_modifier_t)(owned | mods);
+        result = axidev_io_keyboard_sender_hold_modifier_internal(mods);
+        if (result == AXIDEV_IO_RESULT_OK) {
+          result = axidev_io_keyboard_sender_delay_internal();
+        }
+      }
+      break;
+    case AXIDEV_IO_TYPING_STEP_RELEASE_MODS:
+      mods = (axidev_io_keyboard_modifier_t)(step->mods & owned);
+      if (mods != AXIDEV_IO_MOD_NONE) {
+        owned = (axidev_io_keyboard_modifier_t)(owned & ~mods);
+        result = axidev_io_keyboard_sender_release_modifier_internal(mods);
+        if (result == AXIDEV_IO_RESULT_OK) {
+          result = axidev_io_keyboard_sender_delay_internal();
+        }
+      }
+      break;
+    case AXIDEV_IO_TYPING_STEP_TAP:
+      result = axidev_io_keyboard_sender_tap_keycode_internal(
+          (axidev_io_keyboard_key_t)step->key, (int32_t)step->value);
+      break;
+    case AXIDEV_IO_TYPING_STEP_UNICODE:
+      result = axidev_io_keyboard_sender_type_unicode_internal(step->value);
+      break;
+    default:
+      result = AXIDEV_IO_RESULT_INTERNAL_ERROR;
+      break;
+    }
+  }
+
+  if (owned != AXIDEV_IO_MOD_NONE) {
+    axidev_io_keyboard_sender_release_modifier_internal(owned);
+  }
+  batch_result = axidev_io_keyboard_sender_end_batch_internal();
+  sender->key_delay_us = key_delay_us;
+  return result != AXIDEV_IO_RESULT_OK ? result : batch_result;
+}
+
+void axidev_io_typing_plan_free(axidev_io_typing_step **steps) {
+  if (steps == NULL) {
+    return;
+  }
+  arrfree(*steps);
+}
+
+axidev_io_result
+axidev_io_keyboard_plan_compile_internal(const char *text,
+                                         axidev_io_keyboard_plan_t **out_plan) {
+  axidev_io_keyboard_plan_t *plan;
+  axidev_io_result result;
+
+  if (text == NULL || out_plan == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  *out_plan = NULL;
+
+  plan = (axidev_io_keyboard_plan_t *)calloc(1, sizeof(*plan));
+  if (plan == NULL) {
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+  plan->text = axidev_io_duplicate_string(text);
+  if (plan->text == NULL) {
+    free(plan);
+    return AXIDEV_IO_RESULT_INTERNAL_ERROR;
+  }
+
+  result = axidev_io_typing_plan_build(plan->text, &plan->steps);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    axidev_io_keyboard_plan_free_internal(plan);
+    return result;
+  }
+  plan->keymap_generation = axidev_io_keymap_generation();
+  *out_plan = plan;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+axidev_io_result
+axidev_io_keyboard_plan_refresh_internal(axidev_io_keyboard_plan_t *plan) {
+  axidev_io_typing_step *steps = NULL;
+  uint64_t generation = axidev_io_keymap_generation();
+  axidev_io_result result;
+
+  if (plan == NULL) {
+    return AXIDEV_IO_RESULT_INVALID_ARGUMENT;
+  }
+  if (plan->keymap_generation == generation) {
+    return AXIDEV_IO_RESULT_OK;
+  }
+
+  result = axidev_io_typing_plan_build(plan->text, &steps);
+  if (result != AXIDEV_IO_RESULT_OK) {
+    return result;
+  }
+  AXIDEV_IO_LOG_DEBUG("typing plan recompiled for keymap generation %llu",
+                      (unsigned long long)generation);
+  axidev_io_typing_plan_free(&plan->steps);
+  plan->steps = steps;
+  plan->keymap_generation = generation;
+  return AXIDEV_IO_RESULT_OK;
+}
+
+void axidev_io_keyboard_plan_free_internal(axidev_io_keyboard_plan_t *plan) {
+  if (plan == NULL) {
+    return;
+  }
+  axidev_io_typing_plan_free(&plan->steps);
+  free(plan->text);
+  free(plan);
+}
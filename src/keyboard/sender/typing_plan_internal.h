@@ -0,0 +1,61 @@
+#pragma once
+#ifndef AXIDEV_IO_KEYBOARD_TYPING_PLAN_INTERNAL_H
+#define AXIDEV_IO_KEYBOARD_TYPING_PLAN_INTERNAL_H
+
+#include "../../internal/context.h"
+
+#include <stdatomic.h>
+
+typedef enum axidev_io_typing_step_kind {
+  AXIDEV_IO_TYPING_STEP_HOLD_MODS = 0,
+  AXIDEV_IO_TYPING_STEP_RELEASE_MODS = 1,
+  AXIDEV_IO_TYPING_STEP_TAP = 2,
+  AXIDEV_IO_TYPING_STEP_UNICODE = 3
+} axidev_io_typing_step_kind;
+
+/* One transition of a planned text run, packed into 8 bytes. Modifier steps
+   carry `mods`, taps carry the resolved key and the platform keycode in
+   `value`, and Unicode steps carry a codepoint the layout cannot produce in
+   `value`. */
+typedef struct axidev_io_typing_step {
+  uint8_t kind;
+  axidev_io_keyboard_modifier_t mods;
+  uint16_t key;
+  uint32_t value;
+} axidev_io_typing_step;
+
+/* Backing object for the public axidev_io_keyboard_plan_t. Keeps the source
+   text so the steps can be rebuilt when the keymap they were resolved
+   against is replaced. */
+struct axidev_io_keyboard_plan {
+  char *text;
+  uint64_t keymap_generation;
+  axidev_io_typing_step *steps;
+};
+
+/* Resolves `text` against the active keymap into an stb_ds array of steps in
+   which modifiers stay held across characters that need the same set. The
+   caller frees `*out_steps` with axidev_io_typing_plan_free. */
+axidev_io_result
+axidev_io_typing_plan_build(const char *text,
+                            axidev_io_typing_step **out_steps);
+/* Emits a plan through the active sender backend inside one sender batch.
+   Modifiers the caller already holds are neither pressed again nor released.
+   When `cancel` is non-NULL it is polled before every step; a set flag stops
+   playback with AXIDEV_IO_RESULT_CANCELLED after releasing planned
+   modifiers. */
+axidev_io_result axidev_io_typing_plan_play(const axidev_io_typing_step *steps,
+                                            size_t count,
+                                            const atomic_bool *cancel);
+void axidev_io_typing_plan_free(axidev_io_typing_step **steps);
+
+axidev_io_result
+axidev_io_keyboard_plan_compile_internal(const char *text,
+                                         axidev_io_keyboard_plan_t **out_plan);
+/* Rebuilds the plan's steps if the keymap generation changed since it was
+   compiled. On failure the previous steps are kept. */
+axidev_io_result
+axidev_io_keyboard_plan_refresh_internal(axidev_io_keyboard_plan_t *plan);
+void axidev_io_keyboard_plan_free_internal(axidev_io_keyboard_plan_t *plan);
+
+#endif
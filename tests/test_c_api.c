@@ -1,9 +1,28 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
 #include <axidev-io/c_api.h>
 
 #include "test_assert.h"
 
-#if defined(_WIN32)
+#include "keyboard/common/keymap_internal.h"
+#include "keyboard/common/keymap_snapshot_internal.h"
+#include "keyboard/listener/listener_internal.h"
+#include "keyboard/macro/macro_internal.h"
 #include "keyboard/sender/sender_internal.h"
+#include "keyboard/sender/typing_plan_internal.h"
+
+#include "internal/context.h"
+#include "internal/utf.h"
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #endif
 
 #if defined(__linux__)
@@ -12,9 +31,10 @@
 
 #include <stb/stb_ds.h>
 
-#include "internal/context.h"
-#include "keyboard/common/keymap_internal.h"
+#include <sys/socket.h>
+
 #include "keyboard/common/linux_keysym_internal.h"
+#include "keyboard/common/linux_layout_cache_internal.h"
 #endif
 
 static void noop_listener_cb(uint32_t codepoint,
@@ -26,6 +46,33 @@ static void noop_listener_cb(uint32_t codepoint,
   (void)user_data;
 }
 
+typedef struct batch_observation {
+  unsigned int calls;
+  size_t events;
+  uint64_t last_timestamp_us;
+} batch_observation;
+
+static void counting_batch_cb(const axidev_io_key_event_t *events,
+                              size_t count, void *user_data) {
+  batch_observation *observed = (batch_observation *)user_data;
+
+  ++observed->calls;
+  observed->events += count;
+  observed->last_timestamp_us = events[count - 1].timestamp_us;
+}
+
+static void counting_listener_cb(uint32_t codepoint,
+                                 axidev_io_keyboard_key_with_modifier_t key_mod,
+                                 bool pressed, void *user_data) {
+  batch_observation *observed = (batch_observation *)user_data;
+
+  (void)codepoint;
+  (void)key_mod;
+  (void)pressed;
+  ++observed->calls;
+  ++observed->events;
+}
+
 static void test_conversion_helpers(void) {
   char *text;
   axidev_io_keyboard_key_with_modifier_t parsed;
@@ -51,6 +98,7 @@ static void test_linux_fr_digit_key_resolution(void) {
   struct xkb_state *xkb_state;
   struct xkb_rule_names names;
   axidev_io_linux_keymap linux_keymap;
+  static axidev_io_keymap_layout_set set;
   ptrdiff_t index;
   int32_t keycode = -1;
   axidev_io_keyboard_modifier_t mods = AXIDEV_IO_MOD_NONE;
@@ -101,26 +149,14 @@ static void test_linux_fr_digit_key_resolution(void) {
                     AXIDEV_IO_KEY_NUM1);
 
   axidev_io_keyboard_keymap_free();
-  for (index = 0; index < hmlen(linux_keymap.char_to_keycode); ++index) {
-    hmput(axidev_io_keymap_impl_get()->char_to_mapping,
-          linux_keymap.char_to_keycode[index].key,
-          linux_keymap.char_to_keycode[index].value);
-  }
-  for (index = 0; index < hmlen(linux_keymap.evdev_to_key); ++index) {
-    hmput(axidev_io_keymap_impl_get()->code_to_key,
-          linux_keymap.evdev_to_key[index].key,
-          linux_keymap.evdev_to_key[index].value);
-  }
-  for (index = 0; index < hmlen(linux_keymap.code_and_mods_to_key); ++index) {
-    hmput(axidev_io_keymap_impl_get()->code_and_mods_to_key,
-          linux_keymap.code_and_mods_to_key[index].key,
-          linux_keymap.code_and_mods_to_key[index].value);
-  }
-  for (index = 0; index < hmlen(linux_keymap.key_to_evdev); ++index) {
-    hmput(axidev_io_keymap_impl_get()->key_to_code,
-          linux_keymap.key_to_evdev[index].key,
-          linux_keymap.key_to_evdev[index].value);
-  }
+  memset(&set, 0, sizeof(set));
+  TEST_CHECK_EQ_INT(axidev_io_keymap_tables_build(
+                        &set.tables, linux_keymap.key_to_evdev,
+                        linux_keymap.evdev_to_key,
+                        linux_keymap.code_and_mods_to_key,
+                        linux_keymap.char_to_keycode),
+                    AXIDEV_IO_RESULT_OK);
+  axidev_io_keymap_impl_get()->active = &set;
   axidev_io_keymap_public_context()->initialized = true;
 
   TEST_CHECK_EQ_INT(axidev_io_keymap_resolve_key_request(
@@ -131,15 +167,480 @@ static void test_linux_fr_digit_key_resolution(void) {
   TEST_CHECK_EQ_INT(keycode, KEY_1);
   TEST_CHECK((mods & AXIDEV_IO_MOD_SHIFT) != 0);
   TEST_CHECK_EQ_INT(resolved_key, AXIDEV_IO_KEY_NUM1);
+  TEST_CHECK_EQ_INT(axidev_io_keymap_key_from_code(KEY_1, AXIDEV_IO_MOD_SHIFT,
+                                                   &resolved_key),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK_EQ_INT(resolved_key, AXIDEV_IO_KEY_NUM1);
 
   axidev_io_keyboard_keymap_free();
+  axidev_io_keymap_tables_free(&set.tables);
   axidev_io_linux_keymap_free(&linux_keymap);
   xkb_state_unref(xkb_state);
   xkb_keymap_unref(xkb_keymap);
   xkb_context_unref(xkb_context);
 }
+
+static void test_linux_layout_cache_shared(void) {
+  axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
+  axidev_io_linux_compiled_layout *first = NULL;
+  axidev_io_linux_compiled_layout *second = NULL;
+
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_keymap_initialize(),
+                    AXIDEV_IO_RESULT_OK);
+  if (impl->active == NULL || impl->active->layout == NULL) {
+    return;
+  }
+
+  TEST_CHECK_EQ_INT(axidev_io_linux_layout_acquire("test", false, &first),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(first == impl->active->layout);
+  TEST_CHECK(first != NULL && first->tables == impl->active->tables);
+  TEST_CHECK_EQ_INT(axidev_io_linux_layout_acquire("test", false, &second),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(second == first);
+  TEST_CHECK_EQ_INT((int)first->refcount, 3);
+  axidev_io_linux_layout_release(second);
+  axidev_io_linux_layout_release(first);
+  TEST_CHECK_EQ_INT((int)impl->active->layout->refcount, 1);
+  axidev_io_keyboard_keymap_free();
+  TEST_CHECK(impl->active == NULL);
+}
+
+static void test_linux_keysym_table(void) {
+  axidev_io_linux_compiled_layout *layout = NULL;
+  axidev_io_keymap_uint_to_key_entry *table = NULL;
+
+  if (axidev_io_linux_layout_acquire("test", true, &layout) !=
+      AXIDEV_IO_RESULT_OK) {
+    return;
+  }
+  axidev_io_linux_keysym_table_build(layout->keymap, &table);
+  TEST_CHECK_EQ_INT(axidev_io_linux_keysym_table_lookup(table, XKB_KEY_a),
+                    AXIDEV_IO_KEY_A);
+  TEST_CHECK_EQ_INT(axidev_io_linux_keysym_table_lookup(table, XKB_KEY_A),
+                    AXIDEV_IO_KEY_A);
+  TEST_CHECK_EQ_INT(
+      axidev_io_linux_keysym_table_lookup(table, XKB_KEY_Return),
+      AXIDEV_IO_KEY_ENTER);
+  /* Resolved through the keysym name while the table was built. */
+  TEST_CHECK_EQ_INT(axidev_io_linux_keysym_table_lookup(table, 0x1008ff12u),
+                    AXIDEV_IO_KEY_MUTE);
+  TEST_CHECK_EQ_INT(axidev_io_linux_keysym_table_lookup(table, XKB_KEY_F20),
+                    AXIDEV_IO_KEY_UNKNOWN);
+  hmfree(table);
+  axidev_io_linux_layout_release(layout);
+}
+
+/* A seqpacket socket keeps write() boundaries, so every datagram must be
+   whole frames ending in SYN_REPORT, even when a frame or a run of frames
+   is larger than the buffer. */
+static void test_linux_sender_whole_frames(void) {
+  static axidev_io_keyboard_sender_impl impl;
+  struct input_event packet[AXIDEV_IO_LINUX_SENDER_EVENT_BUFFER_LEN];
+  int sockets[2];
+  int key_events = 0;
+  ssize_t received;
+
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets) != 0) {
+    return;
+  }
+  memset(&impl, 0, sizeof(impl));
+  impl.fd = sockets[0];
+  for (int i = 0; i < 100; ++i) {
+    axidev_io_linux_sender_queue_event(&impl, EV_KEY, KEY_A + i % 8, 1);
+  }
+  axidev_io_linux_sender_queue_event(&impl, EV_SYN, SYN_REPORT, 0);
+  for (int i = 0; i < 40; ++i) {
+    axidev_io_linux_sender_queue_event(&impl, EV_KEY, KEY_B, i % 2);
+    axidev_io_linux_sender_queue_event(&impl, EV_SYN, SYN_REPORT, 0);
+  }
+  /* Unterminated: stays queued. */
+  axidev_io_linux_sender_queue_event(&impl, EV_KEY, KEY_C, 1);
+  TEST_CHECK_EQ_INT(AXIDEV_IO_RESULT_OK,
+                    axidev_io_linux_sender_flush_frames(&impl));
+  TEST_CHECK_EQ_INT(1, (int)impl.pending_len);
+
+  while ((received = recv(sockets[1], packet, sizeof(packet),
+                          MSG_DONTWAIT)) > 0) {
+    size_t count = (size_t)received / sizeof(packet[0]);
+
+    TEST_CHECK((size_t)received % sizeof(packet[0]) == 0);
+    TEST_CHECK(count > 0 && packet[count - 1].type == EV_SYN &&
+               packet[count - 1].code == SYN_REPORT);
+    for (size_t i = 0; i < count; ++i) {
+      key_events += packet[i].type == EV_KEY ? 1 : 0;
+    }
+  }
+  TEST_CHECK_EQ_INT(140, key_events);
+  close(sockets[0]);
+  close(sockets[1]);
+}
+#endif
+
+#if !defined(_WIN32)
+static bool corrupt_only_file_in(const char *directory, long offset) {
+  DIR *handle = opendir(directory);
+  struct dirent *entry;
+  bool corrupted = false;
+
+  while (handle != NULL && (entry = readdir(handle)) != NULL) {
+    char path[512];
+    FILE *file;
+
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    file = fopen(path, "r+b");
+    if (file != NULL) {
+      corrupted =
+          fseek(file, offset, SEEK_SET) == 0 && fputc(0x5a, file) != EOF;
+      fclose(file);
+    }
+  }
+  if (handle != NULL) {
+    closedir(handle);
+  }
+  return corrupted;
+}
+
+static void test_keymap_snapshot_round_trip(void) {
+  char directory[] = "/tmp/axidev-io-test-XXXXXX";
+  axidev_io_keymap_tables *source = NULL;
+  axidev_io_keymap_tables *loaded = NULL;
+  axidev_io_keyboard_mapping_value mapping;
+
+  TEST_CHECK(mkdtemp(directory) != NULL);
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("id", &loaded),
+                    AXIDEV_IO_RESULT_NOT_FOUND);
+  TEST_CHECK(axidev_io_keyboard_set_keymap_cache_dir(directory));
+
+  TEST_CHECK_EQ_INT(
+      axidev_io_keymap_tables_build(&source, NULL, NULL, NULL, NULL),
+      AXIDEV_IO_RESULT_OK);
+  if (source == NULL) {
+    return;
+  }
+  source->key_to_code[AXIDEV_IO_KEY_A] = 30;
+  source->fast_chars['a'].keycode = 30;
+  source->fast_chars['a'].produced_key = AXIDEV_IO_KEY_A;
+  source->fast_char_present['a'] = true;
+  mapping.keycode = 18;
+  mapping.required_mods = AXIDEV_IO_MOD_ALT;
+  mapping.produced_key = AXIDEV_IO_KEY_UNKNOWN;
+  hmput(source->char_overflow, 0x20ACu, mapping);
+  source->char_count = 2;
+
+  axidev_io_keymap_snapshot_store("id", source);
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("other", &loaded),
+                    AXIDEV_IO_RESULT_NOT_FOUND);
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("id", &loaded),
+                    AXIDEV_IO_RESULT_OK);
+  if (loaded != NULL) {
+    TEST_CHECK_EQ_INT(loaded->key_to_code[AXIDEV_IO_KEY_A], 30);
+    TEST_CHECK(axidev_io_keymap_tables_lookup_char(loaded, 'a', &mapping));
+    TEST_CHECK_EQ_INT(mapping.produced_key, AXIDEV_IO_KEY_A);
+    TEST_CHECK(axidev_io_keymap_tables_lookup_char(loaded, 0x20ACu, &mapping));
+    TEST_CHECK_EQ_INT(mapping.keycode, 18);
+    TEST_CHECK_EQ_INT((int)loaded->char_count, 2);
+    axidev_io_keymap_tables_free(&loaded);
+  }
+
+  /* A flipped payload byte fails the checksum instead of loading. */
+  TEST_CHECK(corrupt_only_file_in(directory, 1024));
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("id", &loaded),
+                    AXIDEV_IO_RESULT_NOT_FOUND);
+
+  /* Out-of-range values with a valid checksum are rejected as well. */
+  source->key_to_code[AXIDEV_IO_KEY_B] = (int32_t)AXIDEV_IO_KEYMAP_CODE_LIMIT;
+  axidev_io_keymap_snapshot_store("id", source);
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("id", &loaded),
+                    AXIDEV_IO_RESULT_NOT_FOUND);
+  source->key_to_code[AXIDEV_IO_KEY_B] = AXIDEV_IO_KEYMAP_NO_CODE;
+  source->code_mods_to_key[30][1] = (uint16_t)AXIDEV_IO_KEYMAP_KEY_LIMIT;
+  axidev_io_keymap_snapshot_store("id", source);
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("id", &loaded),
+                    AXIDEV_IO_RESULT_NOT_FOUND);
+  source->code_mods_to_key[30][1] = AXIDEV_IO_KEYMAP_NO_KEY;
+  mapping.keycode = 18;
+  mapping.required_mods = (axidev_io_keyboard_modifier_t)0x80;
+  mapping.produced_key = AXIDEV_IO_KEY_UNKNOWN;
+  hmput(source->char_overflow, 0x20ACu, mapping);
+  axidev_io_keymap_snapshot_store("id", source);
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("id", &loaded),
+                    AXIDEV_IO_RESULT_NOT_FOUND);
+  mapping.required_mods = AXIDEV_IO_MOD_ALT;
+  hmput(source->char_overflow, 0x20ACu, mapping);
+
+  axidev_io_keymap_snapshot_store("id", source);
+  TEST_CHECK(axidev_io_keyboard_invalidate_keymap_cache());
+  TEST_CHECK_EQ_INT(axidev_io_keymap_snapshot_load("id", &loaded),
+                    AXIDEV_IO_RESULT_NOT_FOUND);
+
+  TEST_CHECK(axidev_io_keyboard_set_keymap_cache_dir(NULL));
+  axidev_io_keymap_tables_free(&source);
+  TEST_CHECK_EQ_INT(rmdir(directory), 0);
+}
 #endif
 
+static void check_plan_kinds(const char *text,
+                             const axidev_io_typing_step_kind *expected,
+                             size_t expected_count) {
+  axidev_io_typing_step *steps = NULL;
+  size_t i;
+
+  TEST_CHECK_EQ_INT(axidev_io_typing_plan_build(text, &steps),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK_EQ_INT(arrlen(steps), expected_count);
+  for (i = 0; i < expected_count && i < (size_t)arrlen(steps); ++i) {
+    TEST_CHECK_EQ_INT(steps[i].kind, expected[i]);
+  }
+  axidev_io_typing_plan_free(&steps);
+}
+
+static void test_typing_plan_modifier_elision(void) {
+  static const axidev_io_typing_step_kind upper[] = {
+      AXIDEV_IO_TYPING_STEP_HOLD_MODS, AXIDEV_IO_TYPING_STEP_TAP,
+      AXIDEV_IO_TYPING_STEP_TAP,       AXIDEV_IO_TYPING_STEP_TAP,
+      AXIDEV_IO_TYPING_STEP_TAP,       AXIDEV_IO_TYPING_STEP_TAP,
+      AXIDEV_IO_TYPING_STEP_RELEASE_MODS};
+  static const axidev_io_typing_step_kind mixed[] = {
+      AXIDEV_IO_TYPING_STEP_TAP, AXIDEV_IO_TYPING_STEP_HOLD_MODS,
+      AXIDEV_IO_TYPING_STEP_TAP, AXIDEV_IO_TYPING_STEP_RELEASE_MODS,
+      AXIDEV_IO_TYPING_STEP_TAP};
+  static const axidev_io_typing_step_kind latched[] = {
+      AXIDEV_IO_TYPING_STEP_HOLD_MODS, AXIDEV_IO_TYPING_STEP_TAP,
+      AXIDEV_IO_TYPING_STEP_TAP, AXIDEV_IO_TYPING_STEP_RELEASE_MODS};
+  axidev_io_typing_step *steps = NULL;
+
+  axidev_io_context_ensure_runtime();
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_keymap_initialize(),
+                    AXIDEV_IO_RESULT_OK);
+  if (!axidev_io_keymap_public_context()->initialized) {
+    return;
+  }
+
+  check_plan_kinds("HELLO", upper, sizeof(upper) / sizeof(upper[0]));
+  check_plan_kinds("aBc", mixed, sizeof(mixed) / sizeof(mixed[0]));
+  check_plan_kinds("ctrl+ab", latched, sizeof(latched) / sizeof(latched[0]));
+
+  TEST_CHECK_EQ_INT(axidev_io_typing_plan_build("HELLO", &steps),
+                    AXIDEV_IO_RESULT_OK);
+  if (arrlen(steps) > 0) {
+    TEST_CHECK_EQ_INT(steps[0].mods, AXIDEV_IO_MOD_SHIFT);
+  }
+  axidev_io_typing_plan_free(&steps);
+
+  axidev_io_keyboard_keymap_free();
+}
+
+static void test_utf8_ascii_run_heap_bounds(void) {
+  size_t length;
+
+  /* Exactly sized heap strings, so `build.py test-asan` catches any read
+     past the terminator. */
+  for (length = 0; length <= 40u; ++length) {
+    char *text = malloc(length + 1u);
+    TEST_CHECK(text != NULL);
+    if (text == NULL) {
+      return;
+    }
+    memset(text, 'a', length);
+    text[length] = '\0';
+    TEST_CHECK_EQ_INT(axidev_io_utf8_ascii_run(text, length, ','),
+                      (int)length);
+    if (length > 0u) {
+      text[length - 1u] = ',';
+      TEST_CHECK_EQ_INT(axidev_io_utf8_ascii_run(text, length, ','),
+                        (int)length - 1);
+    }
+    free(text);
+  }
+}
+
+static void test_typing_plan_ascii_fast_path(void) {
+  static const char text[] =
+      "The quick brown fox, jumps over 12 lazy dogs!\tDone\n";
+  char buffer[96];
+  axidev_io_typing_step *fast = NULL;
+  axidev_io_typing_step *slow = NULL;
+  axidev_io_keymap_ascii_tap saved[AXIDEV_IO_KEYMAP_ASCII_LIMIT];
+  axidev_io_keyboard_keymap_impl *impl;
+  size_t offset;
+
+  /* Every starting alignment, stopping at ',', non-ASCII and the end. */
+  for (offset = 0; offset < 16u; ++offset) {
+    memset(buffer, 'x', offset);
+    strcpy(buffer + offset, "abcdefghijklmnopqrstuvwxyz0123456789,tail");
+    TEST_CHECK_EQ_INT(
+        axidev_io_utf8_ascii_run(buffer + offset, strlen(buffer + offset), ','),
+        36);
+    strcpy(buffer + offset, "abcdefghijklmnopqrstuv\xc3\xa9");
+    TEST_CHECK_EQ_INT(
+        axidev_io_utf8_ascii_run(buffer + offset, strlen(buffer + offset), ','),
+        22);
+    strcpy(buffer + offset, "abcdefghijklmnopqrstuvwxyz");
+    TEST_CHECK_EQ_INT(
+        axidev_io_utf8_ascii_run(buffer + offset, strlen(buffer + offset), ','),
+        26);
+  }
+  TEST_CHECK_EQ_INT(axidev_io_utf8_ascii_run(",", 1, ','), 0);
+  /* The run never extends past the given length. */
+  TEST_CHECK_EQ_INT(axidev_io_utf8_ascii_run(text, 20, ','), 20);
+
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_keymap_initialize(),
+                    AXIDEV_IO_RESULT_OK);
+  if (!axidev_io_keymap_public_context()->initialized) {
+    return;
+  }
+
+  /* The precomputed taps must plan exactly what per-character lookups do. */
+  impl = axidev_io_keymap_impl_get();
+  TEST_CHECK_EQ_INT(axidev_io_typing_plan_build(text, &fast),
+                    AXIDEV_IO_RESULT_OK);
+  memcpy(saved, impl->active->ascii_taps, sizeof(saved));
+  memset(impl->active->ascii_taps, 0, sizeof(impl->active->ascii_taps));
+  TEST_CHECK_EQ_INT(axidev_io_typing_plan_build(text, &slow),
+                    AXIDEV_IO_RESULT_OK);
+  memcpy(impl->active->ascii_taps, saved, sizeof(saved));
+
+  TEST_CHECK(arrlen(fast) > 0);
+  TEST_CHECK_EQ_INT(arrlen(fast), arrlen(slow));
+  if (arrlen(fast) == arrlen(slow)) {
+    TEST_CHECK(memcmp(fast, slow, (size_t)arrlen(fast) * sizeof(*fast)) == 0);
+  }
+  axidev_io_typing_plan_free(&fast);
+  axidev_io_typing_plan_free(&slow);
+  axidev_io_keyboard_keymap_free();
+}
+
+/* Alternating case adds a modifier change per character; the rate must
+   still hold for the text as a whole. */
+static void test_typing_rate_shifted_text(void) {
+  axidev_io_captured_transition_t captured[64];
+  uint64_t start_ns;
+  uint64_t elapsed_ns;
+
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  TEST_CHECK(axidev_io_keyboard_initialize());
+  axidev_io_keyboard_set_typing_rate(50);
+  TEST_CHECK_EQ_INT(50, (int)axidev_io_global->keyboard.sender.typing_rate_cps);
+
+  /* 10 characters at 50 per second take 200 ms; a fixed half-character
+     delay per transition would take 300 ms here. */
+  start_ns = axidev_io_monotonic_time_ns();
+  TEST_CHECK(axidev_io_keyboard_type_text("aAaAaAaAaA"));
+  elapsed_ns = axidev_io_monotonic_time_ns() - start_ns;
+  TEST_CHECK(elapsed_ns >= 190000000u);
+  TEST_CHECK(elapsed_ns < 270000000u);
+  TEST_CHECK(axidev_io_keyboard_capture_read(captured, 64) >= 20u);
+  TEST_CHECK_EQ_INT(10000, (int)axidev_io_global->keyboard.sender.key_delay_us);
+
+  axidev_io_keyboard_set_key_delay(1000);
+  TEST_CHECK_EQ_INT(0, (int)axidev_io_global->keyboard.sender.typing_rate_cps);
+  axidev_io_keyboard_free();
+  axidev_io_keyboard_set_sender_options(0);
+}
+
+static void test_typing_rate_taps(void) {
+  axidev_io_keyboard_key_with_modifier_t key = {AXIDEV_IO_KEY_A,
+                                                AXIDEV_IO_MOD_NONE};
+  axidev_io_captured_transition_t captured[64];
+  uint64_t start_ns;
+  uint64_t elapsed_ns;
+  int i;
+
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  TEST_CHECK(axidev_io_keyboard_initialize());
+  axidev_io_keyboard_set_typing_rate(50);
+
+  /* 10 plain taps at 50 per second take 200 ms; a delay before the press
+     as well would take 300 ms. */
+  start_ns = axidev_io_monotonic_time_ns();
+  for (i = 0; i < 10; ++i) {
+    TEST_CHECK(axidev_io_keyboard_tap(key));
+  }
+  elapsed_ns = axidev_io_monotonic_time_ns() - start_ns;
+  TEST_CHECK(elapsed_ns >= 190000000u);
+  TEST_CHECK(elapsed_ns < 270000000u);
+  TEST_CHECK_EQ_INT((int)axidev_io_keyboard_capture_read(captured, 64), 20);
+
+  axidev_io_keyboard_free();
+  axidev_io_keyboard_set_sender_options(0);
+}
+
+static void test_keyboard_plan_recompile(void) {
+  axidev_io_keyboard_plan_t *plan = NULL;
+  uint64_t generation;
+
+  TEST_CHECK(axidev_io_keyboard_plan_compile(NULL) == NULL);
+  TEST_CHECK(!axidev_io_keyboard_plan_play(NULL));
+  axidev_io_keyboard_plan_free(NULL);
+
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_keymap_initialize(),
+                    AXIDEV_IO_RESULT_OK);
+  if (!axidev_io_keymap_public_context()->initialized) {
+    return;
+  }
+
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_plan_compile_internal("Hi", &plan),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(plan != NULL);
+  if (plan == NULL) {
+    axidev_io_keyboard_keymap_free();
+    return;
+  }
+  generation = plan->keymap_generation;
+  TEST_CHECK_EQ_INT(generation, axidev_io_keymap_generation());
+  TEST_CHECK_EQ_INT(arrlen(plan->steps), 4);
+
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_keymap_initialize(),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(axidev_io_keymap_generation() != generation);
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_plan_refresh_internal(plan),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK_EQ_INT(plan->keymap_generation, axidev_io_keymap_generation());
+  TEST_CHECK_EQ_INT(arrlen(plan->steps), 4);
+
+  axidev_io_keyboard_plan_free_internal(plan);
+  axidev_io_keyboard_keymap_free();
+}
+
+static int read_other_thread_error_code(void *user_data) {
+  *(int *)user_data = (int)axidev_io_get_last_error_code();
+  return 0;
+}
+
+static void test_last_error_per_thread(void) {
+  axidev_io_thread thread;
+  int other_code = -1;
+
+  axidev_io_clear_last_error();
+  TEST_CHECK_EQ_INT((int)axidev_io_get_last_error_code(),
+                    (int)AXIDEV_IO_ERROR_NONE);
+  TEST_CHECK(axidev_io_get_last_error() == NULL);
+  TEST_CHECK(strcmp(axidev_io_get_last_error_message(), "") == 0);
+
+  TEST_CHECK(!axidev_io_keyboard_tap((axidev_io_keyboard_key_with_modifier_t){
+      AXIDEV_IO_KEY_A, AXIDEV_IO_MOD_NONE}));
+  TEST_CHECK_EQ_INT((int)axidev_io_get_last_error_code(),
+                    (int)AXIDEV_IO_ERROR_NOT_INITIALIZED);
+  TEST_CHECK(strstr(axidev_io_get_last_error_message(), "not_initialized") !=
+             NULL);
+
+  /* Another thread's failure state is its own. */
+  TEST_CHECK(axidev_io_thread_create(&thread, read_other_thread_error_code,
+                                     &other_code));
+  axidev_io_thread_join(&thread);
+  TEST_CHECK_EQ_INT(other_code, (int)AXIDEV_IO_ERROR_NONE);
+  TEST_CHECK_EQ_INT((int)axidev_io_get_last_error_code(),
+                    (int)AXIDEV_IO_ERROR_NOT_INITIALIZED);
+
+  axidev_io_clear_last_error();
+  TEST_CHECK_EQ_INT((int)axidev_io_get_last_error_code(),
+                    (int)AXIDEV_IO_ERROR_NONE);
+}
+
 static void test_sender_lifecycle_and_errors(void) {
   char *error_text;
   axidev_io_keyboard_capabilities_t capabilities;
@@ -184,6 +685,382 @@ static void test_sender_lifecycle_and_errors(void) {
   TEST_CHECK(!axidev_io_keyboard_is_ready());
 }
 
+static void test_sender_options_survive_reinitialize(void) {
+  const uint32_t options = AXIDEV_IO_SENDER_OPTION_FAST_INIT |
+                           AXIDEV_IO_SENDER_OPTION_KEEP_DEVICE;
+  int cycle;
+
+  TEST_CHECK_EQ_INT(0, (int)axidev_io_keyboard_get_sender_options());
+  axidev_io_keyboard_set_sender_options(options);
+  TEST_CHECK_EQ_INT((int)options, (int)axidev_io_keyboard_get_sender_options());
+
+  for (cycle = 0; cycle < 2; ++cycle) {
+    if (axidev_io_keyboard_initialize()) {
+      TEST_CHECK(axidev_io_keyboard_is_ready());
+      TEST_CHECK(
+          axidev_io_keyboard_tap((axidev_io_keyboard_key_with_modifier_t){
+              AXIDEV_IO_KEY_A, AXIDEV_IO_MOD_SHIFT}));
+    }
+    axidev_io_keyboard_free();
+    TEST_CHECK(!axidev_io_keyboard_is_ready());
+  }
+  TEST_CHECK_EQ_INT((int)options, (int)axidev_io_keyboard_get_sender_options());
+
+  axidev_io_keyboard_set_sender_options(0);
+  TEST_CHECK_EQ_INT(0, (int)axidev_io_keyboard_get_sender_options());
+}
+
+static void test_sender_capture(void) {
+  axidev_io_captured_transition_t captured[AXIDEV_IO_SENDER_CAPTURE_CAPACITY];
+  const axidev_io_keyboard_key_with_modifier_t tap_a = {AXIDEV_IO_KEY_A,
+                                                        AXIDEV_IO_MOD_NONE};
+  axidev_io_sender_t *handle;
+  size_t count;
+
+  TEST_CHECK(axidev_io_keyboard_capture_read(captured, 4) == 0);
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  TEST_CHECK(axidev_io_keyboard_initialize());
+  TEST_CHECK_EQ_INT((int)AXIDEV_IO_BACKEND_CAPTURE,
+                    (int)axidev_io_keyboard_type());
+
+  TEST_CHECK(axidev_io_keyboard_tap(tap_a));
+  count = axidev_io_keyboard_capture_read(captured, 4);
+  TEST_CHECK_EQ_INT(2, (int)count);
+  if (count == 2) {
+    TEST_CHECK_EQ_INT(captured[0].code, captured[1].code);
+    TEST_CHECK_EQ_INT(1, captured[0].value);
+    TEST_CHECK_EQ_INT(0, captured[1].value);
+    TEST_CHECK(!captured[0].unicode);
+#if defined(__linux__)
+    TEST_CHECK_EQ_INT(KEY_A, captured[0].code);
+#endif
+  }
+
+  /* Handles sharing the global sender record into its buffer. */
+  handle = axidev_io_sender_open(0);
+  TEST_CHECK(handle != NULL);
+  if (handle != NULL) {
+    TEST_CHECK(axidev_io_sender_type_text(handle, "B"));
+    axidev_io_sender_close(handle);
+  }
+  TEST_CHECK_EQ_INT(4, (int)axidev_io_keyboard_capture_read(captured, 8));
+
+  /* A full buffer keeps the newest transitions. */
+  for (unsigned int i = 0; i < AXIDEV_IO_SENDER_CAPTURE_CAPACITY; ++i) {
+    TEST_CHECK(axidev_io_keyboard_tap(tap_a));
+  }
+  count = axidev_io_keyboard_capture_read(
+      captured, AXIDEV_IO_SENDER_CAPTURE_CAPACITY);
+  TEST_CHECK_EQ_INT((int)AXIDEV_IO_SENDER_CAPTURE_CAPACITY, (int)count);
+  TEST_CHECK_EQ_INT(0, captured[count - 1].value);
+  TEST_CHECK(axidev_io_keyboard_capture_read(captured, 4) == 0);
+
+  axidev_io_keyboard_free();
+  axidev_io_keyboard_set_sender_options(0);
+  TEST_CHECK(axidev_io_keyboard_capture_read(captured, 4) == 0);
+}
+
+typedef struct log_sink_observed {
+  atomic_uint count;
+  axidev_io_log_level_t last_level;
+  char last_message[64];
+  size_t last_length;
+} log_sink_observed;
+
+static void counting_log_sink(axidev_io_log_level_t level, const char *file,
+                              int line, const char *message, void *user_data) {
+  log_sink_observed *observed = (log_sink_observed *)user_data;
+
+  (void)file;
+  (void)line;
+  observed->last_level = level;
+  observed->last_length = strlen(message);
+  snprintf(observed->last_message, sizeof(observed->last_message), "%s",
+           message);
+  atomic_fetch_add(&observed->count, 1u);
+}
+
+/* Logs and flushes from inside the sink; both must return without
+   re-entering the output path. */
+static void reentrant_log_sink(axidev_io_log_level_t level, const char *file,
+                               int line, const char *message,
+                               void *user_data) {
+  axidev_io_log_message(AXIDEV_IO_LOG_LEVEL_ERROR, __FILE__, __LINE__,
+                        "nested %s", message);
+  axidev_io_log_flush();
+  counting_log_sink(level, file, line, message, user_data);
+}
+
+static void test_log_sink_reentry(void) {
+  axidev_io_log_level_t previous_level = axidev_io_log_get_level();
+  log_sink_observed observed;
+  uint64_t dropped_before = axidev_io_log_dropped_count();
+
+  memset(&observed, 0, sizeof(observed));
+  atomic_init(&observed.count, 0u);
+  axidev_io_log_set_level(AXIDEV_IO_LOG_LEVEL_DEBUG);
+  axidev_io_log_set_sink(reentrant_log_sink, &observed);
+
+  axidev_io_log_message(AXIDEV_IO_LOG_LEVEL_WARN, __FILE__, __LINE__,
+                        "sync");
+  TEST_CHECK_EQ_INT((int)atomic_load(&observed.count), 1);
+  TEST_CHECK(strcmp(observed.last_message, "sync") == 0);
+
+  TEST_CHECK(axidev_io_log_set_async(true));
+  axidev_io_log_message(AXIDEV_IO_LOG_LEVEL_WARN, __FILE__, __LINE__,
+                        "async");
+  axidev_io_log_flush();
+  TEST_CHECK_EQ_INT((int)atomic_load(&observed.count), 2);
+  TEST_CHECK(strcmp(observed.last_message, "async") == 0);
+  TEST_CHECK(axidev_io_log_set_async(false));
+  TEST_CHECK_EQ_INT((int)(axidev_io_log_dropped_count() - dropped_before), 2);
+
+  axidev_io_log_set_sink(NULL, NULL);
+  axidev_io_log_set_level(previous_level);
+}
+
+static void test_log_sink_and_async(void) {
+  axidev_io_log_level_t previous_level = axidev_io_log_get_level();
+  log_sink_observed observed;
+  uint64_t dropped_before = axidev_io_log_dropped_count();
+  unsigned int i;
+
+  memset(&observed, 0, sizeof(observed));
+  atomic_init(&observed.count, 0u);
+  axidev_io_log_set_level(AXIDEV_IO_LOG_LEVEL_DEBUG);
+  axidev_io_log_set_sink(counting_log_sink, &observed);
+
+  AXIDEV_IO_LOG_WARN("sync %d", 1);
+  TEST_CHECK_EQ_INT((int)atomic_load(&observed.count), 1);
+  TEST_CHECK_EQ_INT((int)observed.last_level, (int)AXIDEV_IO_LOG_LEVEL_WARN);
+  TEST_CHECK(strcmp(observed.last_message, "sync 1") == 0);
+
+  /* Only async messages are cut to the ring record size. */
+  AXIDEV_IO_LOG_WARN("%01000d", 0);
+  TEST_CHECK_EQ_INT((int)observed.last_length, 1000);
+
+  TEST_CHECK(axidev_io_log_set_async(true));
+  TEST_CHECK(axidev_io_log_set_async(true));
+  AXIDEV_IO_LOG_WARN("%01000d", 0);
+  axidev_io_log_flush();
+  TEST_CHECK_EQ_INT((int)observed.last_length, 511);
+  for (i = 0; i < 100u; ++i) {
+    AXIDEV_IO_LOG_DEBUG("async %u", i);
+  }
+  axidev_io_log_flush();
+  TEST_CHECK_EQ_INT((int)atomic_load(&observed.count), 103);
+  TEST_CHECK(strcmp(observed.last_message, "async 99") == 0);
+
+  /* A burst larger than the ring is either written or counted as dropped. */
+  for (i = 0; i < 5000u; ++i) {
+    AXIDEV_IO_LOG_DEBUG("burst %u", i);
+  }
+  TEST_CHECK(axidev_io_log_set_async(false));
+  TEST_CHECK_EQ_INT(
+      (int)(atomic_load(&observed.count) - 103u +
+            (unsigned int)(axidev_io_log_dropped_count() - dropped_before)),
+      5000);
+
+  axidev_io_log_set_sink(NULL, NULL);
+  axidev_io_log_set_level(previous_level);
+}
+
+static void test_log_filtered_arguments(void) {
+  axidev_io_log_level_t previous_level = axidev_io_log_get_level();
+  log_sink_observed observed;
+  unsigned int evaluated = 0;
+
+  memset(&observed, 0, sizeof(observed));
+  atomic_init(&observed.count, 0u);
+  axidev_io_log_set_sink(counting_log_sink, &observed);
+
+  /* A filtered macro call must not evaluate its arguments. */
+  axidev_io_log_set_level(AXIDEV_IO_LOG_LEVEL_ERROR);
+  AXIDEV_IO_LOG_DEBUG("filtered %u", ++evaluated);
+  TEST_CHECK_EQ_INT((int)evaluated, 0);
+  TEST_CHECK_EQ_INT((int)atomic_load(&observed.count), 0);
+
+  axidev_io_log_set_sink(NULL, NULL);
+  axidev_io_log_set_level(previous_level);
+}
+
+static axidev_io_once g_test_once = AXIDEV_IO_ONCE_INIT;
+static atomic_int g_test_once_runs;
+static atomic_int g_test_once_finished;
+
+static void slow_once_init(void) {
+  atomic_fetch_add(&g_test_once_runs, 1);
+  axidev_io_sleep_ms(20);
+  atomic_store(&g_test_once_finished, 1);
+}
+
+static int call_test_once(void *user_data) {
+  (void)user_data;
+  axidev_io_call_once(&g_test_once, slow_once_init);
+  /* Returning before the initializer finished would be a bug. */
+  return atomic_load(&g_test_once_finished) == 1 ? 0 : 1;
+}
+
+static void test_call_once_waits_for_initializer(void) {
+  axidev_io_thread thread;
+
+  atomic_init(&g_test_once_runs, 0);
+  atomic_init(&g_test_once_finished, 0);
+  TEST_CHECK(axidev_io_thread_create(&thread, call_test_once, NULL));
+  axidev_io_sleep_ms(5);
+  TEST_CHECK_EQ_INT(call_test_once(NULL), 0);
+  axidev_io_thread_join(&thread);
+  TEST_CHECK_EQ_INT(call_test_once(NULL), 0);
+  TEST_CHECK_EQ_INT(atomic_load(&g_test_once_runs), 1);
+}
+
+static void test_pacer_absolute_deadlines(void) {
+  axidev_io_pacer pacer;
+  uint64_t deadline;
+
+  axidev_io_pacer_init(&pacer);
+  deadline = axidev_io_pacer_next_deadline(&pacer, 1000u, 5000000u);
+  TEST_CHECK(deadline == 6000000u);
+  /* Waking 300us late does not push the following deadline back. */
+  deadline = axidev_io_pacer_next_deadline(&pacer, 1000u, 6300000u);
+  TEST_CHECK(deadline == 7000000u);
+  /* After an idle gap the schedule restarts instead of bursting. */
+  deadline = axidev_io_pacer_next_deadline(&pacer, 1000u, 50000000u);
+  TEST_CHECK(deadline == 51000000u);
+  axidev_io_pacer_destroy(&pacer);
+
+  axidev_io_pacer_init(&pacer);
+  pacer.spin_us = 200u;
+  deadline = axidev_io_monotonic_time_ns();
+  axidev_io_pacer_wait(&pacer, 500u);
+  axidev_io_pacer_wait(&pacer, 500u);
+  TEST_CHECK(axidev_io_monotonic_time_ns() - deadline >= 1000000u);
+  axidev_io_pacer_destroy(&pacer);
+}
+
+typedef struct async_observation_t {
+  unsigned int completed;
+  unsigned int succeeded;
+} async_observation_t;
+
+static void async_job_cb(uint64_t job_id, bool success, void *user_data) {
+  async_observation_t *observed = (async_observation_t *)user_data;
+  (void)job_id;
+  ++observed->completed;
+  if (success) {
+    ++observed->succeeded;
+  }
+}
+
+static void test_async_queue_backpressure_and_cancel(void) {
+  async_observation_t observed = {0, 0};
+  axidev_io_keyboard_key_with_modifier_t key_mod = {AXIDEV_IO_KEY_A,
+                                                    AXIDEV_IO_MOD_NONE};
+  unsigned int accepted = 0;
+  uint64_t last_id = 0;
+  char *error_text;
+
+  TEST_CHECK_EQ_INT((int)axidev_io_keyboard_type_text_async(NULL, NULL, NULL),
+                    0);
+  TEST_CHECK(!axidev_io_keyboard_async_wait(1000000u, 0));
+
+  /* Holding the context lock parks the worker before its first injection so
+     the ring can be filled deterministically. */
+  axidev_io_context_lock();
+  while (accepted <= AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY) {
+    uint64_t job_id = axidev_io_keyboard_tap_async(key_mod, async_job_cb,
+                                                   &observed);
+    if (job_id == 0) {
+      break;
+    }
+    TEST_CHECK(job_id > last_id);
+    last_id = job_id;
+    ++accepted;
+  }
+  error_text = axidev_io_get_last_error();
+  TEST_CHECK(error_text != NULL && strstr(error_text, "queue_full") != NULL);
+  axidev_io_free_string(error_text);
+  TEST_CHECK(accepted >= AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY);
+  TEST_CHECK(accepted <= AXIDEV_IO_KEYBOARD_ASYNC_QUEUE_CAPACITY + 1u);
+  TEST_CHECK_EQ_INT((int)axidev_io_keyboard_async_pending(), (int)accepted);
+  TEST_CHECK(!axidev_io_keyboard_async_wait(last_id, 10));
+  TEST_CHECK(axidev_io_keyboard_async_cancel(0));
+  axidev_io_context_unlock();
+
+  TEST_CHECK(axidev_io_keyboard_async_wait(0, AXIDEV_IO_ASYNC_WAIT_INFINITE));
+  TEST_CHECK_EQ_INT((int)observed.completed, (int)accepted);
+  TEST_CHECK_EQ_INT((int)observed.succeeded, 0);
+  TEST_CHECK_EQ_INT((int)axidev_io_keyboard_async_pending(), 0);
+  axidev_io_keyboard_free();
+}
+
+typedef struct async_reentry_t {
+  bool initialize_result;
+  int initialize_error;
+  bool wait_result;
+  atomic_bool release;
+  int dropped_errors[2];
+  unsigned int dropped_count;
+} async_reentry_t;
+
+/* Tries to tear the queue down from its own worker, then keeps the worker
+   busy until the test has queued more jobs behind it. */
+static void async_reentry_cb(uint64_t job_id, bool success, void *user_data) {
+  async_reentry_t *observed = (async_reentry_t *)user_data;
+
+  (void)success;
+  observed->initialize_result = axidev_io_keyboard_initialize();
+  observed->initialize_error = (int)axidev_io_get_last_error_code();
+  observed->wait_result =
+      axidev_io_keyboard_async_wait(job_id, AXIDEV_IO_ASYNC_WAIT_INFINITE);
+  while (!atomic_load(&observed->release)) {
+    axidev_io_sleep_ms(1);
+  }
+  axidev_io_sleep_ms(50);
+}
+
+static void async_dropped_cb(uint64_t job_id, bool success, void *user_data) {
+  async_reentry_t *observed = (async_reentry_t *)user_data;
+
+  (void)job_id;
+  if (!success && observed->dropped_count < 2u) {
+    observed->dropped_errors[observed->dropped_count] =
+        (int)axidev_io_get_last_error_code();
+  }
+  ++observed->dropped_count;
+}
+
+static void test_async_callback_reentry(void) {
+  async_reentry_t observed;
+  axidev_io_keyboard_key_with_modifier_t key_mod = {AXIDEV_IO_KEY_A,
+                                                    AXIDEV_IO_MOD_NONE};
+
+  memset(&observed, 0, sizeof(observed));
+  atomic_init(&observed.release, false);
+  observed.initialize_result = true;
+  observed.wait_result = true;
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  TEST_CHECK(axidev_io_keyboard_initialize());
+  TEST_CHECK(axidev_io_keyboard_tap_async(key_mod, async_reentry_cb,
+                                          &observed) != 0);
+  TEST_CHECK(axidev_io_keyboard_tap_async(key_mod, async_dropped_cb,
+                                          &observed) != 0);
+  TEST_CHECK(axidev_io_keyboard_tap_async(key_mod, async_dropped_cb,
+                                          &observed) != 0);
+  atomic_store(&observed.release, true);
+  /* Drops the two jobs still queued behind the busy callback. */
+  axidev_io_keyboard_free();
+
+  TEST_CHECK(!observed.initialize_result);
+  TEST_CHECK_EQ_INT(AXIDEV_IO_ERROR_NOT_SUPPORTED, observed.initialize_error);
+  TEST_CHECK(!observed.wait_result);
+  TEST_CHECK_EQ_INT(2, (int)observed.dropped_count);
+  TEST_CHECK_EQ_INT(AXIDEV_IO_ERROR_CANCELLED, observed.dropped_errors[0]);
+  TEST_CHECK_EQ_INT(AXIDEV_IO_ERROR_CANCELLED, observed.dropped_errors[1]);
+  TEST_CHECK_EQ_INT((int)axidev_io_keyboard_async_pending(), 0);
+  axidev_io_keyboard_set_sender_options(0);
+}
+
 #if defined(_WIN32)
 static void test_windows_repeat_state(void) {
   TEST_CHECK(axidev_io_keyboard_initialize());
@@ -237,6 +1114,161 @@ static void test_windows_repeat_state(void) {
 }
 #endif
 
+static bool count_repeat_fire(int32_t keycode, void *user_data) {
+  (void)keycode;
+  atomic_fetch_add((atomic_uint *)user_data, 1u);
+  return true;
+}
+
+typedef struct repeat_slow_sink_t {
+  atomic_bool slow_started;
+  atomic_uint failures;
+} repeat_slow_sink_t;
+
+/* Keycode 1 stands in for a write stuck in its retries, keycode 2 for a
+   sink that rejects every write. */
+static bool slow_or_failing_repeat_fire(int32_t keycode, void *user_data) {
+  repeat_slow_sink_t *sink = (repeat_slow_sink_t *)user_data;
+
+  if (keycode == 1) {
+    atomic_store(&sink->slow_started, true);
+    axidev_io_sleep_ms(200);
+    return true;
+  }
+  if (keycode == 2) {
+    atomic_fetch_add(&sink->failures, 1u);
+    return false;
+  }
+  return true;
+}
+
+static void test_repeat_engine_fires_unlocked(void) {
+  axidev_io_repeat_engine engine;
+  axidev_io_repeat_entry entry;
+  repeat_slow_sink_t sink;
+  axidev_io_keyboard_key_with_modifier_t slow = {AXIDEV_IO_KEY_A,
+                                                 AXIDEV_IO_MOD_NONE};
+  axidev_io_keyboard_key_with_modifier_t other = {AXIDEV_IO_KEY_B,
+                                                  AXIDEV_IO_MOD_NONE};
+  axidev_io_keyboard_key_with_modifier_t failing = {AXIDEV_IO_KEY_C,
+                                                    AXIDEV_IO_MOD_NONE};
+  uint64_t start_ns;
+  int waited_ms;
+
+  atomic_init(&sink.slow_started, false);
+  atomic_init(&sink.failures, 0u);
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_start(
+                        &engine, slow_or_failing_repeat_fire, &sink),
+                    (int)AXIDEV_IO_RESULT_OK);
+
+  memset(&entry, 0, sizeof(entry));
+  entry.request = slow;
+  entry.keycode = 1;
+  entry.next_fire_at_ns = axidev_io_monotonic_time_ns();
+  entry.interval_ns = 1000000000ull;
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_add(&engine, &entry),
+                    (int)AXIDEV_IO_RESULT_OK);
+  for (waited_ms = 0; !atomic_load(&sink.slow_started) && waited_ms < 1000;
+       ++waited_ms) {
+    axidev_io_sleep_ms(1);
+  }
+  TEST_CHECK(atomic_load(&sink.slow_started));
+
+  /* Other keys are added and cancelled while the slow write is stuck. */
+  start_ns = axidev_io_monotonic_time_ns();
+  entry.request = other;
+  entry.keycode = 3;
+  entry.next_fire_at_ns = start_ns + 60000000000ull;
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_add(&engine, &entry),
+                    (int)AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(axidev_io_repeat_engine_cancel(&engine, other));
+  TEST_CHECK(axidev_io_monotonic_time_ns() - start_ns < 100000000ull);
+
+  /* A rejected repeat stops that key after one attempt. */
+  entry.request = failing;
+  entry.keycode = 2;
+  entry.next_fire_at_ns = axidev_io_monotonic_time_ns();
+  entry.interval_ns = 1000000ull;
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_add(&engine, &entry),
+                    (int)AXIDEV_IO_RESULT_OK);
+  for (waited_ms = 0;
+       axidev_io_repeat_engine_contains(&engine, failing) && waited_ms < 1000;
+       ++waited_ms) {
+    axidev_io_sleep_ms(1);
+  }
+  axidev_io_sleep_ms(20);
+  TEST_CHECK(!axidev_io_repeat_engine_contains(&engine, failing));
+  TEST_CHECK_EQ_INT(1, (int)atomic_load(&sink.failures));
+
+  /* Cancelling the key being fired returns only after that fire. */
+  TEST_CHECK(axidev_io_repeat_engine_cancel(&engine, slow));
+  axidev_io_repeat_engine_stop(&engine);
+}
+
+static void test_repeat_engine_heap(void) {
+  axidev_io_repeat_engine engine;
+  axidev_io_repeat_entry entry;
+  axidev_io_repeat_entry *drained = NULL;
+  axidev_io_keyboard_key_with_modifier_t fast = {AXIDEV_IO_KEY_A,
+                                                 AXIDEV_IO_MOD_NONE};
+  axidev_io_keyboard_key_with_modifier_t slow = {AXIDEV_IO_KEY_B,
+                                                 AXIDEV_IO_MOD_SHIFT};
+  atomic_uint fires;
+  unsigned int settled;
+  size_t count = 0;
+  int waited_ms;
+
+  atomic_init(&fires, 0u);
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_start(
+                        &engine, count_repeat_fire, &fires),
+                    (int)AXIDEV_IO_RESULT_OK);
+
+  memset(&entry, 0, sizeof(entry));
+  entry.request = slow;
+  entry.next_fire_at_ns = axidev_io_monotonic_time_ns() + 60000000000ull;
+  entry.interval_ns = 1000000000ull;
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_add(&engine, &entry),
+                    (int)AXIDEV_IO_RESULT_OK);
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_add(&engine, &entry),
+                    (int)AXIDEV_IO_RESULT_ALREADY_INITIALIZED);
+
+  /* A newly due root must wake the worker out of the long wait. */
+  entry.request = fast;
+  entry.next_fire_at_ns = axidev_io_monotonic_time_ns();
+  entry.interval_ns = 1000000ull;
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_add(&engine, &entry),
+                    (int)AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(axidev_io_repeat_engine_contains(&engine, fast));
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_count(&engine), 2);
+
+  for (waited_ms = 0; atomic_load(&fires) < 3u && waited_ms < 1000;
+       ++waited_ms) {
+    axidev_io_sleep_ms(1);
+  }
+  TEST_CHECK(atomic_load(&fires) >= 3u);
+
+  TEST_CHECK(axidev_io_repeat_engine_cancel(&engine, fast));
+  TEST_CHECK(!axidev_io_repeat_engine_cancel(&engine, fast));
+  TEST_CHECK(!axidev_io_repeat_engine_contains(&engine, fast));
+  settled = atomic_load(&fires);
+  axidev_io_sleep_ms(20);
+  TEST_CHECK_EQ_INT((int)atomic_load(&fires), (int)settled);
+
+  axidev_io_repeat_engine_drain(&engine, &drained, &count);
+  TEST_CHECK_EQ_INT((int)count, 1);
+  TEST_CHECK(drained != NULL && drained[0].request.key == slow.key &&
+             drained[0].request.mods == slow.mods);
+  free(drained);
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_engine_count(&engine), 0);
+  TEST_CHECK(!axidev_io_repeat_engine_contains(&engine, slow));
+  axidev_io_repeat_engine_stop(&engine);
+
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_next_deadline(100u, 10u, 105u),
+                    110);
+  TEST_CHECK_EQ_INT((int)axidev_io_repeat_next_deadline(100u, 10u, 135u),
+                    140);
+}
+
 static void test_listener_lifecycle(void) {
   char *error_text;
   bool started;
@@ -259,15 +1291,758 @@ static void test_listener_lifecycle(void) {
   }
 }
 
+static int check_default_sender_binding(void *user_data) {
+  bool *saw_default = (bool *)user_data;
+
+  *saw_default = axidev_io_sender_is_default() &&
+                 axidev_io_sender_public_context() ==
+                     &axidev_io_global->keyboard.sender;
+  return 0;
+}
+
+static void test_sender_handles(void) {
+  struct axidev_io_sender handle;
+  axidev_io_thread thread;
+  bool saw_default = false;
+  char *error_text;
+
+  TEST_CHECK(axidev_io_sender_open(0) == NULL);
+  error_text = axidev_io_get_last_error();
+  TEST_CHECK(error_text != NULL &&
+             strstr(error_text, "not_initialized") != NULL);
+  axidev_io_free_string(error_text);
+  TEST_CHECK(axidev_io_sender_open_device(&(axidev_io_virtual_device_t){
+                 "lane 1", 0x1d6b, 0x0001}) == NULL);
+  TEST_CHECK(axidev_io_sender_open_device(NULL) == NULL);
+  TEST_CHECK(!axidev_io_sender_tap(
+      NULL, (axidev_io_keyboard_key_with_modifier_t){AXIDEV_IO_KEY_A,
+                                                     AXIDEV_IO_MOD_NONE}));
+  TEST_CHECK(!axidev_io_sender_type_text(NULL, "a"));
+  TEST_CHECK(axidev_io_sender_active_modifiers(NULL) == AXIDEV_IO_MOD_NONE);
+  axidev_io_sender_flush(NULL);
+  axidev_io_sender_close(NULL);
+
+  /* A bound handle redirects sender state on this thread only. */
+  memset(&handle, 0, sizeof(handle));
+  axidev_io_sender_binding = &handle.context;
+  axidev_io_keyboard_reset_public_sender_state();
+  TEST_CHECK(!axidev_io_sender_is_default());
+  TEST_CHECK(axidev_io_sender_storage_ptr() == handle.context.storage.bytes);
+  TEST_CHECK(handle.context.key_delay_us == 1000u);
+  TEST_CHECK(axidev_io_thread_create(&thread, check_default_sender_binding,
+                                     &saw_default));
+  axidev_io_thread_join(&thread);
+  axidev_io_sender_binding = NULL;
+  TEST_CHECK(saw_default);
+  TEST_CHECK(axidev_io_sender_public_context() ==
+             &axidev_io_global->keyboard.sender);
+}
+
+static void test_listener_batched_delivery(void) {
+  axidev_io_keyboard_listener_impl impl;
+  axidev_io_key_event_t events[3];
+  batch_observation observed;
+
+  TEST_CHECK(!axidev_io_listener_start_batched(NULL, NULL));
+
+  memset(&impl, 0, sizeof(impl));
+  memset(events, 0, sizeof(events));
+  memset(&observed, 0, sizeof(observed));
+  for (size_t i = 0; i < 3; ++i) {
+    events[i].timestamp_us = 1000u * (i + 1);
+    events[i].key_mod.key = AXIDEV_IO_KEY_A;
+    events[i].pressed = (i % 2) == 0;
+  }
+
+  TEST_CHECK(axidev_io_keyboard_listener_set_callback(
+                 &impl, NULL, counting_batch_cb, &observed) ==
+             AXIDEV_IO_RESULT_OK);
+  axidev_io_keyboard_listener_deliver(&impl, events, 3);
+  axidev_io_keyboard_listener_deliver(&impl, events, 0);
+  TEST_CHECK_EQ_INT(1, (int)observed.calls);
+  TEST_CHECK_EQ_INT(3, (int)observed.events);
+  TEST_CHECK(observed.last_timestamp_us == 3000u);
+
+  memset(&observed, 0, sizeof(observed));
+  TEST_CHECK(axidev_io_keyboard_listener_set_callback(
+                 &impl, counting_listener_cb, NULL, &observed) ==
+             AXIDEV_IO_RESULT_OK);
+  axidev_io_keyboard_listener_deliver(&impl, events, 3);
+  TEST_CHECK_EQ_INT(3, (int)observed.calls);
+  TEST_CHECK(atomic_load(&impl.events_delivered) == 6u);
+  axidev_io_keyboard_listener_release_subscribers(&impl);
+}
+
+static void test_listener_subscribers(void) {
+  axidev_io_keyboard_listener_impl impl;
+  axidev_io_key_event_t events[2];
+  batch_observation session;
+  batch_observation first;
+  batch_observation second;
+  uint64_t first_token = 0;
+  uint64_t second_token = 0;
+
+  TEST_CHECK(axidev_io_listener_subscribe(NULL, NULL) == 0);
+  TEST_CHECK(!axidev_io_listener_unsubscribe(0));
+
+  memset(&impl, 0, sizeof(impl));
+  memset(events, 0, sizeof(events));
+  memset(&session, 0, sizeof(session));
+  memset(&first, 0, sizeof(first));
+  memset(&second, 0, sizeof(second));
+  TEST_CHECK(axidev_io_keyboard_listener_subscribe_internal(
+                 &impl, counting_batch_cb, &first, &first_token) ==
+             AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(axidev_io_keyboard_listener_subscribe_internal(
+                 &impl, counting_batch_cb, &second, &second_token) ==
+             AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(first_token != 0 && second_token != first_token);
+  TEST_CHECK(axidev_io_keyboard_listener_set_callback(
+                 &impl, NULL, counting_batch_cb, &session) ==
+             AXIDEV_IO_RESULT_OK);
+
+  axidev_io_keyboard_listener_deliver(&impl, events, 2);
+  TEST_CHECK_EQ_INT(1, (int)session.calls);
+  TEST_CHECK_EQ_INT(2, (int)first.events);
+  TEST_CHECK_EQ_INT(2, (int)second.events);
+  /* Fan-out counts each event once, not once per subscriber. */
+  TEST_CHECK(atomic_load(&impl.events_delivered) == 2u);
+
+  TEST_CHECK(axidev_io_keyboard_listener_unsubscribe_internal(
+                 &impl, first_token) == AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(axidev_io_keyboard_listener_unsubscribe_internal(
+                 &impl, first_token) == AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+  axidev_io_keyboard_listener_deliver(&impl, events, 1);
+  TEST_CHECK_EQ_INT(2, (int)first.events);
+  TEST_CHECK_EQ_INT(3, (int)second.events);
+  TEST_CHECK_EQ_INT(2, (int)session.calls);
+
+  /* The dispatcher is idle, so no swapped-out set is kept around. */
+  TEST_CHECK(impl.retired == NULL);
+  TEST_CHECK((atomic_load(&impl.dispatch_seq) & 1u) == 0);
+  axidev_io_keyboard_listener_release_subscribers(&impl);
+}
+
+static void test_listener_latency_histogram(void) {
+  axidev_io_keyboard_listener_impl impl;
+  axidev_io_key_event_t events[2];
+  axidev_io_listener_latency_t latency;
+  batch_observation observed;
+  uint64_t now_us = axidev_io_monotonic_time_us();
+  uint64_t total = 0;
+
+  memset(&impl, 0, sizeof(impl));
+  memset(events, 0, sizeof(events));
+  memset(&observed, 0, sizeof(observed));
+  TEST_CHECK(axidev_io_keyboard_listener_set_callback(
+                 &impl, NULL, counting_batch_cb, &observed) ==
+             AXIDEV_IO_RESULT_OK);
+  /* One event from the future clamps to zero latency, one is 10 s old. */
+  events[0].timestamp_us = now_us + 1000000u;
+  events[1].timestamp_us = now_us - 10000000u;
+  axidev_io_keyboard_listener_deliver(&impl, events, 2);
+
+  TEST_CHECK(events[0].dispatch_time_us >= now_us);
+  TEST_CHECK(events[1].dispatch_time_us == events[0].dispatch_time_us);
+  TEST_CHECK(atomic_load(&impl.latency_buckets[0]) == 1u);
+  TEST_CHECK(atomic_load(
+                 &impl.latency_buckets[AXIDEV_IO_LISTENER_LATENCY_BUCKETS -
+                                       1]) == 1u);
+  TEST_CHECK(atomic_load(&impl.latency_max_us) >= 10000000u);
+  axidev_io_keyboard_listener_release_subscribers(&impl);
+
+  axidev_io_listener_get_latency(&latency);
+  for (size_t i = 0; i < AXIDEV_IO_LISTENER_LATENCY_BUCKETS; ++i) {
+    total += latency.buckets[i];
+  }
+  TEST_CHECK(total == latency.samples);
+}
+
+static void test_listener_pull_queue(void) {
+  axidev_io_listener_wait_handle_t handle;
+  axidev_io_key_event_t events[8];
+  axidev_io_listener_stats_t stats;
+  char *error_text;
+
+  TEST_CHECK(!axidev_io_listener_open_queue(NULL));
+  TEST_CHECK(axidev_io_listener_read_events(events, 8) == 0);
+  error_text = axidev_io_get_last_error();
+  TEST_CHECK(error_text != NULL);
+  axidev_io_free_string(error_text);
+
+  if (axidev_io_listener_open_queue(&handle)) {
+    TEST_CHECK(axidev_io_listener_is_listening());
+    TEST_CHECK(!axidev_io_listener_open_queue(&handle));
+    TEST_CHECK(!axidev_io_listener_start(noop_listener_cb, NULL));
+    axidev_io_listener_get_stats(&stats);
+    TEST_CHECK(stats.queue_capacity > 0);
+    (void)axidev_io_listener_read_events(events, 8);
+    axidev_io_listener_stop();
+    TEST_CHECK(axidev_io_listener_read_events(events, 8) == 0);
+  }
+}
+
+static void check_listener_backend_option(
+    uint32_t option, axidev_io_keyboard_backend_type_t expected) {
+  axidev_io_listener_set_options(option);
+  if (axidev_io_listener_start(noop_listener_cb, NULL)) {
+    TEST_CHECK_EQ_INT(expected, axidev_io_listener_backend_type());
+    axidev_io_listener_stop();
+  } else {
+    char *error_text = axidev_io_get_last_error();
+    TEST_CHECK(error_text != NULL);
+    axidev_io_free_string(error_text);
+  }
+  TEST_CHECK_EQ_INT(AXIDEV_IO_BACKEND_UNKNOWN,
+                    axidev_io_listener_backend_type());
+  axidev_io_listener_set_options(0);
+}
+
+static void test_listener_backend_options(void) {
+  TEST_CHECK_EQ_INT(AXIDEV_IO_BACKEND_UNKNOWN,
+                    axidev_io_listener_backend_type());
+#if defined(_WIN32)
+  check_listener_backend_option(AXIDEV_IO_LISTENER_OPTION_RAW_INPUT,
+                                AXIDEV_IO_BACKEND_WINDOWS_RAW_INPUT);
+  check_listener_backend_option(AXIDEV_IO_LISTENER_OPTION_EVDEV,
+                                AXIDEV_IO_BACKEND_WINDOWS);
+#elif defined(__linux__)
+  check_listener_backend_option(AXIDEV_IO_LISTENER_OPTION_EVDEV,
+                                AXIDEV_IO_BACKEND_LINUX_EVDEV);
+  check_listener_backend_option(AXIDEV_IO_LISTENER_OPTION_RAW_INPUT,
+                                AXIDEV_IO_BACKEND_LINUX_LIBINPUT);
+#endif
+}
+
+/* A worker that fails during startup must leave its error on the thread
+   that called start. An unknown layout fails the evdev session before it
+   is ready. */
+static void test_listener_startup_error(void) {
+#if defined(__linux__)
+  const char *previous = getenv("XKB_DEFAULT_LAYOUT");
+  char saved[64] = {0};
+  bool had_previous = previous != NULL;
+
+  if (had_previous) {
+    snprintf(saved, sizeof(saved), "%s", previous);
+  }
+  setenv("XKB_DEFAULT_LAYOUT", "axidev-io-no-such-layout", 1);
+  axidev_io_listener_set_options(AXIDEV_IO_LISTENER_OPTION_EVDEV);
+  if (axidev_io_listener_start(noop_listener_cb, NULL)) {
+    axidev_io_listener_stop();
+  } else {
+    const char *message = axidev_io_get_last_error_message();
+
+    TEST_CHECK_EQ_INT(AXIDEV_IO_ERROR_PLATFORM,
+                      (int)axidev_io_get_last_error_code());
+    TEST_CHECK(message != NULL && message[0] != '\0');
+    TEST_CHECK(strstr(message, "platform_error") == NULL);
+  }
+  axidev_io_listener_set_options(0);
+  if (had_previous) {
+    setenv("XKB_DEFAULT_LAYOUT", saved, 1);
+  } else {
+    unsetenv("XKB_DEFAULT_LAYOUT");
+  }
+#endif
+}
+
+static void test_listener_filter_codes(void) {
+  axidev_io_keyboard_keymap_impl *keymap = axidev_io_keymap_impl_get();
+  axidev_io_listener_filter_t filter;
+  uint8_t codes[AXIDEV_IO_KEYMAP_CODE_LIMIT];
+  int32_t code_a;
+  int32_t code_b;
+
+  memset(&filter, 0, sizeof(filter));
+  TEST_CHECK(!axidev_io_listener_filter_is_active(&filter));
+  TEST_CHECK(axidev_io_listener_filter_accepts_key(&filter, AXIDEV_IO_KEY_B));
+  filter.required_mods = AXIDEV_IO_MOD_CTRL;
+  TEST_CHECK(axidev_io_listener_filter_is_active(&filter));
+
+  axidev_io_listener_filter_add_key(&filter, AXIDEV_IO_KEY_A);
+  axidev_io_listener_filter_add_key(&filter, AXIDEV_IO_KEY_RF_KILL);
+  TEST_CHECK(axidev_io_listener_filter_accepts_key(&filter, AXIDEV_IO_KEY_A));
+  TEST_CHECK(
+      axidev_io_listener_filter_accepts_key(&filter, AXIDEV_IO_KEY_RF_KILL));
+  TEST_CHECK(!axidev_io_listener_filter_accepts_key(&filter, AXIDEV_IO_KEY_B));
+  TEST_CHECK(
+      !axidev_io_listener_filter_accepts_key(&filter, AXIDEV_IO_KEY_UNKNOWN));
+
+  if (axidev_io_keyboard_keymap_initialize() != AXIDEV_IO_RESULT_OK ||
+      keymap->active == NULL) {
+    return;
+  }
+  code_a = keymap->active->tables->key_to_code[AXIDEV_IO_KEY_A];
+  code_b = keymap->active->tables->key_to_code[AXIDEV_IO_KEY_B];
+  axidev_io_listener_filter_build_codes(&filter, keymap->active->tables,
+                                        AXIDEV_IO_KEYMAP_CODE_LIMIT, codes);
+  if (code_a >= 0 && code_b >= 0) {
+    TEST_CHECK((codes[code_a] & AXIDEV_IO_LISTENER_CODE_PASS) != 0);
+    TEST_CHECK((codes[code_b] & AXIDEV_IO_LISTENER_CODE_PASS) == 0);
+  }
+
+  memset(filter.keys, 0, sizeof(filter.keys));
+  axidev_io_listener_filter_build_codes(&filter, keymap->active->tables,
+                                        AXIDEV_IO_KEYMAP_CODE_LIMIT, codes);
+  if (code_b >= 0) {
+    TEST_CHECK(codes[code_b] == AXIDEV_IO_LISTENER_CODE_PASS);
+  }
+  axidev_io_keyboard_keymap_free();
+}
+
+typedef struct replay_observation {
+  size_t count;
+  axidev_io_key_event_t events[4];
+} replay_observation;
+
+static void replay_collect_cb(const axidev_io_key_event_t *events,
+                              size_t count, void *user_data) {
+  replay_observation *observed = (replay_observation *)user_data;
+
+  for (size_t i = 0; i < count && observed->count < 4; ++i) {
+    observed->events[observed->count++] = events[i];
+  }
+}
+
+static void test_listener_replay(void) {
+#if defined(__linux__)
+  const uint32_t code_a = KEY_A;
+#else
+  const uint32_t code_a = 'A';
+#endif
+  const axidev_io_listener_synthetic_key keys[2] = {{code_a, true},
+                                                    {code_a, false}};
+  replay_observation observed;
+
+  memset(&observed, 0, sizeof(observed));
+  TEST_CHECK(axidev_io_keyboard_listener_replay_for_tests(keys, 2, NULL,
+                                                          NULL) ==
+             AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+  if (axidev_io_keyboard_listener_replay_for_tests(
+          keys, 2, replay_collect_cb, &observed) != AXIDEV_IO_RESULT_OK) {
+    return;
+  }
+  TEST_CHECK_EQ_INT(2, (int)observed.count);
+  if (observed.count == 2) {
+    TEST_CHECK_EQ_INT(AXIDEV_IO_KEY_A, observed.events[0].key_mod.key);
+    TEST_CHECK(observed.events[0].pressed);
+    TEST_CHECK(!observed.events[1].pressed);
+    TEST_CHECK_EQ_INT('a', (int)observed.events[1].codepoint);
+  }
+  axidev_io_keyboard_listener_reclaim(axidev_io_listener_impl_get());
+}
+
+static void test_runtime_stats(void) {
+#if defined(__linux__)
+  const uint32_t code_a = KEY_A;
+#else
+  const uint32_t code_a = 'A';
+#endif
+  const axidev_io_listener_synthetic_key keys[2] = {{code_a, true},
+                                                    {code_a, false}};
+  const axidev_io_keyboard_key_with_modifier_t tap_a = {AXIDEV_IO_KEY_A,
+                                                        AXIDEV_IO_MOD_NONE};
+  axidev_io_captured_transition_t captured[4];
+  replay_observation observed;
+  axidev_io_stats_t stats;
+
+  axidev_io_clear_last_error();
+  axidev_io_get_stats(NULL);
+  TEST_CHECK_EQ_INT((int)AXIDEV_IO_ERROR_INVALID_ARGUMENT,
+                    (int)axidev_io_get_last_error_code());
+  axidev_io_clear_last_error();
+
+  axidev_io_reset_stats();
+  axidev_io_get_stats(&stats);
+  TEST_CHECK(stats.sender_events_sent == 0);
+  TEST_CHECK(stats.tap_duration_us.samples == 0);
+
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  if (axidev_io_keyboard_initialize()) {
+    axidev_io_keyboard_set_key_delay(0);
+    TEST_CHECK(axidev_io_keyboard_tap(tap_a));
+    TEST_CHECK(axidev_io_keyboard_tap(tap_a));
+    axidev_io_keyboard_capture_read(captured, 4);
+    axidev_io_get_stats(&stats);
+    TEST_CHECK(stats.sender_events_sent == 4);
+    TEST_CHECK(stats.sender_write_failures == 0);
+    TEST_CHECK(stats.tap_duration_us.samples == 2);
+    axidev_io_keyboard_free();
+  }
+  axidev_io_keyboard_set_sender_options(0);
+
+  memset(&observed, 0, sizeof(observed));
+  if (axidev_io_keyboard_listener_replay_for_tests(
+          keys, 2, replay_collect_cb, &observed) == AXIDEV_IO_RESULT_OK) {
+    axidev_io_get_stats(&stats);
+    TEST_CHECK(stats.listener_events_received == 2);
+    TEST_CHECK(stats.listener_events_delivered == 2);
+    TEST_CHECK(stats.callback_duration_ns.samples == 1);
+    TEST_CHECK(stats.listener_events_dropped == 0);
+    axidev_io_keyboard_listener_reclaim(axidev_io_listener_impl_get());
+  }
+
+  axidev_io_reset_stats();
+  axidev_io_get_stats(&stats);
+  TEST_CHECK(stats.listener_events_received == 0);
+  TEST_CHECK(stats.callback_duration_ns.max == 0);
+}
+
+static void test_macro_codec(void) {
+  const axidev_io_macro_event source = {
+      (uint64_t)1 << 40, 0x2FFu, AXIDEV_IO_KEY_RF_KILL,
+      (axidev_io_keyboard_modifier_t)(AXIDEV_IO_MOD_SHIFT | AXIDEV_IO_MOD_ALT),
+      true};
+  uint8_t record[AXIDEV_IO_MACRO_RECORD_MAX_SIZE];
+  axidev_io_macro_event decoded;
+  const uint8_t *cursor = record;
+  size_t length = axidev_io_macro_encode_event(&source, record);
+
+  TEST_CHECK(length <= AXIDEV_IO_MACRO_RECORD_MAX_SIZE);
+  TEST_CHECK_EQ_INT(axidev_io_macro_decode_event(&cursor, record + length,
+                                                 &decoded),
+                    AXIDEV_IO_RESULT_OK);
+  TEST_CHECK(cursor == record + length);
+  TEST_CHECK(decoded.delta_us == source.delta_us);
+  TEST_CHECK_EQ_INT((int)decoded.code, 0x2FF);
+  TEST_CHECK_EQ_INT(decoded.key, AXIDEV_IO_KEY_RF_KILL);
+  TEST_CHECK_EQ_INT(decoded.mods, source.mods);
+  TEST_CHECK(decoded.pressed);
+
+  /* Every proper prefix of a record is rejected. */
+  for (size_t cut = 0; cut < length; ++cut) {
+    cursor = record;
+    TEST_CHECK_EQ_INT(axidev_io_macro_decode_event(&cursor, record + cut,
+                                                   &decoded),
+                      AXIDEV_IO_RESULT_INVALID_ARGUMENT);
+  }
+}
+
+static void test_macro_record_replay(void) {
+#if defined(__linux__)
+  const uint32_t code_a = KEY_A;
+#else
+  const uint32_t code_a = 'A';
+#endif
+  axidev_io_key_event_t events[3];
+  axidev_io_captured_transition_t captured[8];
+  axidev_io_macro_recorder_t *recorder;
+  uint8_t stream[64];
+  size_t size;
+  uint64_t start_ns;
+
+  recorder = axidev_io_macro_recorder_create();
+  TEST_CHECK(recorder != NULL);
+  if (recorder == NULL) {
+    return;
+  }
+  memset(events, 0, sizeof(events));
+  for (size_t i = 0; i < 3; ++i) {
+    events[i].code = code_a;
+    events[i].key_mod.key = AXIDEV_IO_KEY_A;
+    events[i].pressed = i != 1;
+    events[i].timestamp_us = 5000000u + i * 20000u;
+  }
+  axidev_io_macro_recorder_append(events, 3, recorder);
+  TEST_CHECK_EQ_INT(3, (int)axidev_io_macro_recorder_event_count(recorder));
+  size = axidev_io_macro_recorder_copy(recorder, stream, sizeof(stream));
+  TEST_CHECK(size > AXIDEV_IO_MACRO_HEADER_SIZE && size <= sizeof(stream));
+  TEST_CHECK(memcmp(stream, "AXMR", 4) == 0);
+  TEST_CHECK_EQ_INT(
+      (int)size, (int)axidev_io_macro_recorder_copy(recorder, NULL, 0));
+
+  TEST_CHECK(!axidev_io_macro_replay(stream, size, 1.0));
+  TEST_CHECK_EQ_INT((int)AXIDEV_IO_ERROR_NOT_INITIALIZED,
+                    (int)axidev_io_get_last_error_code());
+
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  if (axidev_io_keyboard_initialize()) {
+    /* The trailing press is released once the stream ends, and the 40 ms
+       of recorded delays are kept at full speed. */
+    start_ns = axidev_io_monotonic_time_ns();
+    TEST_CHECK(axidev_io_macro_replay(stream, size, 1.0));
+    TEST_CHECK(axidev_io_monotonic_time_ns() - start_ns >= 40000000u);
+    TEST_CHECK_EQ_INT(4, (int)axidev_io_keyboard_capture_read(captured, 8));
+    TEST_CHECK_EQ_INT((int)code_a, captured[0].code);
+    TEST_CHECK_EQ_INT(1, captured[0].value);
+    TEST_CHECK_EQ_INT(0, captured[1].value);
+    TEST_CHECK_EQ_INT(1, captured[2].value);
+    TEST_CHECK_EQ_INT(0, captured[3].value);
+    TEST_CHECK_EQ_INT(AXIDEV_IO_MOD_NONE,
+                      axidev_io_keyboard_active_modifiers());
+
+    TEST_CHECK(axidev_io_macro_replay(stream, size, 0.0));
+    TEST_CHECK_EQ_INT(4, (int)axidev_io_keyboard_capture_read(captured, 8));
+    TEST_CHECK(!axidev_io_macro_replay(stream, size, -1.0));
+
+    /* A stream cut inside the release stops there, and the press before
+       it is still released. */
+    TEST_CHECK(
+        !axidev_io_macro_replay(stream, AXIDEV_IO_MACRO_HEADER_SIZE + 6, 0.0));
+    TEST_CHECK_EQ_INT(2, (int)axidev_io_keyboard_capture_read(captured, 8));
+    TEST_CHECK_EQ_INT(1, captured[0].value);
+    TEST_CHECK_EQ_INT(0, captured[1].value);
+
+    stream[5] ^= 3u;
+    TEST_CHECK(!axidev_io_macro_replay(stream, size, 0.0));
+    TEST_CHECK_EQ_INT((int)AXIDEV_IO_ERROR_NOT_SUPPORTED,
+                      (int)axidev_io_get_last_error_code());
+    stream[5] ^= 3u;
+
+#if !defined(_WIN32)
+    {
+      char directory[] = "/tmp/axidev-io-test-XXXXXX";
+      char path[64];
+
+      TEST_CHECK(mkdtemp(directory) != NULL);
+      snprintf(path, sizeof(path), "%s/macro.bin", directory);
+      TEST_CHECK(axidev_io_macro_recorder_save(recorder, path));
+      TEST_CHECK(axidev_io_macro_replay_file(path, 0.0));
+      TEST_CHECK_EQ_INT(4, (int)axidev_io_keyboard_capture_read(captured, 8));
+      remove(path);
+      TEST_CHECK(!axidev_io_macro_replay_file(path, 0.0));
+      TEST_CHECK_EQ_INT((int)AXIDEV_IO_ERROR_NOT_FOUND,
+                        (int)axidev_io_get_last_error_code());
+      rmdir(directory);
+    }
+#endif
+    axidev_io_keyboard_free();
+  }
+  axidev_io_keyboard_set_sender_options(0);
+
+  axidev_io_macro_recorder_clear(recorder);
+  TEST_CHECK_EQ_INT(0, (int)axidev_io_macro_recorder_event_count(recorder));
+  TEST_CHECK_EQ_INT((int)AXIDEV_IO_MACRO_HEADER_SIZE,
+                    (int)axidev_io_macro_recorder_copy(recorder, NULL, 0));
+  axidev_io_macro_recorder_destroy(recorder);
+}
+
+/* A replay idling between events leaves the library to other callers and
+   stops at once when its async job is cancelled. */
+static void test_macro_replay_async_cancel(void) {
+#if defined(__linux__)
+  const uint32_t code_a = KEY_A;
+#else
+  const uint32_t code_a = 'A';
+#endif
+  axidev_io_keyboard_key_with_modifier_t other = {AXIDEV_IO_KEY_B,
+                                                  AXIDEV_IO_MOD_NONE};
+  axidev_io_key_event_t events[2];
+  axidev_io_captured_transition_t captured[8];
+  axidev_io_macro_recorder_t *recorder;
+  async_reentry_t observed;
+  uint8_t stream[64];
+  size_t size;
+  uint64_t start_ns;
+  uint64_t job_id;
+
+  recorder = axidev_io_macro_recorder_create();
+  TEST_CHECK(recorder != NULL);
+  if (recorder == NULL) {
+    return;
+  }
+  memset(events, 0, sizeof(events));
+  for (size_t i = 0; i < 2; ++i) {
+    events[i].code = code_a;
+    events[i].key_mod.key = AXIDEV_IO_KEY_A;
+    events[i].pressed = i == 0;
+    events[i].timestamp_us = 1000000u + i * 5000000u;
+  }
+  axidev_io_macro_recorder_append(events, 2, recorder);
+  size = axidev_io_macro_recorder_copy(recorder, stream, sizeof(stream));
+  axidev_io_macro_recorder_destroy(recorder);
+  TEST_CHECK_EQ_INT(0, (int)axidev_io_macro_replay_async(NULL, 0, 1.0,
+                                                          NULL, NULL));
+
+  memset(&observed, 0, sizeof(observed));
+  axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+  TEST_CHECK(axidev_io_keyboard_initialize());
+  start_ns = axidev_io_monotonic_time_ns();
+  job_id = axidev_io_macro_replay_async(stream, size, 1.0, async_dropped_cb,
+                                        &observed);
+  TEST_CHECK(job_id != 0);
+  axidev_io_sleep_ms(30);
+  TEST_CHECK(axidev_io_keyboard_tap(other));
+  TEST_CHECK(axidev_io_keyboard_async_cancel(job_id));
+  TEST_CHECK(axidev_io_keyboard_async_wait(job_id, 1000));
+  TEST_CHECK(axidev_io_monotonic_time_ns() - start_ns < 1000000000u);
+  TEST_CHECK_EQ_INT(1, (int)observed.dropped_count);
+  TEST_CHECK_EQ_INT(AXIDEV_IO_ERROR_CANCELLED, observed.dropped_errors[0]);
+
+  /* The replay's press, the tap sent while it waited, then the release
+     of the key the cancelled replay still held. */
+  TEST_CHECK_EQ_INT(4, (int)axidev_io_keyboard_capture_read(captured, 8));
+  TEST_CHECK_EQ_INT((int)code_a, captured[0].code);
+  TEST_CHECK_EQ_INT(1, captured[0].value);
+  TEST_CHECK(captured[1].code != (int32_t)code_a);
+  TEST_CHECK_EQ_INT(1, captured[1].value);
+  TEST_CHECK_EQ_INT(0, captured[2].value);
+  TEST_CHECK_EQ_INT((int)code_a, captured[3].code);
+  TEST_CHECK_EQ_INT(0, captured[3].value);
+  axidev_io_keyboard_free();
+  axidev_io_keyboard_set_sender_options(0);
+}
+
+static void test_keyboard_refresh_layout(void) {
+  bool changed = true;
+
+  TEST_CHECK(!axidev_io_keyboard_refresh_layout(&changed));
+  TEST_CHECK(!changed);
+  TEST_CHECK_EQ_INT((int)AXIDEV_IO_ERROR_NOT_INITIALIZED,
+                    (int)axidev_io_get_last_error_code());
+
+#if defined(__linux__)
+  {
+    const char *previous = getenv("XKB_DEFAULT_LAYOUT");
+    char saved[64] = "";
+    axidev_io_keyboard_keymap_impl *impl = axidev_io_keymap_impl_get();
+    axidev_io_captured_transition_t captured[4];
+    axidev_io_keymap_tables *us_tables;
+    uint64_t generation;
+    int32_t code = -1;
+
+    if (previous != NULL) {
+      snprintf(saved, sizeof(saved), "%s", previous);
+    }
+    setenv("XKB_DEFAULT_LAYOUT", "us", 1);
+    axidev_io_keyboard_set_sender_options(AXIDEV_IO_SENDER_OPTION_CAPTURE);
+    if (axidev_io_keyboard_initialize()) {
+      TEST_CHECK(axidev_io_keyboard_refresh_layout(&changed));
+      TEST_CHECK(!changed);
+      us_tables = impl->active->tables;
+      generation = axidev_io_keymap_generation();
+
+      /* The switch swaps tables under the running sender. */
+      setenv("XKB_DEFAULT_LAYOUT", "fr", 1);
+      TEST_CHECK(axidev_io_keyboard_refresh_layout(&changed));
+      TEST_CHECK(changed);
+      TEST_CHECK(axidev_io_keymap_generation() > generation);
+      TEST_CHECK(axidev_io_keyboard_is_ready());
+      TEST_CHECK_EQ_INT(axidev_io_keymap_code_for_key(AXIDEV_IO_KEY_A, &code),
+                        AXIDEV_IO_RESULT_OK);
+      TEST_CHECK_EQ_INT(KEY_Q, code);
+      TEST_CHECK(axidev_io_keyboard_type_text("a"));
+      TEST_CHECK_EQ_INT(2, (int)axidev_io_keyboard_capture_read(captured, 4));
+      TEST_CHECK_EQ_INT(KEY_Q, captured[0].code);
+
+      /* Switching back reuses the first layout's tables. */
+      setenv("XKB_DEFAULT_LAYOUT", "us", 1);
+      TEST_CHECK(axidev_io_keyboard_refresh_layout(&changed));
+      TEST_CHECK(changed);
+      TEST_CHECK(impl->active->tables == us_tables);
+      TEST_CHECK_EQ_INT(2, (int)impl->recent_count);
+      TEST_CHECK(axidev_io_keyboard_type_text("a"));
+      TEST_CHECK_EQ_INT(2, (int)axidev_io_keyboard_capture_read(captured, 4));
+      TEST_CHECK_EQ_INT(KEY_A, captured[0].code);
+
+      /* A fast-init device lacking keys of the next layout is replaced
+         only once its successor exists. Without /dev/uinput the old one
+         stays and the sender stays initialized. */
+      if (access("/dev/uinput", W_OK) != 0) {
+        axidev_io_keyboard_sender_impl *sender = axidev_io_sender_impl_get();
+        int pipe_fds[2];
+
+        if (pipe(pipe_fds) == 0) {
+          sender->fd = pipe_fds[1];
+          sender->all_keys_registered = false;
+          memset(sender->registered_keys, 0, sizeof(sender->registered_keys));
+          setenv("XKB_DEFAULT_LAYOUT", "fr", 1);
+          TEST_CHECK(!axidev_io_keyboard_refresh_layout(&changed));
+          TEST_CHECK(changed);
+          TEST_CHECK_EQ_INT(pipe_fds[1], sender->fd);
+          TEST_CHECK(axidev_io_keyboard_is_ready());
+          sender->fd = -1;
+          sender->all_keys_registered = true;
+          memset(sender->registered_keys, 0xff,
+                 sizeof(sender->registered_keys));
+          close(pipe_fds[0]);
+          close(pipe_fds[1]);
+        }
+      }
+      axidev_io_keyboard_free();
+    }
+    axidev_io_keyboard_set_sender_options(0);
+    if (previous != NULL) {
+      setenv("XKB_DEFAULT_LAYOUT", saved, 1);
+    } else {
+      unsetenv("XKB_DEFAULT_LAYOUT");
+    }
+  }
+#endif
+}
+
+static void test_listener_deferred_dispatch_stats(void) {
+  axidev_io_listener_stats_t stats;
+
+  TEST_CHECK_EQ_INT(0, (int)axidev_io_listener_get_options());
+  axidev_io_listener_set_options(AXIDEV_IO_LISTENER_OPTION_DEFERRED_DISPATCH);
+  TEST_CHECK_EQ_INT((int)AXIDEV_IO_LISTENER_OPTION_DEFERRED_DISPATCH,
+                    (int)axidev_io_listener_get_options());
+
+  if (axidev_io_listener_start(noop_listener_cb, NULL)) {
+    axidev_io_listener_get_stats(&stats);
+#if defined(_WIN32)
+    TEST_CHECK(stats.queue_capacity > 0);
+#endif
+    TEST_CHECK(stats.events_dropped == 0);
+    axidev_io_listener_stop();
+  }
+  axidev_io_listener_get_stats(&stats);
+  TEST_CHECK(stats.queue_high_water <= stats.queue_capacity);
+
+  axidev_io_listener_set_options(0);
+  TEST_CHECK_EQ_INT(0, (int)axidev_io_listener_get_options());
+}
+
 int main(void) {
   TEST_RUN(test_conversion_helpers);
 #if defined(__linux__)
   TEST_RUN(test_linux_fr_digit_key_resolution);
+  TEST_RUN(test_linux_layout_cache_shared);
+  TEST_RUN(test_linux_keysym_table);
+  TEST_RUN(test_linux_sender_whole_frames);
+#endif
+#if !defined(_WIN32)
+  TEST_RUN(test_keymap_snapshot_round_trip);
 #endif
+  TEST_RUN(test_typing_plan_modifier_elision);
+  TEST_RUN(test_utf8_ascii_run_heap_bounds);
+  TEST_RUN(test_typing_plan_ascii_fast_path);
+  TEST_RUN(test_typing_rate_shifted_text);
+  TEST_RUN(test_typing_rate_taps);
+  TEST_RUN(test_keyboard_plan_recompile);
   TEST_RUN(test_sender_lifecycle_and_errors);
+  TEST_RUN(test_last_error_per_thread);
+  TEST_RUN(test_sender_options_survive_reinitialize);
+  TEST_RUN(test_sender_capture);
+  TEST_RUN(test_call_once_waits_for_initializer);
+  TEST_RUN(test_pacer_absolute_deadlines);
+  TEST_RUN(test_log_sink_and_async);
+  TEST_RUN(test_log_filtered_arguments);
+  TEST_RUN(test_log_sink_reentry);
+  TEST_RUN(test_async_queue_backpressure_and_cancel);
+  TEST_RUN(test_async_callback_reentry);
 #if defined(_WIN32)
   TEST_RUN(test_windows_repeat_state);
 #endif
+  TEST_RUN(test_repeat_engine_heap);
+  TEST_RUN(test_repeat_engine_fires_unlocked);
+  TEST_RUN(test_sender_handles);
   TEST_RUN(test_listener_lifecycle);
+  TEST_RUN(test_listener_batched_delivery);
+  TEST_RUN(test_listener_subscribers);
+  TEST_RUN(test_listener_pull_queue);
+  TEST_RUN(test_listener_latency_histogram);
+  TEST_RUN(test_listener_backend_options);
+  TEST_RUN(test_listener_startup_error);
+  TEST_RUN(test_listener_filter_codes);
+  TEST_RUN(test_listener_replay);
+  TEST_RUN(test_runtime_stats);
+  TEST_RUN(test_macro_codec);
+  TEST_RUN(test_macro_record_replay);
+  TEST_RUN(test_macro_replay_async_cancel);
+  TEST_RUN(test_keyboard_refresh_layout);
+  TEST_RUN(test_listener_deferred_dispatch_stats);
   return g_axidev_test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
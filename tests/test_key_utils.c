@@ -94,10 +94,55 @@ static void test_key_with_modifier_helpers(void) {
   TEST_CHECK_EQ_INT(parsed.key, AXIDEV_IO_KEY_UNKNOWN);
 }
 
+static void test_non_allocating_helpers(void) {
+  char buffer[16];
+
+  TEST_CHECK_STR(axidev_io_keyboard_key_name(AXIDEV_IO_KEY_ESCAPE), "Escape");
+  TEST_CHECK_STR(axidev_io_keyboard_key_name((axidev_io_keyboard_key_t)9999),
+                 "Unknown");
+
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_key_to_string_buf(AXIDEV_IO_KEY_ESCAPE,
+                                                         buffer, 4),
+                    6);
+  TEST_CHECK_STR(buffer, "Esc");
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_key_to_string_buf(AXIDEV_IO_KEY_ESCAPE,
+                                                         NULL, 0),
+                    6);
+
+  TEST_CHECK_EQ_INT(
+      axidev_io_keyboard_key_to_string_with_modifier_buf(
+          (axidev_io_keyboard_key_with_modifier_t){
+              AXIDEV_IO_KEY_A, AXIDEV_IO_MOD_CTRL | AXIDEV_IO_MOD_SHIFT},
+          buffer, sizeof(buffer)),
+      12);
+  TEST_CHECK_STR(buffer, "Ctrl+Shift+A");
+  TEST_CHECK_EQ_INT(
+      axidev_io_keyboard_key_to_string_with_modifier_buf(
+          (axidev_io_keyboard_key_with_modifier_t){AXIDEV_IO_KEY_A,
+                                                   AXIDEV_IO_MOD_CTRL},
+          buffer, 3),
+      6);
+  TEST_CHECK_STR(buffer, "Ct");
+
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_string_to_key("ESC"),
+                    AXIDEV_IO_KEY_ESCAPE);
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_string_to_key("Kp_Mul"),
+                    AXIDEV_IO_KEY_NUMPAD_MULTIPLY);
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_string_to_key("kpHome"),
+                    AXIDEV_IO_KEY_NUMPAD7);
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_string_to_key("OE"), AXIDEV_IO_KEY_OE);
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_string_to_key("Oe"), AXIDEV_IO_KEY_oe);
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_string_to_key("xf86Launch5"),
+                    AXIDEV_IO_KEY_LAUNCH5);
+  TEST_CHECK_EQ_INT(axidev_io_keyboard_string_to_key("escape_key_too_long"),
+                    AXIDEV_IO_KEY_UNKNOWN);
+}
+
 int main(void) {
   TEST_RUN(test_roundtrip_and_uniqueness);
   TEST_RUN(test_aliases_and_synonyms);
   TEST_RUN(test_invalid_inputs);
   TEST_RUN(test_key_with_modifier_helpers);
+  TEST_RUN(test_non_allocating_helpers);
   return g_axidev_test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }